@@ -18,12 +18,28 @@
 
 #include <vector>
 #include <fstream> // used for operator<<
+#include <sstream>
+#include <stdexcept>
 #include <string>    // for (basic_string and) getline()
 #include <algorithm> // for std::min
+#include <utility>   // for std::move
+#include <iterator>  // for std::back_inserter
+#include <cstdio>    // for std::remove
 #include <assert.h>  // <cassert> is sometimes macro-guarded :-(
 
 #include "boost/limits.hpp"
 #include "boost/dynamic_bitset/dynamic_bitset.hpp"
+#include "boost/dynamic_bitset/rank_select_index.hpp"
+#include "boost/dynamic_bitset/hierarchical_bitset.hpp"
+#include "boost/dynamic_bitset/roaring_bitset.hpp"
+#include "boost/dynamic_bitset/ewah_bitset.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset_view.hpp"
+#include "boost/dynamic_bitset/binary_format.hpp"
+#include "boost/dynamic_bitset/text_codecs.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset_hasher.hpp"
+#include "boost/functional/hash.hpp"
+#include "boost/static_assert.hpp"
+#include "boost/type_traits/is_convertible.hpp"
 #include "boost/test/minimal.hpp"
 
 
@@ -60,11 +76,73 @@ std::string get_long_string()
   return std::string(p);
 }
 
+// A string spanning several kilobits, long enough to go through
+// the vector kernels (see detail/dynamic_bitset_kernels.hpp); its
+// length isn't a multiple of any block width.
+std::string get_very_long_string()
+{
+  const std::string s = get_long_string();
+  std::string r(s.rbegin(), s.rend());
+  std::string result;
+  for (int i = 0; i < 20; ++i)
+    result += (i % 3 == 0) ? r : s;
+  return result + "101";
+}
+
 const char * test_file_name()
 {
   return "boost_dynamic_bitset_tests";
 }
 
+// the kernel levels the processor supports, the portable one first:
+// the kernel tests run each of them against a reference
+std::vector<boost::detail::dynamic_bitset_impl::simd_level> available_simd_levels()
+{
+  using namespace boost::detail::dynamic_bitset_impl;
+  const simd_level levels[] = { simd_none, simd_sse2, simd_avx2, simd_avx512 };
+  std::vector<simd_level> result;
+  for (std::size_t l = 0; l < sizeof levels / sizeof levels[0]; ++l)
+    if (simd_level_available(levels[l]))
+      result.push_back(levels[l]);
+  return result;
+}
+
+// the same for the count kernels
+std::vector<boost::detail::dynamic_bitset_impl::count_kernel> available_count_kernels()
+{
+  using namespace boost::detail::dynamic_bitset_impl;
+  const count_kernel kernels[] = {
+    count_by_table, count_by_popcnt, count_by_avx2, count_by_avx512
+  };
+  std::vector<count_kernel> result;
+  for (std::size_t k = 0; k < sizeof kernels / sizeof kernels[0]; ++k)
+    if (count_kernel_available(kernels[k]))
+      result.push_back(kernels[k]);
+  return result;
+}
+
+// the characters of a string, through a stream buffer which cannot
+// seek, as a pipe
+class unseekable_buffer : public std::streambuf
+{
+public:
+  explicit unseekable_buffer(const std::string& s) : m_s(s)
+  {
+    char* const p = &m_s[0];
+    setg(p, p, p + m_s.size());
+  }
+
+private:
+  std::string m_s;
+};
+
+// deletes test_file_name() when leaving scope, whether or not a check
+// threw
+struct test_file_remover
+{
+  ~test_file_remover() { std::remove(test_file_name()); }
+};
+
 #if defined BOOST_OLD_IOSTREAMS || defined BOOST_NO_STD_LOCALE
 template <typename Stream>
 bool is_one_or_zero(const Stream & /*s*/, char c)
@@ -193,6 +271,378 @@ struct bitset_test {
 
   }
 
+  // from_chars(): the bits of the string constructor, or an empty
+  // bitset if one of the characters is neither '0' nor '1'
+  static void from_chars(const std::string& str)
+  {
+      const char * const first = str.data();
+      const std::size_t n = str.size();
+
+      Bitset b(std::string("1"));
+      BOOST_CHECK(boost::from_chars(first, first + n, b) == boost::bitset_parse_ok);
+      BOOST_CHECK(b == Bitset(str));
+
+#if !defined(BOOST_NO_CXX17_HDR_STRING_VIEW)
+      BOOST_CHECK(Bitset(std::string_view(str)) == b);
+      BOOST_CHECK(Bitset(std::string_view(str), n / 2) == Bitset(str, 0, n, n / 2));
+      BOOST_CHECK(boost::from_chars(std::string_view(str), b) == boost::bitset_parse_ok);
+      BOOST_CHECK(b == Bitset(str));
+#endif
+
+      // at both ends and around the 64-character groups of the kernels
+      const std::size_t positions[] = { 0, 1, n / 2, n - 64, n - 65, n - 2, n - 1 };
+      const char bad_chars[] = { '2', '/', ' ', 'q', '\xb0', '\xb1', '\0' };
+      for (std::size_t i = 0; i < sizeof positions / sizeof positions[0]; ++i) {
+          if (positions[i] >= n)
+              continue;
+          std::string bad(str);
+          bad[positions[i]] = bad_chars[i];
+          BOOST_CHECK(boost::from_chars(bad.data(), bad.data() + n, b)
+                      == boost::bitset_parse_invalid_char);
+          BOOST_CHECK(b.empty());
+      }
+  }
+
+  // every parse kernel supported by the processor must read the
+  // 64-character groups at the end of str as a character by character
+  // loop does, and reject them if one of the characters is bad
+  // PRE: str is all '0' and '1'
+  static void parse_kernels(const std::string& str)
+  {
+      using namespace boost::detail::dynamic_bitset_impl;
+
+      const std::size_t m = str.size() / 64;
+      if (m == 0)
+          return;
+      const std::size_t first = str.size() - 64 * m;
+      std::vector<boost::uint64_t> expected(m + 1, UINT64_C(0x5a5a5a5a5a5a5a5a));
+      for (std::size_t k = 0; k < m; ++k) {
+          expected[k] = 0;
+          for (std::size_t j = 0; j < 64; ++j)
+              if (str[str.size() - 1 - 64 * k - j] == '1')
+                  expected[k] |= boost::uint64_t(1) << j;
+      }
+
+      // at both ends of the first, a middle and the last group
+      const std::size_t positions[] = { first, first + 63, first + 64 * (m / 2),
+                                        str.size() - 64, str.size() - 65,
+                                        str.size() - 2, str.size() - 1 };
+      const char bad_chars[] = { '2', '/', ' ', 'q', '\xb0', '\xb1', '\0' };
+
+      const std::vector<simd_level> levels = available_simd_levels();
+      for (std::size_t l = 0; l < levels.size(); ++l) {
+          const parse_function f = parse_kernel_function(levels[l]);
+          std::vector<boost::uint64_t> out(m + 1, UINT64_C(0x5a5a5a5a5a5a5a5a));
+          BOOST_CHECK(f(str.data() + str.size(), m, &out[0]));
+          BOOST_CHECK(out == expected);
+
+          for (std::size_t i = 0; i < sizeof positions / sizeof positions[0]; ++i) {
+              if (positions[i] < first || positions[i] >= str.size())
+                  continue;
+              std::string bad(str);
+              bad[positions[i]] = bad_chars[i];
+              BOOST_CHECK(!f(bad.data() + bad.size(), m, &out[0]));
+          }
+      }
+  }
+
+  // hash_value(), std::hash and dynamic_bitset_hasher agree, and
+  // don't depend on the block type
+  static void hash(const Bitset& b)
+  {
+      typedef typename Bitset::block_type Block;
+      const std::size_t h = hash_value(b);
+      BOOST_CHECK(boost::hash<Bitset>()(b) == h);
+#if !defined(BOOST_NO_CXX11_HDR_FUNCTIONAL)
+      BOOST_CHECK(std::hash<Bitset>()(b) == h);
+#endif
+
+      std::string str;
+      boost::to_string(b, str);
+      BOOST_CHECK(hash_value(boost::dynamic_bitset<unsigned char>(str)) == h);
+      BOOST_CHECK(hash_value(boost::dynamic_bitset<unsigned long>(str)) == h);
+
+      boost::dynamic_bitset_hasher<Block> bits;
+      for (std::size_t i = 0; i < b.size(); ++i)
+          bits.push_back(b[i]);
+      BOOST_CHECK(bits.size() == b.size());
+      BOOST_CHECK(bits.value() == h);
+
+      // whole blocks, then the extra bits
+      std::vector<Block> blocks;
+      boost::to_block_range(b, std::back_inserter(blocks));
+      const std::size_t whole = b.size() / Bitset::bits_per_block;
+      boost::dynamic_bitset_hasher<Block> by_blocks;
+      by_blocks.append(blocks.begin(), blocks.begin() + whole);
+      for (std::size_t i = whole * Bitset::bits_per_block; i < b.size(); ++i)
+          by_blocks.push_back(b[i]);
+      BOOST_CHECK(by_blocks.value() == h);
+
+      // from b, and growing with it
+      Bitset c(b);
+      boost::dynamic_bitset_hasher<Block> from_b(c);
+      BOOST_CHECK(from_b.value() == h);
+      for (std::size_t i = 0; i < 70; ++i) {
+          const bool bit = (i * 7) % 3 == 0;
+          c.push_back(bit);
+          from_b.push_back(bit);
+      }
+      BOOST_CHECK(from_b.value() == hash_value(c));
+      c.append(Block(0x5a));
+      from_b.append(Block(0x5a));
+      BOOST_CHECK(from_b.value() == hash_value(c));
+
+      // a flipped bit, an extra bit
+      if (b.size() != 0) {
+          Bitset d(b);
+          d.flip(d.size() - 1);
+          BOOST_CHECK(hash_value(d) != h);
+          if (b.size() > 1) {
+              d.flip(0);
+              BOOST_CHECK(hash_value(d) != h);
+          }
+      }
+      Bitset e(b);
+      e.push_back(false);
+      BOOST_CHECK(hash_value(e) != h);
+  }
+
+  // to_hex_string() and from_hex(): four bits per digit, the most
+  // significant first
+  static void hex(const Bitset& b)
+  {
+      const std::size_t n = b.size();
+      std::string s;
+      boost::to_hex_string(b, s);
+      BOOST_CHECK(s.size() == (n + 3) / 4);
+      for (std::size_t i = 0; i < s.size(); ++i) {
+          unsigned long v = 0;
+          for (std::size_t j = 4; j-- > 0; ) {
+              const std::size_t pos = 4 * (s.size() - 1 - i) + j;
+              v = 2 * v + (pos < n && b[pos]);
+          }
+          BOOST_CHECK(s[i] == "0123456789abcdef"[v]);
+      }
+
+      Bitset c(std::string("1"));
+      BOOST_CHECK(boost::from_hex(s.data(), s.data() + s.size(), c, n) == boost::bitset_parse_ok);
+      BOOST_CHECK(c == b);
+      BOOST_CHECK(boost::from_hex(s.data(), s.data() + s.size(), c) == boost::bitset_parse_ok);
+      BOOST_CHECK(c.size() == 4 * s.size());
+      c.resize(n);
+      BOOST_CHECK(c == b);
+
+      std::string upper(s);
+      for (std::size_t i = 0; i < upper.size(); ++i)
+          if (upper[i] >= 'a')
+              upper[i] = static_cast<char>(upper[i] - 'a' + 'A');
+      BOOST_CHECK(boost::from_hex(upper.data(), upper.data() + upper.size(), c, n)
+                  == boost::bitset_parse_ok);
+      BOOST_CHECK(c == b);
+
+#if !defined(BOOST_NO_CXX17_HDR_STRING_VIEW)
+      BOOST_CHECK(boost::from_hex(std::string_view(s), c, n) == boost::bitset_parse_ok);
+      BOOST_CHECK(c == b);
+#endif
+
+      // at both ends and around the 16-digit groups of the kernels
+      const std::size_t m = s.size();
+      const std::size_t positions[] = { 0, 1, m / 2, m - 16, m - 17, m - 2, m - 1 };
+      const char bad_chars[] = { 'g', '/', ' ', ':', '\xb0', 'G', '@' };
+      for (std::size_t i = 0; i < sizeof positions / sizeof positions[0]; ++i) {
+          if (positions[i] >= m)
+              continue;
+          std::string bad(s);
+          bad[positions[i]] = bad_chars[i];
+          BOOST_CHECK(boost::from_hex(bad.data(), bad.data() + m, c)
+                      == boost::bitset_parse_invalid_char);
+          BOOST_CHECK(c.empty());
+      }
+
+      // a set bit beyond num_bits
+      if (n != 0 && b.test(n - 1)) {
+          BOOST_CHECK(boost::from_hex(s.data(), s.data() + m, c, n - 1)
+                      == boost::bitset_parse_out_of_range);
+          BOOST_CHECK(c.empty());
+      }
+  }
+
+  // to_base64() and from_base64(): the bytes of b, the least
+  // significant first
+  static void base64(const Bitset& b)
+  {
+      const char alphabet[] =
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+      const std::size_t n = b.size();
+      std::vector<unsigned char> bytes((n + 7) / 8);
+      for (std::size_t i = 0; i < n; ++i)
+          if (b[i])
+              bytes[i / 8] |= static_cast<unsigned char>(1u << (i % 8));
+      std::string expected;
+      for (std::size_t i = 0; i < bytes.size(); i += 3) {
+          unsigned long v = static_cast<unsigned long>(bytes[i]) << 16;
+          if (i + 1 < bytes.size())
+              v |= static_cast<unsigned long>(bytes[i + 1]) << 8;
+          if (i + 2 < bytes.size())
+              v |= bytes[i + 2];
+          expected += alphabet[v >> 18];
+          expected += alphabet[(v >> 12) & 63];
+          expected += i + 1 < bytes.size() ? alphabet[(v >> 6) & 63] : '=';
+          expected += i + 2 < bytes.size() ? alphabet[v & 63] : '=';
+      }
+
+      std::string s;
+      boost::to_base64(b, s);
+      BOOST_CHECK(s == expected);
+
+      Bitset c(std::string("1"));
+      BOOST_CHECK(boost::from_base64(s.data(), s.data() + s.size(), c, n) == boost::bitset_parse_ok);
+      BOOST_CHECK(c == b);
+      BOOST_CHECK(boost::from_base64(s.data(), s.data() + s.size(), c) == boost::bitset_parse_ok);
+      BOOST_CHECK(c.size() == 8 * bytes.size());
+      c.resize(n);
+      BOOST_CHECK(c == b);
+
+#if !defined(BOOST_NO_CXX17_HDR_STRING_VIEW)
+      BOOST_CHECK(boost::from_base64(std::string_view(s), c, n) == boost::bitset_parse_ok);
+      BOOST_CHECK(c == b);
+#endif
+
+      // at both ends and around the 16-character groups of the kernels
+      const std::size_t m = s.size();
+      const std::size_t positions[] = { 0, 1, m / 2, m - 16, m - 17, m - 5, m - 4 };
+      const char bad_chars[] = { '=', '-', ' ', '_', '\xb0', '.', '=' };
+      for (std::size_t i = 0; i < sizeof positions / sizeof positions[0]; ++i) {
+          if (positions[i] >= m)
+              continue;
+          std::string bad(s);
+          bad[positions[i]] = bad_chars[i];
+          BOOST_CHECK(boost::from_base64(bad.data(), bad.data() + m, c)
+                      == boost::bitset_parse_invalid_char);
+          BOOST_CHECK(c.empty());
+      }
+      if (m != 0) {
+          BOOST_CHECK(boost::from_base64(s.data(), s.data() + m - 1, c)
+                      == boost::bitset_parse_invalid_char);
+          BOOST_CHECK(c.empty());
+      }
+
+      // a set bit beyond num_bits
+      if (n != 0 && b.test(n - 1)) {
+          BOOST_CHECK(boost::from_base64(s.data(), s.data() + m, c, n - 1)
+                      == boost::bitset_parse_out_of_range);
+          BOOST_CHECK(c.empty());
+      }
+  }
+
+  // every hexadecimal kernel supported by the processor must encode
+  // the whole 64-bit words of b as a digit by digit loop does, decode
+  // them back from lowercase and uppercase digits, and reject a
+  // character which is not a digit
+  static void hex_kernels(const Bitset& b)
+  {
+      using namespace boost::detail::dynamic_bitset_impl;
+
+      const std::size_t m = b.size() / 64;
+      if (m == 0)
+          return;
+      std::vector<Block> blocks(b.num_blocks());
+      boost::to_block_range(b, blocks.begin());
+      std::vector<boost::uint64_t> words(m + 1, UINT64_C(0x5a5a5a5a5a5a5a5a));
+      for (std::size_t k = 0; k < m; ++k)
+          words[k] = load_bits64(&blocks[0], blocks.size(), k);
+
+      // with a guard character on each side
+      std::string expected(16 * m + 2, '*');
+      for (std::size_t k = 0; k < m; ++k)
+          for (std::size_t d = 0; d < 16; ++d)
+              expected[16 * (m - k) - d] = "0123456789abcdef"[(words[k] >> (4 * d)) & 15];
+      std::string upper(expected);
+      for (std::size_t i = 0; i < upper.size(); ++i)
+          if (upper[i] >= 'a')
+              upper[i] = static_cast<char>(upper[i] - 'a' + 'A');
+
+      const std::size_t last = 16 * m + 1;
+      const std::size_t positions[] = { 1, 2, 8 * m, last - 16, last - 17, last - 2, last - 1 };
+      const char bad_chars[] = { 'g', '/', ' ', ':', '\xb0', 'G', '@' };
+
+      const std::vector<simd_level> levels = available_simd_levels();
+      for (std::size_t l = 0; l < levels.size(); ++l) {
+          std::string s(16 * m + 2, '*');
+          hex_encode_kernel_function(levels[l])(&words[0], m, &s[0] + last);
+          BOOST_CHECK(s == expected);
+
+          const hex_decode_function decode = hex_decode_kernel_function(levels[l]);
+          std::vector<boost::uint64_t> out(m + 1, UINT64_C(0x5a5a5a5a5a5a5a5a));
+          BOOST_CHECK(decode(expected.data() + last, m, &out[0]));
+          BOOST_CHECK(out == words);
+          std::fill(out.begin(), out.end(), UINT64_C(0x5a5a5a5a5a5a5a5a));
+          BOOST_CHECK(decode(upper.data() + last, m, &out[0]));
+          BOOST_CHECK(out == words);
+
+          for (std::size_t i = 0; i < sizeof positions / sizeof positions[0]; ++i) {
+              if (positions[i] < 1 || positions[i] >= last)
+                  continue;
+              std::string bad(expected);
+              bad[positions[i]] = bad_chars[i];
+              BOOST_CHECK(!decode(bad.data() + last, m, &out[0]));
+          }
+      }
+  }
+
+  // every base64 kernel supported by the processor must encode the
+  // bytes of b, as many as make whole groups of three, as a byte by
+  // byte loop does, decode them back, and reject a character which is
+  // not in the alphabet
+  static void base64_kernels(const Bitset& b)
+  {
+      using namespace boost::detail::dynamic_bitset_impl;
+
+      const char alphabet[] =
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+      std::vector<byte_type> bytes(b.size() / 8 / 3 * 3);
+      if (bytes.empty())
+          return;
+      for (std::size_t i = 0; i < 8 * bytes.size(); ++i)
+          if (b[i])
+              bytes[i / 8] |= static_cast<byte_type>(1u << (i % 8));
+      std::string expected;
+      for (std::size_t i = 0; i < bytes.size(); i += 3) {
+          const unsigned long v = (static_cast<unsigned long>(bytes[i]) << 16)
+                                | (static_cast<unsigned long>(bytes[i + 1]) << 8)
+                                | bytes[i + 2];
+          expected += alphabet[v >> 18];
+          expected += alphabet[(v >> 12) & 63];
+          expected += alphabet[(v >> 6) & 63];
+          expected += alphabet[v & 63];
+      }
+
+      const std::size_t m = expected.size();
+      const std::size_t positions[] = { 0, 1, m / 2, m - 16, m - 17, m - 5, m - 1 };
+      const char bad_chars[] = { '=', '-', ' ', '_', '\xb0', '.', '=' };
+
+      const std::vector<simd_level> levels = available_simd_levels();
+      for (std::size_t l = 0; l < levels.size(); ++l) {
+          // with a guard character on each side
+          std::string s(m + 2, '*');
+          base64_encode_kernel_function(levels[l])(&bytes[0], bytes.size(), &s[1]);
+          BOOST_CHECK(s == '*' + expected + '*');
+
+          const base64_decode_function decode = base64_decode_kernel_function(levels[l]);
+          std::vector<byte_type> out(bytes.size() + base64_slack);
+          BOOST_CHECK(decode(expected.data(), m, &out[0]));
+          BOOST_CHECK(std::equal(bytes.begin(), bytes.end(), out.begin()));
+
+          for (std::size_t i = 0; i < sizeof positions / sizeof positions[0]; ++i) {
+              if (positions[i] >= m)
+                  continue;
+              std::string bad(expected);
+              bad[positions[i]] = bad_chars[i];
+              BOOST_CHECK(!decode(bad.data(), m, &out[0]));
+          }
+      }
+  }
+
   static void to_block_range(const Bitset & b /*, BlockOutputIterator result*/)
   {
     typedef typename Bitset::size_type size_type;
@@ -282,6 +732,38 @@ struct bitset_test {
     }
   }
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+  // move constructor (absent from std::bitset)
+  static void move_constructor(const Bitset& b)
+  {
+    Bitset copy(b);
+    Bitset moved(std::move(copy));
+    BOOST_CHECK(moved == b);
+
+    // the source is left empty, and usable
+    BOOST_CHECK(copy.size() == 0);
+    BOOST_CHECK(copy.num_blocks() == 0);
+    copy.push_back(true);
+    BOOST_CHECK(copy.size() == 1 && copy[0]);
+  }
+
+  // move assignment operator (absent from std::bitset)
+  static void move_assignment_operator(const Bitset& lhs, const Bitset& rhs)
+  {
+    Bitset b(lhs);
+    Bitset copy(rhs);
+    b = std::move(copy);
+    BOOST_CHECK(b == rhs);
+    BOOST_CHECK(copy.size() == 0);
+    BOOST_CHECK(copy.num_blocks() == 0);
+
+    // self move-assignment leaves the object unchanged
+    Bitset& alias = b;
+    b = std::move(alias);
+    BOOST_CHECK(b == rhs);
+  }
+#endif
+
   static void swap(const Bitset& lhs, const Bitset& rhs)
   {
     // bitsets must be swapped
@@ -356,6 +838,37 @@ struct bitset_test {
       BOOST_CHECK(b[j] == lhs[j]);
   }
 
+  static void reserve(const Bitset& lhs)
+  {
+    typedef typename Bitset::size_type size_type;
+
+    Bitset b(lhs);
+    const size_type n = lhs.size() + 3 * bits_per_block + 1;
+    b.reserve(n);
+    BOOST_CHECK(b == lhs);
+    BOOST_CHECK(b.capacity() >= n);
+
+    // push_back() within the capacity
+    const size_type cap = b.capacity();
+    size_type ones = lhs.count();
+    while (b.size() < n) {
+      const bool bit = b.size() % 5 == 0;
+      ones += bit;
+      b.push_back(bit);
+    }
+    BOOST_CHECK(b.capacity() == cap);
+    BOOST_CHECK(b.count() == ones);
+    for (size_type i = 0; i < n; ++i)
+      BOOST_CHECK(b[i] == (i < lhs.size() ? lhs[i] : i % 5 == 0));
+
+    // shrink_to_fit() gives memory back, not bits
+    b.resize(lhs.size());
+    b.shrink_to_fit();
+    BOOST_CHECK(b == lhs);
+    BOOST_CHECK(b.capacity() >= b.size());
+    BOOST_CHECK(b.capacity() < n);
+  }
+
   static void append_block(const Bitset& lhs)
   {
     Bitset b(lhs);
@@ -376,6 +889,74 @@ struct bitset_test {
     BOOST_CHECK(b == c);
   }
 
+  // growing past the inline blocks of a dynamic_bitset_small_buffer, or
+  // the capacity of a dynamic_bitset_compact_buffer, and shrinking back
+  // must give the same blocks as std::vector storage
+  static void block_storage(const Bitset& lhs)
+  {
+    typedef boost::dynamic_bitset<Block> reference_bitset;
+
+    Bitset b(lhs);
+    reference_bitset r(lhs.size());
+    for (std::size_t i = 0; i < lhs.size(); ++i)
+      r[i] = lhs[i];
+
+    for (std::size_t i = 0; i < 3 * bits_per_block + 1; ++i) {
+      b.push_back(i % 3 == 0);
+      r.push_back(i % 3 == 0);
+      std::vector<Block> vb, vr;
+      boost::to_block_range(b, std::back_inserter(vb));
+      boost::to_block_range(r, std::back_inserter(vr));
+      BOOST_CHECK(vb == vr);
+      BOOST_CHECK(b.count() == r.count());
+    }
+    b.resize(lhs.size());
+    BOOST_CHECK(b == lhs);
+
+    // copies, moves and swaps between inline and allocated storage
+    Bitset big(lhs);
+    big.resize(lhs.size() + 4 * bits_per_block, true);
+    Bitset s1(lhs), s2(big);
+    s1.swap(s2);
+    BOOST_CHECK(s1 == big && s2 == lhs);
+    s1.swap(s2);
+    BOOST_CHECK(s1 == lhs && s2 == big);
+    s1 = big;
+    BOOST_CHECK(s1 == big);
+    s1 = lhs;
+    BOOST_CHECK(s1 == lhs);
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    Bitset m1(big), m2(lhs);
+    Bitset moved1(std::move(m1)), moved2(std::move(m2));
+    BOOST_CHECK(moved1 == big && moved2 == lhs);
+    BOOST_CHECK(m1.size() == 0 && m2.size() == 0);
+    m1 = std::move(moved2);
+    m2 = std::move(moved1);
+    BOOST_CHECK(m1 == lhs && m2 == big);
+    m1.push_back(true);
+    BOOST_CHECK(m1.size() == lhs.size() + 1 && m1[lhs.size()]);
+#endif
+  }
+
+  // conversions through block ranges to and from the default storage
+  static void block_range_interoperation(const Bitset& b)
+  {
+    typedef boost::dynamic_bitset<Block> other_bitset;
+
+    std::vector<Block> blocks;
+    boost::to_block_range(b, std::back_inserter(blocks));
+    other_bitset other(blocks.begin(), blocks.end());
+    other.resize(b.size());
+    for (std::size_t i = 0; i < b.size(); ++i)
+      BOOST_CHECK(other[i] == b[i]);
+
+    Bitset back(b.size());
+    blocks.clear();
+    boost::to_block_range(other, std::back_inserter(blocks));
+    boost::from_block_range(blocks.begin(), blocks.end(), back);
+    BOOST_CHECK(back == b);
+  }
+
   // operator[] and reference members
   // PRE: b[i] == bit_vec[i]
   static void operator_bracket(const Bitset& lhs, const std::vector<bool>& bit_vec)
@@ -451,6 +1032,246 @@ struct bitset_test {
         BOOST_CHECK(lhs[I] == prev[I]);
   }
 
+  // every vector level supported by the processor must give the
+  // same result as a block by block loop
+  // PRE: b.size() == rhs.size()
+  static void bitwise_kernels(const Bitset& b, const Bitset& rhs)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    const std::size_t n = b.num_blocks();
+    std::vector<Block> lhs_blocks(n + 1), rhs_blocks(n + 1);
+    boost::to_block_range(b, lhs_blocks.begin());
+    boost::to_block_range(rhs, rhs_blocks.begin());
+
+    const std::vector<simd_level> levels = available_simd_levels();
+    for (std::size_t l = 0; l < levels.size(); ++l) {
+      check_bitwise_kernel<op_and>(levels[l], lhs_blocks, rhs_blocks, n);
+      check_bitwise_kernel<op_or> (levels[l], lhs_blocks, rhs_blocks, n);
+      check_bitwise_kernel<op_xor>(levels[l], lhs_blocks, rhs_blocks, n);
+      check_bitwise_kernel<op_sub>(levels[l], lhs_blocks, rhs_blocks, n);
+      check_bitwise_kernel<op_rsub>(levels[l], lhs_blocks, rhs_blocks, n);
+      check_bitwise_kernel<op_not>(levels[l], lhs_blocks, rhs_blocks, n);
+    }
+  }
+
+  template <int Op>
+  static void check_bitwise_kernel(boost::detail::dynamic_bitset_impl::simd_level l,
+                                   const std::vector<Block>& lhs,
+                                   const std::vector<Block>& rhs,
+                                   std::size_t n)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    // the extra block past n acts as a sentinel
+    std::vector<Block> expected(lhs), actual(lhs);
+    for (std::size_t i = 0; i < n; ++i)
+      expected[i] = apply_bitwise<Op>(lhs[i], rhs[i]);
+    bitwise_kernel_function<Op>(l)(mutable_object_representation(&actual[0]),
+                                   object_representation(&rhs[0]),
+                                   n * sizeof(Block));
+    BOOST_CHECK(actual == expected);
+  }
+
+  // every shift kernel supported by the processor must give the same
+  // result as a block by block loop, for each operation, in both
+  // directions, for shifts by whole bytes and by odd bits, and with
+  // d == s
+  // PRE: b.size() == rhs.size()
+  static void shift_kernels(const Bitset& b, const Bitset& rhs)
+  {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+    // (the kernels number the bits of the bytes as on x86)
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    const std::size_t n = b.num_blocks();
+    if (n == 0)
+      return;
+    // the extra block past n acts as a sentinel
+    std::vector<Block> lhs_blocks(n + 1, Block(0x5a)), rhs_blocks(n + 1, Block(0xa5));
+    boost::to_block_range(b, lhs_blocks.begin());
+    boost::to_block_range(rhs, rhs_blocks.begin());
+
+    const std::size_t bits = n * Bitset::bits_per_block;
+    const std::size_t shifts[] = { 0, 1, 7, 8, 9, 63, 64, 65, 257, 512,
+                                   bits / 2, bits / 2 + 3, bits - 8, bits - 1, bits };
+    const std::vector<simd_level> levels = available_simd_levels();
+    for (std::size_t l = 0; l < levels.size(); ++l) {
+      for (std::size_t i = 0; i < sizeof shifts / sizeof shifts[0]; ++i) {
+        const std::size_t k = shifts[i];
+        if (k > bits)
+          continue;
+        check_shift_kernel<op_copy, true> (levels[l], lhs_blocks, rhs_blocks, n, k);
+        check_shift_kernel<op_copy, false>(levels[l], lhs_blocks, rhs_blocks, n, k);
+        check_shift_kernel<op_and, true>  (levels[l], lhs_blocks, rhs_blocks, n, k);
+        check_shift_kernel<op_and, false> (levels[l], lhs_blocks, rhs_blocks, n, k);
+        check_shift_kernel<op_or, true>   (levels[l], lhs_blocks, rhs_blocks, n, k);
+        check_shift_kernel<op_or, false>  (levels[l], lhs_blocks, rhs_blocks, n, k);
+        check_shift_kernel<op_xor, true>  (levels[l], lhs_blocks, rhs_blocks, n, k);
+        check_shift_kernel<op_xor, false> (levels[l], lhs_blocks, rhs_blocks, n, k);
+        check_shift_kernel<op_sub, true>  (levels[l], lhs_blocks, rhs_blocks, n, k);
+        check_shift_kernel<op_sub, false> (levels[l], lhs_blocks, rhs_blocks, n, k);
+      }
+    }
+#else
+    (void)b;
+    (void)rhs;
+#endif
+  }
+
+  // d = d op (s shifted by k) over n blocks, a block at a time
+  template <int Op, bool Left>
+  static void shift_blocks(std::vector<Block>& d, const std::vector<Block>& s,
+                           std::size_t n, std::size_t k)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    const std::size_t bits_per_block = Bitset::bits_per_block;
+    const std::size_t div = k / bits_per_block;
+    const unsigned r = static_cast<unsigned>(k % bits_per_block);
+    for (std::size_t j = 0; j < n; ++j) {
+      const std::size_t i = Left ? n - 1 - j : j;
+      Block t = 0;
+      if (Left) {
+        if (i >= div)
+          t = static_cast<Block>(s[i - div] << r);
+        if (r != 0 && i >= div + 1)
+          t |= static_cast<Block>(s[i - div - 1] >> (bits_per_block - r));
+      }
+      else {
+        if (i + div < n)
+          t = static_cast<Block>(s[i + div] >> r);
+        if (r != 0 && i + div + 1 < n)
+          t |= static_cast<Block>(s[i + div + 1] << (bits_per_block - r));
+      }
+      d[i] = apply_bitwise<Op>(d[i], t);
+    }
+  }
+
+  template <int Op, bool Left>
+  static void check_shift_kernel(boost::detail::dynamic_bitset_impl::simd_level l,
+                                 const std::vector<Block>& lhs,
+                                 const std::vector<Block>& rhs,
+                                 std::size_t n, std::size_t k)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    const shift_function f = shift_kernel_function<Op, Left>(l);
+    const std::size_t q = k / 8;
+    const unsigned r = static_cast<unsigned>(k % 8);
+
+    std::vector<Block> expected(lhs), actual(lhs);
+    shift_blocks<Op, Left>(expected, rhs, n, k);
+    f(mutable_object_representation(&actual[0]), object_representation(&rhs[0]),
+      n * sizeof(Block), q, r);
+    BOOST_CHECK(actual == expected);
+
+    // in place
+    expected = rhs;
+    shift_blocks<Op, Left>(expected, rhs, n, k);
+    actual = rhs;
+    f(mutable_object_representation(&actual[0]), object_representation(&actual[0]),
+      n * sizeof(Block), q, r);
+    BOOST_CHECK(actual == expected);
+  }
+
+  // every scan kernel must find the same first nonzero byte as a
+  // byte by byte loop; then any(), intersects() and find_first()
+  // (which use them) are checked against their definitions
+  // PRE: b.size() == rhs.size()
+  static void scan_kernels(const Bitset& b, const Bitset& rhs)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    const std::size_t n = b.num_blocks();
+    std::vector<Block> lhs_blocks(n + 1), rhs_blocks(n + 1);
+    boost::to_block_range(b, lhs_blocks.begin());
+    boost::to_block_range(rhs, rhs_blocks.begin());
+
+    const std::vector<simd_level> levels = available_simd_levels();
+    for (std::size_t l = 0; l < levels.size(); ++l) {
+      check_scan_kernel<op_id>(levels[l], lhs_blocks, rhs_blocks, n);
+      check_scan_kernel<op_not>(levels[l], lhs_blocks, rhs_blocks, n);
+      check_scan_kernel<op_and>(levels[l], lhs_blocks, rhs_blocks, n);
+    }
+
+    bool have_intersection = false;
+    for (std::size_t i = 0; i < b.size(); ++i)
+      if (b[i] && rhs[i])
+        have_intersection = true;
+    BOOST_CHECK(b.intersects(rhs) == have_intersection);
+    BOOST_CHECK(b.any() == (b.count() != 0));
+    find_first(b);
+    find_first_zero(b);
+  }
+
+  template <int Op>
+  static void check_scan_kernel(boost::detail::dynamic_bitset_impl::simd_level l,
+                                const std::vector<Block>& lhs,
+                                const std::vector<Block>& rhs,
+                                std::size_t n)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    const byte_type * const p = object_representation(&lhs[0]);
+    const byte_type * const q = object_representation(&rhs[0]);
+    const std::size_t len = n * sizeof(Block);
+    std::size_t expected = 0;
+    while (expected < len && apply_bitwise<Op>(p[expected], q[expected]) == 0)
+      ++expected;
+    BOOST_CHECK(scan_kernel_function<Op>(l)(p, q, len) == expected);
+  }
+
+  // every reverse scan kernel supported by the processor must find the
+  // last byte which makes a op b nonzero, wherever it is: a single one
+  // is moved over every offset of buffers of lengths around the vector
+  // widths, so that it lands on both sides of each vector boundary, with
+  // another one below it; the byte past the end is nonzero too
+  static void rscan_kernels()
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    const std::size_t lengths[] = { 0, 1, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65,
+                                    127, 128, 129, 191, 192, 193, 255, 256, 257, 300 };
+    const std::vector<simd_level> levels = available_simd_levels();
+    for (std::size_t l = 0; l < levels.size(); ++l) {
+      for (std::size_t i = 0; i < sizeof lengths / sizeof lengths[0]; ++i) {
+        const std::size_t n = lengths[i];
+        check_rscan_kernel<op_xor>(levels[l], n, n);
+        check_rscan_kernel<op_id>(levels[l], n, n);
+        check_rscan_kernel<op_not>(levels[l], n, n);
+        for (std::size_t pos = 0; pos < n; ++pos) {
+          check_rscan_kernel<op_xor>(levels[l], n, pos);
+          check_rscan_kernel<op_id>(levels[l], n, pos);
+          check_rscan_kernel<op_not>(levels[l], n, pos);
+        }
+      }
+    }
+  }
+
+  // the n bytes at a op b are zero except at pos and pos / 2 (none if
+  // pos == n)
+  template <int Op>
+  static void check_rscan_kernel(boost::detail::dynamic_bitset_impl::simd_level l,
+                                 std::size_t n, std::size_t pos)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    // op_not looks for a byte of a which is not all ones, op_id for
+    // one which is not zero, op_xor for one where a and b differ
+    std::vector<byte_type> a(n + 1), b(n + 1);
+    for (std::size_t k = 0; k < n + 1; ++k) {
+      b[k] = static_cast<byte_type>(k * 37);
+      a[k] = Op == op_xor ? b[k] : Op == op_not ? byte_type(0xff) : byte_type(0);
+    }
+    a[n] = static_cast<byte_type>(a[n] ^ 0x81);
+    if (pos < n) {
+      a[pos] = static_cast<byte_type>(a[pos] ^ 0x10);
+      a[pos / 2] = static_cast<byte_type>(a[pos / 2] ^ 0x01);
+    }
+    BOOST_CHECK(rscan_kernel_function<Op>(l)(&a[0], &b[0], n) == pos);
+  }
+
   // PRE: b.size() == rhs.size()
   static void or_assignment(const Bitset& b, const Bitset& rhs)
   {
@@ -557,6 +1378,30 @@ struct bitset_test {
     }
   }
 
+  // set(pos, len, value), reset(pos, len) and flip(pos, len) must do
+  // what the single bit functions do for each bit in [pos, pos + len)
+  // PRE: pos + len <= b.size()
+  static void range_operations(const Bitset& b, std::size_t pos, std::size_t len)
+  {
+    Bitset set_range(b), reset_range(b), flip_range(b), assign_range(b);
+    Bitset set_bits(b), reset_bits(b), flip_bits(b);
+    set_range.set(pos, len, true);
+    reset_range.reset(pos, len);
+    flip_range.flip(pos, len);
+    assign_range.set(pos, len, false);
+    for (std::size_t i = pos; i < pos + len; ++i) {
+      set_bits.set(i);
+      reset_bits.reset(i);
+      flip_bits.flip(i);
+    }
+    BOOST_CHECK(set_range == set_bits);
+    BOOST_CHECK(reset_range == reset_bits);
+    BOOST_CHECK(flip_range == flip_bits);
+    BOOST_CHECK(assign_range == reset_bits);
+    BOOST_CHECK(set_range.count() == set_bits.count());
+    BOOST_CHECK(flip_range.count() == flip_bits.count());
+  }
+
   static void reset_all(const Bitset& b)
   {
     Bitset lhs(b);
@@ -674,6 +1519,34 @@ struct bitset_test {
       BOOST_CHECK(str[b.size() - 1 - i] ==(b.test(i)? '1':'0'));
   }
 
+  // every format kernel supported by the processor must write the
+  // whole 64-bit words of b as to_string() does, and nothing outside
+  // of them
+  static void format_kernels(const Bitset& b)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    const std::size_t m = b.size() / 64;
+    if (m == 0)
+      return;
+    std::vector<Block> blocks(b.num_blocks());
+    boost::to_block_range(b, blocks.begin());
+    std::vector<boost::uint64_t> words(m);
+    for (std::size_t k = 0; k < m; ++k)
+      words[k] = load_bits64(&blocks[0], blocks.size(), k);
+
+    std::string expected(64 * m + 2, '*');
+    for (std::size_t i = 0; i < 64 * m; ++i)
+      expected[64 * m - i] = b[i] ? '1' : '0';
+
+    const std::vector<simd_level> levels = available_simd_levels();
+    for (std::size_t l = 0; l < levels.size(); ++l) {
+      std::string out(64 * m + 2, '*');
+      format_kernel_function(levels[l])(&words[0], m, &out[0] + 64 * m + 1);
+      BOOST_CHECK(out == expected);
+    }
+  }
+
   static void count(const Bitset& b)
   {
     std::size_t c = b.count();
@@ -684,6 +1557,86 @@ struct bitset_test {
     BOOST_CHECK(c == actual);
   }
 
+  // every count kernel supported by the processor must agree with count()
+  static void count_kernels(const Bitset& b)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    std::vector<Block> blocks(b.num_blocks() + 1);
+    boost::to_block_range(b, blocks.begin());
+    const byte_type * p = object_representation(&blocks[0]);
+    const std::size_t len = b.num_blocks() * sizeof(Block);
+
+    const std::vector<count_kernel> kernels = available_count_kernels();
+    for (std::size_t k = 0; k < kernels.size(); ++k)
+      BOOST_CHECK(count_kernel_function(kernels[k])(p, len) == b.count());
+  }
+
+  // a and b have the same size
+  static void fused_counts(const Bitset& a, const Bitset& b)
+  {
+    typedef typename Bitset::size_type size_type;
+
+    Bitset x(a);
+    x &= b;
+    BOOST_CHECK(intersection_count(a, b) == x.count());
+    BOOST_CHECK((a & b).count() == x.count());
+    x = a;
+    x |= b;
+    BOOST_CHECK(union_count(a, b) == x.count());
+    x = a;
+    x -= b;
+    BOOST_CHECK(difference_count(a, b) == x.count());
+    BOOST_CHECK((a & ~b).count() == x.count());
+    x = a;
+    x ^= b;
+    BOOST_CHECK(hamming_distance(a, b) == x.count());
+    BOOST_CHECK(hamming_distance(a, a) == 0);
+
+    const size_type c = a.count();
+    const size_type ic = intersection_count(a, b);
+    const size_type ks[] = { 0, 1, c / 2, c, c + 1, ic, ic + 1,
+                             a.size(), a.size() + 1 };
+    for (std::size_t i = 0; i < sizeof ks / sizeof ks[0]; ++i) {
+      BOOST_CHECK(a.count_at_least(ks[i]) == (c >= ks[i]));
+      BOOST_CHECK(a.intersection_count_at_least(b, ks[i]) == (ic >= ks[i]));
+      BOOST_CHECK((a ^ ~b).count_at_least(ks[i]) == ((a ^ ~b).count() >= ks[i]));
+    }
+  }
+
+  template <int Op>
+  static void check_count2_kernel(const unsigned char * p, const unsigned char * q,
+                                  std::size_t len, std::size_t expected)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    const std::vector<count_kernel> kernels = available_count_kernels();
+    for (std::size_t k = 0; k < kernels.size(); ++k)
+      BOOST_CHECK(count2_kernel_function<Op>(kernels[k])(p, q, len) == expected);
+  }
+
+  // the binary count kernels, at every level the processor supports
+  static void count2_kernels(const Bitset& a, const Bitset& b)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    std::vector<Block> blocks_a(a.num_blocks() + 1), blocks_b(b.num_blocks() + 1);
+    boost::to_block_range(a, blocks_a.begin());
+    boost::to_block_range(b, blocks_b.begin());
+    const byte_type * p = object_representation(&blocks_a[0]);
+    const byte_type * q = object_representation(&blocks_b[0]);
+    const std::size_t len = a.num_blocks() * sizeof(Block);
+
+    Bitset x(a);
+    check_count2_kernel<op_and>(p, q, len, (x &= b).count());
+    x = a;
+    check_count2_kernel<op_or>(p, q, len, (x |= b).count());
+    x = a;
+    check_count2_kernel<op_xor>(p, q, len, (x ^= b).count());
+    x = a;
+    check_count2_kernel<op_sub>(p, q, len, (x -= b).count());
+  }
+
   static void size(const Bitset& b)
   {
     BOOST_CHECK(Bitset(b).set().count() == b.size());
@@ -804,6 +1757,652 @@ struct bitset_test {
     BOOST_CHECK(next_bit_on(b, prev) == b.find_next(prev));
   }
 
+  static void find_last(const Bitset& b)
+  {
+      // find last non-null bit, if any
+      typename Bitset::size_type i = b.size();
+      while (i > 0 && b[i - 1] == 0)
+          --i;
+
+      if (i == 0)
+        BOOST_CHECK(b.find_last() == Bitset::npos); // not found;
+      else {
+        BOOST_CHECK(b.find_last() == i - 1);
+        BOOST_CHECK(b.test(i - 1) == true);
+      }
+
+  }
+
+  static void find_prev(const Bitset& b, typename Bitset::size_type pos)
+  {
+      // last bit on before pos; all of them if pos is past the end
+      typename Bitset::size_type i = (std::min)(pos, b.size());
+      while (i > 0 && b[i - 1] == 0)
+          --i;
+
+      BOOST_CHECK(b.find_prev(pos) == (i == 0 ? Bitset::npos : i - 1));
+  }
+
+  static void find_first_zero(const Bitset& b)
+  {
+      typename Bitset::size_type i = 0;
+      while (i < b.size() && b[i] == 1)
+          ++i;
+
+      BOOST_CHECK(b.find_first_zero() == (i == b.size() ? Bitset::npos : i));
+  }
+
+  static void find_next_zero(const Bitset& b, typename Bitset::size_type prev)
+  {
+      typename Bitset::size_type i = prev == Bitset::npos ? b.size() : prev + 1;
+      while (i < b.size() && b[i] == 1)
+          ++i;
+
+      BOOST_CHECK(b.find_next_zero(prev) == (i >= b.size() ? Bitset::npos : i));
+  }
+
+  // set_bits() and decode_set_bits() give the positions found by a
+  // find_first()/find_next() walk; so does every decode kernel
+  static void set_bits(const Bitset& b)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+    typedef typename Bitset::set_bit_iterator iterator;
+
+    std::vector<std::size_t> expected;
+    for (std::size_t i = b.find_first(); i != Bitset::npos; i = b.find_next(i))
+      expected.push_back(i);
+
+    const typename Bitset::set_bit_range r = b.set_bits();
+    BOOST_CHECK(std::vector<std::size_t>(r.begin(), r.end()) == expected);
+    BOOST_CHECK(static_cast<std::size_t>(std::distance(r.begin(), r.end()))
+                == b.count());
+    BOOST_CHECK(r.empty() == b.none());
+    iterator it = r.begin();
+    for (std::size_t k = 0; k < expected.size(); ++k)
+      BOOST_CHECK(*it++ == expected[k]);
+    BOOST_CHECK(it == r.end());
+
+    std::vector<boost::uint32_t> out(expected.size() + 1, 0xdeadbeef);
+    BOOST_CHECK(b.decode_set_bits(&out[0]) == expected.size());
+    BOOST_CHECK(std::equal(expected.begin(), expected.end(), out.begin()));
+    BOOST_CHECK(out.back() == 0xdeadbeef);
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+    // (the kernels number the bits of the bytes as on x86)
+    if (b.num_blocks() == 0)
+      return;
+    std::vector<Block> blocks(b.num_blocks());
+    boost::to_block_range(b, blocks.begin());
+    const byte_type * const p = object_representation(&blocks[0]);
+    const std::vector<simd_level> levels = available_simd_levels();
+    for (std::size_t l = 0; l < levels.size(); ++l) {
+      std::fill(out.begin(), out.end(), 0xdeadbeef);
+      boost::uint32_t * const last = decode_kernel_function(levels[l])(
+          p, blocks.size() * sizeof(Block), 0, &out[0], &out[0] + expected.size());
+      BOOST_CHECK(last == &out[0] + expected.size());
+      BOOST_CHECK(std::equal(expected.begin(), expected.end(), out.begin()));
+      BOOST_CHECK(out.back() == 0xdeadbeef);
+    }
+#endif
+  }
+
+  // rank() and select() against a scan of the bits; then the bits
+  // from pos onwards change, the size grows, and update(pos) follows
+  template <typename A>
+  static void rank_select(const boost::dynamic_bitset<Block, A>& b, std::size_t pos)
+  {
+    boost::dynamic_bitset<Block, A> c(b);
+    boost::rank_select_index<Block, A> index(c);
+    check_rank_select(c, index);
+    // 64 bits per 2048, 32 per 8192 set bits, and the first entries
+    BOOST_CHECK(index.memory_usage() * CHAR_BIT
+                <= c.size() / 32 + c.size() / 256 + 4 * 64);
+
+    c.flip(pos, c.size() - pos);
+    index.update(pos);
+    check_rank_select(c, index);
+
+    c.resize(c.size() + 3000, true);
+    c.reset(c.size() - 1000, 500);
+    index.update(pos);
+    check_rank_select(c, index);
+
+    c.resize(pos);
+    index.update(pos);
+    check_rank_select(c, index);
+  }
+
+  template <typename A>
+  static void check_rank_select(const boost::dynamic_bitset<Block, A>& b,
+                                const boost::rank_select_index<Block, A>& index)
+  {
+    std::size_t ones = 0;
+    for (std::size_t i = 0; i < b.size(); ++i) {
+      BOOST_CHECK(index.rank(i) == ones);
+      if (b[i]) {
+        BOOST_CHECK(index.select(ones) == i);
+        ++ones;
+      }
+    }
+    BOOST_CHECK(index.rank(b.size()) == ones);
+    BOOST_CHECK(index.count() == ones);
+    BOOST_CHECK(index.select(ones) == index.npos);
+  }
+
+  // hierarchical_bitset against dynamic_bitset: lookups and the
+  // bitwise operators, then set() and reset() until a is empty, and
+  // resize()
+  static void hierarchical(const Bitset& a, const Bitset& b)
+  {
+    typedef boost::hierarchical_bitset<Block> hbitset;
+
+    const hbitset ha(a), hb(b);
+    check_hierarchical(a, ha);
+    check_hierarchical(b, hb);
+    BOOST_CHECK((ha == hb) == (a == b));
+    BOOST_CHECK(ha == hbitset(a));
+
+    check_hierarchical(Bitset(a & b), ha & hb);
+    check_hierarchical(Bitset(a | b), ha | hb);
+    check_hierarchical(Bitset(a ^ b), ha ^ hb);
+    check_hierarchical(Bitset(a - b), ha - hb);
+    check_hierarchical(Bitset(b - a), hb - ha);
+
+    Bitset c(a);
+    hbitset h(ha);
+    for (std::size_t i = b.find_first(); i != b.npos; i = b.find_next(i)) {
+      c.flip(i);
+      h.flip(i);
+    }
+    check_hierarchical(c, h);
+    for (std::size_t i = a.find_last(); i != a.npos; i = a.find_prev(i)) {
+      c.reset(i);
+      h.reset(i);
+    }
+    check_hierarchical(c, h);
+
+    c.resize(c.size() + 1000);
+    h.resize(h.size() + 1000);
+    c.set(c.size() - 1);
+    h.set(h.size() - 1);
+    check_hierarchical(c, h);
+    h.reset();
+    BOOST_CHECK(h.none() && h.count() == 0 && h.find_first() == h.npos);
+  }
+
+  // the summaries must be those of h.bits(), and the lookups those of a;
+  // on large bitsets, only some of the starting positions are tried
+  static void check_hierarchical(const Bitset& a,
+                                 const boost::hierarchical_bitset<Block>& h)
+  {
+    BOOST_CHECK(h.bits() == a);
+    BOOST_CHECK(h == boost::hierarchical_bitset<Block>(a));
+    BOOST_CHECK(h.count() == a.count());
+    BOOST_CHECK(h.any() == a.any());
+    BOOST_CHECK(h.find_first() == a.find_first());
+    BOOST_CHECK(h.find_last() == a.find_last());
+
+    const std::size_t step = a.size() / 4000 + 1;
+    for (std::size_t i = 0; i < a.size(); i += step) {
+      BOOST_CHECK(h.find_next(i) == a.find_next(i));
+      BOOST_CHECK(h.find_prev(i) == a.find_prev(i));
+    }
+    for (std::size_t i = a.find_first(); i != a.npos; i = a.find_next(i))
+      BOOST_CHECK(h.find_next(i) == a.find_next(i));
+    for (std::size_t i = a.find_last(); i != a.npos; i = a.find_prev(i))
+      BOOST_CHECK(h.find_prev(i) == a.find_prev(i));
+    BOOST_CHECK(h.find_prev(a.size()) == a.find_last());
+  }
+
+  // roaring_bitset against dynamic_bitset: conversions, lookups,
+  // serialization and the bitwise operators, then set() and reset()
+  // (a and b have the same size)
+  static void roaring(const Bitset& a, const Bitset& b)
+  {
+    const boost::roaring_bitset ra(a), rb(b);
+    check_roaring(a, ra);
+    check_roaring(b, rb);
+    BOOST_CHECK((ra == rb) == (a == b));
+
+    check_roaring(Bitset(a & b), ra & rb);
+    check_roaring(Bitset(a | b), ra | rb);
+    check_roaring(Bitset(a ^ b), ra ^ rb);
+    check_roaring(Bitset(a - b), ra - rb);
+    check_roaring(Bitset(b - a), rb - ra);
+
+    Bitset c(a);
+    boost::roaring_bitset r(ra);
+    for (std::size_t i = b.find_first(); i != b.npos; i = b.find_next(i)) {
+      c.flip(i);
+      r.set(i, c[i]);
+    }
+    check_roaring(c, r);
+    // the kinds left by set() and reset() may not be the smallest ones
+    r.optimize();
+    BOOST_CHECK(r.serialized_size() == boost::roaring_bitset(c).serialized_size());
+
+    for (std::size_t i = c.find_first(); i != c.npos; i = c.find_next(i))
+      r.reset(i);
+    BOOST_CHECK(r.none() && r.count() == 0 && r.find_first() == r.npos);
+    BOOST_CHECK(r == boost::roaring_bitset());
+  }
+
+  static void check_roaring(const Bitset& a, const boost::roaring_bitset& r)
+  {
+    BOOST_CHECK(r.count() == a.count());
+    BOOST_CHECK(r.any() == a.any());
+    BOOST_CHECK(r.find_first() == a.find_first());
+    BOOST_CHECK(r.find_last() == a.find_last());
+    for (std::size_t i = a.find_first(); i != a.npos; i = a.find_next(i))
+      BOOST_CHECK(r.find_next(i) == a.find_next(i));
+
+    const std::size_t step = a.size() / 4000 + 1;
+    for (std::size_t i = 0; i < a.size(); i += step) {
+      BOOST_CHECK(r.test(i) == a.test(i));
+      BOOST_CHECK(r.find_next(i) == a.find_next(i));
+    }
+
+    Bitset c(a.size(), 1ul);
+    c.set(c.size() / 2, c.size() / 4, true);
+    r.to_bitset(c);
+    BOOST_CHECK(c == a);
+
+    std::vector<char> buf(r.serialized_size());
+    BOOST_CHECK(r.serialize(buf.empty() ? 0 : &buf[0]) == buf.size());
+    const boost::roaring_bitset d =
+        boost::roaring_bitset::deserialize(buf.empty() ? 0 : &buf[0], buf.size());
+    BOOST_CHECK(d == r);
+    std::vector<char> buf2(d.serialized_size());
+    if (!buf2.empty())
+      d.serialize(&buf2[0]);
+    BOOST_CHECK(buf2 == buf);
+  }
+
+  // the serializations of the format specification, and invalid ones
+  static void roaring_format()
+  {
+    boost::roaring_bitset r;
+    r.set(1).set(2).set(2 * 65536 + 5);
+    const unsigned char plain[] = {
+      0x3a, 0x30, 0, 0,  2, 0, 0, 0,           // cookie, 2 containers
+      0, 0, 1, 0,  2, 0, 0, 0,                 // keys, cardinalities - 1
+      24, 0, 0, 0,  28, 0, 0, 0,               // offsets
+      1, 0, 2, 0,  5, 0                        // two arrays
+    };
+    check_roaring_bytes(r, plain, sizeof plain);
+
+    r.reset();
+    for (std::size_t i = 0; i < 100; ++i)
+      r.set(i);
+    r.optimize();
+    const unsigned char runs[] = {
+      0x3b, 0x30, 0, 0,  1,                    // cookie, 1 container, a run one
+      0, 0, 99, 0,                             // key, cardinality - 1
+      1, 0,  0, 0, 99, 0                       // [0, 0 + 99]
+    };
+    check_roaring_bytes(r, runs, sizeof runs);
+
+    const char* const p = reinterpret_cast<const char*>(plain);
+    for (std::size_t n = 0; n < sizeof plain; ++n)
+      roaring_invalid(p, n); // truncated
+
+    std::vector<char> bad(p, p + sizeof plain);
+    bad[12] = 0; // second key equal to the first
+    roaring_invalid(&bad[0], bad.size());
+    bad.assign(p, p + sizeof plain);
+    bad[26] = 1; // unsorted array
+    roaring_invalid(&bad[0], bad.size());
+    bad.assign(p, p + sizeof plain);
+    bad[0] = 0x3c; // unknown cookie
+    roaring_invalid(&bad[0], bad.size());
+    bad.assign(p, p + sizeof plain);
+    bad[4] = bad[5] = '\xff'; // 65535 containers, in 30 bytes
+    roaring_invalid(&bad[0], bad.size());
+  }
+
+  static void check_roaring_bytes(const boost::roaring_bitset& r,
+                                  const unsigned char* bytes, std::size_t n)
+  {
+    std::vector<char> buf(r.serialized_size());
+    BOOST_CHECK(buf.size() == n);
+    r.serialize(&buf[0]);
+    BOOST_CHECK(std::equal(buf.begin(), buf.end(), reinterpret_cast<const char*>(bytes)));
+    BOOST_CHECK(boost::roaring_bitset::deserialize(&buf[0], n) == r);
+  }
+
+  static void roaring_invalid(const char* p, std::size_t n)
+  {
+    bool thrown = false;
+    try {
+      boost::roaring_bitset::deserialize(p, n);
+    }
+    catch (const std::invalid_argument&) {
+      thrown = true;
+    }
+    BOOST_CHECK(thrown);
+  }
+
+  // ewah_bitset against dynamic_bitset: conversions, lookups and the
+  // bitwise operators, then the same blocks appended one at a time
+  // (a and b have the same size)
+  static void ewah(const Bitset& a, const Bitset& b)
+  {
+    typedef boost::ewah_bitset<Block> ebitset;
+
+    const ebitset ea(a), eb(b);
+    check_ewah(a, ea);
+    check_ewah(b, eb);
+    BOOST_CHECK((ea == eb) == (a == b));
+
+    check_ewah(Bitset(a & b), ea & eb);
+    check_ewah(Bitset(a | b), ea | eb);
+    check_ewah(Bitset(a ^ b), ea ^ eb);
+    check_ewah(Bitset(a - b), ea - eb);
+    check_ewah(Bitset(b - a), eb - ea);
+
+    if (a.size() % ebitset::bits_per_block == 0) {
+      std::vector<Block> blocks;
+      boost::to_block_range(a, std::back_inserter(blocks));
+      ebitset e;
+      for (std::size_t i = 0; i < blocks.size(); ++i)
+        e.append(blocks[i]);
+      BOOST_CHECK(e == ea);
+
+      e.append(3, true);
+      e.append(2, false);
+      Bitset c(a);
+      c.resize(a.size() + 5 * ebitset::bits_per_block);
+      c.set(a.size(), 3 * ebitset::bits_per_block, true);
+      check_ewah(c, e);
+    }
+  }
+
+  static void check_ewah(const Bitset& a, const boost::ewah_bitset<Block>& e)
+  {
+    typedef typename boost::ewah_bitset<Block>::set_bit_iterator iterator;
+
+    BOOST_CHECK(e.size() == a.size());
+    BOOST_CHECK(e.count() == a.count());
+    BOOST_CHECK(e.any() == a.any());
+    BOOST_CHECK(e == boost::ewah_bitset<Block>(a));
+
+    std::size_t i = a.find_first();
+    for (iterator it = e.set_bits().begin(); it != e.set_bits().end(); ++it) {
+      BOOST_CHECK(*it == i);
+      i = a.find_next(i);
+    }
+    BOOST_CHECK(i == a.npos);
+
+    const std::size_t step = a.size() / 1000 + 1;
+    for (std::size_t j = 0; j < a.size(); j += step)
+      BOOST_CHECK(e.test(j) == a.test(j));
+
+    Bitset c(a.size() / 2, 1ul);
+    e.to_bitset(c);
+    BOOST_CHECK(c == a);
+  }
+
+  // dynamic_bitset_view against dynamic_bitset: views of a and b, and
+  // of copies of their blocks, then the modifiers through a view
+  // (a and b have the same size)
+  static void view(const Bitset& a, const Bitset& b)
+  {
+    typedef boost::dynamic_bitset_view<const Block> const_view;
+    typedef boost::dynamic_bitset_view<Block> view_type;
+
+    // only a view of const blocks is made from a const bitset
+    BOOST_STATIC_ASSERT((boost::is_convertible<const Bitset&, const_view>::value));
+    BOOST_STATIC_ASSERT((!boost::is_convertible<const Bitset&, view_type>::value));
+
+    std::vector<Block> blocks;
+    boost::to_block_range(a, std::back_inserter(blocks));
+    const view_type va(blocks.empty() ? 0 : &blocks[0], a.size());
+    const const_view vb(b);
+    check_view(a, va);
+    check_view(b, vb);
+
+    BOOST_CHECK((va == vb) == (a == b));
+    BOOST_CHECK((va != vb) == (a != b));
+    BOOST_CHECK(va == const_view(a));
+    BOOST_CHECK((va < vb) == (a < b));
+    BOOST_CHECK((vb <= va) == (b <= a));
+    BOOST_CHECK(find_first_difference(va, vb) == find_first_difference(a, b));
+    BOOST_CHECK(find_last_difference(va, vb) == find_last_difference(a, b));
+    BOOST_CHECK(va.is_subset_of(vb) == a.is_subset_of(b));
+    BOOST_CHECK(va.is_proper_subset_of(vb) == a.is_proper_subset_of(b));
+    BOOST_CHECK(va.intersects(vb) == a.intersects(b));
+
+    // the blocks of a view are those of the bitset
+    Bitset c(a);
+    view_type vc(c);
+    vc &= b;
+    BOOST_CHECK(c == (a & b));
+    vc |= vb;
+    BOOST_CHECK(c == ((a & b) | b));
+    vc ^= va;
+    BOOST_CHECK(c == (((a & b) | b) ^ a));
+    vc -= b;
+    BOOST_CHECK(c == ((((a & b) | b) ^ a) - b));
+
+    c = a;
+    vc.flip();
+    BOOST_CHECK(c == ~a);
+    vc.set();
+    BOOST_CHECK(c.count() == c.size());
+    vc.reset();
+    BOOST_CHECK(c.none());
+    for (std::size_t i = b.find_first(); i != b.npos; i = b.find_next(i)) {
+      vc.set(i);
+      vc.flip(i / 2);
+    }
+    Bitset d(a.size());
+    for (std::size_t i = b.find_first(); i != b.npos; i = b.find_next(i)) {
+      d.set(i);
+      d.flip(i / 2);
+    }
+    BOOST_CHECK(c == d);
+    for (std::size_t i = 0; i < c.size(); i += 3)
+      vc.reset(i);
+    for (std::size_t i = 0; i < d.size(); i += 3)
+      d.reset(i);
+    BOOST_CHECK(c == d);
+  }
+
+  template <typename View>
+  static void check_view(const Bitset& a, const View& v)
+  {
+    BOOST_CHECK(v.size() == a.size());
+    BOOST_CHECK(v.num_blocks() == a.num_blocks());
+    BOOST_CHECK(v.count() == a.count());
+    BOOST_CHECK(v.any() == a.any());
+    BOOST_CHECK(v.find_first() == a.find_first());
+    BOOST_CHECK(v.find_last() == a.find_last());
+    BOOST_CHECK(v.find_first_zero() == a.find_first_zero());
+    BOOST_CHECK(std::equal(v.set_bits().begin(), v.set_bits().end(),
+                           a.set_bits().begin()));
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      BOOST_CHECK(v[i] == a[i]);
+      BOOST_CHECK(v.find_next(i) == a.find_next(i));
+      BOOST_CHECK(v.find_prev(i) == a.find_prev(i));
+      BOOST_CHECK(v.find_next_zero(i) == a.find_next_zero(i));
+    }
+  }
+
+  // write_binary() and read_binary(), from blocks of every size and of
+  // the other byte order, and the same files mapped in memory
+  static void binary_format(const Bitset& a)
+  {
+    const std::string bytes = write_binary_string(a);
+    const std::size_t payload = a.num_blocks() * sizeof(Block);
+    BOOST_CHECK(bytes.size() == 64 + (payload + 63) / 64 * 64);
+    check_read_binary(a, bytes);
+
+    const std::string narrow = write_binary_string(copy_blocks<unsigned char>(a));
+    check_read_binary(a, narrow);
+    check_read_binary(a, write_binary_string(copy_blocks<unsigned short>(a)));
+    check_read_binary(a, write_binary_string(copy_blocks<unsigned int>(a)));
+    check_read_binary(a, write_binary_string(copy_blocks<boost::uint64_t>(a)));
+    const std::string swapped =
+        swap_byte_order(write_binary_string(copy_blocks<boost::uint32_t>(a)));
+    check_read_binary(a, swapped);
+
+#if defined(BOOST_HAS_UNISTD_H)
+    const bool can_map = true;
+#else
+    const bool can_map = false;
+#endif
+    using boost::detail::dynamic_bitset_impl::host_big_endian;
+    check_mapped(a, bytes, can_map);
+    check_mapped(a, narrow, can_map && !host_big_endian);
+    check_mapped(a, swapped, false);
+
+    // invalid data
+    for (std::size_t n = 0; n < bytes.size(); n += 13)
+      binary_invalid(bytes.substr(0, n), false); // truncated
+    std::string bad(bytes);
+    bad[0] = 'b';
+    binary_invalid(bad, false);
+    bad = bytes;
+    bad[8] = 2; // version
+    binary_invalid(bad, false);
+    if (payload != 0) {
+      bad = bytes;
+      bad[64] ^= 1; // wrong checksum
+      binary_invalid(bad, true);
+    }
+    if (a.size() % 8 != 0 && !host_big_endian) {
+      bad = bytes;
+      bad[64 + a.size() / 8] |= static_cast<char>(0x80); // a bit beyond size()
+      set_checksum(bad);
+      binary_invalid(bad, false);
+    }
+
+    // a header claiming 2^40 bits, or more than a 32-bit size_t holds,
+    // before a short stream: rejected before the bits are allocated
+    using boost::detail::dynamic_bitset_impl::store_le;
+    const boost::uint64_t huge = (std::numeric_limits<std::size_t>::max)() > 0xffffffffu
+                                 ? boost::uint64_t(1) << 40 : boost::uint64_t(1) << 31;
+    bad = bytes;
+    unsigned char* const p = reinterpret_cast<unsigned char*>(&bad[0]);
+    store_le(p + 16, huge, 8);
+    store_le(p + 24, huge / (8 * sizeof(Block)), 8);
+    binary_invalid(bad, false);
+  }
+
+  template <typename Bitset2>
+  static std::string write_binary_string(const Bitset2& b)
+  {
+    std::ostringstream os;
+    boost::write_binary(os, b);
+    return os.str();
+  }
+
+  template <typename B>
+  static boost::dynamic_bitset<B> copy_blocks(const Bitset& a)
+  {
+    boost::dynamic_bitset<B> c(a.size());
+    for (std::size_t i = a.find_first(); i != a.npos; i = a.find_next(i))
+      c.set(i);
+    return c;
+  }
+
+  // the blocks in the other byte order
+  static std::string swap_byte_order(std::string bytes)
+  {
+    const std::size_t w = static_cast<unsigned char>(bytes[10]);
+    const std::size_t n = static_cast<std::size_t>(
+        boost::detail::dynamic_bitset_impl::load_le(
+            reinterpret_cast<const unsigned char*>(bytes.data()) + 24, 8)) * w;
+    for (std::size_t i = 64; i < 64 + n; i += w)
+      std::reverse(bytes.begin() + i, bytes.begin() + i + w);
+    bytes[11] ^= 1;
+    set_checksum(bytes);
+    return bytes;
+  }
+
+  static void set_checksum(std::string& bytes)
+  {
+    using namespace boost::detail::dynamic_bitset_impl;
+    unsigned char* const p = reinterpret_cast<unsigned char*>(&bytes[0]);
+    const std::size_t n = static_cast<std::size_t>(load_le(p + 24, 8) * p[10]);
+    store_le(p + 32, binary_checksum(p + 64, n, n), 8);
+  }
+
+  static void check_read_binary(const Bitset& a, const std::string& bytes)
+  {
+    std::istringstream is(bytes);
+    Bitset b(3, 5ul);
+    boost::read_binary(is, b);
+    BOOST_CHECK(b == a);
+    BOOST_CHECK(is.good() && is.peek() == EOF);
+
+    unseekable_buffer buf(bytes);
+    std::istream us(&buf);
+    Bitset c(3, 5ul);
+    boost::read_binary(us, c);
+    BOOST_CHECK(c == a);
+    BOOST_CHECK(us.good() && us.peek() == EOF);
+  }
+
+  static void check_mapped(const Bitset& a, const std::string& bytes, bool zero_copy)
+  {
+    const test_file_remover remover;
+    {
+      std::ofstream f(test_file_name(), std::ios::binary | std::ios::trunc);
+      f.write(bytes.data(), bytes.size());
+    }
+    {
+      const boost::mapped_dynamic_bitset<Block> m(test_file_name(), true);
+      BOOST_CHECK(m.size() == a.size());
+      BOOST_CHECK(m.bits() == boost::dynamic_bitset_view<const Block>(a));
+      BOOST_CHECK(m.bits().count() == a.count());
+      BOOST_CHECK(m.zero_copy() == zero_copy);
+    } // unmap before the file is removed
+  }
+
+  // read_binary() throws, and so does mapped_dynamic_bitset if the
+  // data is not truncated (when the checksum is verified, for a wrong
+  // one)
+  static void binary_invalid(const std::string& bytes, bool checksum)
+  {
+    bool thrown = false;
+    try {
+      std::istringstream is(bytes);
+      Bitset b;
+      boost::read_binary(is, b);
+    }
+    catch (const std::invalid_argument&) {
+      thrown = true;
+    }
+    BOOST_CHECK(thrown);
+
+    thrown = false;
+    try {
+      unseekable_buffer buf(bytes);
+      std::istream is(&buf);
+      Bitset b;
+      boost::read_binary(is, b);
+    }
+    catch (const std::invalid_argument&) {
+      thrown = true;
+    }
+    BOOST_CHECK(thrown);
+
+    const test_file_remover remover;
+    {
+      std::ofstream f(test_file_name(), std::ios::binary | std::ios::trunc);
+      f.write(bytes.data(), bytes.size());
+    }
+    thrown = false;
+    try {
+      boost::mapped_dynamic_bitset<Block> m(test_file_name(), checksum);
+    }
+    catch (const std::invalid_argument&) {
+      thrown = true;
+    }
+    BOOST_CHECK(thrown);
+  }
+
   static void operator_equal(const Bitset& a, const Bitset& b)
   {
     if (a == b) {
@@ -890,6 +2489,24 @@ struct bitset_test {
       BOOST_CHECK(!(a < b));
   }
 
+  // PRE: a.size() == b.size()
+  static void find_difference(const Bitset& a, const Bitset& b)
+  {
+    std::size_t first = Bitset::npos, last = Bitset::npos;
+    for (std::size_t I = 0; I < a.size(); ++I)
+      if (a[I] != b[I]) {
+        if (first == Bitset::npos)
+          first = I;
+        last = I;
+      }
+    BOOST_CHECK(find_first_difference(a, b) == first);
+    BOOST_CHECK(find_last_difference(a, b) == last);
+    BOOST_CHECK(find_first_difference(b, a) == first);
+    BOOST_CHECK(find_last_difference(b, a) == last);
+    BOOST_CHECK((a == b) == (first == Bitset::npos));
+    BOOST_CHECK((a < b) == (last != Bitset::npos && b[last]));
+  }
+
   static void operator_greater_than(const Bitset& a, const Bitset& b)
   {
     if (less_than(a, b) || a == b)
@@ -937,12 +2554,48 @@ struct bitset_test {
     BOOST_CHECK((lhs >> pos) == (x >>= pos));
   }
 
+  // PRE: a.size() == b.size()
+  static void shifted_operations(const Bitset& a, const Bitset& b, std::ptrdiff_t k)
+  {
+    const std::size_t N = a.size();
+    Bitset t(N);
+    for (std::size_t I = 0; I < N; ++I) {
+      const std::ptrdiff_t J = static_cast<std::ptrdiff_t>(I) - k;
+      t[I] = J >= 0 && J < static_cast<std::ptrdiff_t>(N) && b[J];
+    }
+    if (k >= 0)
+      BOOST_CHECK((b << static_cast<std::size_t>(k)) == t);
+    else
+      BOOST_CHECK((b >> static_cast<std::size_t>(-k)) == t);
+
+    Bitset x(a);
+    BOOST_CHECK(x.or_shifted(b, k) == (a | t));
+    x = a;
+    BOOST_CHECK(x.and_shifted(b, k) == (a & t));
+    x = a;
+    BOOST_CHECK(x.xor_shifted(b, k) == (a ^ t));
+    x = a;
+    BOOST_CHECK(x.andnot_shifted(b, k) == (a - t));
+
+    // in place
+    Bitset y(b);
+    BOOST_CHECK(y.xor_shifted(y, k) == (b ^ t));
+    y = b;
+    BOOST_CHECK(y.and_shifted(y, k) == (b & t));
+  }
+
   // operator|
   static
   void operator_or(const Bitset& lhs, const Bitset& rhs)
   {
     Bitset x(lhs);
     BOOST_CHECK((lhs | rhs) == (x |= rhs));
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    // overloads reusing an rvalue operand
+    BOOST_CHECK((Bitset(lhs) | rhs) == x);
+    BOOST_CHECK((lhs | Bitset(rhs)) == x);
+    BOOST_CHECK((Bitset(lhs) | Bitset(rhs)) == x);
+#endif
   }
 
   // operator&
@@ -951,6 +2604,12 @@ struct bitset_test {
   {
     Bitset x(lhs);
     BOOST_CHECK((lhs & rhs) == (x &= rhs));
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    // overloads reusing an rvalue operand
+    BOOST_CHECK((Bitset(lhs) & rhs) == x);
+    BOOST_CHECK((lhs & Bitset(rhs)) == x);
+    BOOST_CHECK((Bitset(lhs) & Bitset(rhs)) == x);
+#endif
   }
 
   // operator^
@@ -959,6 +2618,12 @@ struct bitset_test {
   {
     Bitset x(lhs);
     BOOST_CHECK((lhs ^ rhs) == (x ^= rhs));
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    // overloads reusing an rvalue operand
+    BOOST_CHECK((Bitset(lhs) ^ rhs) == x);
+    BOOST_CHECK((lhs ^ Bitset(rhs)) == x);
+    BOOST_CHECK((Bitset(lhs) ^ Bitset(rhs)) == x);
+#endif
   }
 
   // operator-
@@ -967,6 +2632,111 @@ struct bitset_test {
   {
     Bitset x(lhs);
     BOOST_CHECK((lhs - rhs) == (x -= rhs));
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    // overloads reusing an rvalue operand
+    BOOST_CHECK((Bitset(lhs) - rhs) == x);
+    BOOST_CHECK((lhs - Bitset(rhs)) == x);
+    BOOST_CHECK((Bitset(lhs) - Bitset(rhs)) == x);
+#endif
+  }
+
+  // the results of &, |, ^, - and ~ are bitsets, usable wherever one
+  // is; a, b and c have the same size
+  static
+  void bitwise_operator_results(const Bitset& a, const Bitset& b, const Bitset& c)
+  {
+    // reference results, computed a step at a time
+    Bitset not_c(c);
+    not_c.flip();
+    Bitset ref(a);
+    ref &= b;
+    ref |= not_c;
+
+    Bitset r = (a & b) | ~c;
+    BOOST_CHECK(r == ref);
+    BOOST_CHECK(((a & b) | ~c).count() == ref.count());
+    BOOST_CHECK(((a | b) < c) == (Bitset(a | b) < c));
+    BOOST_CHECK(((a & b) >> 1) == (Bitset(a & b) >>= 1));
+    BOOST_CHECK((a & b).is_subset_of(a));
+    BOOST_CHECK((a - b).is_subset_of(a));
+    if (a.size() > 0) {
+      BOOST_CHECK((a & b).flip(0)[0] == !(a[0] && b[0]));
+      BOOST_CHECK((~a).set(0)[0]);
+    }
+    BOOST_CHECK((~~a) == a);
+    BOOST_CHECK((a - ~c) == (a & c));
+    BOOST_CHECK((~(a ^ b)).count() == a.size() - (a ^ b).count());
+
+    // the result doesn't refer to its operands
+    Bitset x(a), y(b);
+    Bitset z = x & y;
+    x.resize(x.size() + 1000, true);
+    y.clear();
+    BOOST_CHECK(z == (a & b));
+
+    // the target is also an operand
+    x = a;
+    x = b & (c | x);
+    y = c;
+    y |= a;
+    y &= b;
+    BOOST_CHECK(x == y);
+    x = a;
+    x &= ~x | b;
+    BOOST_CHECK(x == (a & b));
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    BOOST_CHECK((Bitset(a) | (b & ~c)) == (a | Bitset(b & ~c)));
+    BOOST_CHECK(((b ^ c) - Bitset(a)) == Bitset((b ^ c) - a));
+    BOOST_CHECK((Bitset(a) - (b ^ c)) == Bitset(a - (b ^ c)));
+    BOOST_CHECK((~Bitset(c)) == not_c);
+#endif
+  }
+
+  // bitset_expr(): expressions of several operators, evaluated in a
+  // single pass, against the operators of dynamic_bitset; a, b, c and
+  // d have the same size
+  static
+  void bitset_expressions(const Bitset& a, const Bitset& b, const Bitset& c, const Bitset& d)
+  {
+    using boost::bitset_expr;
+
+    check_expression((bitset_expr(a) & bitset_expr(b)) | (bitset_expr(c) - bitset_expr(d)),
+                     (a & b) | (c - d));
+    // a pipeline of masks
+    check_expression(bitset_expr(a) & ~bitset_expr(b) & (bitset_expr(c) | bitset_expr(d))
+                     & ~(bitset_expr(a) ^ bitset_expr(d))
+                     & (bitset_expr(b) | bitset_expr(c) | ~bitset_expr(d)),
+                     a & ~b & (c | d) & ~(a ^ d) & (b | c | ~d));
+    // the shapes count() has kernels for
+    check_expression(bitset_expr(a), a);
+    check_expression(bitset_expr(a) ^ bitset_expr(b), a ^ b);
+    check_expression(bitset_expr(a) & ~bitset_expr(b), a - b);
+    check_expression(~bitset_expr(c), ~c);
+
+    // the target is also an operand, at any depth
+    Bitset x(a);
+    x.assign(bitset_expr(b) | (bitset_expr(c) & ~bitset_expr(x)));
+    BOOST_CHECK(x == (b | (c - a)));
+    x = d;
+    x.assign(~(bitset_expr(x) ^ bitset_expr(a)) - bitset_expr(x));
+    BOOST_CHECK(x == (~(d ^ a) - d));
+  }
+
+  template <typename Expr>
+  static
+  void check_expression(const boost::detail::dynamic_bitset_impl::dynamic_bitset_expr<Expr, Block>& e,
+                        const Bitset& ref)
+  {
+    Bitset r(3, 5ul);
+    BOOST_CHECK(&r.assign(e) == &r);
+    BOOST_CHECK(r == ref);
+    BOOST_CHECK(e.count() == ref.count());
+    BOOST_CHECK(e.count_at_least(ref.count()));
+    BOOST_CHECK(!e.count_at_least(ref.count() + 1));
+    BOOST_CHECK(e.any() == ref.any());
+    BOOST_CHECK(e.none() == ref.none());
+    BOOST_CHECK(e.find_first() == ref.find_first());
   }
 
 //------------------------------------------------------------------------------
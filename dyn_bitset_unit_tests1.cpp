@@ -189,6 +189,19 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     Tests::from_string(std::string("x11"), 1, 10);
     Tests::from_string(std::string("x11"), 1, 10, 10);
 
+    run_string_tests<Tests>(get_very_long_string());
+  }
+  //=====================================================================
+  // Test from_chars
+  {
+    Tests::from_chars(std::string(""));
+    Tests::from_chars(std::string("1"));
+    Tests::from_chars(long_string);
+    Tests::from_chars(get_very_long_string());
+    Tests::from_chars(get_very_long_string().substr(0, 4096));
+    Tests::parse_kernels(long_string);
+    Tests::parse_kernels(get_very_long_string());
+    Tests::parse_kernels(get_very_long_string().substr(0, 4096));
   }
   //=====================================================================
   // test from_block_range
@@ -263,6 +276,46 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     bitset_type b(long_string); // b greater than a
     Tests::assignment_operator(a, b);
   }
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+  //=====================================================================
+  // Test move constructor
+  {
+    boost::dynamic_bitset<Block> b;
+    Tests::move_constructor(b);
+  }
+  {
+    boost::dynamic_bitset<Block> b(std::string("0"));
+    Tests::move_constructor(b);
+  }
+  {
+    boost::dynamic_bitset<Block> b(long_string);
+    Tests::move_constructor(b);
+  }
+  //=====================================================================
+  // Test move assignment operator
+  {
+    bitset_type a, b;
+    Tests::move_assignment_operator(a, b);
+  }
+  {
+    bitset_type a(std::string("1")), b(std::string("0"));
+    Tests::move_assignment_operator(a, b);
+  }
+  {
+    bitset_type a(long_string), b(long_string);
+    Tests::move_assignment_operator(a, b);
+  }
+  {
+    bitset_type a;
+    bitset_type b(long_string); // b greater than a, a empty
+    Tests::move_assignment_operator(a, b);
+  }
+  {
+    bitset_type a(long_string);
+    bitset_type b(std::string("0")); // b smaller than a
+    Tests::move_assignment_operator(a, b);
+  }
+#endif
   //=====================================================================
   // Test swap
   {
@@ -338,6 +391,20 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     Tests::append_bit(a);
   }
   //=====================================================================
+  // Test reserve, capacity and shrink_to_fit
+  {
+    boost::dynamic_bitset<Block> a;
+    Tests::reserve(a);
+  }
+  {
+    boost::dynamic_bitset<Block> a(std::string("1"));
+    Tests::reserve(a);
+  }
+  {
+    boost::dynamic_bitset<Block> a(long_string);
+    Tests::reserve(a);
+  }
+  //=====================================================================
   // Test append block
   {
     boost::dynamic_bitset<Block> a;
@@ -8,6 +8,7 @@
 //
 // -----------------------------------------------------------
 
+#include <algorithm>
 #include "bitset_test.hpp"
 #include "boost/dynamic_bitset/dynamic_bitset.hpp"
 #include "boost/config.hpp"
@@ -21,6 +22,10 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
   const int bits_per_block = bitset_type::bits_per_block;
 
   std::string long_string = get_long_string();
+  std::string very_long_string = get_very_long_string();
+  std::string rotated_string = very_long_string;
+  std::rotate(rotated_string.begin(), rotated_string.begin() + 100,
+              rotated_string.end());
 
   //=====================================================================
   // Test operator&=
@@ -40,6 +45,21 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     boost::dynamic_bitset<Block> lhs(long_string.size(), 1), rhs(long_string);
     Tests::and_assignment(lhs, rhs);
   }
+  {
+    boost::dynamic_bitset<Block> lhs(very_long_string), rhs(rotated_string);
+    Tests::and_assignment(lhs, rhs);
+  }
+  {
+    boost::dynamic_bitset<Block> lhs(very_long_string), rhs(rotated_string);
+    Tests::bitwise_kernels(lhs, rhs);
+    Tests::shift_kernels(lhs, rhs);
+    for (std::size_t len = 1; len < 400; len += 13) {
+      boost::dynamic_bitset<Block> short_lhs(very_long_string, 0, len);
+      boost::dynamic_bitset<Block> short_rhs(rotated_string, 0, len);
+      Tests::bitwise_kernels(short_lhs, short_rhs);
+      Tests::shift_kernels(short_lhs, short_rhs);
+    }
+  }
   //=====================================================================
   // Test operator |=
   {
@@ -58,6 +78,10 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     boost::dynamic_bitset<Block> lhs(long_string.size(), 1), rhs(long_string);
     Tests::or_assignment(lhs, rhs);
   }
+  {
+    boost::dynamic_bitset<Block> lhs(very_long_string), rhs(rotated_string);
+    Tests::or_assignment(lhs, rhs);
+  }
   //=====================================================================
   // Test operator^=
   {
@@ -76,6 +100,10 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     boost::dynamic_bitset<Block> lhs(long_string), rhs(long_string);
     Tests::xor_assignment(lhs, rhs);
   }
+  {
+    boost::dynamic_bitset<Block> lhs(very_long_string), rhs(rotated_string);
+    Tests::xor_assignment(lhs, rhs);
+  }
   //=====================================================================
   // Test operator-=
   {
@@ -94,6 +122,10 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     boost::dynamic_bitset<Block> lhs(long_string), rhs(long_string);
     Tests::sub_assignment(lhs, rhs);
   }
+  {
+    boost::dynamic_bitset<Block> lhs(very_long_string), rhs(rotated_string);
+    Tests::sub_assignment(lhs, rhs);
+  }
   //=====================================================================
   // Test operator<<=
   { // case pos == 0
@@ -245,6 +277,10 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     boost::dynamic_bitset<Block> b(long_string);
     Tests::operator_flip(b);
   }
+  {
+    boost::dynamic_bitset<Block> b(very_long_string);
+    Tests::operator_flip(b);
+  }
   //=====================================================================
   // Test b.flip()
   {
@@ -259,6 +295,10 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     boost::dynamic_bitset<Block> b(long_string);
     Tests::flip_all(b);
   }
+  {
+    boost::dynamic_bitset<Block> b(very_long_string);
+    Tests::flip_all(b);
+  }
   //=====================================================================
   // Test b.flip(pos)
   { // case pos >= b.size()
@@ -273,6 +313,34 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     boost::dynamic_bitset<Block> b(long_string);
     Tests::flip_one(b, long_string.size()/2);
   }
+  //=====================================================================
+  // Test b.set(pos, len, value), b.reset(pos, len) and b.flip(pos, len)
+  {
+    boost::dynamic_bitset<Block> b;
+    Tests::range_operations(b, 0, 0);
+  }
+  {
+    boost::dynamic_bitset<Block> b(std::string("0"));
+    Tests::range_operations(b, 0, 1);
+    Tests::range_operations(b, 1, 0);
+  }
+  {
+    boost::dynamic_bitset<Block> b(long_string);
+    const std::size_t n = b.size();
+    for (std::size_t pos = 0; pos <= n; pos += 1 + pos / 2)
+      for (std::size_t len = 0; pos + len <= n; len += 1 + len / 2)
+        Tests::range_operations(b, pos, len);
+    Tests::range_operations(b, 0, n);
+    Tests::range_operations(b, bits_per_block, bits_per_block);
+  }
+  {
+    // whole blocks in the middle go through the vector kernels
+    boost::dynamic_bitset<Block> b(very_long_string);
+    const std::size_t n = b.size();
+    Tests::range_operations(b, 0, n);
+    Tests::range_operations(b, 3, n - 5);
+    Tests::range_operations(b, n / 3, n / 3);
+  }
 }
 
 int
@@ -24,6 +24,7 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
   // typedef typename bitset_type::size_type size_type; // unusable with Borland 5.5.1
 
   std::string long_string = get_long_string();
+  std::string very_long_string = get_very_long_string();
   std::size_t ul_width = std::numeric_limits<unsigned long>::digits;
 
   //=====================================================================
@@ -83,6 +84,12 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
   {
     boost::dynamic_bitset<Block> b(long_string);
     Tests::to_string(b);
+    Tests::format_kernels(b);
+  }
+  {
+    boost::dynamic_bitset<Block> b(very_long_string);
+    Tests::to_string(b);
+    Tests::format_kernels(b);
   }
   //=====================================================================
   // Test b.count()
@@ -105,6 +112,186 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
   {
     boost::dynamic_bitset<Block> b(long_string);
     Tests::count(b);
+    Tests::count_kernels(b);
+  }
+  {
+    // long enough to go through the unrolled loops of the kernels,
+    // and with every possible tail length
+    std::string str;
+    for (int i = 0; i < 24; ++i)
+        str += long_string;
+    for (std::size_t len = str.size() - 8 * sizeof(Block) * 64; len <= str.size(); len += 7) {
+      boost::dynamic_bitset<Block> b(str, 0, len);
+      Tests::count(b);
+      Tests::count_kernels(b);
+    }
+  }
+  //=====================================================================
+  // Test intersection_count() and friends
+  {
+    boost::dynamic_bitset<Block> a, b;
+    Tests::fused_counts(a, b);
+    Tests::count2_kernels(a, b);
+  }
+  {
+    boost::dynamic_bitset<Block> a(long_string), b(long_string.size(), 0xABCDul);
+    Tests::fused_counts(a, b);
+    Tests::count2_kernels(a, b);
+  }
+  {
+    // every tail length of the kernels, and several chunks
+    for (std::size_t len = very_long_string.size() - 8 * sizeof(Block) * 64;
+         len <= very_long_string.size(); len += 7) {
+      boost::dynamic_bitset<Block> a(very_long_string, 0, len), b(len, 0xFACEul);
+      b.flip();
+      b ^= (a << 3);
+      Tests::fused_counts(a, b);
+      Tests::count2_kernels(a, b);
+    }
+  }
+  //=====================================================================
+  // Test rank_select_index
+  {
+    boost::dynamic_bitset<Block> b;
+    Tests::rank_select(b, 0);
+  }
+  {
+    boost::dynamic_bitset<Block> b(long_string);
+    Tests::rank_select(b, 0);
+    Tests::rank_select(b, b.size() / 2);
+    Tests::rank_select(b, b.size());
+  }
+  {
+    // several groups and select samples: dense, sparse and full
+    const std::size_t n = 70000;
+    boost::dynamic_bitset<Block> dense(n), sparse(n), full(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      dense[i] = ((i * 2654435761ul) >> 7) & 1;
+      sparse[i] = (i * 2654435761ul) % 997 == 0;
+    }
+    full.set();
+    Tests::rank_select(dense, 0);
+    Tests::rank_select(dense, 2048 * 17 + 5);
+    Tests::rank_select(sparse, 4096);
+    Tests::rank_select(full, n - 1);
+  }
+  //=====================================================================
+  // Test hierarchical_bitset
+  {
+    boost::dynamic_bitset<Block> a, b;
+    Tests::hierarchical(a, b);
+  }
+  {
+    boost::dynamic_bitset<Block> a(long_string);
+    boost::dynamic_bitset<Block> b(~a);
+    b[0] = b[a.size() - 1] = true;
+    Tests::hierarchical(a, b);
+    Tests::hierarchical(a, a);
+  }
+  {
+    // three summary levels or more, with long runs of null blocks
+    const std::size_t n = 300000;
+    boost::dynamic_bitset<Block> sparse(n), other(n), dense(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      sparse[i] = (i * 2654435761ul) % 9973 == 0;
+      other[i] = i % 40000 < 3 || (i * 40503ul) % 7919 == 0;
+      dense[i] = i > 200000 && ((i * 2654435761ul) >> 7) & 1;
+    }
+    sparse[n - 1] = true;
+    Tests::hierarchical(sparse, other);
+    Tests::hierarchical(sparse, dense);
+    Tests::hierarchical(dense, other);
+  }
+  //=====================================================================
+  // Test roaring_bitset
+  Tests::roaring_format();
+  {
+    boost::dynamic_bitset<Block> a, b;
+    Tests::roaring(a, b);
+  }
+  {
+    boost::dynamic_bitset<Block> a(long_string);
+    boost::dynamic_bitset<Block> b(~a);
+    b[0] = true;
+    Tests::roaring(a, b);
+    Tests::roaring(a, a);
+  }
+  {
+    // chunks of every kind: sparse (array), dense (bitmap), runs,
+    // empty, and a last partial one
+    const std::size_t n = 4 * 65536 + 1000;
+    boost::dynamic_bitset<Block> a(n), b(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::size_t chunk = i / 65536;
+      const std::size_t h = (i * 2654435761ul) >> 7;
+      a[i] = chunk == 0 ? h % 997 == 0
+           : chunk == 1 ? (h & 1) != 0
+           : chunk == 2 ? i % 5000 < 2000
+           : chunk == 4;
+      b[i] = chunk == 0 ? i % 3000 < 1000
+           : chunk == 1 ? h % 5 == 0
+           : chunk == 2 ? (h & 1) != 0
+           : h % 101 == 0;
+    }
+    Tests::roaring(a, b);
+    Tests::roaring(b, a);
+  }
+  //=====================================================================
+  // Test ewah_bitset
+  {
+    boost::dynamic_bitset<Block> a, b;
+    Tests::ewah(a, b);
+  }
+  {
+    boost::dynamic_bitset<Block> a(long_string);
+    boost::dynamic_bitset<Block> b(~a);
+    b[0] = true;
+    Tests::ewah(a, b);
+    Tests::ewah(a, a);
+  }
+  {
+    // runs of clean blocks longer than a marker holds, between literal
+    // blocks, and more literal blocks in a row than a marker counts
+    const std::size_t bits = std::numeric_limits<Block>::digits;
+    const std::size_t n = 300 * bits;
+    boost::dynamic_bitset<Block> a(n), b(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::size_t block = i / bits;
+      const std::size_t h = (i * 2654435761ul) >> 7;
+      a[i] = block < 40 ? false
+           : block < 100 ? true
+           : block < 200 ? h % 7 == 0
+           : block % 50 == 0 && i % 3 == 0;
+      b[i] = block < 20 ? (h & 1) != 0
+           : block < 150 ? block % 2 == 0
+           : block < 280;
+    }
+    Tests::ewah(a, b);
+    Tests::ewah(b, a);
+    a.resize(n - 3);
+    b.resize(n - 3);
+    Tests::ewah(a, b);
+  }
+  //=====================================================================
+  // Test dynamic_bitset_view
+  {
+    boost::dynamic_bitset<Block> a, b;
+    Tests::view(a, b);
+  }
+  {
+    boost::dynamic_bitset<Block> a(std::string("1")), b(std::string("0"));
+    Tests::view(a, b);
+  }
+  {
+    boost::dynamic_bitset<Block> a(long_string);
+    boost::dynamic_bitset<Block> b(~a);
+    b[0] = true;
+    Tests::view(a, b);
+    Tests::view(a, a);
+    b = a;
+    b.reset(b.size() - 1);
+    Tests::view(a, b);
+    Tests::view(b, a);
   }
   //=====================================================================
   // Test b.size()
@@ -256,6 +443,24 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
       b.set(b.size() - 1);
       Tests::find_first(b);
   }
+  {
+      // a single bit on (and a single bit off) in a long bitset, at
+      // positions hitting every step of the scan kernels
+      const std::size_t sz = 8 * 300 + 5;
+      for (std::size_t i = 0; i < sz; i += (i < 300 ? 1 : 37)) {
+          bitset_type b(sz);
+          b.set(i);
+          bitset_type c(sz);
+          c.set(i).set(sz - 1 - i);
+          Tests::scan_kernels(b, c);
+          Tests::scan_kernels(~b, c);
+          Tests::scan_kernels(c, bitset_type(sz));
+          Tests::find_next(b, i / 2);
+      }
+      const bitset_type zeros(sz);
+      Tests::scan_kernels(zeros, zeros);
+      Tests::scan_kernels(~zeros, zeros);
+  }
   //=====================================================================
   // Test find_next
   {
@@ -331,6 +536,121 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
 
   }
   //=====================================================================
+  // Test find_last, find_prev, find_first_zero and find_next_zero
+  {
+      // empty bitset
+      bitset_type b;
+      Tests::find_last(b);
+      Tests::find_first_zero(b);
+      Tests::find_prev(b, 0);
+      Tests::find_prev(b, 200);
+      Tests::find_prev(b, b.npos);
+      Tests::find_next_zero(b, 0);
+      Tests::find_next_zero(b, b.npos);
+  }
+  {
+      // bitsets of size 1
+      bitset_type b(1, 1ul);
+      bitset_type c(1, 0ul);
+      Tests::find_last(b);
+      Tests::find_last(c);
+      Tests::find_first_zero(b);
+      Tests::find_first_zero(c);
+      for (typename bitset_type::size_type i = 0; i <= 2; ++i) {
+          Tests::find_prev(b, i);
+          Tests::find_prev(c, i);
+          Tests::find_next_zero(b, i);
+          Tests::find_next_zero(c, i);
+      }
+  }
+  {
+      // all-0s and all-1s bitsets, with and without unused bits
+      for (typename bitset_type::size_type sz = 4 * bitset_type::bits_per_block - 1;
+           sz <= 4 * bitset_type::bits_per_block; ++sz) {
+          bitset_type zeros(sz);
+          bitset_type ones(sz);
+          ones.set();
+          Tests::find_last(zeros);
+          Tests::find_last(ones);
+          Tests::find_first_zero(zeros);
+          Tests::find_first_zero(ones);
+          for (typename bitset_type::size_type i = 0; i <= sz + 5; ++i) {
+              Tests::find_prev(zeros, i);
+              Tests::find_prev(ones, i);
+              Tests::find_next_zero(zeros, i);
+              Tests::find_next_zero(ones, i);
+          }
+          Tests::find_prev(ones, ones.npos);
+          Tests::find_next_zero(zeros, zeros.npos);
+      }
+  }
+  {
+      // a bitset with 1s (or 0s) at block boundary only
+      const int num_blocks = 32;
+      const int block_width = bitset_type::bits_per_block;
+
+      bitset_type b(num_blocks * block_width);
+      typename bitset_type::size_type i = block_width - 1;
+      for ( ; i < b.size(); i += block_width) {
+        b.set(i);
+        b.set(i - (block_width - 1));
+      }
+      const bitset_type c = ~b;
+
+      Tests::find_last(b);
+      Tests::find_first_zero(c);
+      for (i = 0; i <= b.size() + 5; ++i) {
+          Tests::find_prev(b, i);
+          Tests::find_next_zero(c, i);
+      }
+  }
+  {
+      // a bitset with a single 1 (and one with a single 0)
+      bitset_type b(long_string.size());
+      b.set(b.size() / 2 + 1);
+      const bitset_type c = ~b;
+      Tests::find_last(b);
+      Tests::find_first_zero(c);
+      for (typename bitset_type::size_type i = 0; i <= b.size(); ++i) {
+          Tests::find_prev(b, i);
+          Tests::find_next_zero(c, i);
+      }
+  }
+  {
+      bitset_type b(long_string);
+      Tests::find_last(b);
+      Tests::find_first_zero(b);
+      for (typename bitset_type::size_type i = 0; i <= b.size(); ++i) {
+          Tests::find_prev(b, i);
+          Tests::find_next_zero(b, i);
+      }
+  }
+  //=====================================================================
+  // Test set_bits() and decode_set_bits()
+  {
+      Tests::set_bits(bitset_type());
+      Tests::set_bits(bitset_type(1, 1ul));
+      Tests::set_bits(bitset_type(long_string));
+      Tests::set_bits(~bitset_type(long_string));
+  }
+  {
+      // sparse and dense long bitsets: the vector kernels switch to
+      // one index at a time near the end of the output
+      const std::size_t sz = 8 * 600 + 3;
+      bitset_type sparse(sz), dense(sz);
+      for (std::size_t i = 0; i < sz; ++i) {
+          if (i % 211 == 7 || i % 997 == 0)
+              sparse.set(i);
+          if (i % 5 != 3)
+              dense.set(i);
+      }
+      Tests::set_bits(sparse);
+      Tests::set_bits(dense);
+      Tests::set_bits(bitset_type(sz).set());
+      Tests::set_bits(bitset_type(sz).set(sz - 1));
+      Tests::set_bits(bitset_type(sz));
+  }
+  //=====================================================================
   // Test operator==
   {
     boost::dynamic_bitset<Block> a, b;
@@ -432,6 +752,42 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     assert(!(a < b));
   }
   //=====================================================================
+  // Test find_first_difference() and find_last_difference()
+  {
+    Tests::rscan_kernels();
+  }
+  {
+    boost::dynamic_bitset<Block> a, b;
+    Tests::find_difference(a, b);
+  }
+  {
+    boost::dynamic_bitset<Block> a(std::string("10")), b(std::string("11"));
+    Tests::find_difference(a, b);
+  }
+  {
+    boost::dynamic_bitset<Block> a(long_string), b(long_string);
+    Tests::find_difference(a, b);
+    b[long_string.size()/2].flip();
+    Tests::find_difference(a, b);
+  }
+  {
+    // on both sides of the vectors of the kernels
+    const std::size_t n = very_long_string.size();
+    const std::size_t positions[] = { 0, 1, 63, 64, 255, 256, n/2, n - 65, n - 64, n - 1 };
+    for (std::size_t i = 0; i < sizeof positions / sizeof positions[0]; ++i) {
+      for (std::size_t j = i; j < sizeof positions / sizeof positions[0]; ++j) {
+        boost::dynamic_bitset<Block> a(very_long_string), b(very_long_string);
+        b[positions[i]].flip();
+        Tests::find_difference(a, b);
+        b[positions[j]].flip();
+        Tests::find_difference(a, b);
+        Tests::operator_less_than(a, b);
+        Tests::operator_less_than(b, a);
+        Tests::operator_equal(a, b);
+      }
+    }
+  }
+  //=====================================================================
   // Test operator<=
   {
     boost::dynamic_bitset<Block> a, b;
@@ -603,6 +959,32 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     Tests::operator_shift_right(b, pos);
   }
   //=====================================================================
+  // Test or_shifted(), and_shifted(), xor_shifted() and andnot_shifted()
+  {
+    boost::dynamic_bitset<Block> a, b;
+    Tests::shifted_operations(a, b, 0);
+    Tests::shifted_operations(a, b, -1);
+  }
+  {
+    boost::dynamic_bitset<Block> a(std::string("1011")), b(std::string("0110"));
+    for (int k = -5; k <= 5; ++k)
+      Tests::shifted_operations(a, b, k);
+  }
+  {
+    // whole blocks, whole bytes and odd bits, around the vectors of the
+    // kernels, and past the end
+    const std::size_t n = very_long_string.size();
+    const std::ptrdiff_t shifts[] = { 0, 1, 7, 8, 9, 63, 64, 65, 257, 513,
+        static_cast<std::ptrdiff_t>(n / 2), static_cast<std::ptrdiff_t>(n - 1),
+        static_cast<std::ptrdiff_t>(n), static_cast<std::ptrdiff_t>(n + 100) };
+    boost::dynamic_bitset<Block> a(very_long_string), b(very_long_string);
+    b.flip(0, n / 3);
+    for (std::size_t i = 0; i < sizeof shifts / sizeof shifts[0]; ++i) {
+      Tests::shifted_operations(a, b, shifts[i]);
+      Tests::shifted_operations(a, b, -shifts[i]);
+    }
+  }
+  //=====================================================================
   // Test a & b
   {
     boost::dynamic_bitset<Block> lhs, rhs;
@@ -620,6 +1002,12 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     boost::dynamic_bitset<Block> lhs(long_string.size(), 1), rhs(long_string);
     Tests::operator_and(lhs, rhs);
   }
+  {
+    boost::dynamic_bitset<Block> lhs(very_long_string);
+    boost::dynamic_bitset<Block> rhs(very_long_string.size(), 0xABCDul);
+    rhs.flip();
+    Tests::operator_and(lhs, rhs);
+  }
   //=====================================================================
   // Test a | b
   {
@@ -638,6 +1026,12 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     boost::dynamic_bitset<Block> lhs(long_string.size(), 1), rhs(long_string);
     Tests::operator_or(lhs, rhs);
   }
+  {
+    boost::dynamic_bitset<Block> lhs(very_long_string);
+    boost::dynamic_bitset<Block> rhs(very_long_string.size(), 0xABCDul);
+    rhs.flip();
+    Tests::operator_or(lhs, rhs);
+  }
   //=====================================================================
   // Test a^b
   {
@@ -656,6 +1050,12 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     boost::dynamic_bitset<Block> lhs(long_string.size(), 1), rhs(long_string);
     Tests::operator_xor(lhs, rhs);
   }
+  {
+    boost::dynamic_bitset<Block> lhs(very_long_string);
+    boost::dynamic_bitset<Block> rhs(very_long_string.size(), 0xABCDul);
+    rhs.flip();
+    Tests::operator_xor(lhs, rhs);
+  }
   //=====================================================================
   // Test a-b
   {
@@ -674,6 +1074,68 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
     boost::dynamic_bitset<Block> lhs(long_string.size(), 1), rhs(long_string);
     Tests::operator_sub(lhs, rhs);
   }
+  {
+    boost::dynamic_bitset<Block> lhs(very_long_string);
+    boost::dynamic_bitset<Block> rhs(very_long_string.size(), 0xABCDul);
+    rhs.flip();
+    Tests::operator_sub(lhs, rhs);
+  }
+  //=====================================================================
+  // Test the results of the bitwise operators
+  {
+    boost::dynamic_bitset<Block> a, b, c;
+    Tests::bitwise_operator_results(a, b, c);
+  }
+  {
+    boost::dynamic_bitset<Block> a(std::string("1")), b(std::string("1")),
+                                 c(std::string("0"));
+    Tests::bitwise_operator_results(a, b, c);
+  }
+  {
+    boost::dynamic_bitset<Block> a(long_string), b(long_string.size(), 0xABCDul);
+    boost::dynamic_bitset<Block> c(long_string.size(), 1);
+    Tests::bitwise_operator_results(a, b, c);
+  }
+  {
+    // several chunks, and sizes that are not a multiple of the chunk
+    for (std::size_t n = very_long_string.size(); n > 0; n /= 3) {
+      const std::string s = very_long_string.substr(0, n);
+      boost::dynamic_bitset<Block> a(s), b(s), c(n, 0xCAFEul);
+      b.flip();
+      b <<= 5;
+      for (int i = 0; i < 16; ++i)
+        b |= (a << (13 * i));
+      Tests::bitwise_operator_results(a, b, c);
+      Tests::bitwise_operator_results(c, a, b);
+    }
+  }
+  //=====================================================================
+  // Test bitset_expr()
+  {
+    boost::dynamic_bitset<Block> a, b, c, d;
+    Tests::bitset_expressions(a, b, c, d);
+  }
+  {
+    // several chunks of the evaluation, and sizes that are not a
+    // multiple of one
+    const std::size_t sizes[] = { 1, long_string.size(), very_long_string.size(),
+                                  3 * 8 * 2048 + 77 };
+    for (std::size_t i = 0; i < sizeof sizes / sizeof sizes[0]; ++i) {
+      const std::size_t n = sizes[i];
+      boost::dynamic_bitset<Block> a(n), b(n), c(n), d(n);
+      for (std::size_t k = 0; k < n; ++k) {
+        a[k] = very_long_string[k % very_long_string.size()] == '1';
+        b[k] = k % 3 == 0;
+        c[k] = k % 7 < 3;
+        d[k] = ((k * 2654435761u) >> 7) & 1;
+      }
+      Tests::bitset_expressions(a, b, c, d);
+      // only the last bit on, in the last chunk
+      a.reset();
+      a.set(n - 1);
+      Tests::bitset_expressions(a, a, b, b);
+    }
+  }
 }
 
 int
@@ -56,6 +56,47 @@ std::wstring widen_string( const std::string & str,
 }
 #endif
 
+#if !defined BOOST_OLD_IOSTREAMS
+// A stream buffer over a string which shows at most chunk characters
+// in its get area at a time, or none at all if chunk is 0 (then every
+// character goes through underflow() and uflow()).
+class chunked_buf : public std::streambuf
+{
+  std::string m_str;
+  std::size_t m_pos;
+  std::size_t m_chunk;
+
+public:
+  chunked_buf(const std::string & str, std::size_t chunk)
+    : m_str(str), m_pos(0), m_chunk(chunk) {}
+
+protected:
+  int_type underflow()
+  {
+    if (gptr() != egptr())
+      return traits_type::to_int_type(*gptr());
+    if (m_pos == m_str.size())
+      return traits_type::eof();
+    if (m_chunk == 0)
+      return traits_type::to_int_type(m_str[m_pos]);
+
+    char * const p = &m_str[0] + m_pos;
+    m_pos = (std::min)(m_pos + m_chunk, m_str.size());
+    setg(p, p, &m_str[0] + m_pos);
+    return traits_type::to_int_type(*p);
+  }
+
+  int_type uflow()
+  {
+    if (m_chunk != 0)
+      return std::streambuf::uflow();
+    if (m_pos == m_str.size())
+      return traits_type::eof();
+    return traits_type::to_int_type(m_str[m_pos++]);
+  }
+};
+#endif
+
 template <typename Block>
 void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
 {
@@ -82,7 +123,8 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
                                   std::string("0"),
                                   std::string("1"),
                                   std::string("11100"),
-                                  get_long_string()
+                                  get_long_string(),
+                                  get_very_long_string()
                                 };
 
     char fill_chars[] =         { '*', 'x', ' ' };
@@ -218,7 +260,13 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
             long_string,
             "  " + long_string + " xyz",
             spaces + long_string,
-            spaces + long_string + spaces
+            spaces + long_string + spaces,
+
+            // long enough for the vector kernels, stopping at a
+            // non digit anywhere
+            get_very_long_string(),
+            spaces + get_very_long_string() + "x" + long_string,
+            get_very_long_string().substr(0, 3001) + "2" + long_string
     };
 
 
@@ -306,12 +354,77 @@ void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block) )
         }
 #endif // BOOST_DYNAMIC_BITSET_NO_WCHAR_T_TESTS
 
+#if !defined BOOST_OLD_IOSTREAMS
+        // test 3 - stream buffers with a small get area, or none
+        {
+          const std::size_t chunks[] = { 0, 1, 7, 64, 100 };
+          for (std::size_t ci = 0; ci < sizeof chunks / sizeof chunks[0]; ++ci) {
+            bitset_type b(1, 255ul);
+            chunked_buf buf(strings[si], chunks[ci]);
+            std::istream stream(&buf);
+            stream.width(w);
+            stream.exceptions(masks[mi]);
+            Tests::stream_extractor(b, stream, strings[si]);
+          }
+        }
+#endif
+
       }
     }
 
   } // for ( mi = 0; ...)
 
 
+  }
+  //=====================================================================
+  // Test write_binary(), read_binary() and mapped_dynamic_bitset
+  {
+    Tests::binary_format(bitset_type());
+    Tests::binary_format(bitset_type(std::string("1")));
+    Tests::binary_format(bitset_type(get_long_string()));
+    bitset_type b(64 * 8 * 3);
+    for (std::size_t i = 0; i < b.size(); i += 7)
+      b.set(i);
+    Tests::binary_format(b);
+    b.resize(b.size() + 9, true);
+    Tests::binary_format(b);
+  }
+  //=====================================================================
+  // Test to_hex_string(), from_hex(), to_base64() and from_base64()
+  {
+    const std::string strings[] = {
+      std::string(), std::string("1"), std::string("1011"), std::string("10110"),
+      get_long_string(), get_very_long_string()
+    };
+    for (std::size_t i = 0; i < sizeof strings / sizeof strings[0]; ++i) {
+      Tests::hex(bitset_type(strings[i]));
+      Tests::base64(bitset_type(strings[i]));
+      Tests::hex_kernels(bitset_type(strings[i]));
+      Tests::base64_kernels(bitset_type(strings[i]));
+    }
+    bitset_type b(64 * 16 * 3 + 5);
+    for (std::size_t i = 0; i < b.size(); i += 5)
+      b.set(i);
+    b.set(b.size() - 1);
+    Tests::hex(b);
+    Tests::base64(b);
+    Tests::hex_kernels(b);
+    Tests::base64_kernels(b);
+  }
+  //=====================================================================
+  // Test hash_value(), std::hash and dynamic_bitset_hasher
+  {
+    Tests::hash(bitset_type());
+    Tests::hash(bitset_type(std::string("1")));
+    Tests::hash(bitset_type(std::string("0")));
+    Tests::hash(bitset_type(get_long_string()));
+    Tests::hash(bitset_type(get_very_long_string()));
+    for (std::size_t n = 500; n < 530; ++n) {
+      bitset_type b(n);
+      for (std::size_t i = 0; i < n; i += 3)
+        b.set(i);
+      Tests::hash(b);
+    }
   }
   //=====================================================================
   // << Any other tests go here >>
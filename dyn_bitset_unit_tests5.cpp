@@ -0,0 +1,152 @@
+// -----------------------------------------------------------
+// dyn_bitset_unit_tests5.cpp
+//
+//       Tests of the small and compact block buffers
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#include "bitset_test.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset.hpp"
+#include "boost/limits.hpp"
+#include "boost/config.hpp"
+
+#include "boost/detail/workaround.hpp"
+
+
+// Codewarrior 8.3 for Win fails without this.
+// Thanks Howard Hinnant ;)
+#if defined __MWERKS__ && BOOST_WORKAROUND(__MWERKS__, <= 0x3003) // 8.x
+# pragma parse_func_templ off
+#endif
+
+
+// dynamic_bitset<Block, dynamic_bitset_small_buffer<N, Allocator> >
+// and dynamic_bitset<Block, dynamic_bitset_compact_buffer<Allocator> >
+template <typename Block, typename Allocator>
+void run_test_cases( BOOST_EXPLICIT_TEMPLATE_TYPE(Block)
+                     BOOST_APPEND_EXPLICIT_TEMPLATE_TYPE(Allocator) )
+{
+  typedef boost::dynamic_bitset<Block, Allocator> bitset_type;
+  typedef bitset_test<bitset_type> Tests;
+  const int bits_per_block = bitset_type::bits_per_block;
+
+  const std::string long_string = get_long_string();
+  const Block all_1s = static_cast<Block>(-1);
+
+  // empty, inline, exactly full and allocated
+  std::vector<bitset_type> bitsets;
+  bitsets.push_back(bitset_type());
+  bitsets.push_back(bitset_type(std::string("1")));
+  bitsets.push_back(bitset_type(bits_per_block + 1, 5ul));
+  bitsets.push_back(bitset_type(2 * bits_per_block, 0ul));
+  bitsets.back().set();
+  bitsets.push_back(bitset_type(long_string));
+
+  //=====================================================================
+  // Test construction
+  {
+    Tests::from_unsigned_long(0, 1ul);
+    Tests::from_unsigned_long(bits_per_block, 3ul);
+    Tests::from_unsigned_long(3 * bits_per_block, 7ul);
+    Tests::from_string(long_string, 0, long_string.size());
+    Tests::from_string(long_string, 0, 3, 2 * bits_per_block);
+  }
+  {
+    std::vector<Block> blocks;
+    Tests::from_block_range(blocks);
+    blocks.push_back(all_1s);
+    Tests::from_block_range(blocks);
+    blocks.push_back(static_cast<Block>(1));
+    Tests::from_block_range(blocks);
+    blocks.push_back(static_cast<Block>(0));
+    Tests::from_block_range(blocks);
+  }
+  //=====================================================================
+  // Test copying, moving, swapping and size changing operations
+  for (std::size_t i = 0; i < bitsets.size(); ++i) {
+    const bitset_type& a = bitsets[i];
+    Tests::to_block_range(a);
+    Tests::copy_constructor(a);
+    Tests::resize(a);
+    Tests::clear(a);
+    Tests::append_bit(a);
+    Tests::reserve(a);
+    Tests::append_block(a);
+    std::vector<Block> blocks(3, all_1s);
+    Tests::append_block_range(a, blocks);
+    Tests::block_storage(a);
+    Tests::block_range_interoperation(a);
+    for (std::size_t j = 0; j < bitsets.size(); ++j) {
+      const bitset_type& b = bitsets[j];
+      Tests::assignment_operator(a, b);
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+      Tests::move_assignment_operator(a, b);
+#endif
+    }
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    Tests::move_constructor(a);
+#endif
+  }
+  //=====================================================================
+  // Test bitwise operations and lookups
+  for (std::size_t i = 0; i < bitsets.size(); ++i) {
+    const bitset_type& a = bitsets[i];
+    bitset_type b(a);
+    b.flip();
+    if (a.size() > 0)
+      b[a.size() / 2] = a[a.size() / 2];
+    Tests::and_assignment(a, b);
+    Tests::or_assignment(a, b);
+    Tests::xor_assignment(a, b);
+    Tests::sub_assignment(a, b);
+    Tests::shift_left_assignment(a, 1);
+    Tests::shift_right_assignment(a, bits_per_block + 1);
+    Tests::flip_all(a);
+    Tests::count(a);
+    Tests::fused_counts(a, b);
+    Tests::find_first(a);
+    Tests::find_last(a);
+    Tests::find_first_zero(a);
+    Tests::intersects(a, b);
+    Tests::subset(a, b);
+    Tests::operator_equal(a, b);
+    Tests::operator_less_than(a, b);
+    Tests::to_string(a);
+  }
+}
+
+int
+test_main(int, char*[])
+{
+  run_test_cases<unsigned char, boost::dynamic_bitset_small_buffer<2> >();
+  run_test_cases<unsigned short, boost::dynamic_bitset_small_buffer<2> >();
+  run_test_cases<unsigned int, boost::dynamic_bitset_small_buffer<2> >();
+  run_test_cases<unsigned long, boost::dynamic_bitset_small_buffer<2> >();
+  run_test_cases<unsigned long,
+      boost::dynamic_bitset_small_buffer<1, std::allocator<unsigned long> > >();
+# ifdef BOOST_HAS_LONG_LONG
+  run_test_cases< ::boost::ulong_long_type, boost::dynamic_bitset_small_buffer<2> >();
+# endif
+
+  run_test_cases<unsigned char, boost::dynamic_bitset_compact_buffer<> >();
+  run_test_cases<unsigned short, boost::dynamic_bitset_compact_buffer<> >();
+  run_test_cases<unsigned int, boost::dynamic_bitset_compact_buffer<> >();
+  run_test_cases<unsigned long, boost::dynamic_bitset_compact_buffer<> >();
+  run_test_cases<unsigned long,
+      boost::dynamic_bitset_compact_buffer<std::allocator<unsigned long> > >();
+# ifdef BOOST_HAS_LONG_LONG
+  run_test_cases< ::boost::ulong_long_type, boost::dynamic_bitset_compact_buffer<> >();
+# endif
+
+  // the compact storage is a single pointer
+  BOOST_CHECK(sizeof(boost::dynamic_bitset<unsigned char,
+                       boost::dynamic_bitset_compact_buffer<> >) == sizeof(void*));
+  BOOST_CHECK(sizeof(boost::dynamic_bitset<unsigned long,
+                       boost::dynamic_bitset_compact_buffer<> >) == sizeof(void*));
+
+  return 0;
+}
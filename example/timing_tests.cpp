@@ -42,6 +42,11 @@
 
 #include <typeinfo>
 #include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
 #if !defined(BOOST_OLD_IOSTREAMS)
 # include <ostream>
 #endif
@@ -51,6 +56,15 @@
 #include "boost/version.hpp"
 #include "boost/timer.hpp"
 #include "boost/dynamic_bitset.hpp"
+#include "boost/dynamic_bitset/hierarchical_bitset.hpp"
+#include "boost/dynamic_bitset/roaring_bitset.hpp"
+#include "boost/dynamic_bitset/ewah_bitset.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset_view.hpp"
+#include "boost/dynamic_bitset/binary_format.hpp"
+#include "boost/dynamic_bitset/text_codecs.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset_hasher.hpp"
+#include "boost/functional/hash.hpp"
+#include "boost/detail/dynamic_bitset_kernels.hpp"
 
 
 namespace {
@@ -124,6 +138,905 @@ void timing_test(T* = 0) // dummy parameter to workaround VC6
 }
 
 
+// Times each population count kernel on the same buffer; count()
+// uses the fastest one which is supported by the running processor.
+//
+template <typename T>
+void count_kernels_timing_test(T* = 0)
+{
+    using namespace boost::detail::dynamic_bitset_impl;
+
+    const unsigned long num = 1000;
+    const std::size_t sz = 1000000;
+
+    boost::dynamic_bitset<T> bs(sz);
+    for (std::size_t i = 0; i < sz; ++i)
+        if (((i * 2654435761ul) >> 13) & 1)
+            bs.set(i);
+
+    std::vector<T> blocks(bs.num_blocks());
+    to_block_range(bs, blocks.begin());
+    const byte_type * const p = object_representation(&blocks[0]);
+    const std::size_t len = blocks.size() * sizeof(T);
+
+    std::cout << "\nCount kernels, dynamic_bitset<" << typeid(T).name()
+              << "> of " << sz << " bits  [" << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    const count_kernel kernels[] = {
+        count_by_table, count_by_popcnt, count_by_avx2, count_by_avx512
+    };
+    for (std::size_t k = 0; k < sizeof kernels / sizeof kernels[0]; ++k) {
+        std::cout << count_kernel_name(kernels[k]) << ":\t";
+        if (!count_kernel_available(kernels[k])) {
+            std::cout << "not supported\n";
+            continue;
+        }
+
+        const count_function f = count_kernel_function(kernels[k]);
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            dummy += f(p, len - (i & 1)); // defeat hoisting out of the loop
+
+        const double elaps = time.elapsed();
+        std::cout << "Elapsed: " << elaps << "  (total count: " << dummy << ")\n";
+    }
+    std::cout << "count() uses: "
+              << count_kernel_name(best_count_kernel()) << "\n\n";
+}
+
+// (a & b).count() computed a step at a time vs. intersection_count()
+template <typename T>
+void intersection_count_timing_test(T* = 0)
+{
+    const unsigned long num = 1000;
+    const std::size_t sz = 1000000;
+
+    boost::dynamic_bitset<T> a(sz), b(sz);
+    for (std::size_t i = 0; i < sz; ++i) {
+        if (((i * 2654435761ul) >> 13) & 1)
+            a.set(i);
+        if (((i * 40503ul) >> 7) & 1)
+            b.set(i);
+    }
+
+    std::cout << "\nIntersection count, dynamic_bitset<" << typeid(T).name()
+              << "> of " << sz << " bits  [" << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            boost::dynamic_bitset<T> x(a);
+            x &= b;
+            dummy += x.count();
+        }
+        const double elaps = time.elapsed();
+        std::cout << "copy, &=, count():\tElapsed: " << elaps
+                  << "  (total count: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            dummy += intersection_count(a, b);
+        const double elaps = time.elapsed();
+        std::cout << "intersection_count():\tElapsed: " << elaps
+                  << "  (total count: " << dummy << ")\n";
+    }
+}
+
+// push_back() of single bits, as when a decoder builds a bitset
+template <typename T>
+void push_back_timing_test(T* = 0)
+{
+    const std::size_t sz = 100000000;
+
+    std::cout << "\npush_back(), dynamic_bitset<" << typeid(T).name()
+              << "> of " << sz << " bits\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        boost::timer time;
+        boost::dynamic_bitset<T> b;
+        for (std::size_t i = 0; i < sz; ++i)
+            b.push_back(((i * 2654435761ul) >> 13) & 1);
+        const double elaps = time.elapsed();
+        std::cout << "push_back():\t\tElapsed: " << elaps
+                  << "  (count: " << b.count() << ")\n";
+    }
+    {
+        boost::timer time;
+        boost::dynamic_bitset<T> b;
+        b.reserve(sz);
+        for (std::size_t i = 0; i < sz; ++i)
+            b.push_back(((i * 2654435761ul) >> 13) & 1);
+        const double elaps = time.elapsed();
+        std::cout << "reserve(), push_back():\tElapsed: " << elaps
+                  << "  (count: " << b.count() << ")\n";
+    }
+}
+
+// find_first()/find_next() walks and none() over a sparse bitset,
+// whose set bits are separated by long runs of zero blocks
+template <typename T>
+void find_next_timing_test(T* = 0)
+{
+    const unsigned long num = 100;
+    const std::size_t sz = 100000000;
+
+    boost::dynamic_bitset<T> b(sz);
+    for (std::size_t i = 0; i < sz; i += 20000 + ((i * 2654435761ul) >> 7) % 20000)
+        b.set(i);
+
+    std::cout << "\nfind_next(), dynamic_bitset<" << typeid(T).name()
+              << "> of " << sz << " bits, " << b.count() << " on  ["
+              << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            for (std::size_t pos = b.find_first(); pos != b.npos; pos = b.find_next(pos))
+                dummy += pos;
+        const double elaps = time.elapsed();
+        std::cout << "find_first(), find_next():\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        boost::dynamic_bitset<T> z(sz);
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            z[i] = false;
+            dummy += z.none();
+        }
+        const double elaps = time.elapsed();
+        std::cout << "none():\t\t\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+// the positions of the set bits of a bitset with one bit in eight on:
+// find_next() walk, set_bits() iteration and decode_set_bits()
+template <typename T>
+void set_bits_timing_test(T* = 0)
+{
+    const unsigned long num = 20;
+    const std::size_t sz = 10000000;
+
+    boost::dynamic_bitset<T> b(sz);
+    for (std::size_t i = 0; i < sz; ++i)
+        if (((i * 2654435761ul) >> 11) % 8 == 0)
+            b.set(i);
+    std::vector<boost::uint32_t> out(b.count());
+
+    std::cout << "\nset bit positions, dynamic_bitset<" << typeid(T).name()
+              << "> of " << sz << " bits, " << b.count() << " on  ["
+              << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            for (std::size_t pos = b.find_first(); pos != b.npos; pos = b.find_next(pos))
+                dummy += pos;
+        const double elaps = time.elapsed();
+        std::cout << "find_first(), find_next():\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            typedef typename boost::dynamic_bitset<T>::set_bit_iterator iterator;
+            const iterator last = b.set_bits().end();
+            for (iterator it = b.set_bits().begin(); it != last; ++it)
+                dummy += *it;
+        }
+        const double elaps = time.elapsed();
+        std::cout << "set_bits():\t\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            dummy += out[b.decode_set_bits(&out[0]) / 2];
+        const double elaps = time.elapsed();
+        std::cout << "decode_set_bits():\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+// find_next() and find_prev() walks over a huge universe with a few
+// thousand bits on: dynamic_bitset vs. hierarchical_bitset
+template <typename T>
+void hierarchical_timing_test(T* = 0)
+{
+    const unsigned long num = 10;
+    const std::size_t sz = 500000000;
+
+    boost::dynamic_bitset<T> b(sz);
+    for (std::size_t i = 0; i < sz; i += 50000 + ((i * 2654435761ul) >> 7) % 150000)
+        b.set(i);
+    const boost::hierarchical_bitset<T> h(b);
+
+    std::cout << "\nhierarchical_bitset, dynamic_bitset<" << typeid(T).name()
+              << "> of " << sz << " bits, " << b.count() << " on  ["
+              << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            for (std::size_t pos = b.find_first(); pos != b.npos; pos = b.find_next(pos))
+                dummy += pos;
+            for (std::size_t pos = b.find_last(); pos != b.npos; pos = b.find_prev(pos))
+                dummy += pos;
+        }
+        const double elaps = time.elapsed();
+        std::cout << "dynamic_bitset:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            for (std::size_t pos = h.find_first(); pos != h.npos; pos = h.find_next(pos))
+                dummy += pos;
+            for (std::size_t pos = h.find_last(); pos != h.npos; pos = h.find_prev(pos))
+                dummy += pos;
+        }
+        const double elaps = time.elapsed();
+        std::cout << "hierarchical_bitset:\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        boost::hierarchical_bitset<T> x(h);
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < 1000; ++i) {
+            x ^= h;
+            dummy += x.count();
+        }
+        const double elaps = time.elapsed();
+        std::cout << "^=, count() [1000 iterations]:\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+// & and | of two sets whose density changes every 2^20 bits, from
+// 0.001% to 90%: dynamic_bitset vs. roaring_bitset
+template <typename T>
+void roaring_timing_test(T* = 0)
+{
+    const unsigned long num = 20;
+    const std::size_t sz = std::size_t(1) << 28;
+    const unsigned long per_million[] = { 10, 100, 1000, 50000, 500000, 900000 };
+    const std::size_t densities = sizeof per_million / sizeof per_million[0];
+
+    boost::dynamic_bitset<T> a(sz), b(sz);
+    for (std::size_t i = 0; i < sz; ++i) {
+        const unsigned long d = per_million[(i >> 20) % densities];
+        if (((i * 2654435761ul) >> 5) % 1000000 < d)
+            a.set(i);
+        if (((i * 40503ul + 7) * 2654435761ul >> 9) % 1000000 < d)
+            b.set(i);
+    }
+    const boost::roaring_bitset ra(a), rb(b);
+
+    std::cout << "\nroaring_bitset, dynamic_bitset<" << typeid(T).name()
+              << "> of " << sz << " bits, " << a.count() << " on  ["
+              << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+    std::cout << "bytes:\t\t\t" << a.num_blocks() * sizeof(T) << " vs. "
+              << ra.memory_usage() << " (serialized: " << ra.serialized_size() << ")\n";
+
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            dummy += boost::dynamic_bitset<T>(a & b).count();
+            dummy += boost::dynamic_bitset<T>(a | b).count();
+        }
+        const double elaps = time.elapsed();
+        std::cout << "dynamic_bitset &, |:\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            dummy += (ra & rb).count();
+            dummy += (ra | rb).count();
+        }
+        const double elaps = time.elapsed();
+        std::cout << "roaring_bitset &, |:\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+template <typename T>
+void ewah_timing_test(T* = 0)
+{
+    const unsigned long num = 20;
+    const std::size_t sz = std::size_t(1) << 28;
+
+    // the bitmaps of a sorted column: long runs, with a few scattered
+    // bits between them
+    boost::dynamic_bitset<T> a(sz), b(sz);
+    for (std::size_t i = 0; i < sz; ++i) {
+        const std::size_t h = (i * 2654435761ul) >> 5;
+        a[i] = (i >> 16) % 7 == 0 || h % 100000 == 0;
+        b[i] = ((i + 12345) >> 15) % 5 == 0 || h % 77777 == 1;
+    }
+    const boost::ewah_bitset<T> ea(a), eb(b);
+
+    std::cout << "\newah_bitset, dynamic_bitset<" << typeid(T).name()
+              << "> of " << sz << " bits, " << a.count() << " on  ["
+              << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+    std::cout << "bytes:\t\t\t" << a.num_blocks() * sizeof(T) << " vs. "
+              << ea.num_words() * sizeof(T) << "\n";
+
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            dummy += boost::dynamic_bitset<T>(a & b).count();
+            dummy += boost::dynamic_bitset<T>(a ^ b).count();
+        }
+        const double elaps = time.elapsed();
+        std::cout << "dynamic_bitset &, ^:\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            dummy += (ea & eb).count();
+            dummy += (ea ^ eb).count();
+        }
+        const double elaps = time.elapsed();
+        std::cout << "ewah_bitset &, ^:\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+// queries on blocks owned elsewhere: through a view, or copied into a
+// dynamic_bitset first
+template <typename T>
+void view_timing_test(T* = 0)
+{
+    const unsigned long num = 50;
+    const std::size_t sz = std::size_t(1) << 26;
+
+    std::vector<T> blocks(sz / std::numeric_limits<T>::digits);
+    for (std::size_t i = 0; i < blocks.size(); ++i)
+        blocks[i] = static_cast<T>(i * 2654435761ul) & static_cast<T>(i >> 3);
+
+    std::cout << "\ndynamic_bitset_view<" << typeid(T).name()
+              << "> of " << sz << " bits  [" << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            boost::dynamic_bitset<T> b(sz);
+            boost::from_block_range(blocks.begin(), blocks.end(), b);
+            dummy += b.count() + b.find_next(i);
+        }
+        const double elaps = time.elapsed();
+        std::cout << "copy, count:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            const boost::dynamic_bitset_view<const T> v(&blocks[0], sz);
+            dummy += v.count() + v.find_next(i);
+        }
+        const double elaps = time.elapsed();
+        std::cout << "view, count:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+template <typename T>
+void binary_format_timing_test(T* = 0)
+{
+    const unsigned long num = 10;
+    const std::size_t sz = std::size_t(1) << 30;
+    const char* const file_name = "timing_tests_binary_format.tmp";
+
+    {
+        boost::dynamic_bitset<T> b(sz);
+        for (std::size_t i = 0; i < sz; i += 3)
+            b.set(i);
+        std::ofstream f(file_name, std::ios::binary);
+        boost::write_binary(f, b);
+    }
+
+    std::cout << "\nbinary format, dynamic_bitset<" << typeid(T).name()
+              << "> of " << sz << " bits  [" << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            boost::dynamic_bitset<T> b;
+            std::ifstream f(file_name, std::ios::binary);
+            boost::read_binary(f, b);
+            dummy += b.size();
+        }
+        const double elaps = time.elapsed();
+        std::cout << "read_binary:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            const boost::mapped_dynamic_bitset<T> m(file_name);
+            dummy += m.size() + m.bits().find_next(i);
+        }
+        const double elaps = time.elapsed();
+        std::cout << "mapped_dynamic_bitset:\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    std::remove(file_name);
+}
+
+
+template <typename T>
+void parse_timing_test(T* = 0)
+{
+    const unsigned long num = 20;
+    const std::size_t sz = std::size_t(1) << 24;
+
+    std::string str(sz, '0');
+    for (std::size_t i = 0; i < sz; ++i)
+        if ((i * 2654435761ul) & (i >> 3) & 1)
+            str[i] = '1';
+
+    std::cout << "\nparsing " << sz << " characters into dynamic_bitset<"
+              << typeid(T).name() << ">  [" << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        // what the string constructor used to do
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            boost::dynamic_bitset<T> b(sz);
+            for (std::size_t j = 0; j < sz; ++j)
+                if (str[sz - 1 - j] == '1')
+                    b.set(j);
+            dummy += b.find_next(i);
+        }
+        const double elaps = time.elapsed();
+        std::cout << "per character:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            boost::dynamic_bitset<T> b;
+            if (boost::from_chars(str.data(), str.data() + sz, b) == boost::bitset_parse_ok)
+                dummy += b.find_next(i);
+        }
+        const double elaps = time.elapsed();
+        std::cout << "from_chars:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+template <typename T>
+void extraction_timing_test(T* = 0)
+{
+    const unsigned long num = 10;
+    const std::size_t sz = std::size_t(1) << 24;
+
+    std::string str(sz, '0');
+    for (std::size_t i = 0; i < sz; ++i)
+        if ((i * 2654435761ul) & (i >> 3) & 1)
+            str[i] = '1';
+
+    std::cout << "\noperator>> of " << sz << " bits into dynamic_bitset<"
+              << typeid(T).name() << ">  [" << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            std::istringstream is(str);
+            boost::dynamic_bitset<T> b;
+            is >> b;
+            dummy += b.find_next(i);
+        }
+        const double elaps = time.elapsed();
+        std::cout << "istringstream:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+// discards what is written to it, through a put area of 4096
+// characters
+class null_streambuf : public std::streambuf
+{
+    char m_area[4096];
+
+public:
+    std::size_t count;
+
+    null_streambuf() : count(0) { setp(m_area, m_area + sizeof m_area); }
+
+protected:
+    int_type overflow(int_type c)
+    {
+        count += pptr() - pbase();
+        setp(m_area, m_area + sizeof m_area);
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+            sputc(traits_type::to_char_type(c));
+        return traits_type::not_eof(c);
+    }
+};
+
+template <typename T>
+void insertion_timing_test(T* = 0)
+{
+    const unsigned long num = 10;
+    const std::size_t sz = std::size_t(1) << 24;
+
+    boost::dynamic_bitset<T> b(sz);
+    for (std::size_t i = 0; i < sz; ++i)
+        if ((i * 2654435761ul) & (i >> 3) & 1)
+            b.set(i);
+
+    std::cout << "\noperator<< and to_string of dynamic_bitset<"
+              << typeid(T).name() << "> of " << sz << " bits  [" << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        // what operator<< used to do
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            null_streambuf buf;
+            for (std::size_t j = sz; j != 0; --j)
+                buf.sputc(b.test(j - 1) ? '1' : '0');
+            dummy += buf.count;
+        }
+        const double elaps = time.elapsed();
+        std::cout << "per bit:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            null_streambuf buf;
+            std::ostream os(&buf);
+            os << b;
+            dummy += buf.count;
+        }
+        const double elaps = time.elapsed();
+        std::cout << "operator<<:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            std::string s;
+            boost::to_string(b, s);
+            dummy += s[i];
+        }
+        const double elaps = time.elapsed();
+        std::cout << "to_string:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+template <typename T>
+void text_codecs_timing_test(T* = 0)
+{
+    const unsigned long num = 10;
+    const std::size_t sz = std::size_t(1) << 24;
+
+    boost::dynamic_bitset<T> b(sz);
+    for (std::size_t i = 0; i < sz; ++i)
+        if ((i * 2654435761ul) & (i >> 3) & 1)
+            b.set(i);
+
+    std::cout << "\nhexadecimal and base64 text of dynamic_bitset<"
+              << typeid(T).name() << "> of " << sz << " bits  [" << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    std::string hex;
+    {
+        // a digit at a time
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            hex.resize(sz / 4);
+            for (std::size_t d = 0; d < sz / 4; ++d) {
+                const std::size_t pos = sz - 4 * (d + 1);
+                const unsigned v = b.test(pos) | b.test(pos + 1) << 1
+                                 | b.test(pos + 2) << 2 | b.test(pos + 3) << 3;
+                hex[d] = "0123456789abcdef"[v];
+            }
+            dummy += hex[i];
+        }
+        const double elaps = time.elapsed();
+        std::cout << "per digit:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            boost::to_hex_string(b, hex);
+            dummy += hex[i];
+        }
+        const double elaps = time.elapsed();
+        std::cout << "to_hex_string:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            boost::dynamic_bitset<T> c;
+            boost::from_hex(hex.data(), hex.data() + hex.size(), c);
+            dummy += c.size();
+        }
+        const double elaps = time.elapsed();
+        std::cout << "from_hex:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+
+    std::string text;
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            boost::to_base64(b, text);
+            dummy += text[i];
+        }
+        const double elaps = time.elapsed();
+        std::cout << "to_base64:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            boost::dynamic_bitset<T> c;
+            boost::from_base64(text.data(), text.data() + text.size(), c);
+            dummy += c.size();
+        }
+        const double elaps = time.elapsed();
+        std::cout << "from_base64:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+template <typename T>
+void hash_timing_test(T* = 0)
+{
+    const unsigned long num = 100;
+    const std::size_t sz = std::size_t(1) << 20;
+
+    boost::dynamic_bitset<T> b(sz);
+    for (std::size_t i = 0; i < sz; ++i)
+        if ((i * 2654435761ul) & (i >> 3) & 1)
+            b.set(i);
+    std::vector<T> blocks;
+    boost::to_block_range(b, std::back_inserter(blocks));
+
+    std::cout << "\nhash of dynamic_bitset<"
+              << typeid(T).name() << "> of " << sz << " bits  [" << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        // what hash_value used to do
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            std::size_t h = boost::hash_value(b.size());
+            boost::hash_combine(h, boost::hash_range(blocks.begin(), blocks.end()));
+            dummy += h;
+        }
+        const double elaps = time.elapsed();
+        std::cout << "hash_combine:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            dummy += hash_value(b);
+        const double elaps = time.elapsed();
+        std::cout << "hash_value:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            boost::dynamic_bitset_hasher<T> h;
+            h.append(blocks.begin(), blocks.end());
+            dummy += h.value();
+        }
+        const double elaps = time.elapsed();
+        std::cout << "hasher:\t\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+template <typename T>
+void comparison_timing_test(T* = 0)
+{
+    const unsigned long num = 1000;
+    const std::size_t sz = std::size_t(1) << 20;
+
+    // equal but for the lowest bit: the comparisons read everything
+    boost::dynamic_bitset<T> a(sz);
+    for (std::size_t i = 0; i < sz; ++i)
+        if ((i * 2654435761ul) & (i >> 3) & 1)
+            a.set(i);
+    boost::dynamic_bitset<T> b(a);
+    b.flip(0);
+    const boost::dynamic_bitset<T> c(a);
+    std::vector<T> blocks_a, blocks_b;
+    boost::to_block_range(a, std::back_inserter(blocks_a));
+    boost::to_block_range(b, std::back_inserter(blocks_b));
+
+    std::cout << "\ncomparisons of dynamic_bitset<"
+              << typeid(T).name() << "> of " << sz << " bits  [" << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        // what operator< used to do
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            const T* const p = &blocks_a[0];
+            const T* const q = &blocks_b[0];
+            for (std::size_t k = blocks_a.size(); k > 0; --k)
+                if (p[k - 1] != q[k - 1]) {
+                    dummy += p[k - 1] < q[k - 1];
+                    break;
+                }
+        }
+        const double elaps = time.elapsed();
+        std::cout << "block loop <:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            dummy += a < b;
+        const double elaps = time.elapsed();
+        std::cout << "operator<:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            dummy += a == c;
+        const double elaps = time.elapsed();
+        std::cout << "operator==:\t\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+    {
+        std::size_t dummy = 0;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            dummy += find_last_difference(a, b);
+        const double elaps = time.elapsed();
+        std::cout << "find_last_difference:\tElapsed: " << elaps
+                  << "  (dummy: " << dummy << ")\n";
+    }
+}
+
+template <typename T>
+void shift_timing_test(T* = 0)
+{
+    const unsigned long num = 1000;
+    const std::size_t sz = std::size_t(1) << 20;
+    const std::size_t k = 3 * boost::dynamic_bitset<T>::bits_per_block + 5;
+
+    boost::dynamic_bitset<T> a(sz), b(sz);
+    for (std::size_t i = 0; i < sz; ++i) {
+        if ((i * 2654435761ul) & (i >> 3) & 1)
+            a.set(i);
+        if ((i * 40503ul) & (i >> 5) & 1)
+            b.set(i);
+    }
+
+    std::cout << "\nshifts of dynamic_bitset<"
+              << typeid(T).name() << "> of " << sz << " bits  [" << num << " iterations]\n";
+    std::cout << "--------------------------------------------------\n";
+
+    {
+        // what operator<<= used to do
+        std::vector<T> blocks;
+        boost::to_block_range(a, std::back_inserter(blocks));
+        const std::size_t bits = boost::dynamic_bitset<T>::bits_per_block;
+        const std::size_t div = k / bits, r = k % bits;
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i) {
+            T* const p = &blocks[0];
+            for (std::size_t j = blocks.size() - 1 - div; j > 0; --j)
+                p[j + div] = static_cast<T>((p[j] << r) | (p[j - 1] >> (bits - r)));
+            p[div] = static_cast<T>(p[0] << r);
+            std::fill_n(p, div, T(0));
+        }
+        const double elaps = time.elapsed();
+        std::cout << "block loop <<=:\t\tElapsed: " << elaps
+                  << "  (dummy: " << std::size_t(blocks.back()) << ")\n";
+    }
+    {
+        boost::dynamic_bitset<T> x(a);
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            x <<= k;
+        const double elaps = time.elapsed();
+        std::cout << "operator<<=:\t\tElapsed: " << elaps
+                  << "  (dummy: " << x.test(sz - 1) << ")\n";
+    }
+    {
+        boost::dynamic_bitset<T> x(a);
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            x |= b << k;
+        const double elaps = time.elapsed();
+        std::cout << "a |= b << k:\t\tElapsed: " << elaps
+                  << "  (dummy: " << x.test(sz - 1) << ")\n";
+    }
+    {
+        boost::dynamic_bitset<T> x(a);
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            x.or_shifted(b, k);
+        const double elaps = time.elapsed();
+        std::cout << "or_shifted:\t\tElapsed: " << elaps
+                  << "  (dummy: " << x.test(sz - 1) << ")\n";
+    }
+    {
+        boost::dynamic_bitset<T> x(a);
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            x &= b >> 1;
+        const double elaps = time.elapsed();
+        std::cout << "a &= b >> 1:\t\tElapsed: " << elaps
+                  << "  (dummy: " << x.test(0) << ")\n";
+    }
+    {
+        boost::dynamic_bitset<T> x(a);
+        boost::timer time;
+        for (unsigned long i = 0; i < num; ++i)
+            x.and_shifted(b, -1);
+        const double elaps = time.elapsed();
+        std::cout << "and_shifted:\t\tElapsed: " << elaps
+                  << "  (dummy: " << x.test(0) << ")\n";
+    }
+}
 
 int main()
 {
@@ -137,6 +1050,28 @@ int main()
     timing_test< ::boost::ulong_long_type>();
 # endif
 
+    count_kernels_timing_test<unsigned char>();
+    count_kernels_timing_test<unsigned long>();
+    intersection_count_timing_test<unsigned long>();
+    push_back_timing_test<unsigned long>();
+    find_next_timing_test<unsigned long>();
+    set_bits_timing_test<unsigned long>();
+    hierarchical_timing_test<unsigned long>();
+    roaring_timing_test<unsigned long>();
+    ewah_timing_test<unsigned long>();
+    view_timing_test<unsigned long>();
+    binary_format_timing_test<unsigned long>();
+    parse_timing_test<unsigned long>();
+    extraction_timing_test<unsigned long>();
+    insertion_timing_test<unsigned long>();
+    text_codecs_timing_test<unsigned long>();
+    hash_timing_test<unsigned char>();
+    hash_timing_test<unsigned long>();
+    comparison_timing_test<unsigned char>();
+    comparison_timing_test<unsigned long>();
+    shift_timing_test<unsigned char>();
+    shift_timing_test<unsigned long>();
+
     return boost::exit_success;
 }
 
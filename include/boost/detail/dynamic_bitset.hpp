@@ -15,6 +15,7 @@
 #include <cstddef>
 #include "boost/config.hpp"
 #include "boost/detail/workaround.hpp"
+#include "boost/core/allocator_access.hpp"
 
 
 namespace boost {
@@ -159,8 +160,8 @@ namespace boost {
 
       typedef typename T::allocator_type allocator_type;
 
-      const typename allocator_type::size_type alloc_max =
-                                                  v.get_allocator().max_size();
+      const typename boost::allocator_size_type<allocator_type>::type alloc_max =
+                                    boost::allocator_max_size(v.get_allocator());
       const typename T::size_type container_max = v.max_size();
 
       return alloc_max < container_max?
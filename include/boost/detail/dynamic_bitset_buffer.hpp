@@ -0,0 +1,592 @@
+// -----------------------------------------------------------
+// dynamic_bitset_buffer.hpp
+//
+//       The block buffer of dynamic_bitset: a std::vector, a
+//       vector with inline storage for a few blocks (for
+//       dynamic_bitset_small_buffer) or a single pointer to a
+//       block array prefixed by its sizes (for
+//       dynamic_bitset_compact_buffer)
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DETAIL_DYNAMIC_BITSET_BUFFER_HPP
+#define BOOST_DETAIL_DYNAMIC_BITSET_BUFFER_HPP
+
+#include <assert.h>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include "boost/config.hpp"
+#include "boost/static_assert.hpp"
+#include "boost/core/allocator_access.hpp"
+#include "boost/functional/hash/hash.hpp"
+#include "boost/detail/iterator.hpp"
+#include "boost/dynamic_bitset_fwd.hpp"
+
+
+namespace boost {
+
+  namespace detail {
+  namespace dynamic_bitset_impl {
+
+    // A vector of blocks which keeps up to N blocks inside the object,
+    // and only allocates (with Allocator) beyond that. Only the part of
+    // the std::vector interface which dynamic_bitset needs is provided.
+    //
+    // Blocks are unsigned integers: they are never constructed nor
+    // destroyed, just copied. The allocators of two buffers are assumed
+    // to compare equal (e.g. swap() exchanges the heap storage and the
+    // allocators together).
+    //
+    template <typename Block, std::size_t N, typename Allocator>
+    class small_block_buffer : private Allocator
+    {
+        BOOST_STATIC_ASSERT(N > 0);
+
+    public:
+        typedef Block           value_type;
+        typedef Allocator       allocator_type;
+        typedef std::size_t     size_type;
+        typedef std::ptrdiff_t  difference_type;
+        typedef Block&          reference;
+        typedef const Block&    const_reference;
+        typedef Block*          iterator;
+        typedef const Block*    const_iterator;
+
+        explicit small_block_buffer(const Allocator& alloc = Allocator())
+            : Allocator(alloc), m_data(m_inline), m_size(0), m_capacity(N)
+        {}
+
+        template <typename InputIterator>
+        small_block_buffer(InputIterator first, InputIterator last,
+                           const Allocator& alloc = Allocator())
+            : Allocator(alloc), m_data(m_inline), m_size(0), m_capacity(N)
+        {
+            insert(end(), first, last);
+        }
+
+        small_block_buffer(const small_block_buffer& b)
+            : Allocator(b), m_data(m_inline), m_size(0), m_capacity(N)
+        {
+            reserve(b.m_size);
+            std::copy(b.begin(), b.end(), m_data);
+            m_size = b.m_size;
+        }
+
+        ~small_block_buffer() { m_deallocate(); }
+
+        small_block_buffer& operator=(const small_block_buffer& b)
+        {
+            if (&b != this) {
+                if (b.m_size > m_capacity) {
+                    small_block_buffer tmp(b);
+                    swap(tmp);
+                }
+                else {
+                    std::copy(b.begin(), b.end(), m_data);
+                    m_size = b.m_size;
+                }
+            }
+            return *this;
+        }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+        small_block_buffer(small_block_buffer&& b) BOOST_NOEXCEPT
+            : Allocator(b), m_data(m_inline), m_size(0), m_capacity(N)
+        {
+            m_steal(b);
+        }
+
+        small_block_buffer& operator=(small_block_buffer&& b) BOOST_NOEXCEPT
+        {
+            if (&b != this) {
+                m_deallocate();
+                m_data = m_inline;
+                m_size = 0;
+                m_capacity = N;
+                static_cast<Allocator&>(*this) = static_cast<const Allocator&>(b);
+                m_steal(b);
+            }
+            return *this;
+        }
+#endif
+
+        void swap(small_block_buffer& b) // no throw
+        {
+            small_block_buffer tmp(get_allocator());
+            tmp.m_steal(*this);
+            m_steal(b);
+            b.m_steal(tmp);
+            std::swap(static_cast<Allocator&>(*this), static_cast<Allocator&>(b));
+        }
+
+        allocator_type get_allocator() const { return *this; }
+
+        iterator begin() { return m_data; }
+        iterator end() { return m_data + m_size; }
+        const_iterator begin() const { return m_data; }
+        const_iterator end() const { return m_data + m_size; }
+
+        size_type size() const { return m_size; }
+        size_type capacity() const { return m_capacity; }
+        bool empty() const { return m_size == 0; }
+        size_type max_size() const { return size_type(-1) / sizeof(Block); }
+
+        reference operator[](size_type i) { assert(i < m_size); return m_data[i]; }
+        const_reference operator[](size_type i) const { assert(i < m_size); return m_data[i]; }
+        reference back() { assert(m_size > 0); return m_data[m_size - 1]; }
+        const_reference back() const { assert(m_size > 0); return m_data[m_size - 1]; }
+
+        void reserve(size_type n)
+        {
+            if (n > m_capacity) {
+                Block* const p = boost::allocator_allocate(m_allocator(), n);
+                std::copy(begin(), end(), p);
+                m_deallocate();
+                m_data = p;
+                m_capacity = n;
+            }
+        }
+
+        void resize(size_type n, Block v = Block())
+        {
+            if (n > m_capacity)
+                reserve((std::max)(n, 2 * m_capacity));
+            if (n > m_size)
+                std::fill(m_data + m_size, m_data + n, v);
+            m_size = n;
+        }
+
+        void clear() { m_size = 0; }
+
+        void push_back(Block v)
+        {
+            if (m_size == m_capacity)
+                reserve(2 * m_capacity);
+            m_data[m_size++] = v;
+        }
+
+        void pop_back() { assert(m_size > 0); --m_size; }
+
+        // only at the end
+        template <typename InputIterator>
+        void insert(iterator pos, InputIterator first, InputIterator last)
+        {
+            assert(pos == end());
+            (void)pos;
+            typename boost::detail::iterator_traits<InputIterator>::iterator_category cat;
+            m_append(first, last, cat);
+        }
+
+        friend bool operator==(const small_block_buffer& a, const small_block_buffer& b)
+        {
+            return a.m_size == b.m_size && std::equal(a.begin(), a.end(), b.begin());
+        }
+
+        friend bool operator!=(const small_block_buffer& a, const small_block_buffer& b)
+        {
+            return !(a == b);
+        }
+
+    private:
+        Allocator& m_allocator() { return *this; }
+        bool m_is_inline() const { return m_data == m_inline; }
+
+        void m_deallocate()
+        {
+            if (!m_is_inline())
+                boost::allocator_deallocate(m_allocator(), m_data, m_capacity);
+        }
+
+        // PRE: *this is empty and uses the inline storage
+        // POST: b is empty and uses the inline storage
+        void m_steal(small_block_buffer& b)
+        {
+            assert(m_is_inline() && m_size == 0);
+            if (b.m_is_inline())
+                std::copy(b.begin(), b.end(), m_inline);
+            else {
+                m_data = b.m_data;
+                m_capacity = b.m_capacity;
+                b.m_data = b.m_inline;
+                b.m_capacity = N;
+            }
+            m_size = b.m_size;
+            b.m_size = 0;
+        }
+
+        template <typename InputIterator>
+        void m_append(InputIterator first, InputIterator last, std::input_iterator_tag)
+        {
+            for ( ; first != last; ++first)
+                push_back(*first);
+        }
+
+        template <typename ForwardIterator>
+        void m_append(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag)
+        {
+            const size_type d = boost::detail::distance(first, last);
+            if (m_size + d > m_capacity)
+                reserve((std::max)(m_size + d, 2 * m_capacity));
+            std::copy(first, last, m_data + m_size);
+            m_size += d;
+        }
+
+        Block*    m_data;     // m_inline, or allocated
+        size_type m_size;
+        size_type m_capacity;
+        Block     m_inline[N];
+    };
+
+    // same as the hash of the equivalent std::vector
+    template <typename Block, std::size_t N, typename Allocator>
+    inline std::size_t hash_value(const small_block_buffer<Block, N, Allocator>& b)
+    {
+        return boost::hash_range(b.begin(), b.end());
+    }
+
+
+    // A block array behind a single pointer: the number of bits, the
+    // number of blocks and the capacity are stored in the allocation,
+    // just before the blocks, and an empty buffer allocates nothing.
+    // Provides the same interface as small_block_buffer, and the
+    // number of bits (see sized_block_buffer).
+    //
+    template <typename Block, typename Allocator>
+    class compact_block_buffer
+    {
+    public:
+        typedef Block           value_type;
+        typedef Allocator       allocator_type;
+        typedef std::size_t     size_type;
+        typedef std::ptrdiff_t  difference_type;
+        typedef Block&          reference;
+        typedef const Block&    const_reference;
+        typedef Block*          iterator;
+        typedef const Block*    const_iterator;
+
+    private:
+        // the sizes take one unit each, the blocks the following units
+        union unit {
+            size_type word;
+            Block     block;
+        };
+        typedef typename boost::allocator_rebind<Allocator, unit>::type unit_allocator;
+        BOOST_STATIC_CONSTANT(size_type, header_units = 3);
+        BOOST_STATIC_CONSTANT(size_type, blocks_per_unit = sizeof(unit) / sizeof(Block));
+
+        // empty base optimization: the buffer is sizeof(unit*) for
+        // stateless allocators
+        struct impl : unit_allocator {
+            explicit impl(const unit_allocator& a) : unit_allocator(a), p(0) {}
+            unit* p;
+        };
+
+    public:
+        explicit compact_block_buffer(const Allocator& alloc = Allocator())
+            : m_impl(alloc)
+        {}
+
+        template <typename InputIterator>
+        compact_block_buffer(InputIterator first, InputIterator last,
+                             const Allocator& alloc = Allocator())
+            : m_impl(alloc)
+        {
+            insert(end(), first, last);
+        }
+
+        compact_block_buffer(const compact_block_buffer& b)
+            : m_impl(b.m_impl)
+        {
+            m_impl.p = 0;
+            if (b.size() != 0) {
+                m_allocate(b.size());
+                std::copy(b.begin(), b.end(), begin());
+                m_word(1) = b.size();
+            }
+            set_num_bits(b.num_bits());
+        }
+
+        ~compact_block_buffer() { m_deallocate(m_impl.p); }
+
+        compact_block_buffer& operator=(const compact_block_buffer& b)
+        {
+            if (&b != this) {
+                if (b.size() > capacity()) {
+                    compact_block_buffer tmp(b);
+                    swap(tmp);
+                }
+                else {
+                    std::copy(b.begin(), b.end(), begin());
+                    if (m_impl.p != 0)
+                        m_word(1) = b.size();
+                    set_num_bits(b.num_bits());
+                }
+            }
+            return *this;
+        }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+        compact_block_buffer(compact_block_buffer&& b) BOOST_NOEXCEPT
+            : m_impl(b.m_impl)
+        {
+            b.m_impl.p = 0;
+        }
+
+        compact_block_buffer& operator=(compact_block_buffer&& b) BOOST_NOEXCEPT
+        {
+            if (&b != this) {
+                m_deallocate(m_impl.p);
+                m_impl = b.m_impl;
+                b.m_impl.p = 0;
+            }
+            return *this;
+        }
+#endif
+
+        void swap(compact_block_buffer& b) // no throw
+        {
+            std::swap(m_impl, b.m_impl);
+        }
+
+        allocator_type get_allocator() const
+        {
+            return allocator_type(static_cast<const unit_allocator&>(m_impl));
+        }
+
+        iterator begin() { return m_blocks(); }
+        iterator end() { return m_blocks() + size(); }
+        const_iterator begin() const { return m_blocks(); }
+        const_iterator end() const { return m_blocks() + size(); }
+
+        size_type size() const { return m_impl.p ? m_word(1) : 0; }
+        size_type capacity() const { return m_impl.p ? m_word(2) : 0; }
+        bool empty() const { return size() == 0; }
+        size_type max_size() const { return size_type(-1) / sizeof(unit) * blocks_per_unit; }
+
+        size_type num_bits() const { return m_impl.p ? m_word(0) : 0; }
+        void set_num_bits(size_type n)
+        {
+            assert(m_impl.p != 0 || n == 0);
+            if (m_impl.p != 0)
+                m_word(0) = n;
+        }
+
+        reference operator[](size_type i) { assert(i < size()); return m_blocks()[i]; }
+        const_reference operator[](size_type i) const { assert(i < size()); return m_blocks()[i]; }
+        reference back() { assert(!empty()); return m_blocks()[size() - 1]; }
+        const_reference back() const { assert(!empty()); return m_blocks()[size() - 1]; }
+
+        void reserve(size_type n)
+        {
+            if (n > capacity()) {
+                const size_type sz = size();
+                const size_type nb = num_bits();
+                unit* const old = m_impl.p;
+                m_allocate(n);
+                if (old != 0) {
+                    const Block* const first = reinterpret_cast<const Block*>(old + header_units);
+                    std::copy(first, first + sz, begin());
+                }
+                m_word(0) = nb;
+                m_word(1) = sz;
+                m_deallocate(old);
+            }
+        }
+
+        void resize(size_type n, Block v = Block())
+        {
+            const size_type sz = size();
+            if (n > capacity())
+                reserve((std::max)(n, 2 * capacity()));
+            if (n > sz)
+                std::fill(begin() + sz, begin() + n, v);
+            if (m_impl.p != 0)
+                m_word(1) = n;
+        }
+
+        void clear()
+        {
+            if (m_impl.p != 0)
+                m_word(1) = 0;
+        }
+
+        void push_back(Block v)
+        {
+            const size_type sz = size();
+            if (sz == capacity())
+                reserve(sz == 0 ? 1 : 2 * sz);
+            m_blocks()[sz] = v;
+            m_word(1) = sz + 1;
+        }
+
+        void pop_back() { assert(!empty()); --m_word(1); }
+
+        // only at the end
+        template <typename InputIterator>
+        void insert(iterator pos, InputIterator first, InputIterator last)
+        {
+            assert(pos == end());
+            (void)pos;
+            typename boost::detail::iterator_traits<InputIterator>::iterator_category cat;
+            m_append(first, last, cat);
+        }
+
+        friend bool operator==(const compact_block_buffer& a, const compact_block_buffer& b)
+        {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+        }
+
+        friend bool operator!=(const compact_block_buffer& a, const compact_block_buffer& b)
+        {
+            return !(a == b);
+        }
+
+    private:
+        static size_type units_for(size_type num_blocks)
+        {
+            return header_units + (num_blocks + blocks_per_unit - 1) / blocks_per_unit;
+        }
+
+        size_type& m_word(size_type i) { return m_impl.p[i].word; }
+        size_type m_word(size_type i) const { return m_impl.p[i].word; }
+
+        Block* m_blocks()
+        {
+            return m_impl.p ? reinterpret_cast<Block*>(m_impl.p + header_units) : 0;
+        }
+        const Block* m_blocks() const
+        {
+            return m_impl.p ? reinterpret_cast<const Block*>(m_impl.p + header_units) : 0;
+        }
+
+        // replaces m_impl.p (which is not freed) by a new allocation
+        // with capacity n > 0 and zero sizes
+        void m_allocate(size_type n)
+        {
+            unit* const p = boost::allocator_allocate(
+                static_cast<unit_allocator&>(m_impl), units_for(n));
+            p[0].word = 0;
+            p[1].word = 0;
+            p[2].word = n;
+            m_impl.p = p;
+        }
+
+        void m_deallocate(unit* p)
+        {
+            if (p != 0)
+                boost::allocator_deallocate(static_cast<unit_allocator&>(m_impl),
+                                            p, units_for(p[2].word));
+        }
+
+        template <typename InputIterator>
+        void m_append(InputIterator first, InputIterator last, std::input_iterator_tag)
+        {
+            for ( ; first != last; ++first)
+                push_back(*first);
+        }
+
+        template <typename ForwardIterator>
+        void m_append(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag)
+        {
+            const size_type d = boost::detail::distance(first, last);
+            const size_type sz = size();
+            if (d == 0)
+                return;
+            if (sz + d > capacity())
+                reserve((std::max)(sz + d, 2 * capacity()));
+            std::copy(first, last, begin() + sz);
+            m_word(1) = sz + d;
+        }
+
+        impl m_impl;
+    };
+
+    template <typename Block, typename Allocator>
+    inline std::size_t hash_value(const compact_block_buffer<Block, Allocator>& b)
+    {
+        return boost::hash_range(b.begin(), b.end());
+    }
+
+
+    // A Buffer which also holds the number of bits of the bitset
+    //
+    template <typename Buffer>
+    class sized_block_buffer : public Buffer
+    {
+    public:
+        typedef typename Buffer::allocator_type allocator_type;
+        typedef typename Buffer::size_type size_type;
+
+        explicit sized_block_buffer(const allocator_type& alloc)
+            : Buffer(alloc), m_num_bits(0)
+        {}
+
+        template <typename InputIterator>
+        sized_block_buffer(InputIterator first, InputIterator last)
+            : Buffer(first, last), m_num_bits(0)
+        {}
+
+        size_type num_bits() const { return m_num_bits; }
+        void set_num_bits(size_type n) { m_num_bits = n; }
+
+        void swap(sized_block_buffer& b) // no throw
+        {
+            Buffer::swap(b);
+            std::swap(m_num_bits, b.m_num_bits);
+        }
+
+    private:
+        size_type m_num_bits;
+    };
+
+
+    // The buffer used by dynamic_bitset<Block, Allocator>
+    //
+    template <typename Block, typename Allocator>
+    struct block_buffer
+    {
+        typedef Allocator allocator_type;
+        typedef sized_block_buffer<std::vector<Block, Allocator> > type;
+    };
+
+    template <typename Block, std::size_t N, typename Allocator>
+    struct block_buffer<Block, dynamic_bitset_small_buffer<N, Allocator> >
+    {
+        typedef Allocator allocator_type;
+        typedef sized_block_buffer<small_block_buffer<Block, N, Allocator> > type;
+    };
+
+    template <typename Block, std::size_t N>
+    struct block_buffer<Block, dynamic_bitset_small_buffer<N, void> >
+    {
+        typedef std::allocator<Block> allocator_type;
+        typedef sized_block_buffer<small_block_buffer<Block, N, allocator_type> > type;
+    };
+
+    template <typename Block, typename Allocator>
+    struct block_buffer<Block, dynamic_bitset_compact_buffer<Allocator> >
+    {
+        typedef Allocator allocator_type;
+        typedef compact_block_buffer<Block, Allocator> type;
+    };
+
+    template <typename Block>
+    struct block_buffer<Block, dynamic_bitset_compact_buffer<void> >
+    {
+        typedef std::allocator<Block> allocator_type;
+        typedef compact_block_buffer<Block, allocator_type> type;
+    };
+
+  } // dynamic_bitset_impl
+  } // namespace detail
+
+} // namespace boost
+
+#endif // include guard
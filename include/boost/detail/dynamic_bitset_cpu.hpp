@@ -0,0 +1,124 @@
+// -----------------------------------------------------------
+// dynamic_bitset_cpu.hpp
+//
+//       Run time detection of the x86 instruction set
+//       extensions used by the dynamic_bitset kernels
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DETAIL_DYNAMIC_BITSET_CPU_HPP
+#define BOOST_DETAIL_DYNAMIC_BITSET_CPU_HPP
+
+#include "boost/dynamic_bitset/config.hpp"
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+# if defined(BOOST_MSVC)
+#  include <intrin.h>
+# else
+#  include <cpuid.h>
+# endif
+#endif
+
+
+namespace boost {
+
+  namespace detail {
+  namespace dynamic_bitset_impl {
+
+    // The features are queried once, the first time they are needed.
+    // A feature is reported only if both the processor and the operating
+    // system support it (i.e. the OS saves the corresponding register
+    // state on context switches).
+    //
+    struct cpu_features
+    {
+        bool sse2;
+        bool popcnt;
+        bool avx2;
+        bool bmi2;
+        bool avx512f;
+        bool avx512bw;
+        bool avx512vpopcntdq;
+        bool avx512vbmi2;
+
+        static const cpu_features & get()
+        {
+            static const cpu_features features = detect();
+            return features;
+        }
+
+    private:
+        static cpu_features detect()
+        {
+            cpu_features f;
+            f.sse2 = f.popcnt = f.avx2 = f.bmi2 = false;
+            f.avx512f = f.avx512bw = f.avx512vpopcntdq = f.avx512vbmi2 = false;
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+            unsigned int r[4]; // eax, ebx, ecx, edx
+
+            cpuid(0, 0, r);
+            const unsigned int max_leaf = r[0];
+            if (max_leaf < 1)
+                return f;
+
+            cpuid(1, 0, r);
+            f.sse2   = (r[3] & (1u << 26)) != 0;
+            f.popcnt = (r[2] & (1u << 23)) != 0;
+
+            // AVX state (and above) must be enabled by the OS
+            const bool osxsave = (r[2] & (1u << 27)) != 0;
+            const unsigned int xcr0 = osxsave ? xgetbv0() : 0;
+            const bool os_avx    = (xcr0 & 0x06) == 0x06;  // xmm, ymm
+            const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;  // + opmask, zmm
+
+            if (max_leaf >= 7) {
+                cpuid(7, 0, r);
+                f.bmi2            = (r[1] & (1u <<  8)) != 0;
+                f.avx2            = os_avx && (r[1] & (1u << 5)) != 0;
+                f.avx512f         = os_avx512 && (r[1] & (1u << 16)) != 0;
+                f.avx512bw        = f.avx512f && (r[1] & (1u << 30)) != 0;
+                f.avx512vbmi2     = f.avx512f && (r[2] & (1u <<  6)) != 0;
+                f.avx512vpopcntdq = f.avx512f && (r[2] & (1u << 14)) != 0;
+            }
+#endif
+            return f;
+        }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        static void cpuid(unsigned int leaf, unsigned int subleaf,
+                          unsigned int (&r)[4])
+        {
+# if defined(BOOST_MSVC)
+            int regs[4];
+            __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+            for (int i = 0; i < 4; ++i)
+                r[i] = static_cast<unsigned int>(regs[i]);
+# else
+            __cpuid_count(leaf, subleaf, r[0], r[1], r[2], r[3]);
+# endif
+        }
+
+        static unsigned int xgetbv0()
+        {
+# if defined(BOOST_MSVC)
+            return static_cast<unsigned int>(_xgetbv(0));
+# else
+            unsigned int eax, edx;
+            __asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+            return eax;
+# endif
+        }
+#endif
+    };
+
+  } // dynamic_bitset_impl
+  } // namespace detail
+
+} // namespace boost
+
+#endif // include guard
@@ -0,0 +1,394 @@
+// -----------------------------------------------------------
+// dynamic_bitset_expr.hpp
+//
+//       Single pass evaluation of the bitwise operators &, |,
+//       ^, - and ~ of dynamic_bitset, and of bitset_expr()
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DETAIL_DYNAMIC_BITSET_EXPR_HPP
+#define BOOST_DETAIL_DYNAMIC_BITSET_EXPR_HPP
+
+#include <assert.h>
+#include <cstddef>
+#include <algorithm>
+#include "boost/limits.hpp"
+#include "boost/dynamic_bitset/config.hpp"
+#include "boost/dynamic_bitset_fwd.hpp"
+#include "boost/detail/dynamic_bitset_kernels.hpp"
+
+
+namespace boost {
+
+  namespace detail {
+  namespace dynamic_bitset_impl {
+
+    template <typename Block> class bitset_leaf;
+    template <int Op, typename Left, typename Right> class bitset_binary_expr;
+    template <typename Expr> class bitset_not_expr;
+
+    // Expressions are evaluated a chunk of blocks at a time: the
+    // intermediate results of a chunk stay in the L1 cache, so each
+    // operand is read only once from memory, whatever the number of
+    // operators.
+    //
+    const std::size_t expr_chunk_bytes = 2048;
+
+    template <typename Block>
+    struct expr_chunk
+    {
+        BOOST_STATIC_CONSTANT(std::size_t, value =
+            sizeof(Block) >= expr_chunk_bytes ? 1 : expr_chunk_bytes / sizeof(Block));
+    };
+
+    // The base of the expression types below. The bitwise operators of
+    // dynamic_bitset build an expression of their operands and evaluate
+    // it at once into the result, a chunk of blocks at a time; count(),
+    // count_at_least(), any() and find_first() evaluate one without
+    // storing it. Expressions refer to the storage of their operands:
+    // the user only gets them from bitset_expr(), which takes named
+    // bitsets, and from the operators below.
+    //
+    template <typename Expr, typename Block>
+    class dynamic_bitset_expr
+    {
+    public:
+        typedef Block block_type;
+        typedef std::size_t size_type;
+        BOOST_STATIC_CONSTANT(int, bits_per_block = (std::numeric_limits<Block>::digits));
+
+        const Expr& expression() const { return static_cast<const Expr&>(*this); }
+
+        size_type count() const;
+        bool count_at_least(size_type k) const;
+        bool any() const { return find_first() != npos_bit; }
+        bool none() const { return !any(); }
+        size_type find_first() const;
+
+    protected:
+        dynamic_bitset_expr() {}
+    };
+
+    // Each expression type provides
+    //
+    //   size(), num_blocks()
+    //   block(i)               the i-th block of the result
+    //   eval(out, first, n)    out[k] = block(first + k), k in [0, n)
+    //   apply_to<Op>(out, first, n)
+    //                          out[k] = out[k] op block(first + k)
+    //   aliases(p)             whether p is the storage of an operand
+    //
+    // n never exceeds expr_chunk<Block>::value. The unused bits of the
+    // highest block are always zero.
+
+
+    // an operand (a dynamic_bitset)
+    template <typename Block>
+    class bitset_leaf : public dynamic_bitset_expr<bitset_leaf<Block>, Block>
+    {
+    public:
+        typedef std::size_t size_type;
+
+        template <typename Allocator>
+        explicit bitset_leaf(const dynamic_bitset<Block, Allocator>& b)
+            : m_data(b.m_block_data()), m_num_bits(b.size()),
+              m_num_blocks(b.num_blocks())
+        {}
+
+        size_type size() const { return m_num_bits; }
+        size_type num_blocks() const { return m_num_blocks; }
+        Block block(size_type i) const { return m_data[i]; }
+
+        void eval(Block * out, size_type first, size_type n) const
+        {
+            std::copy(m_data + first, m_data + first + n, out);
+        }
+
+        template <int Op>
+        void apply_to(Block * out, size_type first, size_type n) const
+        {
+            bitwise_blocks<Op>(out, m_data + first, n);
+        }
+
+        bool aliases(const Block * p) const { return p == m_data; }
+
+        const Block * data() const { return m_data; }
+
+    private:
+        const Block * m_data;
+        size_type m_num_bits;
+        size_type m_num_blocks;
+    };
+
+
+    template <int Op, typename Left, typename Right>
+    class bitset_binary_expr
+        : public dynamic_bitset_expr<bitset_binary_expr<Op, Left, Right>,
+                                     typename Left::block_type>
+    {
+    public:
+        typedef typename Left::block_type block_type;
+        typedef std::size_t size_type;
+
+        bitset_binary_expr(const Left& left, const Right& right)
+            : m_left(left), m_right(right)
+        {
+            assert(left.size() == right.size());
+        }
+
+        size_type size() const { return m_left.size(); }
+        size_type num_blocks() const { return m_left.num_blocks(); }
+
+        block_type block(size_type i) const
+        {
+            return apply_bitwise<Op>(m_left.block(i), m_right.block(i));
+        }
+
+        void eval(block_type * out, size_type first, size_type n) const
+        {
+            m_left.eval(out, first, n);
+            m_right.template apply_to<Op>(out, first, n);
+        }
+
+        template <int Op2>
+        void apply_to(block_type * out, size_type first, size_type n) const
+        {
+            block_type tmp[expr_chunk<block_type>::value];
+            eval(tmp, first, n);
+            bitwise_blocks<Op2>(out, tmp, n);
+        }
+
+        bool aliases(const block_type * p) const
+        {
+            return m_left.aliases(p) || m_right.aliases(p);
+        }
+
+        const Left& left() const { return m_left; }
+        const Right& right() const { return m_right; }
+
+    private:
+        Left m_left;
+        Right m_right;
+    };
+
+
+    template <typename Expr>
+    class bitset_not_expr
+        : public dynamic_bitset_expr<bitset_not_expr<Expr>,
+                                     typename Expr::block_type>
+    {
+    public:
+        typedef typename Expr::block_type block_type;
+        typedef std::size_t size_type;
+
+        explicit bitset_not_expr(const Expr& e)
+            : m_expr(e), m_last_mask(~block_type(0))
+        {
+            const int extra_bits = static_cast<int>(
+                e.size() % std::numeric_limits<block_type>::digits);
+            if (extra_bits != 0)
+                m_last_mask = static_cast<block_type>(m_last_mask
+                    >> (std::numeric_limits<block_type>::digits - extra_bits));
+        }
+
+        size_type size() const { return m_expr.size(); }
+        size_type num_blocks() const { return m_expr.num_blocks(); }
+
+        block_type block(size_type i) const
+        {
+            const block_type b = static_cast<block_type>(~m_expr.block(i));
+            return i + 1 == num_blocks() ? static_cast<block_type>(b & m_last_mask) : b;
+        }
+
+        void eval(block_type * out, size_type first, size_type n) const
+        {
+            m_expr.eval(out, first, n);
+            bitwise_blocks<op_not>(out, out, n);
+            if (first + n == num_blocks())
+                out[n - 1] &= m_last_mask;
+        }
+
+        // x & ~e and x - ~e don't need to evaluate ~e
+        template <int Op2>
+        void apply_to(block_type * out, size_type first, size_type n) const
+        {
+            if (Op2 == op_and)
+                m_expr.template apply_to<op_sub>(out, first, n);
+            else if (Op2 == op_sub)
+                m_expr.template apply_to<op_and>(out, first, n);
+            else {
+                block_type tmp[expr_chunk<block_type>::value];
+                eval(tmp, first, n);
+                bitwise_blocks<Op2>(out, tmp, n);
+            }
+        }
+
+        bool aliases(const block_type * p) const { return m_expr.aliases(p); }
+
+        const Expr& operand() const { return m_expr; }
+
+    private:
+        Expr m_expr;
+        block_type m_last_mask;
+    };
+
+
+    // Number of bits set in the blocks [first, first + n) of e; buf is
+    // a scratch chunk. The overloads for a op b and a & ~b, with
+    // dynamic_bitset operands, use the binary count kernels, which don't
+    // store a op b at all.
+    //
+    template <typename Expr, typename Block>
+    inline std::size_t expr_count(const Expr& e, Block * buf,
+                                  std::size_t first, std::size_t n)
+    {
+        e.eval(buf, first, n);
+        return count_block_range(buf, n);
+    }
+
+    template <typename Block>
+    inline std::size_t expr_count(const bitset_leaf<Block>& e, Block *,
+                                  std::size_t first, std::size_t n)
+    {
+        return count_block_range(e.data() + first, n);
+    }
+
+    template <int Op, typename Block>
+    inline std::size_t expr_count(
+        const bitset_binary_expr<Op, bitset_leaf<Block>, bitset_leaf<Block> >& e,
+        Block *, std::size_t first, std::size_t n)
+    {
+        return count2_block_range<Op>(e.left().data() + first,
+                                      e.right().data() + first, n);
+    }
+
+    template <typename Block>
+    inline std::size_t expr_count(
+        const bitset_binary_expr<op_and, bitset_leaf<Block>,
+                                 bitset_not_expr<bitset_leaf<Block> > >& e,
+        Block *, std::size_t first, std::size_t n)
+    {
+        return count2_block_range<op_sub>(e.left().data() + first,
+                                          e.right().operand().data() + first, n);
+    }
+
+    template <typename Expr, typename Block>
+    typename dynamic_bitset_expr<Expr, Block>::size_type
+    dynamic_bitset_expr<Expr, Block>::count() const
+    {
+        const size_type chunk = expr_chunk<Block>::value;
+        const size_type n = expression().num_blocks();
+
+        Block buf[expr_chunk<Block>::value];
+        size_type result = 0;
+        for (size_type first = 0; first < n; first += chunk) {
+            const size_type len = (std::min)(chunk, n - first);
+            result += expr_count(expression(), buf, first, len);
+        }
+        return result;
+    }
+
+    // Same as count() >= k, but stops as soon as the answer is known:
+    // when k bits have been found, or when the bits not yet examined are
+    // too few to reach k.
+    //
+    template <typename Expr, typename Block>
+    bool dynamic_bitset_expr<Expr, Block>::count_at_least(size_type k) const
+    {
+        const size_type chunk = expr_chunk<Block>::value;
+        const size_type n = expression().num_blocks();
+        const size_type sz = expression().size();
+
+        if (k == 0)
+            return true;
+        if (k > sz)
+            return false;
+
+        Block buf[expr_chunk<Block>::value];
+        size_type result = 0;
+        for (size_type first = 0; first < n; first += chunk) {
+            const size_type len = (std::min)(chunk, n - first);
+            result += expr_count(expression(), buf, first, len);
+            if (result >= k)
+                return true;
+
+            const size_type examined = (first + len) * bits_per_block;
+            if (examined < sz && sz - examined < k - result)
+                return false;
+        }
+        return false;
+    }
+
+    template <typename Expr, typename Block>
+    typename dynamic_bitset_expr<Expr, Block>::size_type
+    dynamic_bitset_expr<Expr, Block>::find_first() const
+    {
+        const size_type chunk = expr_chunk<Block>::value;
+        const size_type n = expression().num_blocks();
+
+        Block buf[expr_chunk<Block>::value];
+        for (size_type first = 0; first < n; first += chunk) {
+            const size_type len = (std::min)(chunk, n - first);
+            expression().eval(buf, first, len);
+            const size_type pos = find_from_block(buf, len, 0);
+            if (pos != npos_bit)
+                return first * bits_per_block + pos;
+        }
+        return npos_bit;
+    }
+
+
+    // The operators of expressions, found by argument dependent lookup;
+    // the operands are copied, so that sub-expressions may be temporaries.
+    // PRE: the operands have the same size
+    //
+#define BOOST_DYNAMIC_BITSET_EXPR_OPERATOR(op, Op)                          \
+    template <typename L, typename R, typename Block>                       \
+    inline bitset_binary_expr<Op, L, R>                                     \
+    operator op(const dynamic_bitset_expr<L, Block>& l,                     \
+                const dynamic_bitset_expr<R, Block>& r)                     \
+    {                                                                       \
+        return bitset_binary_expr<Op, L, R>(l.expression(), r.expression());\
+    }
+
+    BOOST_DYNAMIC_BITSET_EXPR_OPERATOR(&, op_and)
+    BOOST_DYNAMIC_BITSET_EXPR_OPERATOR(|, op_or)
+    BOOST_DYNAMIC_BITSET_EXPR_OPERATOR(^, op_xor)
+    BOOST_DYNAMIC_BITSET_EXPR_OPERATOR(-, op_sub)
+
+#undef BOOST_DYNAMIC_BITSET_EXPR_OPERATOR
+
+    template <typename E, typename Block>
+    inline bitset_not_expr<E> operator~(const dynamic_bitset_expr<E, Block>& e)
+    {
+        return bitset_not_expr<E>(e.expression());
+    }
+
+  } // dynamic_bitset_impl
+  } // namespace detail
+
+  // The operand of a lazy bitwise expression: bitset_expr(a) & bitset_expr(b)
+  // is evaluated in a single pass by r.assign(), count(), count_at_least(),
+  // any(), none() and find_first(), whatever the number of operators. The
+  // expression refers to b, which must not be resized or destroyed while
+  // it is used; temporaries are rejected, as they would be gone by then.
+  //
+  template <typename Block, typename Allocator>
+  inline detail::dynamic_bitset_impl::bitset_leaf<Block>
+  bitset_expr(const dynamic_bitset<Block, Allocator>& b)
+  {
+      return detail::dynamic_bitset_impl::bitset_leaf<Block>(b);
+  }
+
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) && !defined(BOOST_NO_CXX11_DELETED_FUNCTIONS)
+  template <typename Block, typename Allocator>
+  void bitset_expr(const dynamic_bitset<Block, Allocator>&&) = delete;
+#endif
+
+} // namespace boost
+
+#endif // include guard
@@ -0,0 +1,132 @@
+// -----------------------------------------------------------
+// dynamic_bitset_iterator.hpp
+//
+//       Iteration over the positions of the set bits of a
+//       dynamic_bitset
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DETAIL_DYNAMIC_BITSET_ITERATOR_HPP
+#define BOOST_DETAIL_DYNAMIC_BITSET_ITERATOR_HPP
+
+#include <cstddef>
+#include <iterator>
+#include "boost/limits.hpp"
+#include "boost/pending/lowest_bit.hpp"
+#include "boost/detail/dynamic_bitset_kernels.hpp"
+
+
+namespace boost {
+
+  namespace detail {
+  namespace dynamic_bitset_impl {
+
+    // A forward iterator over the positions of the set bits of a block
+    // buffer, in increasing order. It holds the bits of the current
+    // block not visited yet, and clears the lowest one on increment;
+    // null blocks are skipped with the scan kernels. Any change to the
+    // bitset invalidates it.
+    //
+    template <typename Block>
+    class set_bit_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::size_t value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::size_t * pointer;
+        typedef std::size_t reference;
+
+        set_bit_iterator()
+            : m_blocks(0), m_num_blocks(0), m_index(0), m_current(0)
+        {}
+
+        // the first set bit of the blocks [first, n) of p, or the end
+        set_bit_iterator(const Block * p, std::size_t n, std::size_t first)
+            : m_blocks(p), m_num_blocks(n), m_index(0), m_current(0)
+        {
+            m_seek(first);
+        }
+
+        reference operator*() const
+        {
+            return m_index * std::numeric_limits<Block>::digits
+                 + boost::lowest_bit(m_current);
+        }
+
+        set_bit_iterator & operator++()
+        {
+            m_current = static_cast<Block>(m_current & (m_current - 1));
+            if (m_current == 0)
+                m_seek(m_index + 1);
+            return *this;
+        }
+
+        set_bit_iterator operator++(int)
+        {
+            set_bit_iterator r(*this);
+            ++*this;
+            return r;
+        }
+
+        friend bool operator==(const set_bit_iterator & a, const set_bit_iterator & b)
+        {
+            return a.m_index == b.m_index && a.m_current == b.m_current;
+        }
+
+        friend bool operator!=(const set_bit_iterator & a, const set_bit_iterator & b)
+        {
+            return !(a == b);
+        }
+
+    private:
+        // the first nonzero block at or after i; the end is the block
+        // index m_num_blocks, with no bits left
+        void m_seek(std::size_t i)
+        {
+            if (i < m_num_blocks && m_blocks[i] == 0) {
+                const Block * const p = m_blocks + i;
+                i += find_nonzero_block<op_id>(p, p, m_num_blocks - i);
+            }
+            m_index = i;
+            m_current = i < m_num_blocks ? m_blocks[i] : Block(0);
+        }
+
+        const Block * m_blocks;
+        std::size_t m_num_blocks;
+        std::size_t m_index;    // of the current block
+        Block m_current;        // its bits not visited yet
+    };
+
+    // the begin and end set_bit_iterators of a bitset, for range for
+    // and the algorithms taking a range
+    template <typename Block>
+    class set_bit_range
+    {
+    public:
+        typedef set_bit_iterator<Block> iterator;
+        typedef iterator const_iterator;
+
+        set_bit_range(const Block * p, std::size_t n)
+            : m_first(p, n, 0), m_last(p, n, n)
+        {}
+
+        iterator begin() const { return m_first; }
+        iterator end() const { return m_last; }
+        bool empty() const { return m_first == m_last; }
+
+    private:
+        iterator m_first;
+        iterator m_last;
+    };
+
+  } // dynamic_bitset_impl
+  } // namespace detail
+
+} // namespace boost
+
+#endif // include guard
@@ -0,0 +1,2340 @@
+// -----------------------------------------------------------
+// dynamic_bitset_kernels.hpp
+//
+//       Block buffer kernels for dynamic_bitset, with
+//       run time selection of the x86 implementations
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DETAIL_DYNAMIC_BITSET_KERNELS_HPP
+#define BOOST_DETAIL_DYNAMIC_BITSET_KERNELS_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <climits>      // for CHAR_BIT
+#include "boost/limits.hpp"
+#include "boost/cstdint.hpp"
+#include "boost/pending/lowest_bit.hpp"
+#include "boost/pending/highest_bit.hpp"
+#include "boost/predef/other/endian.h"
+#include "boost/dynamic_bitset/config.hpp"
+#include "boost/detail/dynamic_bitset.hpp"
+#include "boost/detail/dynamic_bitset_cpu.hpp"
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+# include <immintrin.h>
+# if defined(__x86_64__) || defined(_M_X64)
+#  define BOOST_DYNAMIC_BITSET_X86_64
+# endif
+#endif
+
+
+namespace boost {
+
+  namespace detail {
+  namespace dynamic_bitset_impl {
+
+    // All the kernels work on the object representation of the block
+    // buffer, i.e. on a sequence of bytes. This is only valid when Block
+    // has no padding bits, which is checked by the callers, and it makes
+    // the kernels independent of the block type.
+    //
+    // Unaligned loads are always used: std::vector gives no alignment
+    // guarantee beyond that of Block.
+
+    inline boost::uint64_t load_word64(const byte_type * p)
+    {
+        boost::uint64_t w;
+        std::memcpy(&w, p, sizeof w);
+        return w;
+    }
+
+    // ------- single word helpers ----------------------------
+
+    // number of set bits, branch free; compilers targeting POPCNT
+    // recognize the pattern
+    inline std::size_t popcount_word64(boost::uint64_t x)
+    {
+        x = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+        x = (x & UINT64_C(0x3333333333333333)) + ((x >> 2) & UINT64_C(0x3333333333333333));
+        x = (x + (x >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+        return static_cast<std::size_t>((x * UINT64_C(0x0101010101010101)) >> 56);
+    }
+
+    // position of the k-th (from 0) set bit of x
+    // PRE: k < popcount_word64(x)
+    inline unsigned select_word64(boost::uint64_t x, std::size_t k)
+    {
+        // byte counts, then the running totals of the bytes
+        boost::uint64_t c = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+        c = (c & UINT64_C(0x3333333333333333)) + ((c >> 2) & UINT64_C(0x3333333333333333));
+        c = (c + (c >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+        c *= UINT64_C(0x0101010101010101);
+
+        unsigned shift = 0;
+        while (((c >> shift) & 0xff) <= k)
+            shift += 8;
+        if (shift != 0)
+            k -= static_cast<std::size_t>((c >> (shift - 8)) & 0xff);
+
+        unsigned byte = static_cast<unsigned>((x >> shift) & 0xff);
+        for ( ; k != 0; --k)
+            byte &= byte - 1;
+        unsigned pos = shift;
+        while ((byte & 1) == 0) {
+            byte >>= 1;
+            ++pos;
+        }
+        return pos;
+    }
+
+    // ------- count kernels ---------------------------------
+
+    enum count_kernel {
+        count_by_table,     // portable: 256-entry table, one lookup per byte
+        count_by_popcnt,    // POPCNT, one word at a time
+        count_by_avx2,      // AVX2 Harley-Seal carry-save adder over 512 bytes
+        count_by_avx512     // AVX-512 VPOPCNTDQ
+    };
+
+    typedef std::size_t (*count_function)(const byte_type *, std::size_t);
+
+    inline std::size_t count_table_kernel(const byte_type * p, std::size_t n)
+    {
+        return do_count(p, n, 0, static_cast<value_to_type<access_by_bytes> *>(0));
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+
+    BOOST_DYNAMIC_BITSET_TARGET("popcnt")
+    inline std::size_t count_popcnt_kernel(const byte_type * p, std::size_t n)
+    {
+        std::size_t num = 0;
+        std::size_t i = 0;
+#if defined(BOOST_DYNAMIC_BITSET_X86_64)
+        // four independent sums, to keep several popcnt in flight
+        std::size_t n0 = 0, n1 = 0, n2 = 0, n3 = 0;
+        for ( ; i + 32 <= n; i += 32) {
+            n0 += static_cast<std::size_t>(_mm_popcnt_u64(load_word64(p + i)));
+            n1 += static_cast<std::size_t>(_mm_popcnt_u64(load_word64(p + i + 8)));
+            n2 += static_cast<std::size_t>(_mm_popcnt_u64(load_word64(p + i + 16)));
+            n3 += static_cast<std::size_t>(_mm_popcnt_u64(load_word64(p + i + 24)));
+        }
+        for ( ; i + 8 <= n; i += 8)
+            n0 += static_cast<std::size_t>(_mm_popcnt_u64(load_word64(p + i)));
+        num = n0 + n1 + n2 + n3;
+#endif
+        for ( ; i + 4 <= n; i += 4) {
+            boost::uint32_t w;
+            std::memcpy(&w, p + i, sizeof w);
+            num += _mm_popcnt_u32(w);
+        }
+        for ( ; i < n; ++i)
+            num += _mm_popcnt_u32(p[i]);
+
+        return num;
+    }
+
+    // AVX2 version of the Harley-Seal algorithm: sixteen 256-bit vectors
+    // are reduced with a tree of carry-save adders, so that only one
+    // (nibble lookup based) population count is needed per 512 bytes.
+    // See W. Mula, N. Kurz, D. Lemire, "Faster Population Counts Using
+    // AVX2 Instructions", The Computer Journal 61(1), 2018.
+    //
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline __m256i avx2_popcount_bytes(__m256i v)
+    {
+        const __m256i lookup = _mm256_setr_epi8(
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low_mask = _mm256_set1_epi8(0x0f);
+        const __m256i lo = _mm256_and_si256(v, low_mask);
+        const __m256i hi = _mm256_and_si256(_mm256_srli_epi32(v, 4), low_mask);
+        return _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                               _mm256_shuffle_epi8(lookup, hi));
+    }
+
+    // per 64-bit lane counts
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline __m256i avx2_popcount(__m256i v)
+    {
+        return _mm256_sad_epu8(avx2_popcount_bytes(v), _mm256_setzero_si256());
+    }
+
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline void avx2_csa(__m256i & h, __m256i & l, __m256i a, __m256i b, __m256i c)
+    {
+        const __m256i u = _mm256_xor_si256(a, b);
+        h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+        l = _mm256_xor_si256(u, c);
+    }
+
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline __m256i avx2_load(const byte_type * p)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    }
+
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline boost::uint64_t avx2_hsum64(__m256i v)
+    {
+        boost::uint64_t lanes[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), v);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    // the vectors of a plain byte sequence; other loaders combine
+    // two sequences on the fly (see the binary count kernels below)
+    struct avx2_plain_loader
+    {
+        explicit avx2_plain_loader(const byte_type * p) : m_p(p) {}
+
+        BOOST_DYNAMIC_BITSET_TARGET("avx2")
+        __m256i operator()(std::size_t i) const { return avx2_load(m_p + 32 * i); }
+
+        const byte_type * m_p;
+    };
+
+    // per 64-bit lane counts of the first nv vectors given by ld
+    template <typename Loader>
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline __m256i avx2_harley_seal(const Loader & ld, std::size_t nv)
+    {
+        std::size_t i = 0;
+
+        __m256i total = _mm256_setzero_si256();
+        __m256i ones = total, twos = total, fours = total, eights = total;
+        __m256i sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+        for ( ; i + 16 <= nv; i += 16) {
+            avx2_csa(twos_a, ones, ones, ld(i),      ld(i + 1));
+            avx2_csa(twos_b, ones, ones, ld(i + 2),  ld(i + 3));
+            avx2_csa(fours_a, twos, twos, twos_a, twos_b);
+            avx2_csa(twos_a, ones, ones, ld(i + 4),  ld(i + 5));
+            avx2_csa(twos_b, ones, ones, ld(i + 6),  ld(i + 7));
+            avx2_csa(fours_b, twos, twos, twos_a, twos_b);
+            avx2_csa(eights_a, fours, fours, fours_a, fours_b);
+            avx2_csa(twos_a, ones, ones, ld(i + 8),  ld(i + 9));
+            avx2_csa(twos_b, ones, ones, ld(i + 10), ld(i + 11));
+            avx2_csa(fours_a, twos, twos, twos_a, twos_b);
+            avx2_csa(twos_a, ones, ones, ld(i + 12), ld(i + 13));
+            avx2_csa(twos_b, ones, ones, ld(i + 14), ld(i + 15));
+            avx2_csa(fours_b, twos, twos, twos_a, twos_b);
+            avx2_csa(eights_b, fours, fours, fours_a, fours_b);
+            avx2_csa(sixteens, eights, eights, eights_a, eights_b);
+
+            total = _mm256_add_epi64(total, avx2_popcount(sixteens));
+        }
+
+        total = _mm256_slli_epi64(total, 4);
+        total = _mm256_add_epi64(total, _mm256_slli_epi64(avx2_popcount(eights), 3));
+        total = _mm256_add_epi64(total, _mm256_slli_epi64(avx2_popcount(fours), 2));
+        total = _mm256_add_epi64(total, _mm256_slli_epi64(avx2_popcount(twos), 1));
+        total = _mm256_add_epi64(total, avx2_popcount(ones));
+
+        for ( ; i < nv; ++i)
+            total = _mm256_add_epi64(total, avx2_popcount(ld(i)));
+
+        return total;
+    }
+
+    BOOST_DYNAMIC_BITSET_TARGET("avx2,popcnt")
+    inline std::size_t count_avx2_kernel(const byte_type * p, std::size_t n)
+    {
+        const std::size_t nv = n / 32;
+        const __m256i total = avx2_harley_seal(avx2_plain_loader(p), nv);
+
+        const std::size_t done = 32 * nv;
+        return static_cast<std::size_t>(avx2_hsum64(total))
+             + count_popcnt_kernel(p + done, n - done);
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+    BOOST_DYNAMIC_BITSET_TARGET("avx512f,avx512vpopcntdq,popcnt")
+    inline std::size_t count_avx512_kernel(const byte_type * p, std::size_t n)
+    {
+        __m512i acc0 = _mm512_setzero_si512();
+        __m512i acc1 = acc0, acc2 = acc0, acc3 = acc0;
+        std::size_t i = 0;
+        for ( ; i + 256 <= n; i += 256) {
+            acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(_mm512_loadu_si512(p + i)));
+            acc1 = _mm512_add_epi64(acc1, _mm512_popcnt_epi64(_mm512_loadu_si512(p + i + 64)));
+            acc2 = _mm512_add_epi64(acc2, _mm512_popcnt_epi64(_mm512_loadu_si512(p + i + 128)));
+            acc3 = _mm512_add_epi64(acc3, _mm512_popcnt_epi64(_mm512_loadu_si512(p + i + 192)));
+        }
+        for ( ; i + 64 <= n; i += 64)
+            acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(_mm512_loadu_si512(p + i)));
+
+        acc0 = _mm512_add_epi64(_mm512_add_epi64(acc0, acc1),
+                                _mm512_add_epi64(acc2, acc3));
+        boost::uint64_t lanes[8];
+        _mm512_storeu_si512(lanes, acc0);
+        boost::uint64_t num = 0;
+        for (int k = 0; k < 8; ++k)
+            num += lanes[k];
+        return static_cast<std::size_t>(num) + count_popcnt_kernel(p + i, n - i);
+    }
+#endif
+
+#endif // BOOST_DYNAMIC_BITSET_X86_SIMD
+
+    inline bool count_kernel_available(count_kernel k)
+    {
+        const cpu_features & cpu = cpu_features::get();
+        switch (k) {
+        case count_by_table:
+            return true;
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        case count_by_popcnt:
+            return cpu.popcnt;
+        case count_by_avx2:
+            return cpu.popcnt && cpu.avx2;
+# if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+        case count_by_avx512:
+            return cpu.popcnt && cpu.avx512vpopcntdq;
+# endif
+#endif
+        default:
+            (void)cpu;
+            return false;
+        }
+    }
+
+    // PRE: count_kernel_available(k)
+    inline count_function count_kernel_function(count_kernel k)
+    {
+        switch (k) {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        case count_by_popcnt:
+            return &count_popcnt_kernel;
+        case count_by_avx2:
+            return &count_avx2_kernel;
+# if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+        case count_by_avx512:
+            return &count_avx512_kernel;
+# endif
+#endif
+        default:
+            return &count_table_kernel;
+        }
+    }
+
+    inline const char * count_kernel_name(count_kernel k)
+    {
+        static const char * const names[] = { "table", "popcnt", "avx2", "avx512" };
+        return names[k];
+    }
+
+    // the fastest kernel the running processor supports
+    inline count_kernel best_count_kernel()
+    {
+        static const count_kernel best =
+              count_kernel_available(count_by_avx512) ? count_by_avx512
+            : count_kernel_available(count_by_avx2)   ? count_by_avx2
+            : count_kernel_available(count_by_popcnt) ? count_by_popcnt
+            : count_by_table;
+        return best;
+    }
+
+    inline std::size_t count_bytes(const byte_type * p, std::size_t n)
+    {
+        static const count_function f = count_kernel_function(best_count_kernel());
+        return f(p, n);
+    }
+
+    // Same interface as do_count() (see detail/dynamic_bitset.hpp): the
+    // byte access mode goes through the dispatched kernels, the block
+    // access mode (Block has padding bits) keeps using the table.
+    //
+    template <typename Iterator, typename ValueType>
+    inline std::size_t count_blocks(Iterator first, std::size_t length, ValueType,
+                                    value_to_type<access_by_bytes> *)
+    {
+        return length == 0 ? 0
+            : count_bytes(object_representation(&*first), length * sizeof(*first));
+    }
+
+    template <typename Iterator, typename ValueType>
+    inline std::size_t count_blocks(Iterator first, std::size_t length, ValueType v,
+                                    value_to_type<access_by_blocks> * selector)
+    {
+        return do_count(first, length, v, selector);
+    }
+
+    // counts the bits of the contiguous range [p, p + n)
+    template <typename Block>
+    inline std::size_t count_block_range(const Block * p, std::size_t n)
+    {
+        enum { no_padding =
+            std::numeric_limits<Block>::digits == CHAR_BIT * sizeof(Block) };
+        enum { enough_table_width = table_width >= CHAR_BIT };
+        enum { mode = (no_padding && enough_table_width)
+                          ? access_by_bytes
+                          : access_by_blocks };
+
+        return count_blocks(p, n, Block(0),
+                            static_cast<value_to_type<(bool)mode> *>(0));
+    }
+
+    // ------- vector levels ---------------------------------
+
+    // Kernels which only need plain vector integer instructions come in
+    // one flavor per level: SSE2, AVX2 and AVX-512 (F + BW).
+    //
+    enum simd_level { simd_none, simd_sse2, simd_avx2, simd_avx512 };
+
+    inline bool simd_level_available(simd_level l)
+    {
+        const cpu_features & cpu = cpu_features::get();
+        switch (l) {
+        case simd_none:
+            return true;
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        case simd_sse2:
+            return cpu.sse2;
+        case simd_avx2:
+            return cpu.avx2;
+# if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+        case simd_avx512:
+            return cpu.avx512f && cpu.avx512bw;
+# endif
+#endif
+        default:
+            (void)cpu;
+            return false;
+        }
+    }
+
+    inline const char * simd_level_name(simd_level l)
+    {
+        static const char * const names[] = { "scalar", "sse2", "avx2", "avx512" };
+        return names[l];
+    }
+
+    inline simd_level best_simd_level()
+    {
+        static const simd_level best =
+              simd_level_available(simd_avx512) ? simd_avx512
+            : simd_level_available(simd_avx2)   ? simd_avx2
+            : simd_level_available(simd_sse2)   ? simd_sse2
+            : simd_none;
+        return best;
+    }
+
+    // buffers shorter than this (in bytes) are processed block by
+    // block, without going through a kernel
+    const std::size_t simd_threshold = 64;
+
+    inline byte_type * mutable_object_representation(void * p)
+    {
+        return static_cast<byte_type *>(p);
+    }
+
+    // ------- bitwise kernels -------------------------------
+
+    // d = d op s, element by element; op_not and op_id ignore s, op_rsub
+    // is the subtraction with swapped operands (d = s & ~d). op_id
+    // leaves d unchanged: it lets the scan kernels read one sequence.
+    // op_copy ignores d (d = s).
+    enum bitwise_op { op_and, op_or, op_xor, op_sub, op_rsub, op_not, op_id, op_copy };
+
+    template <int Op, typename T>
+    inline T apply_bitwise(T a, T b)
+    {
+        switch (Op) {
+        case op_and: return static_cast<T>(a & b);
+        case op_or:  return static_cast<T>(a | b);
+        case op_xor: return static_cast<T>(a ^ b);
+        case op_sub: return static_cast<T>(a & ~b);
+        case op_rsub: return static_cast<T>(~a & b);
+        case op_id:  return a;
+        case op_copy: return b;
+        default:     return static_cast<T>(~a);
+        }
+    }
+
+    typedef void (*bitwise_function)(byte_type *, const byte_type *, std::size_t);
+
+    template <int Op>
+    inline void bitwise_word_kernel(byte_type * d, const byte_type * s, std::size_t n)
+    {
+        std::size_t i = 0;
+        for ( ; i + 8 <= n; i += 8) {
+            const boost::uint64_t w = apply_bitwise<Op>(load_word64(d + i),
+                                                        load_word64(s + i));
+            std::memcpy(d + i, &w, sizeof w);
+        }
+        for ( ; i < n; ++i)
+            d[i] = apply_bitwise<Op>(d[i], s[i]);
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("sse2")
+    inline __m128i sse2_bitwise(__m128i a, __m128i b)
+    {
+        switch (Op) {
+        case op_and: return _mm_and_si128(a, b);
+        case op_or:  return _mm_or_si128(a, b);
+        case op_xor: return _mm_xor_si128(a, b);
+        case op_sub: return _mm_andnot_si128(b, a);
+        case op_rsub: return _mm_andnot_si128(a, b);
+        case op_id:  return a;
+        case op_copy: return b;
+        default:     return _mm_xor_si128(a, _mm_set1_epi32(-1));
+        }
+    }
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("sse2")
+    inline void bitwise_sse2_kernel(byte_type * d, const byte_type * s, std::size_t n)
+    {
+        __m128i * const vd = reinterpret_cast<__m128i *>(d);
+        const __m128i * const vs = reinterpret_cast<const __m128i *>(s);
+        const std::size_t nv = n / 16;
+        std::size_t i = 0;
+        for ( ; i + 4 <= nv; i += 4) {
+            const __m128i r0 = sse2_bitwise<Op>(_mm_loadu_si128(vd + i),     _mm_loadu_si128(vs + i));
+            const __m128i r1 = sse2_bitwise<Op>(_mm_loadu_si128(vd + i + 1), _mm_loadu_si128(vs + i + 1));
+            const __m128i r2 = sse2_bitwise<Op>(_mm_loadu_si128(vd + i + 2), _mm_loadu_si128(vs + i + 2));
+            const __m128i r3 = sse2_bitwise<Op>(_mm_loadu_si128(vd + i + 3), _mm_loadu_si128(vs + i + 3));
+            _mm_storeu_si128(vd + i,     r0);
+            _mm_storeu_si128(vd + i + 1, r1);
+            _mm_storeu_si128(vd + i + 2, r2);
+            _mm_storeu_si128(vd + i + 3, r3);
+        }
+        for ( ; i < nv; ++i)
+            _mm_storeu_si128(vd + i, sse2_bitwise<Op>(_mm_loadu_si128(vd + i),
+                                                      _mm_loadu_si128(vs + i)));
+
+        bitwise_word_kernel<Op>(d + 16 * nv, s + 16 * nv, n - 16 * nv);
+    }
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline __m256i avx2_bitwise(__m256i a, __m256i b)
+    {
+        switch (Op) {
+        case op_and: return _mm256_and_si256(a, b);
+        case op_or:  return _mm256_or_si256(a, b);
+        case op_xor: return _mm256_xor_si256(a, b);
+        case op_sub: return _mm256_andnot_si256(b, a);
+        case op_rsub: return _mm256_andnot_si256(a, b);
+        case op_id:  return a;
+        case op_copy: return b;
+        default:     return _mm256_xor_si256(a, _mm256_set1_epi32(-1));
+        }
+    }
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline void bitwise_avx2_kernel(byte_type * d, const byte_type * s, std::size_t n)
+    {
+        __m256i * const vd = reinterpret_cast<__m256i *>(d);
+        const __m256i * const vs = reinterpret_cast<const __m256i *>(s);
+        const std::size_t nv = n / 32;
+        std::size_t i = 0;
+        for ( ; i + 4 <= nv; i += 4) {
+            const __m256i r0 = avx2_bitwise<Op>(_mm256_loadu_si256(vd + i),     _mm256_loadu_si256(vs + i));
+            const __m256i r1 = avx2_bitwise<Op>(_mm256_loadu_si256(vd + i + 1), _mm256_loadu_si256(vs + i + 1));
+            const __m256i r2 = avx2_bitwise<Op>(_mm256_loadu_si256(vd + i + 2), _mm256_loadu_si256(vs + i + 2));
+            const __m256i r3 = avx2_bitwise<Op>(_mm256_loadu_si256(vd + i + 3), _mm256_loadu_si256(vs + i + 3));
+            _mm256_storeu_si256(vd + i,     r0);
+            _mm256_storeu_si256(vd + i + 1, r1);
+            _mm256_storeu_si256(vd + i + 2, r2);
+            _mm256_storeu_si256(vd + i + 3, r3);
+        }
+        for ( ; i < nv; ++i)
+            _mm256_storeu_si256(vd + i, avx2_bitwise<Op>(_mm256_loadu_si256(vd + i),
+                                                         _mm256_loadu_si256(vs + i)));
+
+        bitwise_word_kernel<Op>(d + 32 * nv, s + 32 * nv, n - 32 * nv);
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("avx512f")
+    inline __m512i avx512_bitwise(__m512i a, __m512i b)
+    {
+        switch (Op) {
+        case op_and: return _mm512_and_si512(a, b);
+        case op_or:  return _mm512_or_si512(a, b);
+        case op_xor: return _mm512_xor_si512(a, b);
+        // a & ~b; _mm512_andnot_si512 trips -Wmaybe-uninitialized
+        // in the gcc 12 headers
+        case op_sub: return _mm512_ternarylogic_epi64(a, b, b, 0x30);
+        case op_rsub: return _mm512_ternarylogic_epi64(a, b, b, 0x0c);
+        case op_id:  return a;
+        case op_copy: return b;
+        default:     return _mm512_xor_si512(a, _mm512_set1_epi32(-1));
+        }
+    }
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("avx512f")
+    inline void bitwise_avx512_kernel(byte_type * d, const byte_type * s, std::size_t n)
+    {
+        const std::size_t nv = n / 64;
+        std::size_t i = 0;
+        for ( ; i + 4 <= nv; i += 4) {
+            byte_type * const q = d + 64 * i;
+            const byte_type * const r = s + 64 * i;
+            const __m512i r0 = avx512_bitwise<Op>(_mm512_loadu_si512(q),       _mm512_loadu_si512(r));
+            const __m512i r1 = avx512_bitwise<Op>(_mm512_loadu_si512(q + 64),  _mm512_loadu_si512(r + 64));
+            const __m512i r2 = avx512_bitwise<Op>(_mm512_loadu_si512(q + 128), _mm512_loadu_si512(r + 128));
+            const __m512i r3 = avx512_bitwise<Op>(_mm512_loadu_si512(q + 192), _mm512_loadu_si512(r + 192));
+            _mm512_storeu_si512(q,       r0);
+            _mm512_storeu_si512(q + 64,  r1);
+            _mm512_storeu_si512(q + 128, r2);
+            _mm512_storeu_si512(q + 192, r3);
+        }
+        for ( ; i < nv; ++i)
+            _mm512_storeu_si512(d + 64 * i, avx512_bitwise<Op>(_mm512_loadu_si512(d + 64 * i),
+                                                               _mm512_loadu_si512(s + 64 * i)));
+
+        bitwise_avx2_kernel<Op>(d + 64 * nv, s + 64 * nv, n - 64 * nv);
+    }
+#endif
+
+#endif // BOOST_DYNAMIC_BITSET_X86_SIMD
+
+    // PRE: simd_level_available(l)
+    template <int Op>
+    inline bitwise_function bitwise_kernel_function(simd_level l)
+    {
+        switch (l) {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        case simd_sse2:
+            return &bitwise_sse2_kernel<Op>;
+        case simd_avx2:
+            return &bitwise_avx2_kernel<Op>;
+# if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+        case simd_avx512:
+            return &bitwise_avx512_kernel<Op>;
+# endif
+#endif
+        default:
+            return &bitwise_word_kernel<Op>;
+        }
+    }
+
+    // d[i] = d[i] op s[i] for i in [0, n); d and s may be equal but
+    // must not otherwise overlap
+    //
+    template <int Op, typename Block>
+    inline void bitwise_blocks(Block * d, const Block * s, std::size_t n)
+    {
+        const bool no_padding =
+            std::numeric_limits<Block>::digits == CHAR_BIT * sizeof(Block);
+
+        if (no_padding && n * sizeof(Block) >= simd_threshold) {
+            static const bitwise_function f =
+                bitwise_kernel_function<Op>(best_simd_level());
+            f(mutable_object_representation(d), object_representation(s),
+              n * sizeof(Block));
+        }
+        else {
+            for (std::size_t i = 0; i < n; ++i)
+                d[i] = apply_bitwise<Op>(d[i], s[i]);
+        }
+    }
+
+    // ------- shift kernels ----------------------------------
+
+    // d = d op t, where t is s shifted by 8 q + r bits (r < 8): towards
+    // the high bytes if Left, as operator<<=, else towards the low ones;
+    // the bits shifted in are zero. Bits are numbered in little-endian
+    // order across the bytes, which callers check: the bytes of t are
+    // read on the fly from two loads of s one byte apart, and a shift of
+    // each 64-bit lane. Left kernels run from the high end and right ones
+    // from the low end, so that d and s may be equal.
+    //
+    typedef void (*shift_function)(byte_type *, const byte_type *, std::size_t,
+                                   std::size_t, unsigned);
+
+    // byte i of t, for a buffer of n bytes
+    template <bool Left>
+    inline byte_type shifted_byte(const byte_type * s, std::size_t n,
+                                  std::size_t q, unsigned r, std::size_t i)
+    {
+        if (Left) {
+            const unsigned hi = i >= q ? s[i - q] : 0;
+            const unsigned lo = i >= q + 1 ? s[i - q - 1] : 0;
+            return static_cast<byte_type>((hi << r) | (lo >> (8 - r)));
+        }
+        else {
+            const unsigned lo = i + q < n ? s[i + q] : 0;
+            const unsigned hi = i + q + 1 < n ? s[i + q + 1] : 0;
+            return static_cast<byte_type>((lo >> r) | (hi << (8 - r)));
+        }
+    }
+
+    // d = d op 0 over n bytes
+    template <int Op>
+    inline void bitwise_zero_kernel(byte_type * d, std::size_t n)
+    {
+        if (Op == op_and || Op == op_copy)
+            std::memset(d, 0, n);
+    }
+
+    template <int Op, bool Left>
+    inline void shift_word_kernel(byte_type * d, const byte_type * s, std::size_t n,
+                                  std::size_t q, unsigned r)
+    {
+        if (Left) {
+            std::size_t i = n;
+            for ( ; i >= q + 9; i -= 8) {
+                const byte_type * const p = s + (i - 8 - q);
+                const boost::uint64_t t = (load_word64(p) << r)
+                                        | (load_word64(p - 1) >> (8 - r));
+                const boost::uint64_t w = apply_bitwise<Op>(load_word64(d + i - 8), t);
+                std::memcpy(d + i - 8, &w, sizeof w);
+            }
+            for ( ; i > q; --i)
+                d[i - 1] = apply_bitwise<Op>(d[i - 1], shifted_byte<true>(s, n, q, r, i - 1));
+            bitwise_zero_kernel<Op>(d, (std::min)(i, q));
+        }
+        else {
+            std::size_t i = 0;
+            for ( ; i + q + 9 <= n; i += 8) {
+                const byte_type * const p = s + (i + q);
+                const boost::uint64_t t = (load_word64(p) >> r)
+                                        | (load_word64(p + 1) << (8 - r));
+                const boost::uint64_t w = apply_bitwise<Op>(load_word64(d + i), t);
+                std::memcpy(d + i, &w, sizeof w);
+            }
+            for ( ; i + q < n; ++i)
+                d[i] = apply_bitwise<Op>(d[i], shifted_byte<false>(s, n, q, r, i));
+            bitwise_zero_kernel<Op>(d + i, n - i);
+        }
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+
+    template <int Op, bool Left>
+    BOOST_DYNAMIC_BITSET_TARGET("sse2")
+    inline void shift_sse2_kernel(byte_type * d, const byte_type * s, std::size_t n,
+                                  std::size_t q, unsigned r)
+    {
+        const __m128i c0 = _mm_cvtsi32_si128(static_cast<int>(r));
+        const __m128i c1 = _mm_cvtsi32_si128(static_cast<int>(8 - r));
+        if (Left) {
+            std::size_t i = n;
+            for ( ; i >= q + 17; i -= 16) {
+                const byte_type * const p = s + (i - 16 - q);
+                const __m128i t = _mm_or_si128(
+                    _mm_sll_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), c0),
+                    _mm_srl_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p - 1)), c1));
+                __m128i * const v = reinterpret_cast<__m128i *>(d + i - 16);
+                _mm_storeu_si128(v, sse2_bitwise<Op>(_mm_loadu_si128(v), t));
+            }
+            shift_word_kernel<Op, true>(d, s, i, q, r);
+        }
+        else {
+            std::size_t i = 0;
+            for ( ; i + q + 17 <= n; i += 16) {
+                const byte_type * const p = s + (i + q);
+                const __m128i t = _mm_or_si128(
+                    _mm_srl_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), c0),
+                    _mm_sll_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1)), c1));
+                __m128i * const v = reinterpret_cast<__m128i *>(d + i);
+                _mm_storeu_si128(v, sse2_bitwise<Op>(_mm_loadu_si128(v), t));
+            }
+            shift_word_kernel<Op, false>(d + i, s + i, n - i, q, r);
+        }
+    }
+
+    template <int Op, bool Left>
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline void shift_avx2_kernel(byte_type * d, const byte_type * s, std::size_t n,
+                                  std::size_t q, unsigned r)
+    {
+        const __m128i c0 = _mm_cvtsi32_si128(static_cast<int>(r));
+        const __m128i c1 = _mm_cvtsi32_si128(static_cast<int>(8 - r));
+        if (Left) {
+            std::size_t i = n;
+            for ( ; i >= q + 33; i -= 32) {
+                const byte_type * const p = s + (i - 32 - q);
+                const __m256i t = _mm256_or_si256(
+                    _mm256_sll_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), c0),
+                    _mm256_srl_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p - 1)), c1));
+                __m256i * const v = reinterpret_cast<__m256i *>(d + i - 32);
+                _mm256_storeu_si256(v, avx2_bitwise<Op>(_mm256_loadu_si256(v), t));
+            }
+            shift_word_kernel<Op, true>(d, s, i, q, r);
+        }
+        else {
+            std::size_t i = 0;
+            for ( ; i + q + 33 <= n; i += 32) {
+                const byte_type * const p = s + (i + q);
+                const __m256i t = _mm256_or_si256(
+                    _mm256_srl_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), c0),
+                    _mm256_sll_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1)), c1));
+                __m256i * const v = reinterpret_cast<__m256i *>(d + i);
+                _mm256_storeu_si256(v, avx2_bitwise<Op>(_mm256_loadu_si256(v), t));
+            }
+            shift_word_kernel<Op, false>(d + i, s + i, n - i, q, r);
+        }
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+    template <int Op, bool Left>
+    BOOST_DYNAMIC_BITSET_TARGET("avx512f")
+    inline void shift_avx512_kernel(byte_type * d, const byte_type * s, std::size_t n,
+                                    std::size_t q, unsigned r)
+    {
+        const __m128i c0 = _mm_cvtsi32_si128(static_cast<int>(r));
+        const __m128i c1 = _mm_cvtsi32_si128(static_cast<int>(8 - r));
+        // the unmasked shifts trip -Wmaybe-uninitialized in the gcc 12
+        // headers
+        const __mmask8 all = 0xff;
+        if (Left) {
+            std::size_t i = n;
+            for ( ; i >= q + 65; i -= 64) {
+                const byte_type * const p = s + (i - 64 - q);
+                const __m512i t = _mm512_or_si512(_mm512_maskz_sll_epi64(all, _mm512_loadu_si512(p), c0),
+                                                  _mm512_maskz_srl_epi64(all, _mm512_loadu_si512(p - 1), c1));
+                byte_type * const v = d + i - 64;
+                _mm512_storeu_si512(v, avx512_bitwise<Op>(_mm512_loadu_si512(v), t));
+            }
+            shift_avx2_kernel<Op, true>(d, s, i, q, r);
+        }
+        else {
+            std::size_t i = 0;
+            for ( ; i + q + 65 <= n; i += 64) {
+                const byte_type * const p = s + (i + q);
+                const __m512i t = _mm512_or_si512(_mm512_maskz_srl_epi64(all, _mm512_loadu_si512(p), c0),
+                                                  _mm512_maskz_sll_epi64(all, _mm512_loadu_si512(p + 1), c1));
+                byte_type * const v = d + i;
+                _mm512_storeu_si512(v, avx512_bitwise<Op>(_mm512_loadu_si512(v), t));
+            }
+            shift_avx2_kernel<Op, false>(d + i, s + i, n - i, q, r);
+        }
+    }
+#endif
+
+#endif // BOOST_DYNAMIC_BITSET_X86_SIMD
+
+    // PRE: simd_level_available(l)
+    template <int Op, bool Left>
+    inline shift_function shift_kernel_function(simd_level l)
+    {
+        switch (l) {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        case simd_sse2:
+            return &shift_sse2_kernel<Op, Left>;
+        case simd_avx2:
+            return &shift_avx2_kernel<Op, Left>;
+# if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+        case simd_avx512:
+            return &shift_avx512_kernel<Op, Left>;
+# endif
+#endif
+        default:
+            return &shift_word_kernel<Op, Left>;
+        }
+    }
+
+    // d[i] = d[i] op t[i] for i in [0, n), where t is the n blocks of s
+    // shifted by k bits, towards the high blocks if Left; d and s may be
+    // equal but must not otherwise overlap
+    //
+    template <int Op, bool Left, typename Block>
+    inline void shift_bitwise_blocks(Block * d, const Block * s, std::size_t n,
+                                     std::size_t k)
+    {
+        const std::size_t bits_per_block = std::numeric_limits<Block>::digits;
+        const bool no_padding = bits_per_block == CHAR_BIT * sizeof(Block);
+#if BOOST_ENDIAN_BIG_BYTE
+        const bool little_endian = sizeof(Block) == 1;
+#else
+        const bool little_endian = true;
+#endif
+
+        k = (std::min)(k, n * bits_per_block);
+        if (no_padding && little_endian && CHAR_BIT == 8
+                && n * sizeof(Block) >= simd_threshold) {
+            static const shift_function f =
+                shift_kernel_function<Op, Left>(best_simd_level());
+            f(mutable_object_representation(d), object_representation(s),
+              n * sizeof(Block), k / 8, static_cast<unsigned>(k % 8));
+            return;
+        }
+
+        const std::size_t div = k / bits_per_block;
+        const unsigned r = static_cast<unsigned>(k % bits_per_block);
+        if (Left) {
+            for (std::size_t i = n; i-- > 0; ) {
+                Block t = 0;
+                if (i >= div)
+                    t = static_cast<Block>(s[i - div] << r);
+                if (r != 0 && i >= div + 1)
+                    t |= static_cast<Block>(s[i - div - 1] >> (bits_per_block - r));
+                d[i] = apply_bitwise<Op>(d[i], t);
+            }
+        }
+        else {
+            for (std::size_t i = 0; i < n; ++i) {
+                Block t = 0;
+                if (i + div < n)
+                    t = static_cast<Block>(s[i + div] >> r);
+                if (r != 0 && i + div + 1 < n)
+                    t |= static_cast<Block>(s[i + div + 1] << (bits_per_block - r));
+                d[i] = apply_bitwise<Op>(d[i], t);
+            }
+        }
+    }
+
+    // ------- binary count kernels --------------------------
+
+    // Number of bits set in a op b, computed without storing a op b:
+    // one flavor per count kernel.
+    //
+    typedef std::size_t (*count2_function)(const byte_type *, const byte_type *,
+                                           std::size_t);
+
+    template <int Op>
+    inline std::size_t count2_table_kernel(const byte_type * a, const byte_type * b,
+                                           std::size_t n)
+    {
+        std::size_t num = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            num += count_table<>::table[apply_bitwise<Op>(a[i], b[i])];
+        return num;
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("popcnt")
+    inline std::size_t count2_popcnt_kernel(const byte_type * a, const byte_type * b,
+                                            std::size_t n)
+    {
+        std::size_t num = 0;
+        std::size_t i = 0;
+#if defined(BOOST_DYNAMIC_BITSET_X86_64)
+        std::size_t n0 = 0, n1 = 0, n2 = 0, n3 = 0;
+        for ( ; i + 32 <= n; i += 32) {
+            n0 += static_cast<std::size_t>(_mm_popcnt_u64(
+                apply_bitwise<Op>(load_word64(a + i),      load_word64(b + i))));
+            n1 += static_cast<std::size_t>(_mm_popcnt_u64(
+                apply_bitwise<Op>(load_word64(a + i + 8),  load_word64(b + i + 8))));
+            n2 += static_cast<std::size_t>(_mm_popcnt_u64(
+                apply_bitwise<Op>(load_word64(a + i + 16), load_word64(b + i + 16))));
+            n3 += static_cast<std::size_t>(_mm_popcnt_u64(
+                apply_bitwise<Op>(load_word64(a + i + 24), load_word64(b + i + 24))));
+        }
+        for ( ; i + 8 <= n; i += 8)
+            n0 += static_cast<std::size_t>(_mm_popcnt_u64(
+                apply_bitwise<Op>(load_word64(a + i), load_word64(b + i))));
+        num = n0 + n1 + n2 + n3;
+#endif
+        for ( ; i + 4 <= n; i += 4) {
+            boost::uint32_t u, v;
+            std::memcpy(&u, a + i, sizeof u);
+            std::memcpy(&v, b + i, sizeof v);
+            num += _mm_popcnt_u32(apply_bitwise<Op>(u, v));
+        }
+        for ( ; i < n; ++i)
+            num += _mm_popcnt_u32(apply_bitwise<Op>(a[i], b[i]));
+
+        return num;
+    }
+
+    template <int Op>
+    struct avx2_binary_loader
+    {
+        avx2_binary_loader(const byte_type * a, const byte_type * b) : m_a(a), m_b(b) {}
+
+        BOOST_DYNAMIC_BITSET_TARGET("avx2")
+        __m256i operator()(std::size_t i) const
+        {
+            return avx2_bitwise<Op>(avx2_load(m_a + 32 * i), avx2_load(m_b + 32 * i));
+        }
+
+        const byte_type * m_a;
+        const byte_type * m_b;
+    };
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("avx2,popcnt")
+    inline std::size_t count2_avx2_kernel(const byte_type * a, const byte_type * b,
+                                          std::size_t n)
+    {
+        const std::size_t nv = n / 32;
+        const __m256i total = avx2_harley_seal(avx2_binary_loader<Op>(a, b), nv);
+
+        const std::size_t done = 32 * nv;
+        return static_cast<std::size_t>(avx2_hsum64(total))
+             + count2_popcnt_kernel<Op>(a + done, b + done, n - done);
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("avx512f,avx512vpopcntdq,popcnt")
+    inline __m512i avx512_popcount2(const byte_type * a, const byte_type * b)
+    {
+        return _mm512_popcnt_epi64(avx512_bitwise<Op>(_mm512_loadu_si512(a),
+                                                      _mm512_loadu_si512(b)));
+    }
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("avx512f,avx512vpopcntdq,popcnt")
+    inline std::size_t count2_avx512_kernel(const byte_type * a, const byte_type * b,
+                                            std::size_t n)
+    {
+        __m512i acc0 = _mm512_setzero_si512();
+        __m512i acc1 = acc0, acc2 = acc0, acc3 = acc0;
+        std::size_t i = 0;
+        for ( ; i + 256 <= n; i += 256) {
+            acc0 = _mm512_add_epi64(acc0, avx512_popcount2<Op>(a + i,       b + i));
+            acc1 = _mm512_add_epi64(acc1, avx512_popcount2<Op>(a + i + 64,  b + i + 64));
+            acc2 = _mm512_add_epi64(acc2, avx512_popcount2<Op>(a + i + 128, b + i + 128));
+            acc3 = _mm512_add_epi64(acc3, avx512_popcount2<Op>(a + i + 192, b + i + 192));
+        }
+        for ( ; i + 64 <= n; i += 64)
+            acc0 = _mm512_add_epi64(acc0, avx512_popcount2<Op>(a + i, b + i));
+
+        acc0 = _mm512_add_epi64(_mm512_add_epi64(acc0, acc1),
+                                _mm512_add_epi64(acc2, acc3));
+        boost::uint64_t lanes[8];
+        _mm512_storeu_si512(lanes, acc0);
+        boost::uint64_t num = 0;
+        for (int k = 0; k < 8; ++k)
+            num += lanes[k];
+        return static_cast<std::size_t>(num)
+             + count2_popcnt_kernel<Op>(a + i, b + i, n - i);
+    }
+#endif
+
+#endif // BOOST_DYNAMIC_BITSET_X86_SIMD
+
+    // PRE: count_kernel_available(k)
+    template <int Op>
+    inline count2_function count2_kernel_function(count_kernel k)
+    {
+        switch (k) {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        case count_by_popcnt:
+            return &count2_popcnt_kernel<Op>;
+        case count_by_avx2:
+            return &count2_avx2_kernel<Op>;
+# if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+        case count_by_avx512:
+            return &count2_avx512_kernel<Op>;
+# endif
+#endif
+        default:
+            return &count2_table_kernel<Op>;
+        }
+    }
+
+    template <int Op>
+    inline std::size_t count2_bytes(const byte_type * a, const byte_type * b,
+                                    std::size_t n)
+    {
+        static const count2_function f =
+            count2_kernel_function<Op>(best_count_kernel());
+        return f(a, b, n);
+    }
+
+    // counts the bits of a[i] op b[i] for i in [0, n)
+    template <int Op, typename Block>
+    inline std::size_t count2_block_range(const Block * a, const Block * b,
+                                          std::size_t n)
+    {
+        enum { no_padding =
+            std::numeric_limits<Block>::digits == CHAR_BIT * sizeof(Block) };
+        enum { enough_table_width = table_width >= CHAR_BIT };
+
+        if (n == 0)
+            return 0;
+        if (no_padding && enough_table_width)
+            return count2_bytes<Op>(object_representation(a),
+                                    object_representation(b), n * sizeof(Block));
+
+        std::size_t num = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            const Block v = apply_bitwise<Op>(a[i], b[i]);
+            num += do_count(&v, 1, Block(0),
+                            static_cast<value_to_type<access_by_blocks> *>(0));
+        }
+        return num;
+    }
+
+    // ------- scan kernels -----------------------------------
+
+    // Offset of the first nonzero byte of a op b, or n if there is none
+    // (with op_id, of a alone). Zero runs are tested a group of vectors
+    // at a time, and prefetched ahead of the scan.
+    //
+    typedef std::size_t (*scan_function)(const byte_type *, const byte_type *,
+                                         std::size_t);
+
+    // in bytes, ahead of the group being tested
+    const std::size_t scan_prefetch_distance = 1024;
+
+    template <int Op>
+    inline std::size_t scan_word_kernel(const byte_type * a, const byte_type * b,
+                                        std::size_t n)
+    {
+        std::size_t i = 0;
+        for ( ; i + 32 <= n; i += 32) {
+            const boost::uint64_t w =
+                  apply_bitwise<Op>(load_word64(a + i),      load_word64(b + i))
+                | apply_bitwise<Op>(load_word64(a + i + 8),  load_word64(b + i + 8))
+                | apply_bitwise<Op>(load_word64(a + i + 16), load_word64(b + i + 16))
+                | apply_bitwise<Op>(load_word64(a + i + 24), load_word64(b + i + 24));
+            if (w)
+                break;
+        }
+        for ( ; i + 8 <= n; i += 8)
+            if (apply_bitwise<Op>(load_word64(a + i), load_word64(b + i)))
+                break;
+        for ( ; i < n; ++i)
+            if (apply_bitwise<Op>(a[i], b[i]))
+                return i;
+        return n;
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("sse")
+    inline void scan_prefetch(const byte_type * a, const byte_type * b)
+    {
+        _mm_prefetch(reinterpret_cast<const char *>(a + scan_prefetch_distance), _MM_HINT_T0);
+        if (Op != op_id && Op != op_not)
+            _mm_prefetch(reinterpret_cast<const char *>(b + scan_prefetch_distance), _MM_HINT_T0);
+    }
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("sse2")
+    inline std::size_t scan_sse2_kernel(const byte_type * a, const byte_type * b,
+                                        std::size_t n)
+    {
+        const __m128i * const va = reinterpret_cast<const __m128i *>(a);
+        const __m128i * const vb = reinterpret_cast<const __m128i *>(b);
+        const __m128i zero = _mm_setzero_si128();
+        const std::size_t nv = n / 16;
+        std::size_t i = 0;
+        for ( ; i + 4 <= nv; i += 4) {
+            scan_prefetch<Op>(a + 16 * i, b + 16 * i);
+            const __m128i v = _mm_or_si128(
+                _mm_or_si128(sse2_bitwise<Op>(_mm_loadu_si128(va + i),     _mm_loadu_si128(vb + i)),
+                             sse2_bitwise<Op>(_mm_loadu_si128(va + i + 1), _mm_loadu_si128(vb + i + 1))),
+                _mm_or_si128(sse2_bitwise<Op>(_mm_loadu_si128(va + i + 2), _mm_loadu_si128(vb + i + 2)),
+                             sse2_bitwise<Op>(_mm_loadu_si128(va + i + 3), _mm_loadu_si128(vb + i + 3))));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xffff)
+                break;
+        }
+        for ( ; i < nv; ++i) {
+            const __m128i v = sse2_bitwise<Op>(_mm_loadu_si128(va + i), _mm_loadu_si128(vb + i));
+            const unsigned nonzero =
+                ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero))) & 0xffffu;
+            if (nonzero)
+                return 16 * i + boost::lowest_bit(nonzero);
+        }
+
+        const std::size_t done = 16 * nv;
+        return done + scan_word_kernel<Op>(a + done, b + done, n - done);
+    }
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline std::size_t scan_avx2_kernel(const byte_type * a, const byte_type * b,
+                                        std::size_t n)
+    {
+        const avx2_binary_loader<Op> ld(a, b);
+        const std::size_t nv = n / 32;
+        std::size_t i = 0;
+        for ( ; i + 4 <= nv; i += 4) {
+            scan_prefetch<Op>(a + 32 * i, b + 32 * i);
+            scan_prefetch<Op>(a + 32 * i + 64, b + 32 * i + 64);
+            const __m256i v = _mm256_or_si256(_mm256_or_si256(ld(i),     ld(i + 1)),
+                                              _mm256_or_si256(ld(i + 2), ld(i + 3)));
+            if (!_mm256_testz_si256(v, v))
+                break;
+        }
+        for ( ; i < nv; ++i) {
+            const __m256i v = ld(i);
+            if (!_mm256_testz_si256(v, v)) {
+                const unsigned zero = static_cast<unsigned>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256())));
+                return 32 * i + boost::lowest_bit(~zero);
+            }
+        }
+
+        const std::size_t done = 32 * nv;
+        return done + scan_word_kernel<Op>(a + done, b + done, n - done);
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("avx512f,avx512bw")
+    inline std::size_t scan_avx512_kernel(const byte_type * a, const byte_type * b,
+                                          std::size_t n)
+    {
+        const std::size_t nv = n / 64;
+        std::size_t i = 0;
+        for ( ; i + 4 <= nv; i += 4) {
+            const byte_type * const p = a + 64 * i;
+            const byte_type * const q = b + 64 * i;
+            for (std::size_t k = 0; k < 4; ++k)
+                scan_prefetch<Op>(p + 64 * k, q + 64 * k);
+            const __m512i v = _mm512_or_si512(
+                _mm512_or_si512(avx512_bitwise<Op>(_mm512_loadu_si512(p),       _mm512_loadu_si512(q)),
+                                avx512_bitwise<Op>(_mm512_loadu_si512(p + 64),  _mm512_loadu_si512(q + 64))),
+                _mm512_or_si512(avx512_bitwise<Op>(_mm512_loadu_si512(p + 128), _mm512_loadu_si512(q + 128)),
+                                avx512_bitwise<Op>(_mm512_loadu_si512(p + 192), _mm512_loadu_si512(q + 192))));
+            if (_mm512_test_epi64_mask(v, v))
+                break;
+        }
+        for ( ; i < nv; ++i) {
+            const __m512i v = avx512_bitwise<Op>(_mm512_loadu_si512(a + 64 * i),
+                                                 _mm512_loadu_si512(b + 64 * i));
+            const boost::uint64_t nonzero = _mm512_test_epi8_mask(v, v);
+            if (nonzero)
+                return 64 * i + boost::lowest_bit(nonzero);
+        }
+
+        const std::size_t done = 64 * nv;
+        return done + scan_avx2_kernel<Op>(a + done, b + done, n - done);
+    }
+#endif
+
+#endif // BOOST_DYNAMIC_BITSET_X86_SIMD
+
+    // PRE: simd_level_available(l)
+    template <int Op>
+    inline scan_function scan_kernel_function(simd_level l)
+    {
+        switch (l) {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        case simd_sse2:
+            return &scan_sse2_kernel<Op>;
+        case simd_avx2:
+            return &scan_avx2_kernel<Op>;
+# if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+        case simd_avx512:
+            return &scan_avx512_kernel<Op>;
+# endif
+#endif
+        default:
+            return &scan_word_kernel<Op>;
+        }
+    }
+
+    // the first i in [0, n) such that a[i] op b[i] is not zero, or n;
+    // op_id and op_not ignore b, which may then be equal to a
+    //
+    template <int Op, typename Block>
+    inline std::size_t find_nonzero_block(const Block * a, const Block * b, std::size_t n)
+    {
+        const bool no_padding =
+            std::numeric_limits<Block>::digits == CHAR_BIT * sizeof(Block);
+
+        if (no_padding && n * sizeof(Block) >= simd_threshold) {
+            static const scan_function f =
+                scan_kernel_function<Op>(best_simd_level());
+            return f(object_representation(a), object_representation(b),
+                     n * sizeof(Block)) / sizeof(Block);
+        }
+
+        std::size_t i = 0;
+        while (i < n && apply_bitwise<Op>(a[i], b[i]) == 0)
+            ++i;
+        return i;
+    }
+
+    // Offset of the last nonzero byte of a op b, or n if there is none:
+    // the scan kernels run backwards, for the comparisons which start
+    // from the most significant blocks. The top bytes which don't fill
+    // a vector are tested first.
+    //
+    template <int Op>
+    inline std::size_t rscan_word_kernel(const byte_type * a, const byte_type * b,
+                                         std::size_t n)
+    {
+        std::size_t i = n;
+        for ( ; i >= 32; i -= 32) {
+            const boost::uint64_t w =
+                  apply_bitwise<Op>(load_word64(a + i - 32), load_word64(b + i - 32))
+                | apply_bitwise<Op>(load_word64(a + i - 24), load_word64(b + i - 24))
+                | apply_bitwise<Op>(load_word64(a + i - 16), load_word64(b + i - 16))
+                | apply_bitwise<Op>(load_word64(a + i - 8),  load_word64(b + i - 8));
+            if (w)
+                break;
+        }
+        for ( ; i >= 8; i -= 8)
+            if (apply_bitwise<Op>(load_word64(a + i - 8), load_word64(b + i - 8)))
+                break;
+        for ( ; i > 0; --i)
+            if (apply_bitwise<Op>(a[i - 1], b[i - 1]))
+                return i - 1;
+        return n;
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("sse2")
+    inline std::size_t rscan_sse2_kernel(const byte_type * a, const byte_type * b,
+                                         std::size_t n)
+    {
+        const std::size_t nv = n / 16;
+        const std::size_t done = 16 * nv;
+        const std::size_t top = rscan_word_kernel<Op>(a + done, b + done, n - done);
+        if (top != n - done)
+            return done + top;
+
+        const __m128i * const va = reinterpret_cast<const __m128i *>(a);
+        const __m128i * const vb = reinterpret_cast<const __m128i *>(b);
+        const __m128i zero = _mm_setzero_si128();
+        std::size_t i = nv;
+        for ( ; i >= 4; i -= 4) {
+            const __m128i v = _mm_or_si128(
+                _mm_or_si128(sse2_bitwise<Op>(_mm_loadu_si128(va + i - 4), _mm_loadu_si128(vb + i - 4)),
+                             sse2_bitwise<Op>(_mm_loadu_si128(va + i - 3), _mm_loadu_si128(vb + i - 3))),
+                _mm_or_si128(sse2_bitwise<Op>(_mm_loadu_si128(va + i - 2), _mm_loadu_si128(vb + i - 2)),
+                             sse2_bitwise<Op>(_mm_loadu_si128(va + i - 1), _mm_loadu_si128(vb + i - 1))));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xffff)
+                break;
+        }
+        for ( ; i > 0; --i) {
+            const __m128i v = sse2_bitwise<Op>(_mm_loadu_si128(va + i - 1),
+                                               _mm_loadu_si128(vb + i - 1));
+            const unsigned nonzero =
+                ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero))) & 0xffffu;
+            if (nonzero)
+                return 16 * (i - 1) + boost::highest_bit(nonzero);
+        }
+        return n;
+    }
+
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline std::size_t rscan_avx2_kernel(const byte_type * a, const byte_type * b,
+                                         std::size_t n)
+    {
+        const std::size_t nv = n / 32;
+        const std::size_t done = 32 * nv;
+        const std::size_t top = rscan_word_kernel<Op>(a + done, b + done, n - done);
+        if (top != n - done)
+            return done + top;
+
+        const avx2_binary_loader<Op> ld(a, b);
+        std::size_t i = nv;
+        for ( ; i >= 4; i -= 4) {
+            const __m256i v = _mm256_or_si256(_mm256_or_si256(ld(i - 4), ld(i - 3)),
+                                              _mm256_or_si256(ld(i - 2), ld(i - 1)));
+            if (!_mm256_testz_si256(v, v))
+                break;
+        }
+        for ( ; i > 0; --i) {
+            const __m256i v = ld(i - 1);
+            if (!_mm256_testz_si256(v, v)) {
+                const unsigned zero = static_cast<unsigned>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256())));
+                return 32 * (i - 1) + boost::highest_bit(~zero);
+            }
+        }
+        return n;
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+    template <int Op>
+    BOOST_DYNAMIC_BITSET_TARGET("avx512f,avx512bw")
+    inline std::size_t rscan_avx512_kernel(const byte_type * a, const byte_type * b,
+                                           std::size_t n)
+    {
+        const std::size_t nv = n / 64;
+        const std::size_t done = 64 * nv;
+        const std::size_t top = rscan_avx2_kernel<Op>(a + done, b + done, n - done);
+        if (top != n - done)
+            return done + top;
+
+        std::size_t i = nv;
+        for ( ; i >= 4; i -= 4) {
+            const byte_type * const p = a + 64 * (i - 4);
+            const byte_type * const q = b + 64 * (i - 4);
+            const __m512i v = _mm512_or_si512(
+                _mm512_or_si512(avx512_bitwise<Op>(_mm512_loadu_si512(p),       _mm512_loadu_si512(q)),
+                                avx512_bitwise<Op>(_mm512_loadu_si512(p + 64),  _mm512_loadu_si512(q + 64))),
+                _mm512_or_si512(avx512_bitwise<Op>(_mm512_loadu_si512(p + 128), _mm512_loadu_si512(q + 128)),
+                                avx512_bitwise<Op>(_mm512_loadu_si512(p + 192), _mm512_loadu_si512(q + 192))));
+            if (_mm512_test_epi64_mask(v, v))
+                break;
+        }
+        for ( ; i > 0; --i) {
+            const __m512i v = avx512_bitwise<Op>(_mm512_loadu_si512(a + 64 * (i - 1)),
+                                                 _mm512_loadu_si512(b + 64 * (i - 1)));
+            const boost::uint64_t nonzero = _mm512_test_epi8_mask(v, v);
+            if (nonzero)
+                return 64 * (i - 1) + boost::highest_bit(nonzero);
+        }
+        return n;
+    }
+#endif
+
+#endif // BOOST_DYNAMIC_BITSET_X86_SIMD
+
+    // PRE: simd_level_available(l)
+    template <int Op>
+    inline scan_function rscan_kernel_function(simd_level l)
+    {
+        switch (l) {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        case simd_sse2:
+            return &rscan_sse2_kernel<Op>;
+        case simd_avx2:
+            return &rscan_avx2_kernel<Op>;
+# if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+        case simd_avx512:
+            return &rscan_avx512_kernel<Op>;
+# endif
+#endif
+        default:
+            return &rscan_word_kernel<Op>;
+        }
+    }
+
+    // the last i in [0, n) such that a[i] op b[i] is not zero, or n;
+    // as find_nonzero_block(), op_id and op_not ignore b
+    //
+    template <int Op, typename Block>
+    inline std::size_t find_last_nonzero_block(const Block * a, const Block * b, std::size_t n)
+    {
+        const bool no_padding =
+            std::numeric_limits<Block>::digits == CHAR_BIT * sizeof(Block);
+
+        if (no_padding && n * sizeof(Block) >= simd_threshold) {
+            static const scan_function f =
+                rscan_kernel_function<Op>(best_simd_level());
+            return f(object_representation(a), object_representation(b),
+                     n * sizeof(Block)) / sizeof(Block);
+        }
+
+        for (std::size_t i = n; i > 0; --i)
+            if (apply_bitwise<Op>(a[i - 1], b[i - 1]) != 0)
+                return i - 1;
+        return n;
+    }
+
+    // ------- lookup on block ranges -------------------------
+
+    // The lookups and comparisons of dynamic_bitset and
+    // dynamic_bitset_view, on the blocks at p which hold num_bits bits:
+    // the bits of the last block beyond num_bits are off. Positions not
+    // found are npos_bit.
+    //
+    const std::size_t npos_bit = static_cast<std::size_t>(-1);
+
+    template <typename Block>
+    inline std::size_t blocks_for_bits(std::size_t num_bits)
+    {
+        const std::size_t bits = std::numeric_limits<Block>::digits;
+        return num_bits / bits + (num_bits % bits != 0);
+    }
+
+    // the first bit on in the blocks from first_block
+    template <typename Block>
+    inline std::size_t find_from_block(const Block * p, std::size_t num_blocks,
+                                       std::size_t first_block)
+    {
+        if (first_block >= num_blocks)
+            return npos_bit;
+
+        // skip null blocks
+        const std::size_t i = first_block
+            + find_nonzero_block<op_id>(p + first_block, p + first_block,
+                                        num_blocks - first_block);
+        if (i >= num_blocks)
+            return npos_bit;
+
+        return i * std::numeric_limits<Block>::digits + boost::lowest_bit(p[i]);
+    }
+
+    template <typename Block>
+    inline std::size_t find_next_bit(const Block * p, std::size_t num_bits,
+                                     std::size_t pos)
+    {
+        const std::size_t bits = std::numeric_limits<Block>::digits;
+        if (pos >= (num_bits - 1) || num_bits == 0)
+            return npos_bit;
+
+        ++pos;
+
+        // shift bits upto one immediately after current
+        const std::size_t blk = pos / bits;
+        const Block fore = p[blk] >> (pos % bits);
+
+        return fore ? pos + boost::lowest_bit(fore)
+                    : find_from_block(p, blocks_for_bits<Block>(num_bits), blk + 1);
+    }
+
+    // the last bit on in the blocks before last_block
+    template <typename Block>
+    inline std::size_t find_before_block(const Block * p, std::size_t last_block)
+    {
+        // skip null blocks
+        const std::size_t i = find_last_nonzero_block<op_id>(p, p, last_block);
+        if (i == last_block)
+            return npos_bit;
+
+        return i * std::numeric_limits<Block>::digits + boost::highest_bit(p[i]);
+    }
+
+    // the last bit on before pos; if pos >= num_bits, the last one
+    template <typename Block>
+    inline std::size_t find_prev_bit(const Block * p, std::size_t num_bits,
+                                     std::size_t pos)
+    {
+        const std::size_t bits = std::numeric_limits<Block>::digits;
+
+        pos = (std::min)(pos, num_bits);
+        if (pos == 0)
+            return npos_bit;
+
+        --pos;
+
+        // keep the bits upto and including the one at pos
+        const std::size_t blk = pos / bits;
+        const Block all = static_cast<Block>(~Block(0));
+        const Block back = static_cast<Block>(p[blk] & (all >> (bits - 1 - pos % bits)));
+
+        return back ? blk * bits + boost::highest_bit(back)
+                    : find_before_block(p, blk);
+    }
+
+    // the first bit off in the blocks from first_block
+    template <typename Block>
+    inline std::size_t find_zero_from_block(const Block * p, std::size_t num_bits,
+                                            std::size_t first_block)
+    {
+        const std::size_t num_blocks = blocks_for_bits<Block>(num_bits);
+        if (first_block >= num_blocks)
+            return npos_bit;
+
+        // skip full blocks
+        const std::size_t i = first_block
+            + find_nonzero_block<op_not>(p + first_block, p + first_block,
+                                         num_blocks - first_block);
+        if (i >= num_blocks)
+            return npos_bit;
+
+        // the unused bits of the last block are off: don't report them
+        const std::size_t pos = i * std::numeric_limits<Block>::digits
+                              + boost::lowest_bit(static_cast<Block>(~p[i]));
+        return pos < num_bits ? pos : npos_bit;
+    }
+
+    template <typename Block>
+    inline std::size_t find_next_zero_bit(const Block * p, std::size_t num_bits,
+                                          std::size_t pos)
+    {
+        const std::size_t bits = std::numeric_limits<Block>::digits;
+        if (pos >= (num_bits - 1) || num_bits == 0)
+            return npos_bit;
+
+        ++pos;
+
+        // shift bits upto one immediately after current
+        const std::size_t blk = pos / bits;
+        const Block fore = static_cast<Block>(~p[blk]) >> (pos % bits);
+
+        if (!fore)
+            return find_zero_from_block(p, num_bits, blk + 1);
+
+        const std::size_t next = pos + boost::lowest_bit(fore);
+        return next < num_bits ? next : npos_bit;
+    }
+
+    // the bits of a are a subset of those of b
+    template <typename Block>
+    inline bool is_subset_blocks(const Block * a, const Block * b, std::size_t n)
+    {
+        return find_nonzero_block<op_sub>(a, b, n) == n;
+    }
+
+    template <typename Block>
+    inline bool is_proper_subset_blocks(const Block * a, const Block * b, std::size_t n)
+    {
+        return is_subset_blocks(a, b, n) && find_nonzero_block<op_rsub>(a, b, n) != n;
+    }
+
+    template <typename Block>
+    inline bool equal_blocks(const Block * a, const Block * b, std::size_t n)
+    {
+        return find_nonzero_block<op_xor>(a, b, n) == n;
+    }
+
+    // a < b as unsigned numbers, the last block being the most significant
+    template <typename Block>
+    inline bool less_blocks(const Block * a, const Block * b, std::size_t n)
+    {
+        const std::size_t i = find_last_nonzero_block<op_xor>(a, b, n);
+        return i != n && a[i] < b[i];
+    }
+
+    // the lowest and the highest bits which differ in a and b, or npos_bit
+    template <typename Block>
+    inline std::size_t find_first_difference_blocks(const Block * a, const Block * b,
+                                                    std::size_t n)
+    {
+        const std::size_t i = find_nonzero_block<op_xor>(a, b, n);
+        if (i == n)
+            return npos_bit;
+        return i * std::numeric_limits<Block>::digits
+             + boost::lowest_bit(static_cast<Block>(a[i] ^ b[i]));
+    }
+
+    template <typename Block>
+    inline std::size_t find_last_difference_blocks(const Block * a, const Block * b,
+                                                   std::size_t n)
+    {
+        const std::size_t i = find_last_nonzero_block<op_xor>(a, b, n);
+        if (i == n)
+            return npos_bit;
+        return i * std::numeric_limits<Block>::digits
+             + boost::highest_bit(static_cast<Block>(a[i] ^ b[i]));
+    }
+
+    // ------- decode kernels ---------------------------------
+
+    // Write base + i for each set bit i of the n bytes at p, in increasing
+    // order, and return the end of the output. Bit j of byte k is bit
+    // 8 * k + j, as on x86 (the only users of these kernels).
+    //
+    // The vector kernels store a whole vector of indices per byte (AVX2)
+    // or per 16 bits (AVX-512), and advance by the number of set bits: a
+    // 64-bit word may then write up to decode_slack values. Near out_end
+    // they fall back to one index per step.
+    //
+    typedef boost::uint32_t * (*decode_function)(const byte_type *, std::size_t,
+                                                 boost::uint32_t, boost::uint32_t *,
+                                                 boost::uint32_t *);
+
+    const std::size_t decode_slack = 64;
+
+    inline boost::uint32_t * decode_word64(boost::uint64_t w, boost::uint32_t base,
+                                           boost::uint32_t * out)
+    {
+        for ( ; w != 0; w &= w - 1)
+            *out++ = base + static_cast<boost::uint32_t>(boost::lowest_bit(w));
+        return out;
+    }
+
+    inline boost::uint32_t * decode_word_kernel(const byte_type * p, std::size_t n,
+                                                boost::uint32_t base,
+                                                boost::uint32_t * out, boost::uint32_t *)
+    {
+        std::size_t i = 0;
+        for ( ; i + 8 <= n; i += 8)
+            out = decode_word64(load_word64(p + i),
+                                base + static_cast<boost::uint32_t>(8 * i), out);
+        for ( ; i < n; ++i)
+            out = decode_word64(p[i], base + static_cast<boost::uint32_t>(8 * i), out);
+        return out;
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+
+    // for each byte value, the positions of its set bits, one per byte
+    // and in increasing order, padded with zeros
+    struct decode_table
+    {
+        boost::uint64_t entries[256];
+
+        decode_table()
+        {
+            for (unsigned v = 0; v < 256; ++v) {
+                boost::uint64_t e = 0;
+                unsigned k = 0;
+                for (unsigned j = 0; j < 8; ++j)
+                    if (v & (1u << j))
+                        e |= static_cast<boost::uint64_t>(j) << (8 * k++);
+                entries[v] = e;
+            }
+        }
+
+        static const decode_table & get()
+        {
+            static const decode_table table;
+            return table;
+        }
+    };
+
+    // eight indices per byte: the table entry, widened to 32 bits
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline boost::uint32_t * decode_avx2_kernel(const byte_type * p, std::size_t n,
+                                                boost::uint32_t base,
+                                                boost::uint32_t * out, boost::uint32_t * out_end)
+    {
+        const boost::uint64_t * const table = decode_table::get().entries;
+        const __m256i eight = _mm256_set1_epi32(8);
+        std::size_t i = 0;
+        for ( ; i + 8 <= n; i += 8) {
+            boost::uint64_t w = load_word64(p + i);
+            const boost::uint32_t b = base + static_cast<boost::uint32_t>(8 * i);
+            if (w == 0)
+                continue;
+            if (static_cast<std::size_t>(out_end - out) < decode_slack) {
+                out = decode_word64(w, b, out);
+                continue;
+            }
+            __m256i vb = _mm256_set1_epi32(static_cast<int>(b));
+            for ( ; w != 0; w >>= 8) {
+                const unsigned v = static_cast<unsigned>(w & 0xff);
+                const __m256i pos = _mm256_cvtepu8_epi32(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i *>(table + v)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out),
+                                    _mm256_add_epi32(vb, pos));
+                out += count_table<>::table[v];
+                vb = _mm256_add_epi32(vb, eight);
+            }
+        }
+        return decode_word_kernel(p + i, n - i, base + static_cast<boost::uint32_t>(8 * i),
+                                  out, out_end);
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+    // sixteen indices per 16 bits, packed by vpcompressd
+    BOOST_DYNAMIC_BITSET_TARGET("avx512f")
+    inline boost::uint32_t * decode_avx512_kernel(const byte_type * p, std::size_t n,
+                                                  boost::uint32_t base,
+                                                  boost::uint32_t * out, boost::uint32_t * out_end)
+    {
+        const __m512i iota = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                               8, 9, 10, 11, 12, 13, 14, 15);
+        const __m512i sixteen = _mm512_set1_epi32(16);
+        std::size_t i = 0;
+        for ( ; i + 8 <= n; i += 8) {
+            boost::uint64_t w = load_word64(p + i);
+            const boost::uint32_t b = base + static_cast<boost::uint32_t>(8 * i);
+            if (w == 0)
+                continue;
+            if (static_cast<std::size_t>(out_end - out) < decode_slack) {
+                out = decode_word64(w, b, out);
+                continue;
+            }
+            __m512i vb = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(b)), iota);
+            for ( ; w != 0; w >>= 16) {
+                const __mmask16 m = static_cast<__mmask16>(w & 0xffff);
+                _mm512_storeu_si512(out, _mm512_maskz_compress_epi32(m, vb));
+                out += popcount_word64(m);
+                vb = _mm512_add_epi32(vb, sixteen);
+            }
+        }
+        return decode_word_kernel(p + i, n - i, base + static_cast<boost::uint32_t>(8 * i),
+                                  out, out_end);
+    }
+#endif
+
+#endif // BOOST_DYNAMIC_BITSET_X86_SIMD
+
+    // PRE: simd_level_available(l); there is no SSE2 flavor
+    inline decode_function decode_kernel_function(simd_level l)
+    {
+        switch (l) {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        case simd_avx2:
+            return &decode_avx2_kernel;
+# if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+        case simd_avx512:
+            return &decode_avx512_kernel;
+# endif
+#endif
+        default:
+            return &decode_word_kernel;
+        }
+    }
+
+    // the positions of the set bits of [p, p + n), in increasing order;
+    // returns the end of the output
+    // PRE: out_end - out is the number of set bits, and the positions
+    // are less than 2^32
+    //
+    template <typename Block>
+    inline boost::uint32_t * decode_blocks(const Block * p, std::size_t n,
+                                           boost::uint32_t * out,
+                                           boost::uint32_t * out_end)
+    {
+        const int bits_per_block = std::numeric_limits<Block>::digits;
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        const bool no_padding = bits_per_block == CHAR_BIT * sizeof(Block);
+
+        if (no_padding && n * sizeof(Block) >= simd_threshold) {
+            static const decode_function f = decode_kernel_function(best_simd_level());
+            return f(object_representation(p), n * sizeof(Block), 0, out, out_end);
+        }
+#endif
+        (void)out_end;
+
+        for (std::size_t i = 0; i < n; ++i)
+            for (Block x = p[i]; x != 0; x = static_cast<Block>(x & (x - 1)))
+                *out++ = static_cast<boost::uint32_t>(i * bits_per_block + boost::lowest_bit(x));
+        return out;
+    }
+
+    // ------- parse kernels ----------------------------------
+
+    // The bits of a string of '0' and '1' characters whose last character
+    // is bit 0: out[k], for k < n, gets the 64 characters which end
+    // 64 * k characters before last, the character just before that
+    // end in bit 0. Returns false if one of the characters is neither
+    // '0' nor '1', in which case out is unspecified.
+    //
+    // A character is valid iff it is '0' or '1' with its low bit
+    // cleared, i.e. iff (c & 0xfe) == 0x30; its value is then c & 1.
+    //
+    typedef bool (*parse_function)(const char *, std::size_t, boost::uint64_t *);
+
+    // the 64 bits of x in reverse order
+    inline boost::uint64_t reverse_word64(boost::uint64_t x)
+    {
+        x = ((x >> 1) & UINT64_C(0x5555555555555555)) | ((x & UINT64_C(0x5555555555555555)) << 1);
+        x = ((x >> 2) & UINT64_C(0x3333333333333333)) | ((x & UINT64_C(0x3333333333333333)) << 2);
+        x = ((x >> 4) & UINT64_C(0x0f0f0f0f0f0f0f0f)) | ((x & UINT64_C(0x0f0f0f0f0f0f0f0f)) << 4);
+        x = ((x >> 8) & UINT64_C(0x00ff00ff00ff00ff)) | ((x & UINT64_C(0x00ff00ff00ff00ff)) << 8);
+        x = ((x >> 16) & UINT64_C(0x0000ffff0000ffff)) | ((x & UINT64_C(0x0000ffff0000ffff)) << 16);
+        return (x >> 32) | (x << 32);
+    }
+
+    // eight characters, the first one in the low byte
+    inline boost::uint64_t load_chars64(const char * p)
+    {
+        const boost::uint64_t w = load_word64(reinterpret_cast<const byte_type *>(p));
+#if BOOST_ENDIAN_BIG_BYTE
+        boost::uint64_t r = 0;
+        for (int k = 0; k < 8; ++k)
+            r |= ((w >> (8 * k)) & 0xff) << (8 * (7 - k));
+        return r;
+#else
+        return w;
+#endif
+    }
+
+    // eight characters at a time: the multiplication gathers the low bit
+    // of byte k into bit 63 - k
+    inline bool parse_word_kernel(const char * last, std::size_t n,
+                                  boost::uint64_t * out)
+    {
+        const boost::uint64_t mask  = UINT64_C(0xfefefefefefefefe);
+        const boost::uint64_t zeros = UINT64_C(0x3030303030303030);
+        const boost::uint64_t lows  = UINT64_C(0x0101010101010101);
+        boost::uint64_t bad = 0;
+        for (std::size_t k = 0; k < n; ++k) {
+            const char * const p = last - 64 * (k + 1);
+            boost::uint64_t w = 0;
+            for (int g = 0; g < 8; ++g) {
+                const boost::uint64_t x = load_chars64(p + 8 * g);
+                bad |= (x & mask) ^ zeros;
+                w |= (((x & lows) * UINT64_C(0x8040201008040201)) >> 56) << (8 * (7 - g));
+            }
+            out[k] = w;
+        }
+        return bad == 0;
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+
+    // the compare masks are in character order, and reversed at the end
+    BOOST_DYNAMIC_BITSET_TARGET("sse2")
+    inline bool parse_sse2_kernel(const char * last, std::size_t n,
+                                  boost::uint64_t * out)
+    {
+        const __m128i mask  = _mm_set1_epi8(static_cast<char>(0xfe));
+        const __m128i zeros = _mm_set1_epi8('0');
+        const __m128i ones  = _mm_set1_epi8('1');
+        __m128i bad = _mm_setzero_si128();
+        for (std::size_t k = 0; k < n; ++k) {
+            const __m128i * const p = reinterpret_cast<const __m128i *>(last - 64 * (k + 1));
+            boost::uint64_t m = 0;
+            for (int i = 0; i < 4; ++i) {
+                const __m128i v = _mm_loadu_si128(p + i);
+                bad = _mm_or_si128(bad, _mm_xor_si128(_mm_and_si128(v, mask), zeros));
+                m |= static_cast<boost::uint64_t>(
+                         static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, ones))))
+                     << (16 * i);
+            }
+            out[k] = reverse_word64(m);
+        }
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(bad, _mm_setzero_si128())) == 0xffff;
+    }
+
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline bool parse_avx2_kernel(const char * last, std::size_t n,
+                                  boost::uint64_t * out)
+    {
+        const __m256i mask  = _mm256_set1_epi8(static_cast<char>(0xfe));
+        const __m256i zeros = _mm256_set1_epi8('0');
+        const __m256i ones  = _mm256_set1_epi8('1');
+        __m256i bad = _mm256_setzero_si256();
+        for (std::size_t k = 0; k < n; ++k) {
+            const __m256i * const p = reinterpret_cast<const __m256i *>(last - 64 * (k + 1));
+            const __m256i lo = _mm256_loadu_si256(p);
+            const __m256i hi = _mm256_loadu_si256(p + 1);
+            bad = _mm256_or_si256(bad, _mm256_or_si256(
+                      _mm256_xor_si256(_mm256_and_si256(lo, mask), zeros),
+                      _mm256_xor_si256(_mm256_and_si256(hi, mask), zeros)));
+            const boost::uint64_t m =
+                  static_cast<boost::uint64_t>(static_cast<boost::uint32_t>(
+                      _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, ones))))
+                | static_cast<boost::uint64_t>(static_cast<boost::uint32_t>(
+                      _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, ones)))) << 32;
+            out[k] = reverse_word64(m);
+        }
+        return _mm256_testz_si256(bad, bad) != 0;
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+    BOOST_DYNAMIC_BITSET_TARGET("avx512f,avx512bw")
+    inline bool parse_avx512_kernel(const char * last, std::size_t n,
+                                    boost::uint64_t * out)
+    {
+        const __m512i mask  = _mm512_set1_epi8(static_cast<char>(0xfe));
+        const __m512i zeros = _mm512_set1_epi8('0');
+        const __m512i ones  = _mm512_set1_epi8('1');
+        __m512i bad = _mm512_setzero_si512();
+        for (std::size_t k = 0; k < n; ++k) {
+            const __m512i v = _mm512_loadu_si512(last - 64 * (k + 1));
+            bad = _mm512_or_si512(bad, _mm512_xor_si512(_mm512_and_si512(v, mask), zeros));
+            out[k] = reverse_word64(_mm512_cmpeq_epi8_mask(v, ones));
+        }
+        return _mm512_test_epi64_mask(bad, bad) == 0;
+    }
+#endif
+
+#endif // BOOST_DYNAMIC_BITSET_X86_SIMD
+
+    // PRE: simd_level_available(l)
+    inline parse_function parse_kernel_function(simd_level l)
+    {
+        switch (l) {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        case simd_sse2:
+            return &parse_sse2_kernel;
+        case simd_avx2:
+            return &parse_avx2_kernel;
+# if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+        case simd_avx512:
+            return &parse_avx512_kernel;
+# endif
+#endif
+        default:
+            return &parse_word_kernel;
+        }
+    }
+
+    // Sets bit i of the blocks at out, for i < n, if the character
+    // first[n - 1 - i] is '1'. Returns false, with out unspecified, if one
+    // of the characters is neither '0' nor '1'.
+    // PRE: the blocks_for_bits<Block>(n) blocks at out are zero
+    //
+    template <typename Block>
+    inline bool parse_bit_chars(const char * first, std::size_t n, Block * out)
+    {
+        const int bits_per_block = std::numeric_limits<Block>::digits;
+        const char * const last = first + n;
+        std::size_t i = 0;
+
+        // whole 64-bit words, a batch at a time, then spread to the blocks
+        if (64 % bits_per_block == 0 && n >= simd_threshold) {
+            static const parse_function f = parse_kernel_function(best_simd_level());
+            const int per_word = 64 / bits_per_block;
+            const std::size_t num_words = n / 64;
+            boost::uint64_t buf[64];
+            for (std::size_t k = 0; k < num_words; ) {
+                const std::size_t m = (std::min)(num_words - k, std::size_t(64));
+                if (!f(last - 64 * k, m, buf))
+                    return false;
+                for (std::size_t j = 0; j < m; ++j)
+                    for (int q = 0; q < per_word; ++q)
+                        out[(k + j) * per_word + q] =
+                            static_cast<Block>(buf[j] >> (q * bits_per_block));
+                k += m;
+            }
+            i = 64 * num_words;
+        }
+
+        for ( ; i < n; ++i) {
+            const char c = last[-1 - static_cast<std::ptrdiff_t>(i)];
+            if ((c & ~1) != '0')
+                return false;
+            if (c & 1)
+                out[i / bits_per_block] |= static_cast<Block>(Block(1) << (i % bits_per_block));
+        }
+        return true;
+    }
+
+    // Parses [first, first + 64 * n) in stream order, 64 characters at a
+    // time: out[k] gets the characters [64 * k, 64 * k + 64), the last of
+    // them in bit 0. Stops before the first group which is not all '0'
+    // and '1', and returns the number of groups stored.
+    //
+    inline std::size_t parse_bit_words(const char * first, std::size_t n,
+                                       boost::uint64_t * out)
+    {
+        static const parse_function f = parse_kernel_function(best_simd_level());
+        boost::uint64_t buf[64];
+        std::size_t k = 0;
+        while (k < n) {
+            const std::size_t m = (std::min)(n - k, std::size_t(64));
+            if (!f(first + 64 * (k + m), m, buf)) {
+                while (k < n && f(first + 64 * (k + 1), 1, out + k))
+                    ++k;
+                return k;
+            }
+            for (std::size_t j = 0; j < m; ++j)
+                out[k + j] = buf[m - 1 - j];
+            k += m;
+        }
+        return n;
+    }
+
+    // ------- format kernels ---------------------------------
+
+    // The inverse of the parse kernels: for k < n, the 64 characters
+    // which end 64 * k characters before last get the bits of w[k], bit
+    // 0 in the character just before that end, as '0' and '1'.
+    //
+    typedef void (*format_function)(const boost::uint64_t *, std::size_t, char *);
+
+    // eight characters, the first one from the low byte
+    inline void store_chars64(char * p, boost::uint64_t x)
+    {
+#if BOOST_ENDIAN_BIG_BYTE
+        boost::uint64_t r = 0;
+        for (int k = 0; k < 8; ++k)
+            r |= ((x >> (8 * k)) & 0xff) << (8 * (7 - k));
+        x = r;
+#endif
+        std::memcpy(p, &x, sizeof x);
+    }
+
+    // eight characters at a time: byte k of the multiplied value keeps
+    // bit 7 - k of the byte being spread, which the addition moves to
+    // bit 7 of byte k
+    inline void format_word_kernel(const boost::uint64_t * w, std::size_t n,
+                                   char * last)
+    {
+        const boost::uint64_t bits  = UINT64_C(0x0102040810204080);
+        const boost::uint64_t lows  = UINT64_C(0x0101010101010101);
+        const boost::uint64_t zeros = UINT64_C(0x3030303030303030);
+        for (std::size_t k = 0; k < n; ++k) {
+            char * const p = last - 64 * (k + 1);
+            for (int g = 0; g < 8; ++g) {
+                const boost::uint64_t x = ((w[k] >> (8 * (7 - g))) & 0xff) * lows & bits;
+                store_chars64(p + 8 * g,
+                    (((x + UINT64_C(0x7f7f7f7f7f7f7f7f)) >> 7) & lows) + zeros);
+            }
+        }
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+
+    // The words are reversed first, so that bit i goes to character i:
+    // each byte of the mask is spread over eight bytes, which are tested
+    // against their own bit and turned into '0' or '1'.
+    BOOST_DYNAMIC_BITSET_TARGET("sse2")
+    inline void format_sse2_kernel(const boost::uint64_t * w, std::size_t n,
+                                   char * last)
+    {
+        const __m128i bits  = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                            1, 2, 4, 8, 16, 32, 64, -128);
+        const __m128i zeros = _mm_set1_epi8('0');
+        for (std::size_t k = 0; k < n; ++k) {
+            __m128i * const p = reinterpret_cast<__m128i *>(last - 64 * (k + 1));
+            const boost::uint64_t m = reverse_word64(w[k]);
+            for (int i = 0; i < 4; ++i) {
+                __m128i v = _mm_cvtsi32_si128(static_cast<int>((m >> (16 * i)) & 0xffff));
+                v = _mm_unpacklo_epi8(v, v);
+                v = _mm_unpacklo_epi16(v, v);
+                v = _mm_unpacklo_epi32(v, v);
+                const __m128i set = _mm_cmpeq_epi8(_mm_and_si128(v, bits), bits);
+                _mm_storeu_si128(p + i, _mm_sub_epi8(zeros, set));
+            }
+        }
+    }
+
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline void format_avx2_kernel(const boost::uint64_t * w, std::size_t n,
+                                   char * last)
+    {
+        const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0,
+                                                1, 1, 1, 1, 1, 1, 1, 1,
+                                                2, 2, 2, 2, 2, 2, 2, 2,
+                                                3, 3, 3, 3, 3, 3, 3, 3);
+        const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                              1, 2, 4, 8, 16, 32, 64, -128,
+                                              1, 2, 4, 8, 16, 32, 64, -128,
+                                              1, 2, 4, 8, 16, 32, 64, -128);
+        const __m256i zeros = _mm256_set1_epi8('0');
+        for (std::size_t k = 0; k < n; ++k) {
+            __m256i * const p = reinterpret_cast<__m256i *>(last - 64 * (k + 1));
+            const boost::uint64_t m = reverse_word64(w[k]);
+            for (int i = 0; i < 2; ++i) {
+                const __m256i v = _mm256_shuffle_epi8(
+                    _mm256_set1_epi32(static_cast<int>(m >> (32 * i))), spread);
+                const __m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(v, bits), bits);
+                _mm256_storeu_si256(p + i, _mm256_sub_epi8(zeros, set));
+            }
+        }
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+    BOOST_DYNAMIC_BITSET_TARGET("avx512f,avx512bw")
+    inline void format_avx512_kernel(const boost::uint64_t * w, std::size_t n,
+                                     char * last)
+    {
+        const __m512i zeros = _mm512_set1_epi8('0');
+        const __m512i ones  = _mm512_set1_epi8('1');
+        for (std::size_t k = 0; k < n; ++k)
+            _mm512_storeu_si512(last - 64 * (k + 1),
+                                _mm512_mask_blend_epi8(reverse_word64(w[k]), zeros, ones));
+    }
+#endif
+
+#endif // BOOST_DYNAMIC_BITSET_X86_SIMD
+
+    // PRE: simd_level_available(l)
+    inline format_function format_kernel_function(simd_level l)
+    {
+        switch (l) {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        case simd_sse2:
+            return &format_sse2_kernel;
+        case simd_avx2:
+            return &format_avx2_kernel;
+# if defined(BOOST_DYNAMIC_BITSET_X86_AVX512)
+        case simd_avx512:
+            return &format_avx512_kernel;
+# endif
+#endif
+        default:
+            return &format_word_kernel;
+        }
+    }
+
+    // bits [64 * t, 64 * t + 64) of the num_blocks blocks at p, zero
+    // beyond them
+    template <typename Block>
+    inline boost::uint64_t load_bits64(const Block * p, std::size_t num_blocks,
+                                       std::size_t t)
+    {
+        const int bits_per_block = std::numeric_limits<Block>::digits;
+        boost::uint64_t w = 0;
+        if (64 % bits_per_block == 0) {
+            const std::size_t per_word = 64 / bits_per_block;
+            for (std::size_t q = 0; q < per_word && t * per_word + q < num_blocks; ++q)
+                w |= static_cast<boost::uint64_t>(p[t * per_word + q]) << (q * bits_per_block);
+        }
+        else {
+            for (std::size_t j = 0; j < 64; ++j) {
+                const std::size_t i = 64 * t + j;
+                if (i / bits_per_block < num_blocks
+                    && ((p[i / bits_per_block] >> (i % bits_per_block)) & 1))
+                    w |= boost::uint64_t(1) << j;
+            }
+        }
+        return w;
+    }
+
+    // sets the bits [64 * t, 64 * t + 64) of the num_blocks blocks at p
+    // to w, as far as the blocks go
+    template <typename Block>
+    inline void store_bits64(Block * p, std::size_t num_blocks, std::size_t t,
+                             boost::uint64_t w)
+    {
+        const int bits_per_block = std::numeric_limits<Block>::digits;
+        if (64 % bits_per_block == 0) {
+            const std::size_t per_word = 64 / bits_per_block;
+            for (std::size_t q = 0; q < per_word && t * per_word + q < num_blocks; ++q)
+                p[t * per_word + q] = static_cast<Block>(w >> (q * bits_per_block));
+        }
+        else {
+            for (std::size_t j = 0; j < 64; ++j) {
+                const std::size_t i = 64 * t + j;
+                if (i / bits_per_block >= num_blocks)
+                    break;
+                const Block mask = static_cast<Block>(Block(1) << (i % bits_per_block));
+                if ((w >> j) & 1)
+                    p[i / bits_per_block] |= mask;
+                else
+                    p[i / bits_per_block] &= static_cast<Block>(~mask);
+            }
+        }
+    }
+
+    // in characters, the size of the buffers of the callers of
+    // format_bit_chars(); a multiple of 64
+    const std::size_t bit_chars_chunk = 4096;
+
+    // Writes the bits [64 * t, 64 * t + n) of the num_blocks blocks at p
+    // as '0' and '1' to out, the most significant first: out[i] gets bit
+    // 64 * t + n - 1 - i.
+    //
+    template <typename Block>
+    inline void format_bit_chars(const Block * p, std::size_t num_blocks,
+                                 std::size_t t, std::size_t n, char * out)
+    {
+        static const format_function f = format_kernel_function(best_simd_level());
+        char * const last = out + n;
+        const std::size_t num_words = n / 64;
+
+        boost::uint64_t buf[64];
+        for (std::size_t k = 0; k < num_words; ) {
+            const std::size_t m = (std::min)(num_words - k, std::size_t(64));
+            for (std::size_t j = 0; j < m; ++j)
+                buf[j] = load_bits64(p, num_blocks, t + k + j);
+            f(buf, m, last - 64 * k);
+            k += m;
+        }
+
+        const std::size_t rest = n % 64;
+        if (rest != 0) {
+            const boost::uint64_t w = load_bits64(p, num_blocks, t + num_words);
+            for (std::size_t i = 0; i < rest; ++i)
+                out[i] = ((w >> (rest - 1 - i)) & 1) ? '1' : '0';
+        }
+    }
+
+    // the n digits as zero and one: digits itself when they are '0'
+    // and '1', out otherwise
+    template <typename Ch>
+    inline const Ch * widen_bit_chars(const char * digits, std::size_t n,
+                                      Ch * out, Ch zero, Ch one)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = digits[i] == '1' ? one : zero;
+        return out;
+    }
+
+    inline const char * widen_bit_chars(const char * digits, std::size_t n,
+                                        char * out, char zero, char one)
+    {
+        if (zero == '0' && one == '1')
+            return digits;
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = digits[i] == '1' ? one : zero;
+        return out;
+    }
+
+    // ------- hashing ----------------------------------------
+
+    // A hash in the manner of wyhash over the bits as 64-bit words, w[k]
+    // holding the bits [64 k, 64 k + 64): it is the same whatever the
+    // block type. Stripes of 8 words go through 4 independent lanes,
+    // each step a 64 x 64 -> 128-bit product folded to 64 bits; the
+    // last num_words % 8 words and the number of bits are mixed in by
+    // finish(). SIMD units have no wide enough multiplication, the
+    // lanes keep the multipliers of the core busy instead.
+
+    inline boost::uint64_t hash_mum(boost::uint64_t a, boost::uint64_t b)
+    {
+#if defined(BOOST_HAS_INT128)
+        const boost::uint128_type r = static_cast<boost::uint128_type>(a) * b;
+        return static_cast<boost::uint64_t>(r) ^ static_cast<boost::uint64_t>(r >> 64);
+#else
+        const boost::uint64_t mask = UINT64_C(0xffffffff);
+        const boost::uint64_t ll = (a & mask) * (b & mask);
+        const boost::uint64_t lh = (a & mask) * (b >> 32);
+        const boost::uint64_t hl = (a >> 32) * (b & mask);
+        const boost::uint64_t hh = (a >> 32) * (b >> 32);
+        const boost::uint64_t mid = (ll >> 32) + (lh & mask) + (hl & mask);
+        const boost::uint64_t lo = (ll & mask) | (mid << 32);
+        const boost::uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+        return lo ^ hi;
+#endif
+    }
+
+    const boost::uint64_t hash_secret[4] = {
+        UINT64_C(0xa0761d6478bd642f), UINT64_C(0xe7037ed1a0b428db),
+        UINT64_C(0x8ebc6af09c88c6e3), UINT64_C(0x589965cc75374cc3)
+    };
+
+    const std::size_t hash_stripe_words = 8;
+
+    struct hash_state
+    {
+        boost::uint64_t lanes[4];
+
+        // not hash_secret[j], which stripe() combines with the other
+        // word: the product would be symmetric in the two words
+        hash_state()
+        {
+            for (int j = 0; j < 4; ++j)
+                lanes[j] = hash_secret[(j + 1) % 4];
+        }
+
+        void stripe(const boost::uint64_t * w)
+        {
+            for (int j = 0; j < 4; ++j)
+                lanes[j] = hash_mum(w[2 * j] ^ hash_secret[j], w[2 * j + 1] ^ lanes[j]);
+        }
+
+        // PRE: n < hash_stripe_words
+        boost::uint64_t finish(const boost::uint64_t * tail, std::size_t n,
+                               boost::uint64_t num_bits) const
+        {
+            boost::uint64_t t[hash_stripe_words] = { 0 };
+            std::copy(tail, tail + n, t);
+            boost::uint64_t r = num_bits ^ hash_secret[0];
+            for (int j = 0; j < 4; ++j)
+                r = hash_mum(t[2 * j] ^ lanes[j], t[2 * j + 1] ^ hash_secret[j] ^ r);
+            return hash_mum(r ^ hash_secret[1], num_bits ^ hash_secret[2]);
+        }
+    };
+
+    // the hash of the first num_bits bits of the num_blocks blocks at p
+    template <typename Block>
+    boost::uint64_t hash_bits(const Block * p, std::size_t num_blocks, std::size_t num_bits)
+    {
+        const std::size_t num_words = (num_bits + 63) / 64;
+        const std::size_t num_stripes = num_words / hash_stripe_words;
+        const std::size_t stripe_bytes = 8 * hash_stripe_words;
+
+        // on little endian hosts the blocks are the bytes of the words,
+        // whatever their size
+        std::size_t direct = 0;
+#if !BOOST_ENDIAN_BIG_BYTE
+        const bool no_padding =
+            std::numeric_limits<Block>::digits == CHAR_BIT * sizeof(Block);
+        if (no_padding)
+            direct = (std::min)(num_stripes, num_blocks * sizeof(Block) / stripe_bytes);
+#endif
+
+        hash_state h;
+        boost::uint64_t w[hash_stripe_words];
+        const byte_type * const bytes = reinterpret_cast<const byte_type *>(p);
+        for (std::size_t s = 0; s < direct; ++s) {
+            for (std::size_t k = 0; k < hash_stripe_words; ++k)
+                w[k] = load_word64(bytes + stripe_bytes * s + 8 * k);
+            h.stripe(w);
+        }
+        for (std::size_t s = direct; s < num_stripes; ++s) {
+            for (std::size_t k = 0; k < hash_stripe_words; ++k)
+                w[k] = load_bits64(p, num_blocks, hash_stripe_words * s + k);
+            h.stripe(w);
+        }
+
+        const std::size_t rest = num_words % hash_stripe_words;
+        for (std::size_t k = 0; k < rest; ++k)
+            w[k] = load_bits64(p, num_blocks, hash_stripe_words * num_stripes + k);
+        return h.finish(w, rest, num_bits);
+    }
+
+  } // dynamic_bitset_impl
+  } // namespace detail
+
+} // namespace boost
+
+#endif // include guard
@@ -0,0 +1,497 @@
+// -----------------------------------------------------------
+// binary_format.hpp
+//
+//       A versioned binary format for dynamic_bitset: stream
+//       functions, and a loader which maps files in memory
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DYNAMIC_BITSET_BINARY_FORMAT_HPP
+#define BOOST_DYNAMIC_BITSET_BINARY_FORMAT_HPP
+
+#include <assert.h>
+#include <climits>      // for CHAR_BIT
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "boost/config.hpp"
+#include "boost/cstdint.hpp"
+#include "boost/limits.hpp"
+#include "boost/static_assert.hpp"
+#include "boost/predef/other/endian.h"
+#include "boost/dynamic_bitset/dynamic_bitset.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset_view.hpp"
+
+#if defined(BOOST_HAS_UNISTD_H)
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
+
+// The format (version 1). All the header fields are little endian:
+//
+//   offset  size
+//        0     8   magic, "BDYNBSET"
+//        8     2   version, 1
+//       10     1   bytes per block of the writer: 1, 2, 4 or 8
+//       11     1   byte order of the blocks: 0 little, 1 big endian
+//       12     4   header size, 64: the offset of the blocks
+//       16     8   number of bits
+//       24     8   number of blocks, enough for the bits
+//       32     8   checksum of the blocks
+//       40    24   reserved, 0
+//
+// then the blocks as stored in the memory of the writer (bit i is bit
+// i % bits_per_block of block i / bits_per_block, the bits beyond the
+// number of bits are 0), and zeros up to a multiple of 64 bytes. The
+// blocks start and end on 64-byte boundaries, so that they can be used
+// in place when mapped in memory.
+//
+// The checksum reads the blocks, followed by zeros up to a multiple of
+// 32 bytes, as little endian 64-bit words w[0], w[1]... in four lanes:
+// lane j starts at j + 1 and takes h = rotl(h ^ w[4i + j], 31) * K
+// with K = 0x9e3779b97f4a7c15; then, from r = 0, r = (r ^ h[j]) * K for
+// each lane, and the checksum is r ^ (r >> 32).
+//
+// Readers with other block sizes or byte orders convert: with little
+// endian blocks, the blocks are the bytes of the bitset in increasing
+// order, whatever their size.
+
+namespace boost {
+
+  namespace detail {
+  namespace dynamic_bitset_impl {
+
+    const std::size_t binary_header_size = 64;
+    const std::size_t binary_alignment = 64;
+    const char binary_magic[8] = { 'B', 'D', 'Y', 'N', 'B', 'S', 'E', 'T' };
+    const unsigned binary_version = 1;
+
+    const bool host_big_endian = BOOST_ENDIAN_BIG_BYTE != 0;
+
+    inline void store_le(unsigned char * p, boost::uint64_t x, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i)
+            p[i] = static_cast<unsigned char>(x >> (8 * i));
+    }
+
+    inline boost::uint64_t load_le(const unsigned char * p, int bytes)
+    {
+        boost::uint64_t x = 0;
+        for (int i = bytes; i > 0; --i)
+            x = (x << 8) | p[i - 1];
+        return x;
+    }
+
+    inline boost::uint64_t load_le64(const unsigned char * p)
+    {
+        if (host_big_endian)
+            return load_le(p, 8);
+
+        boost::uint64_t w;
+        std::memcpy(&w, p, sizeof w);
+        return w;
+    }
+
+    // the checksum of total bytes, the first n at p and zeros
+    // PRE: n <= total
+    inline boost::uint64_t binary_checksum(const unsigned char * p, std::size_t n,
+                                           std::size_t total)
+    {
+        const boost::uint64_t k = 0x9e3779b97f4a7c15ull;
+        boost::uint64_t h[4] = { 1, 2, 3, 4 };
+
+        unsigned char tail[32];
+        for (std::size_t i = 0; i < total; i += 32) {
+            const unsigned char * q = p + i;
+            if (n < i + 32) {
+                std::memset(tail, 0, sizeof tail);
+                if (i < n)
+                    std::memcpy(tail, q, n - i);
+                q = tail;
+            }
+            for (int j = 0; j < 4; ++j) {
+                const boost::uint64_t x = h[j] ^ load_le64(q + 8 * j);
+                h[j] = ((x << 31) | (x >> 33)) * k;
+            }
+        }
+
+        boost::uint64_t r = 0;
+        for (int j = 0; j < 4; ++j)
+            r = (r ^ h[j]) * k;
+        return r ^ (r >> 32);
+    }
+
+    struct binary_header
+    {
+        boost::uint64_t num_bits;
+        boost::uint64_t num_blocks;
+        unsigned block_bytes;
+        bool big_endian;
+        boost::uint64_t checksum;
+
+        // the byte size of the blocks, and with the padding
+        std::size_t payload() const { return static_cast<std::size_t>(num_blocks * block_bytes); }
+        std::size_t padded_payload() const
+        {
+            return (payload() + binary_alignment - 1) / binary_alignment * binary_alignment;
+        }
+    };
+
+    inline void binary_invalid()
+    {
+        throw std::invalid_argument("boost::read_binary: invalid data");
+    }
+
+    inline void write_binary_header(unsigned char * p, const binary_header & h)
+    {
+        std::memset(p, 0, binary_header_size);
+        std::memcpy(p, binary_magic, sizeof binary_magic);
+        store_le(p + 8, binary_version, 2);
+        store_le(p + 10, h.block_bytes, 1);
+        store_le(p + 11, h.big_endian, 1);
+        store_le(p + 12, binary_header_size, 4);
+        store_le(p + 16, h.num_bits, 8);
+        store_le(p + 24, h.num_blocks, 8);
+        store_le(p + 32, h.checksum, 8);
+    }
+
+    inline binary_header read_binary_header(const unsigned char * p)
+    {
+        binary_header h;
+        h.block_bytes = static_cast<unsigned>(load_le(p + 10, 1));
+        h.big_endian = load_le(p + 11, 1) == 1;
+        h.num_bits = load_le(p + 16, 8);
+        h.num_blocks = load_le(p + 24, 8);
+        h.checksum = load_le(p + 32, 8);
+
+        const unsigned bb = h.block_bytes;
+        if (std::memcmp(p, binary_magic, sizeof binary_magic) != 0
+            || load_le(p + 8, 2) != binary_version
+            || load_le(p + 12, 4) != binary_header_size
+            || load_le(p + 11, 1) > 1
+            || (bb != 1 && bb != 2 && bb != 4 && bb != 8)
+            || h.num_bits > (std::numeric_limits<std::size_t>::max)() - 64 * 8
+            || h.num_blocks != (h.num_bits + 8 * bb - 1) / (8 * bb))
+            binary_invalid();
+        return h;
+    }
+
+    // the blocks of a file can be used as they are: the bytes of the
+    // bitset come in the same order
+    template <typename Block>
+    inline bool binary_native(const binary_header & h)
+    {
+        return h.big_endian == host_big_endian
+            && (!host_big_endian || h.block_bytes == sizeof(Block));
+    }
+
+    // the general conversion, from the payload of a file (n bytes at p)
+    // to num_blocks blocks of the host, a byte at a time
+    template <typename Block>
+    void convert_binary_blocks(const unsigned char * p, std::size_t n,
+                               const binary_header & h,
+                               Block * out, std::size_t num_blocks)
+    {
+        const std::size_t w = h.block_bytes;
+        for (std::size_t i = 0; i < num_blocks; ++i) {
+            Block b = 0;
+            for (std::size_t k = 0; k < sizeof(Block); ++k) {
+                const std::size_t c = i * sizeof(Block) + k; // byte of the bitset
+                const std::size_t s = h.big_endian ? c / w * w + (w - 1 - c % w) : c;
+                if (s < n)
+                    b |= static_cast<Block>(Block(p[s]) << (8 * k));
+            }
+            out[i] = b;
+        }
+    }
+
+    // the bytes left in is, or -1 if the stream cannot seek
+    inline std::streamoff binary_bytes_left(std::istream& is)
+    {
+        const std::istream::pos_type here = is.tellg();
+        if (here == std::istream::pos_type(-1))
+            return -1;
+        is.seekg(0, std::ios_base::end);
+        const std::istream::pos_type end = is.tellg();
+        is.clear();
+        is.seekg(here);
+        if (end == std::istream::pos_type(-1) || !is)
+            return -1;
+        return end - here;
+    }
+
+    // Reads n bytes into v a chunk at a time, so that v grows with the
+    // data actually read rather than with n, which comes from the
+    // header. Returns false if the stream ends first.
+    inline bool read_binary_chunks(std::istream& is, std::vector<unsigned char>& v,
+                                   std::size_t n)
+    {
+        const std::size_t chunk = std::size_t(1) << 20;
+        v.clear();
+        while (v.size() < n) {
+            const std::size_t k = (std::min)(chunk, n - v.size());
+            const std::size_t old = v.size();
+            v.resize(old + k);
+            if (!is.read(reinterpret_cast<char*>(&v[old]), k))
+                return false;
+        }
+        return true;
+    }
+
+    // the bits beyond num_bits in the last block are off
+    template <typename Block>
+    inline bool binary_unused_bits_off(const Block * p, std::size_t num_bits)
+    {
+        const std::size_t bits = std::numeric_limits<Block>::digits;
+        const std::size_t extra = num_bits % bits;
+        const Block all = static_cast<Block>(~Block(0));
+        return extra == 0 || (p[num_bits / bits] & static_cast<Block>(all << extra)) == 0;
+    }
+
+  } // dynamic_bitset_impl
+  } // namespace detail
+
+
+// Writes b in the binary format, with the block size and byte order of
+// the host.
+//
+template <typename Block, typename Allocator>
+std::ostream& write_binary(std::ostream& os, const dynamic_bitset<Block, Allocator>& b)
+{
+    using namespace detail::dynamic_bitset_impl;
+    BOOST_STATIC_ASSERT(CHAR_BIT == 8);
+    BOOST_STATIC_ASSERT(std::numeric_limits<Block>::digits == CHAR_BIT * sizeof(Block));
+
+    const unsigned char* const p =
+        reinterpret_cast<const unsigned char*>(bitset_leaf<Block>(b).data());
+
+    binary_header h;
+    h.num_bits = b.size();
+    h.num_blocks = b.num_blocks();
+    h.block_bytes = sizeof(Block);
+    h.big_endian = host_big_endian;
+    h.checksum = binary_checksum(p, h.payload(), h.payload());
+
+    unsigned char header[binary_header_size];
+    write_binary_header(header, h);
+    const char zeros[binary_alignment] = { 0 };
+
+    os.write(reinterpret_cast<const char*>(header), binary_header_size);
+    if (h.payload() != 0)
+        os.write(reinterpret_cast<const char*>(p), h.payload());
+    os.write(zeros, h.padded_payload() - h.payload());
+    return os;
+}
+
+// Reads a bitset written by write_binary(), converting the blocks if
+// need be, and verifies the checksum. Throws std::invalid_argument if
+// the data is truncated or invalid; b is then unspecified.
+//
+template <typename Block, typename Allocator>
+std::istream& read_binary(std::istream& is, dynamic_bitset<Block, Allocator>& b)
+{
+    using namespace detail::dynamic_bitset_impl;
+    BOOST_STATIC_ASSERT(CHAR_BIT == 8);
+    BOOST_STATIC_ASSERT(std::numeric_limits<Block>::digits == CHAR_BIT * sizeof(Block));
+
+    unsigned char header[binary_header_size];
+    if (!is.read(reinterpret_cast<char*>(header), binary_header_size))
+        binary_invalid();
+    const binary_header h = read_binary_header(header);
+
+    // nothing is allocated for the bits before the stream is known to
+    // hold them: a short stream may have any header
+    const std::streamoff left = binary_bytes_left(is);
+    if (left >= 0 && static_cast<boost::uint64_t>(left) < h.padded_payload())
+        binary_invalid();
+
+    b.resize(0);
+    bool valid = true;
+    std::size_t n = 0; // bytes of the payload read
+    if (left >= 0 && binary_native<Block>(h)) {
+        b.resize(static_cast<std::size_t>(h.num_bits));
+        unsigned char* const out =
+            reinterpret_cast<unsigned char*>(dynamic_bitset_view<Block>(b).data());
+        const std::size_t bytes = b.num_blocks() * sizeof(Block);
+
+        // straight into the blocks: the rest of the payload must be
+        // zeros, it is read with the padding
+        n = (std::min)(bytes, h.payload());
+        valid = n == 0 || is.read(reinterpret_cast<char*>(out), n);
+        valid = valid && h.checksum == binary_checksum(out, n, h.payload());
+    }
+    else {
+        std::vector<unsigned char> payload;
+        n = h.payload();
+        valid = read_binary_chunks(is, payload, n);
+        valid = valid && h.checksum == binary_checksum(n != 0 ? &payload[0] : 0, n, n);
+        if (valid) {
+            b.resize(static_cast<std::size_t>(h.num_bits));
+            convert_binary_blocks(n != 0 ? &payload[0] : 0, n, h,
+                                  dynamic_bitset_view<Block>(b).data(), b.num_blocks());
+        }
+    }
+    Block* const data = dynamic_bitset_view<Block>(b).data();
+
+    char rest[binary_alignment + 8];
+    const std::size_t r = h.padded_payload() - n;
+    valid = valid && is.read(rest, r)
+                  && std::count(rest, rest + r, 0) == static_cast<std::ptrdiff_t>(r);
+
+    // b must stay a valid bitset, whatever the data
+    if (b.num_blocks() != 0 && !binary_unused_bits_off(data, b.size())) {
+        valid = false;
+        b.reset();
+    }
+    if (!valid)
+        binary_invalid();
+    return is;
+}
+
+
+// A bitset written by write_binary() to a file, mapped in memory: when
+// the blocks of the file have the byte order of the host (and, on big
+// endian hosts, the size of Block) bits() refers to them in place, and
+// loading takes the time of mapping the file, whatever its size.
+// Otherwise, or where mapping files is not supported, the blocks are
+// read and converted.
+//
+// The checksum is only verified on request, as it reads all the blocks.
+//
+template <typename Block>
+class mapped_dynamic_bitset
+{
+public:
+    typedef dynamic_bitset_view<const Block> view_type;
+    typedef std::size_t size_type;
+
+    // Throws std::runtime_error if the file cannot be opened or mapped,
+    // std::invalid_argument if its content is invalid.
+    explicit mapped_dynamic_bitset(const std::string& path, bool verify_checksum = false);
+    ~mapped_dynamic_bitset();
+
+    view_type bits() const { return view_type(m_data, m_num_bits); }
+    size_type size() const { return m_num_bits; }
+
+    // the blocks are those of the file
+    bool zero_copy() const { return m_map != 0; }
+
+private:
+    mapped_dynamic_bitset(const mapped_dynamic_bitset&);
+    mapped_dynamic_bitset& operator=(const mapped_dynamic_bitset&);
+
+    void m_load(const std::string& path, bool verify_checksum);
+    void m_unmap();
+
+    void* m_map;
+    size_type m_map_size;
+    dynamic_bitset<Block> m_copy;
+    const Block* m_data;
+    size_type m_num_bits;
+};
+
+template <typename Block>
+mapped_dynamic_bitset<Block>::mapped_dynamic_bitset(const std::string& path,
+                                                    bool verify_checksum)
+  : m_map(0), m_map_size(0), m_data(0), m_num_bits(0)
+{
+    try {
+        m_load(path, verify_checksum);
+    }
+    catch (...) {
+        m_unmap();
+        throw;
+    }
+}
+
+template <typename Block>
+mapped_dynamic_bitset<Block>::~mapped_dynamic_bitset()
+{
+    m_unmap();
+}
+
+template <typename Block>
+void mapped_dynamic_bitset<Block>::m_load(const std::string& path, bool verify_checksum)
+{
+    using namespace detail::dynamic_bitset_impl;
+    BOOST_STATIC_ASSERT(CHAR_BIT == 8);
+    BOOST_STATIC_ASSERT(std::numeric_limits<Block>::digits == CHAR_BIT * sizeof(Block));
+
+#if defined(BOOST_HAS_UNISTD_H)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("boost::mapped_dynamic_bitset: cannot open " + path);
+    struct stat st;
+    void* map = MAP_FAILED;
+    const bool stat_ok = ::fstat(fd, &st) == 0;
+    if (stat_ok && static_cast<std::size_t>(st.st_size) >= binary_header_size)
+        map = ::mmap(0, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (stat_ok && static_cast<std::size_t>(st.st_size) < binary_header_size)
+        binary_invalid();
+    if (map == MAP_FAILED)
+        throw std::runtime_error("boost::mapped_dynamic_bitset: cannot map " + path);
+    m_map = map;
+    m_map_size = static_cast<std::size_t>(st.st_size);
+
+    const unsigned char* const p = static_cast<const unsigned char*>(m_map);
+    const binary_header h = read_binary_header(p);
+    if (m_map_size - binary_header_size < h.padded_payload())
+        binary_invalid();
+
+    const unsigned char* const payload = p + binary_header_size;
+    if (verify_checksum && h.checksum != binary_checksum(payload, h.payload(), h.payload()))
+        binary_invalid();
+
+    m_num_bits = static_cast<size_type>(h.num_bits);
+    if (binary_native<Block>(h)) {
+        // the padding covers the blocks of the host
+        m_data = reinterpret_cast<const Block*>(payload);
+    }
+    else {
+        m_copy.resize(m_num_bits);
+        Block* const data = dynamic_bitset_view<Block>(m_copy).data();
+        convert_binary_blocks(payload, h.payload(), h, data, m_copy.num_blocks());
+        m_data = data;
+        m_unmap();
+    }
+    if (m_num_bits != 0 && !binary_unused_bits_off(m_data, m_num_bits))
+        binary_invalid();
+#else
+    std::ifstream is(path.c_str(), std::ios_base::binary);
+    if (!is)
+        throw std::runtime_error("boost::mapped_dynamic_bitset: cannot open " + path);
+    read_binary(is, m_copy);
+    (void)verify_checksum; // read_binary() always does
+    m_data = dynamic_bitset_view<const Block>(m_copy).data();
+    m_num_bits = m_copy.size();
+#endif
+}
+
+template <typename Block>
+void mapped_dynamic_bitset<Block>::m_unmap()
+{
+#if defined(BOOST_HAS_UNISTD_H)
+    if (m_map != 0)
+        ::munmap(m_map, m_map_size);
+#endif
+    m_map = 0;
+    m_map_size = 0;
+}
+
+} // namespace boost
+
+#endif // include guard
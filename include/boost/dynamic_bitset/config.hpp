@@ -69,4 +69,25 @@ namespace boost { namespace detail {
 
 #endif
 
+// Hand written x86 kernels (SSE2, POPCNT, AVX2, AVX-512) selected at
+// run time from CPUID. The kernels are compiled with per function target
+// attributes, so no special compiler switch is needed to get them; define
+// BOOST_DYNAMIC_BITSET_NO_SIMD to only use the portable code.
+//
+#if !defined(BOOST_DYNAMIC_BITSET_NO_SIMD)
+# if (defined(__x86_64__) || defined(__i386__))                        \
+     && ((defined(__clang__) && (__clang_major__ >= 4))                 \
+         || (defined(BOOST_GCC) && (BOOST_GCC >= 40900)))
+#  define BOOST_DYNAMIC_BITSET_X86_SIMD
+#  define BOOST_DYNAMIC_BITSET_TARGET(isa) __attribute__((target(isa)))
+#  if (defined(__clang__) && (__clang_major__ >= 6)) || (defined(BOOST_GCC) && (BOOST_GCC >= 80000))
+#   define BOOST_DYNAMIC_BITSET_X86_AVX512
+#  endif
+# elif defined(BOOST_MSVC) && (BOOST_MSVC >= 1910) && (defined(_M_IX86) || defined(_M_X64))
+#  define BOOST_DYNAMIC_BITSET_X86_SIMD
+#  define BOOST_DYNAMIC_BITSET_TARGET(isa) /**/
+#  define BOOST_DYNAMIC_BITSET_X86_AVX512
+# endif
+#endif
+
 #endif // include guard
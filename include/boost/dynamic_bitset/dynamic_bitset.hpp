@@ -18,9 +18,18 @@
 #include <algorithm>
 #include <vector>
 #include <climits>      // for CHAR_BIT
+#include <cstddef>      // for std::ptrdiff_t
 
 #include "boost/dynamic_bitset/config.hpp"
 
+#if !defined(BOOST_NO_CXX17_HDR_STRING_VIEW)
+#  include <string_view>
+#endif
+
+#if !defined(BOOST_NO_CXX11_HDR_FUNCTIONAL)
+#  include <functional>
+#endif
+
 #ifndef BOOST_NO_STD_LOCALE
 #  include <locale>
 #endif
@@ -35,15 +44,29 @@
 
 #include "boost/dynamic_bitset_fwd.hpp"
 #include "boost/detail/dynamic_bitset.hpp"
+#include "boost/detail/dynamic_bitset_kernels.hpp"
+#include "boost/detail/dynamic_bitset_buffer.hpp"
+#include "boost/detail/dynamic_bitset_expr.hpp"
+#include "boost/detail/dynamic_bitset_iterator.hpp"
 #include "boost/detail/iterator.hpp" // used to implement append(Iter, Iter)
 #include "boost/static_assert.hpp"
 #include "boost/limits.hpp"
+#include "boost/cstdint.hpp"
 #include "boost/pending/lowest_bit.hpp"
+#include "boost/pending/highest_bit.hpp"
 #include "boost/functional/hash/hash.hpp"
+#include "boost/move/move.hpp"
 
 
 namespace boost {
 
+// returned by from_chars(), from_hex() and from_base64()
+enum bitset_parse_result {
+    bitset_parse_ok,
+    bitset_parse_invalid_char,
+    bitset_parse_out_of_range   // set bits beyond the requested size
+};
+
 template <typename Block, typename Allocator>
 class dynamic_bitset
 {
@@ -59,7 +82,9 @@ class dynamic_bitset
 
 public:
     typedef Block block_type;
-    typedef Allocator allocator_type;
+    // Allocator, or the allocator of a dynamic_bitset_small_buffer
+    typedef typename detail::dynamic_bitset_impl::block_buffer<
+        Block, Allocator>::allocator_type allocator_type;
     typedef std::size_t size_type;
     typedef block_type block_width_type;
 
@@ -115,13 +140,17 @@ public:
 
     typedef bool const_reference;
 
+    // the positions of the set bits, see set_bits()
+    typedef detail::dynamic_bitset_impl::set_bit_iterator<Block> set_bit_iterator;
+    typedef detail::dynamic_bitset_impl::set_bit_range<Block> set_bit_range;
+
     // constructors, etc.
     explicit
-    dynamic_bitset(const Allocator& alloc = Allocator());
+    dynamic_bitset(const allocator_type& alloc = allocator_type());
 
     explicit
     dynamic_bitset(size_type num_bits, unsigned long value = 0,
-               const Allocator& alloc = Allocator());
+               const allocator_type& alloc = allocator_type());
 
 
     // WARNING: you should avoid using this constructor.
@@ -140,10 +169,9 @@ public:
         typename std::basic_string<CharT, Traits, Alloc>::size_type pos,
         typename std::basic_string<CharT, Traits, Alloc>::size_type n,
         size_type num_bits = npos,
-        const Allocator& alloc = Allocator())
+        const allocator_type& alloc = allocator_type())
 
-    :m_bits(alloc),
-     m_num_bits(0)
+    :m_bits(alloc)
     {
       init_from_string(s, pos, n, num_bits);
     }
@@ -153,21 +181,35 @@ public:
     dynamic_bitset(const std::basic_string<CharT, Traits, Alloc>& s,
       typename std::basic_string<CharT, Traits, Alloc>::size_type pos = 0)
 
-    :m_bits(Allocator()),
-     m_num_bits(0)
+    :m_bits(allocator_type())
     {
       init_from_string(s, pos, (std::basic_string<CharT, Traits, Alloc>::npos),
                        npos);
     }
 
+#if !defined(BOOST_NO_CXX17_HDR_STRING_VIEW)
+    // as the string constructors, without a std::basic_string
+    template <typename CharT, typename Traits>
+    explicit
+    dynamic_bitset(std::basic_string_view<CharT, Traits> s,
+        size_type num_bits = npos,
+        const allocator_type& alloc = allocator_type())
+
+    :m_bits(alloc)
+    {
+      const bool valid = init_from_chars<Traits>(s.data(), s.size(), num_bits);
+      assert(valid);
+      (void)valid;
+    }
+#endif
+
     // The first bit in *first is the least significant bit, and the
     // last bit in the block just before *last is the most significant bit.
     template <typename BlockInputIterator>
     dynamic_bitset(BlockInputIterator first, BlockInputIterator last,
-                   const Allocator& alloc = Allocator())
+                   const allocator_type& alloc = allocator_type())
 
-    :m_bits(alloc),
-     m_num_bits(0)
+    :m_bits(alloc)
     {
         using boost::detail::dynamic_bitset_impl::value_to_type;
         using boost::detail::dynamic_bitset_impl::is_numeric;
@@ -197,7 +239,7 @@ public:
     {
         assert(m_bits.size() == 0);
         m_bits.insert(m_bits.end(), first, last);
-        m_num_bits = m_bits.size() * bits_per_block;
+        m_bits.set_num_bits(m_bits.size() * bits_per_block);
     }
 
     // copy constructor
@@ -208,6 +250,12 @@ public:
     void swap(dynamic_bitset& b);
     dynamic_bitset& operator=(const dynamic_bitset& b);
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    // the source is left empty
+    dynamic_bitset(dynamic_bitset&& src) BOOST_NOEXCEPT;
+    dynamic_bitset& operator=(dynamic_bitset&& src) BOOST_NOEXCEPT;
+#endif
+
     allocator_type get_allocator() const;
 
     // size changing operations
@@ -216,10 +264,15 @@ public:
     void push_back(bool bit);
     void append(Block block);
 
+    // capacity, in bits
+    void reserve(size_type num_bits);
+    size_type capacity() const;
+    void shrink_to_fit();
+
     template <typename BlockInputIterator>
     void m_append(BlockInputIterator first, BlockInputIterator last, std::input_iterator_tag)
     {
-        std::vector<Block, Allocator> v(first, last);
+        buffer_type v(first, last);
         m_append(v.begin(), v.end(), std::random_access_iterator_tag());
     }
     template <typename BlockInputIterator>
@@ -241,7 +294,7 @@ public:
                 m_bits.push_back(b | (first==last? 0 : *first << r));
             } while (first != last);
         }
-        m_num_bits += bits_per_block * d;
+        m_bits.set_num_bits(size() + bits_per_block * d);
     }
     template <typename BlockInputIterator>
     void append(BlockInputIterator first, BlockInputIterator last) // strong guarantee
@@ -258,11 +311,25 @@ public:
     dynamic_bitset& operator|=(const dynamic_bitset& b);
     dynamic_bitset& operator^=(const dynamic_bitset& b);
     dynamic_bitset& operator-=(const dynamic_bitset& b);
+
+    // *this = e, a bitwise expression of bitset_expr() operands, in a
+    // single pass and without temporaries; *this may be an operand
+    template <typename Expr>
+    dynamic_bitset& assign(const detail::dynamic_bitset_impl::dynamic_bitset_expr<Expr, Block>& e);
+
     dynamic_bitset& operator<<=(size_type n);
     dynamic_bitset& operator>>=(size_type n);
     dynamic_bitset operator<<(size_type n) const;
     dynamic_bitset operator>>(size_type n) const;
 
+    // *this op= b shifted by k positions, i.e. b << k if k >= 0 and
+    // b >> -k otherwise, in one pass and without a temporary; b may be
+    // *this. andnot_shifted() is the -= of the shifted b.
+    dynamic_bitset& or_shifted(const dynamic_bitset& b, std::ptrdiff_t k);
+    dynamic_bitset& and_shifted(const dynamic_bitset& b, std::ptrdiff_t k);
+    dynamic_bitset& xor_shifted(const dynamic_bitset& b, std::ptrdiff_t k);
+    dynamic_bitset& andnot_shifted(const dynamic_bitset& b, std::ptrdiff_t k);
+
     // basic bit operations
     dynamic_bitset& set(size_type n, bool val = true);
     dynamic_bitset& set();
@@ -270,11 +337,24 @@ public:
     dynamic_bitset& reset();
     dynamic_bitset& flip(size_type n);
     dynamic_bitset& flip();
+
+    // the bits in [n, n + len); val has no default, as set(n, len)
+    // would be ambiguous with set(n, val)
+    dynamic_bitset& set(size_type n, size_type len, bool val);
+    dynamic_bitset& reset(size_type n, size_type len);
+    dynamic_bitset& flip(size_type n, size_type len);
     bool test(size_type n) const;
     bool any() const;
     bool none() const;
+#if defined(BOOST_NO_CXX11_RVALUE_REFERENCES) || defined(BOOST_NO_CXX11_REF_QUALIFIERS)
     dynamic_bitset operator~() const;
+#else
+    dynamic_bitset operator~() const &;
+    dynamic_bitset operator~() &&; // flips in place
+#endif
     size_type count() const;
+    bool count_at_least(size_type k) const;
+    bool intersection_count_at_least(const dynamic_bitset& b, size_type k) const;
 
     // subscript
     reference operator[](size_type pos) {
@@ -296,7 +376,15 @@ public:
     // lookup
     size_type find_first() const;
     size_type find_next(size_type pos) const;
+    size_type find_last() const;
+    size_type find_prev(size_type pos) const;
+    size_type find_first_zero() const;
+    size_type find_next_zero(size_type pos) const;
 
+    // the positions of the set bits, in increasing order
+    set_bit_range set_bits() const;
+    // PRE: out has room for count() values, size() <= 2^32
+    size_type decode_set_bits(boost::uint32_t* out) const;
 
 #if !defined BOOST_DYNAMIC_BITSET_DONT_USE_FRIENDS
     // lexicographical comparison
@@ -308,6 +396,14 @@ public:
     friend bool operator<(const dynamic_bitset<B, A>& a,
                           const dynamic_bitset<B, A>& b);
 
+    template <typename B, typename A>
+    friend typename dynamic_bitset<B, A>::size_type
+    find_first_difference(const dynamic_bitset<B, A>& a, const dynamic_bitset<B, A>& b);
+
+    template <typename B, typename A>
+    friend typename dynamic_bitset<B, A>::size_type
+    find_last_difference(const dynamic_bitset<B, A>& a, const dynamic_bitset<B, A>& b);
+
 
     template <typename B, typename A, typename BlockOutputIterator>
     friend void to_block_range(const dynamic_bitset<B, A>& b,
@@ -317,31 +413,72 @@ public:
     friend void from_block_range(BlockIterator first, BlockIterator last,
                                  dynamic_bitset<B, A>& result);
 
+    template <typename CharT, typename B, typename A>
+    friend bitset_parse_result from_chars(const CharT* first, const CharT* last,
+                                          dynamic_bitset<B, A>& result);
+
 
     template <typename CharT, typename Traits, typename B, typename A>
     friend std::basic_istream<CharT, Traits>& operator>>(std::basic_istream<CharT, Traits>& is,
                                                          dynamic_bitset<B, A>& b);
 
+#ifndef BOOST_OLD_IOSTREAMS
+    template <typename CharT, typename Traits, typename B, typename A>
+    friend std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& os,
+                                                         const dynamic_bitset<B, A>& b);
+#endif
+
     template <typename B, typename A, typename stringT>
     friend void to_string_helper(const dynamic_bitset<B, A> & b, stringT & s, bool dump_all);
 
     template <typename B, typename A>
-    friend std::size_t hash_value(const dynamic_bitset<B, A>& a) {
-        std::size_t res = hash_value(a.m_num_bits);
-        hash_combine(res, hash_value(a.m_bits));
-        return res;
+    friend dynamic_bitset<B, A> operator&(const dynamic_bitset<B, A>& x,
+                                          const dynamic_bitset<B, A>& y);
+    template <typename B, typename A>
+    friend dynamic_bitset<B, A> operator|(const dynamic_bitset<B, A>& x,
+                                          const dynamic_bitset<B, A>& y);
+    template <typename B, typename A>
+    friend dynamic_bitset<B, A> operator^(const dynamic_bitset<B, A>& x,
+                                          const dynamic_bitset<B, A>& y);
+    template <typename B, typename A>
+    friend dynamic_bitset<B, A> operator-(const dynamic_bitset<B, A>& x,
+                                          const dynamic_bitset<B, A>& y);
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    template <typename B, typename A>
+    friend dynamic_bitset<B, A> operator-(const dynamic_bitset<B, A>& x,
+                                          dynamic_bitset<B, A>&& y);
+#endif
+
+    template <typename B>
+    friend class detail::dynamic_bitset_impl::bitset_leaf;
+
+    template <typename B, typename A>
+    friend class hierarchical_bitset;
+
+    template <typename B>
+    friend class dynamic_bitset_view;
+
+    // a hash of the bits as 64-bit words, the same for all block types;
+    // see also dynamic_bitset_hasher
+    friend std::size_t hash_value(const dynamic_bitset& a) {
+        return static_cast<std::size_t>(detail::dynamic_bitset_impl::hash_bits(
+            a.m_block_data(), a.num_blocks(), a.size()));
     }
 #endif
 
 
 private:
     BOOST_STATIC_CONSTANT(block_width_type, ulong_width = std::numeric_limits<unsigned long>::digits);
-    typedef std::vector<block_type, allocator_type> buffer_type;
+    typedef typename detail::dynamic_bitset_impl::block_buffer<
+        Block, Allocator>::type buffer_type;
 
     void m_zero_unused_bits();
     bool m_check_invariants() const;
 
     size_type m_do_find_from(size_type first_block) const;
+    size_type m_do_find_before(size_type last_block) const;
+    size_type m_do_find_zero_from(size_type first_block) const;
 
     block_width_type count_extra_bits() const { return bit_index(size()); }
     static size_type block_index(size_type pos) { return pos / bits_per_block; }
@@ -356,32 +493,53 @@ private:
     {
         assert(pos <= s.size());
 
-        typedef typename std::basic_string<CharT, Traits, Alloc> StrT;
-        typedef typename StrT::traits_type Tr;
+        const typename std::basic_string<CharT, Traits, Alloc>::size_type
+            rlen = (std::min)(n, s.size() - pos);
+        const bool valid = init_from_chars<Traits>(s.data() + pos, rlen, num_bits);
+        assert(valid);
+        (void)valid;
+    }
+
+    // The first min(num_bits, rlen) characters of s, the last of them
+    // being bit 0; the size is num_bits, or rlen if num_bits is npos.
+    // Returns false if one of those characters is neither '0' nor '1'
+    // (the bits are then unspecified).
+    template <typename Traits, typename CharT>
+    bool init_from_chars(const CharT* s, size_type rlen, size_type num_bits)
+    {
+        assert(m_bits.size() == 0);
 
-        const typename StrT::size_type rlen = (std::min)(n, s.size() - pos);
         const size_type sz = ( num_bits != npos? num_bits : rlen);
         m_bits.resize(calc_num_blocks(sz));
-        m_num_bits = sz;
-
-
-        BOOST_DYNAMIC_BITSET_CTYPE_FACET(CharT, fac, std::locale());
-        const CharT one = BOOST_DYNAMIC_BITSET_WIDEN_CHAR(fac, '1');
+        m_bits.set_num_bits(sz);
 
         const size_type m = num_bits < rlen ? num_bits : rlen;
-        typename StrT::size_type i = 0;
-        for( ; i < m; ++i) {
-
-            const CharT c = s[(pos + m - 1) - i];
+        return m == 0 || parse_chars<Traits>(s, m, m_block_data());
+    }
 
-            assert( Tr::eq(c, one)
-                    || Tr::eq(c, BOOST_DYNAMIC_BITSET_WIDEN_CHAR(fac, '0')) );
+    // '0' and '1' are the same in every locale: classify whole
+    // vectors of characters
+    template <typename Traits>
+    static bool parse_chars(const char* s, size_type m, Block* out)
+    {
+        return detail::dynamic_bitset_impl::parse_bit_chars(s, m, out);
+    }
 
-            if (Tr::eq(c, one))
-                set(i);
+    template <typename Traits, typename CharT>
+    static bool parse_chars(const CharT* s, size_type m, Block* out)
+    {
+        BOOST_DYNAMIC_BITSET_CTYPE_FACET(CharT, fac, std::locale());
+        const CharT zero = BOOST_DYNAMIC_BITSET_WIDEN_CHAR(fac, '0');
+        const CharT one = BOOST_DYNAMIC_BITSET_WIDEN_CHAR(fac, '1');
 
+        for (size_type i = 0; i < m; ++i) {
+            const CharT c = s[(m - 1) - i];
+            if (Traits::eq(c, one))
+                out[block_index(i)] |= bit_mask(i);
+            else if (!Traits::eq(c, zero))
+                return false;
         }
-
+        return true;
     }
 
     void init_from_unsigned_long(size_type num_bits,
@@ -392,7 +550,7 @@ private:
         assert(m_bits.size() == 0);
 
         m_bits.resize(calc_num_blocks(num_bits));
-        m_num_bits = num_bits;
+        m_bits.set_num_bits(num_bits);
 
         typedef unsigned long num_type;
         typedef boost::detail::dynamic_bitset_impl
@@ -425,59 +583,175 @@ BOOST_DYNAMIC_BITSET_PRIVATE:
     Block&        m_highest_block();
     const Block&  m_highest_block() const;
 
-    buffer_type m_bits;
-    size_type   m_num_bits;
+    // pointer to the first block, null if the buffer is empty
+    Block*        m_block_data()       { return m_bits.empty() ? 0 : &m_bits[0]; }
+    const Block*  m_block_data() const { return m_bits.empty() ? 0 : &m_bits[0]; }
+
+    // *this = e, a chunk of blocks at a time; if e refers to *this
+    // each chunk goes through a buffer, as later chunks of the
+    // operands must not be overwritten before they are read
+    template <typename Expr>
+    void m_assign(const Expr& e)
+    {
+        using detail::dynamic_bitset_impl::expr_chunk;
+        const size_type chunk = expr_chunk<Block>::value;
+
+        m_bits.resize(e.num_blocks());
+        m_bits.set_num_bits(e.size());
+
+        Block* const d = m_block_data();
+        const size_type n = num_blocks();
+        const bool aliased = e.aliases(d);
+
+        Block buf[expr_chunk<Block>::value];
+        for (size_type first = 0; first < n; first += chunk) {
+            const size_type len = (std::min)(chunk, n - first);
+            if (aliased) {
+                e.eval(buf, first, len);
+                std::copy(buf, buf + len, d + first);
+            }
+            else
+                e.eval(d + first, first, len);
+        }
+        assert(m_check_invariants());
+    }
+
+    // d = d op (s shifted by k), as or_shifted(); d and s may be equal
+    template <int Op>
+    void m_apply_shifted(Block* d, const Block* s, std::ptrdiff_t k) const
+    {
+        using namespace detail::dynamic_bitset_impl;
+        if (k >= 0)
+            shift_bitwise_blocks<Op, true>(d, s, num_blocks(),
+                                           static_cast<size_type>(k));
+        else
+            shift_bitwise_blocks<Op, false>(d, s, num_blocks(),
+                                            static_cast<size_type>(-(k + 1)) + 1);
+    }
+
+    // block op mask, for the bits in [pos, pos + len) of each block:
+    // masked operations on the first and last blocks, and whole
+    // blocks in between. Op is op_or (set), op_sub (reset) or op_xor
+    // (flip)
+    template <int Op>
+    void m_range_operation(size_type pos, size_type len)
+    {
+        using namespace detail::dynamic_bitset_impl;
+
+        assert(pos <= size() && len <= size() - pos);
+        if (len == 0)
+            return;
+
+        const size_type first = block_index(pos);
+        const size_type last = block_index(pos + len - 1);
+        const block_type all = static_cast<block_type>(~Block(0));
+        const block_type head = static_cast<block_type>(all << bit_index(pos));
+        const block_type tail = static_cast<block_type>(
+            all >> (bits_per_block - 1 - bit_index(pos + len - 1)));
+
+        Block* const d = m_block_data();
+        if (first == last) {
+            d[first] = apply_bitwise<Op>(d[first], static_cast<block_type>(head & tail));
+            return;
+        }
+        d[first] = apply_bitwise<Op>(d[first], head);
+        if (Op == op_xor)
+            bitwise_blocks<op_not>(d + first + 1, d + first + 1, last - first - 1);
+        else
+            std::fill(d + first + 1, d + last, Op == op_or ? all : Block(0));
+        d[last] = apply_bitwise<Op>(d[last], tail);
+    }
+
+    buffer_type m_bits; // also holds the number of bits
 
 
     class bit_appender;
     friend class bit_appender;
     class bit_appender {
       // helper for stream >>
-      // Supplies to the lack of an efficient append at the less
-      // significant end: bits are actually appended "at left" but
-      // rearranged in the destructor. From the perspective of
-      // client code everything works *as if* dynamic_bitset<> had
-      // an append_at_right() function (eventually throwing the same
-      // exceptions as push_back) except that the function is in fact
-      // called bit_appender::do_append().
+      // Collects the bits in the order they are read, the first one
+      // being the most significant, in 64-bit words (the last bit of a
+      // word in bit 0), plus the last partial word. finish() then
+      // writes the blocks of the bitset once, in their final order.
       //
-      dynamic_bitset & bs;
-      size_type n;
-      Block mask;
-      Block * current;
+      std::vector<boost::uint64_t> words;
+      boost::uint64_t current;
+      unsigned current_bits;
 
       // not implemented
       bit_appender(const bit_appender &);
       bit_appender & operator=(const bit_appender &);
 
+      void push_current() {
+          words.push_back(current);
+          current = 0;
+          current_bits = 0;
+      }
+
     public:
-        bit_appender(dynamic_bitset & r) : bs(r), n(0), mask(0), current(0) {}
-        ~bit_appender() {
-            // reverse the order of blocks, shift
-            // if needed, and then resize
-            //
-            std::reverse(bs.m_bits.begin(), bs.m_bits.end());
-            const block_width_type offs = bit_index(n);
-            if (offs)
-                bs >>= (bits_per_block - offs);
-            bs.resize(n); // doesn't enlarge, so can't throw
-            assert(bs.m_check_invariants());
+        bit_appender() : current(0), current_bits(0) {}
+
+        void do_append(bool value) {
+            current = (current << 1) | static_cast<boost::uint64_t>(value);
+            if (++current_bits == 64)
+                push_current();
         }
-        inline void do_append(bool value) {
 
-            if (mask == 0) {
-                bs.append(Block(0));
-                current = &bs.m_highest_block();
-                mask = Block(1) << (bits_per_block - 1);
+        // appends the leading '0' and '1' characters of [p, p + n),
+        // and returns their number
+        std::size_t append_chars(const char * p, std::size_t n) {
+            std::size_t i = 0;
+            for ( ; i < n && current_bits != 0; ++i) {
+                if ((p[i] & ~1) != '0')
+                    return i;
+                do_append(p[i] == '1');
             }
 
-            if(value)
-                *current |= mask;
+            const std::size_t groups = (n - i) / 64;
+            if (groups != 0) {
+                const std::size_t old = words.size();
+                words.resize(old + groups);
+                const std::size_t done = detail::dynamic_bitset_impl::
+                    parse_bit_words(p + i, groups, &words[old]);
+                words.resize(old + done);
+                i += 64 * done;
+            }
+
+            for ( ; i < n; ++i) {
+                if ((p[i] & ~1) != '0')
+                    return i;
+                do_append(p[i] == '1');
+            }
+            return n;
+        }
 
-            mask /= 2;
-            ++n;
+        size_type get_count() const { return 64 * words.size() + current_bits; }
+
+        // PRE: bs.empty()
+        void finish(dynamic_bitset & bs) const {
+            const size_type n = get_count();
+            bs.m_bits.resize(calc_num_blocks(n));
+            bs.m_bits.set_num_bits(n);
+
+            // the bits are current, then the words from the last one
+            // back; output word t gets them from bit 64 * t
+            const std::size_t num_words = words.size();
+            const unsigned r = current_bits;
+            const std::size_t num_out = (n + 63) / 64;
+            for (std::size_t t = 0; t < num_out; ++t) {
+                boost::uint64_t w;
+                if (r == 0)
+                    w = words[num_words - 1 - t];
+                else {
+                    w = t == 0 ? current : words[num_words - t] >> (64 - r);
+                    if (t < num_words)
+                        w |= words[num_words - 1 - t] << r;
+                }
+                detail::dynamic_bitset_impl::store_bits64(bs.m_block_data(),
+                                                          bs.num_blocks(), t, w);
+            }
+            assert(bs.m_check_invariants());
         }
-        size_type get_count() const { return n; }
     };
 
 };
@@ -558,6 +832,103 @@ dynamic_bitset<Block, Allocator>
 operator-(const dynamic_bitset<Block, Allocator>& b1,
           const dynamic_bitset<Block, Allocator>& b2);
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+// these reuse the buffer of an rvalue operand, if any
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator&(dynamic_bitset<Block, Allocator>&& b1,
+          const dynamic_bitset<Block, Allocator>& b2);
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator&(const dynamic_bitset<Block, Allocator>& b1,
+          dynamic_bitset<Block, Allocator>&& b2);
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator&(dynamic_bitset<Block, Allocator>&& b1,
+          dynamic_bitset<Block, Allocator>&& b2);
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator|(dynamic_bitset<Block, Allocator>&& b1,
+          const dynamic_bitset<Block, Allocator>& b2);
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator|(const dynamic_bitset<Block, Allocator>& b1,
+          dynamic_bitset<Block, Allocator>&& b2);
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator|(dynamic_bitset<Block, Allocator>&& b1,
+          dynamic_bitset<Block, Allocator>&& b2);
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator^(dynamic_bitset<Block, Allocator>&& b1,
+          const dynamic_bitset<Block, Allocator>& b2);
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator^(const dynamic_bitset<Block, Allocator>& b1,
+          dynamic_bitset<Block, Allocator>&& b2);
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator^(dynamic_bitset<Block, Allocator>&& b1,
+          dynamic_bitset<Block, Allocator>&& b2);
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator-(dynamic_bitset<Block, Allocator>&& b1,
+          const dynamic_bitset<Block, Allocator>& b2);
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator-(const dynamic_bitset<Block, Allocator>& b1,
+          dynamic_bitset<Block, Allocator>&& b2);
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator-(dynamic_bitset<Block, Allocator>&& b1,
+          dynamic_bitset<Block, Allocator>&& b2);
+#endif
+
+// population counts of a op b, without computing a op b
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+intersection_count(const dynamic_bitset<Block, Allocator>& a,
+                   const dynamic_bitset<Block, Allocator>& b);
+
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+union_count(const dynamic_bitset<Block, Allocator>& a,
+            const dynamic_bitset<Block, Allocator>& b);
+
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+difference_count(const dynamic_bitset<Block, Allocator>& a,
+                 const dynamic_bitset<Block, Allocator>& b);
+
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+hamming_distance(const dynamic_bitset<Block, Allocator>& a,
+                 const dynamic_bitset<Block, Allocator>& b);
+
+// the lowest and the highest positions at which a and b differ, or
+// npos if a == b
+// PRE: a.size() == b.size()
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+find_first_difference(const dynamic_bitset<Block, Allocator>& a,
+                      const dynamic_bitset<Block, Allocator>& b);
+
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+find_last_difference(const dynamic_bitset<Block, Allocator>& a,
+                     const dynamic_bitset<Block, Allocator>& b);
+
 // namespace scope swap
 template<typename Block, typename Allocator>
 void swap(dynamic_bitset<Block, Allocator>& b1,
@@ -583,6 +954,32 @@ from_block_range(BlockIterator first, BlockIterator last,
     std::copy (first, last, result.m_bits.begin());
 }
 
+// Assigns to result the bits of the '0' and '1' characters of
+// [first, last), the last of them being bit 0. On failure result is
+// empty.
+template <typename CharT, typename B, typename A>
+inline bitset_parse_result
+from_chars(const CharT* first, const CharT* last,
+           dynamic_bitset<B, A>& result)
+{
+    result.clear();
+    if (!result.template init_from_chars<std::char_traits<CharT> >(
+            first, static_cast<std::size_t>(last - first), result.npos)) {
+        result.clear();
+        return bitset_parse_invalid_char;
+    }
+    return bitset_parse_ok;
+}
+
+#if !defined(BOOST_NO_CXX17_HDR_STRING_VIEW)
+template <typename CharT, typename Traits, typename B, typename A>
+inline bitset_parse_result
+from_chars(std::basic_string_view<CharT, Traits> s, dynamic_bitset<B, A>& result)
+{
+    return from_chars(s.data(), s.data() + s.size(), result);
+}
+#endif
+
 //=============================================================================
 // dynamic_bitset implementation
 
@@ -591,17 +988,16 @@ from_block_range(BlockIterator first, BlockIterator last,
 // constructors, etc.
 
 template <typename Block, typename Allocator>
-dynamic_bitset<Block, Allocator>::dynamic_bitset(const Allocator& alloc)
-  : m_bits(alloc), m_num_bits(0)
+dynamic_bitset<Block, Allocator>::dynamic_bitset(const allocator_type& alloc)
+  : m_bits(alloc)
 {
 
 }
 
 template <typename Block, typename Allocator>
 dynamic_bitset<Block, Allocator>::
-dynamic_bitset(size_type num_bits, unsigned long value, const Allocator& alloc)
-    : m_bits(alloc),
-      m_num_bits(0)
+dynamic_bitset(size_type num_bits, unsigned long value, const allocator_type& alloc)
+    : m_bits(alloc)
 {
     init_from_unsigned_long(num_bits, value);
 }
@@ -610,7 +1006,7 @@ dynamic_bitset(size_type num_bits, unsigned long value, const Allocator& alloc)
 template <typename Block, typename Allocator>
 inline dynamic_bitset<Block, Allocator>::
 dynamic_bitset(const dynamic_bitset& b)
-  : m_bits(b.m_bits), m_num_bits(b.m_num_bits)
+  : m_bits(b.m_bits)
 {
 
 }
@@ -626,8 +1022,7 @@ template <typename Block, typename Allocator>
 inline void dynamic_bitset<Block, Allocator>::
 swap(dynamic_bitset<Block, Allocator>& b) // no throw
 {
-    std::swap(m_bits, b.m_bits);
-    std::swap(m_num_bits, b.m_num_bits);
+    m_bits.swap(b.m_bits);
 }
 
 template <typename Block, typename Allocator>
@@ -635,10 +1030,37 @@ dynamic_bitset<Block, Allocator>& dynamic_bitset<Block, Allocator>::
 operator=(const dynamic_bitset<Block, Allocator>& b)
 {
     m_bits = b.m_bits;
-    m_num_bits = b.m_num_bits;
     return *this;
 }
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+
+// move constructor
+template <typename Block, typename Allocator>
+inline dynamic_bitset<Block, Allocator>::
+dynamic_bitset(dynamic_bitset&& src) BOOST_NOEXCEPT
+  : m_bits(boost::move(src.m_bits))
+{
+    // leave src in a valid (empty) state, so that its
+    // invariants still hold
+    src.m_bits.clear();
+    src.m_bits.set_num_bits(0);
+}
+
+template <typename Block, typename Allocator>
+inline dynamic_bitset<Block, Allocator>& dynamic_bitset<Block, Allocator>::
+operator=(dynamic_bitset<Block, Allocator>&& src) BOOST_NOEXCEPT
+{
+    if (&src != this) {
+        m_bits = boost::move(src.m_bits);
+        src.m_bits.clear();
+        src.m_bits.set_num_bits(0);
+    }
+    return *this;
+}
+
+#endif
+
 template <typename Block, typename Allocator>
 inline typename dynamic_bitset<Block, Allocator>::allocator_type
 dynamic_bitset<Block, Allocator>::get_allocator() const
@@ -674,7 +1096,7 @@ resize(size_type num_bits, bool value) // strong guarantee
   //    any, that were 'unused bits' before enlarging: if value == true,
   //    they must be set.
 
-  if (value && (num_bits > m_num_bits)) {
+  if (value && (num_bits > size())) {
 
     const block_width_type extra_bits = count_extra_bits();
     if (extra_bits) {
@@ -686,7 +1108,7 @@ resize(size_type num_bits, bool value) // strong guarantee
 
   }
 
-  m_num_bits = num_bits;
+  m_bits.set_num_bits(num_bits);
   m_zero_unused_bits();
 
 }
@@ -696,17 +1118,22 @@ void dynamic_bitset<Block, Allocator>::
 clear() // no throw
 {
   m_bits.clear();
-  m_num_bits = 0;
+  m_bits.set_num_bits(0);
 }
 
 
 template <typename Block, typename Allocator>
 void dynamic_bitset<Block, Allocator>::
-push_back(bool bit)
+push_back(bool bit) // strong guarantee
 {
+  // only the top block is touched: the unused bits are already zero
   const size_type sz = size();
-  resize(sz + 1);
-  set(sz, bit);
+  const block_width_type r = bit_index(sz);
+  if (r == 0)
+      m_bits.push_back(static_cast<Block>(bit));
+  else if (bit)
+      m_bits.back() |= Block(1) << r;
+  m_bits.set_num_bits(sz + 1);
 }
 
 template <typename Block, typename Allocator>
@@ -724,12 +1151,40 @@ append(Block value) // strong guarantee
         m_bits[m_bits.size() - 2] |= (value << r); // m_bits.size() >= 2
     }
 
-    m_num_bits += bits_per_block;
+    m_bits.set_num_bits(size() + bits_per_block);
     assert(m_check_invariants());
 
 }
 
 
+template <typename Block, typename Allocator>
+inline void dynamic_bitset<Block, Allocator>::
+reserve(size_type num_bits)
+{
+    m_bits.reserve(calc_num_blocks(num_bits));
+}
+
+template <typename Block, typename Allocator>
+inline typename dynamic_bitset<Block, Allocator>::size_type
+dynamic_bitset<Block, Allocator>::capacity() const
+{
+    const size_type m = m_bits.capacity();
+
+    return m <= (size_type(-1)/bits_per_block) ?
+        m * bits_per_block :
+        size_type(-1);
+}
+
+template <typename Block, typename Allocator>
+void dynamic_bitset<Block, Allocator>::
+shrink_to_fit()
+{
+    // a copy of the buffer has no excess capacity
+    if (m_bits.capacity() > m_bits.size())
+        buffer_type(m_bits).swap(m_bits);
+}
+
+
 //-----------------------------------------------------------------------------
 // bitset operations
 template <typename Block, typename Allocator>
@@ -737,8 +1192,8 @@ dynamic_bitset<Block, Allocator>&
 dynamic_bitset<Block, Allocator>::operator&=(const dynamic_bitset& rhs)
 {
     assert(size() == rhs.size());
-    for (size_type i = 0; i < num_blocks(); ++i)
-        m_bits[i] &= rhs.m_bits[i];
+    using namespace detail::dynamic_bitset_impl;
+    bitwise_blocks<op_and>(m_block_data(), rhs.m_block_data(), num_blocks());
     return *this;
 }
 
@@ -747,9 +1202,8 @@ dynamic_bitset<Block, Allocator>&
 dynamic_bitset<Block, Allocator>::operator|=(const dynamic_bitset& rhs)
 {
     assert(size() == rhs.size());
-    for (size_type i = 0; i < num_blocks(); ++i)
-        m_bits[i] |= rhs.m_bits[i];
-    //m_zero_unused_bits();
+    using namespace detail::dynamic_bitset_impl;
+    bitwise_blocks<op_or>(m_block_data(), rhs.m_block_data(), num_blocks());
     return *this;
 }
 
@@ -758,9 +1212,8 @@ dynamic_bitset<Block, Allocator>&
 dynamic_bitset<Block, Allocator>::operator^=(const dynamic_bitset& rhs)
 {
     assert(size() == rhs.size());
-    for (size_type i = 0; i < this->num_blocks(); ++i)
-        m_bits[i] ^= rhs.m_bits[i];
-    //m_zero_unused_bits();
+    using namespace detail::dynamic_bitset_impl;
+    bitwise_blocks<op_xor>(m_block_data(), rhs.m_block_data(), num_blocks());
     return *this;
 }
 
@@ -769,160 +1222,163 @@ dynamic_bitset<Block, Allocator>&
 dynamic_bitset<Block, Allocator>::operator-=(const dynamic_bitset& rhs)
 {
     assert(size() == rhs.size());
-    for (size_type i = 0; i < num_blocks(); ++i)
-        m_bits[i] &= ~rhs.m_bits[i];
-    //m_zero_unused_bits();
+    using namespace detail::dynamic_bitset_impl;
+    bitwise_blocks<op_sub>(m_block_data(), rhs.m_block_data(), num_blocks());
+    return *this;
+}
+
+template <typename Block, typename Allocator>
+template <typename Expr>
+dynamic_bitset<Block, Allocator>&
+dynamic_bitset<Block, Allocator>::assign(
+    const detail::dynamic_bitset_impl::dynamic_bitset_expr<Expr, Block>& e)
+{
+    m_assign(e.expression());
     return *this;
 }
 
-//
-// NOTE:
-//  Note that the 'if (r != 0)' is crucial to avoid undefined
-//  behavior when the left hand operand of >> isn't promoted to a
-//  wider type (because rs would be too large).
-//
 template <typename Block, typename Allocator>
 dynamic_bitset<Block, Allocator>&
 dynamic_bitset<Block, Allocator>::operator<<=(size_type n)
 {
-    if (n >= m_num_bits)
+    if (n >= size())
         return reset();
     //else
     if (n > 0) {
-
-        size_type    const last = num_blocks() - 1;  // num_blocks() is >= 1
-        size_type    const div  = n / bits_per_block; // div is <= last
-        block_width_type const r = bit_index(n);
-        block_type * const b    = &m_bits[0];
-
-        if (r != 0) {
-
-            block_width_type const rs = bits_per_block - r;
-
-            for (size_type i = last-div; i>0; --i) {
-                b[i+div] = (b[i] << r) | (b[i-1] >> rs);
-            }
-            b[div] = b[0] << r;
-
-        }
-        else {
-            for (size_type i = last-div; i>0; --i) {
-                b[i+div] = b[i];
-            }
-            b[div] = b[0];
-        }
-
-        // zero out div blocks at the less significant end
-        std::fill_n(b, div, static_cast<block_type>(0));
+        m_apply_shifted<detail::dynamic_bitset_impl::op_copy>(
+            m_block_data(), m_block_data(), static_cast<std::ptrdiff_t>(n));
 
         // zero out any 1 bit that flowed into the unused part
         m_zero_unused_bits(); // thanks to Lester Gong
-
     }
 
     return *this;
-
-
 }
 
-
-//
-// NOTE:
-//  see the comments to operator <<=
-//
 template <typename B, typename A>
 dynamic_bitset<B, A> & dynamic_bitset<B, A>::operator>>=(size_type n) {
-    if (n >= m_num_bits) {
+    if (n >= size()) {
         return reset();
     }
     //else
     if (n>0) {
-
-        size_type  const last  = num_blocks() - 1; // num_blocks() is >= 1
-        size_type  const div   = n / bits_per_block;   // div is <= last
-        block_width_type const r     = bit_index(n);
-        block_type * const b   = &m_bits[0];
-
-
-        if (r != 0) {
-
-            block_width_type const ls = bits_per_block - r;
-
-            for (size_type i = div; i < last; ++i) {
-                b[i-div] = (b[i] >> r) | (b[i+1]  << ls);
-            }
-            // r bits go to zero
-            b[last-div] = b[last] >> r;
-        }
-
-        else {
-            for (size_type i = div; i <= last; ++i) {
-                b[i-div] = b[i];
-            }
-            // note the '<=': the last iteration 'absorbs'
-            // b[last-div] = b[last] >> 0;
-        }
-
-
-
-        // div blocks are zero filled at the most significant end
-        std::fill_n(b + (num_blocks()-div), div, static_cast<block_type>(0));
+        m_apply_shifted<detail::dynamic_bitset_impl::op_copy>(
+            m_block_data(), m_block_data(), -static_cast<std::ptrdiff_t>(n));
     }
 
     return *this;
 }
 
 
+// the result is written in one pass from *this, rather than copied and
+// then shifted in place
 template <typename Block, typename Allocator>
 dynamic_bitset<Block, Allocator>
 dynamic_bitset<Block, Allocator>::operator<<(size_type n) const
 {
-    dynamic_bitset r(*this);
-    return r <<= n;
+    dynamic_bitset r(size(), 0, get_allocator());
+    if (n < size()) {
+        m_apply_shifted<detail::dynamic_bitset_impl::op_copy>(
+            r.m_block_data(), m_block_data(), static_cast<std::ptrdiff_t>(n));
+        r.m_zero_unused_bits();
+    }
+    return r;
 }
 
 template <typename Block, typename Allocator>
 dynamic_bitset<Block, Allocator>
 dynamic_bitset<Block, Allocator>::operator>>(size_type n) const
 {
-    dynamic_bitset r(*this);
-    return r >>= n;
+    dynamic_bitset r(size(), 0, get_allocator());
+    if (n < size())
+        m_apply_shifted<detail::dynamic_bitset_impl::op_copy>(
+            r.m_block_data(), m_block_data(), -static_cast<std::ptrdiff_t>(n));
+    return r;
 }
 
-
-//-----------------------------------------------------------------------------
-// basic bit operations
-
 template <typename Block, typename Allocator>
 dynamic_bitset<Block, Allocator>&
-dynamic_bitset<Block, Allocator>::set(size_type pos, bool val)
+dynamic_bitset<Block, Allocator>::or_shifted(const dynamic_bitset& b, std::ptrdiff_t k)
 {
-    assert(pos < m_num_bits);
-
-    if (val)
-        m_bits[block_index(pos)] |= bit_mask(pos);
-    else
-        reset(pos);
+    assert(size() == b.size());
+    m_apply_shifted<detail::dynamic_bitset_impl::op_or>(m_block_data(), b.m_block_data(), k);
+    m_zero_unused_bits();
+    return *this;
+}
 
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>&
+dynamic_bitset<Block, Allocator>::and_shifted(const dynamic_bitset& b, std::ptrdiff_t k)
+{
+    assert(size() == b.size());
+    m_apply_shifted<detail::dynamic_bitset_impl::op_and>(m_block_data(), b.m_block_data(), k);
     return *this;
 }
 
 template <typename Block, typename Allocator>
 dynamic_bitset<Block, Allocator>&
-dynamic_bitset<Block, Allocator>::set()
+dynamic_bitset<Block, Allocator>::xor_shifted(const dynamic_bitset& b, std::ptrdiff_t k)
 {
-  std::fill(m_bits.begin(), m_bits.end(), ~Block(0));
-  m_zero_unused_bits();
-  return *this;
+    assert(size() == b.size());
+    m_apply_shifted<detail::dynamic_bitset_impl::op_xor>(m_block_data(), b.m_block_data(), k);
+    m_zero_unused_bits();
+    return *this;
 }
 
 template <typename Block, typename Allocator>
 dynamic_bitset<Block, Allocator>&
-dynamic_bitset<Block, Allocator>::reset(size_type pos)
+dynamic_bitset<Block, Allocator>::andnot_shifted(const dynamic_bitset& b, std::ptrdiff_t k)
 {
-    assert(pos < m_num_bits);
-#if defined __MWERKS__ && BOOST_WORKAROUND(__MWERKS__, <= 0x3003) // 8.x
-    // CodeWarrior 8 generates incorrect code when the &=~ is compiled,
+    assert(size() == b.size());
+    m_apply_shifted<detail::dynamic_bitset_impl::op_sub>(m_block_data(), b.m_block_data(), k);
+    return *this;
+}
+
+
+//-----------------------------------------------------------------------------
+// basic bit operations
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>&
+dynamic_bitset<Block, Allocator>::set(size_type pos, bool val)
+{
+    assert(pos < size());
+
+    if (val)
+        m_bits[block_index(pos)] |= bit_mask(pos);
+    else
+        reset(pos);
+
+    return *this;
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>&
+dynamic_bitset<Block, Allocator>::set()
+{
+  std::fill(m_bits.begin(), m_bits.end(), ~Block(0));
+  m_zero_unused_bits();
+  return *this;
+}
+
+template <typename Block, typename Allocator>
+inline dynamic_bitset<Block, Allocator>&
+dynamic_bitset<Block, Allocator>::set(size_type pos, size_type len, bool val)
+{
+    if (val)
+        m_range_operation<detail::dynamic_bitset_impl::op_or>(pos, len);
+    else
+        m_range_operation<detail::dynamic_bitset_impl::op_sub>(pos, len);
+    return *this;
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>&
+dynamic_bitset<Block, Allocator>::reset(size_type pos)
+{
+    assert(pos < size());
+#if defined __MWERKS__ && BOOST_WORKAROUND(__MWERKS__, <= 0x3003) // 8.x
+    // CodeWarrior 8 generates incorrect code when the &=~ is compiled,
     // use the |^ variation instead.. <grafik>
     m_bits[block_index(pos)] |= bit_mask(pos);
     m_bits[block_index(pos)] ^= bit_mask(pos);
@@ -940,11 +1396,19 @@ dynamic_bitset<Block, Allocator>::reset()
   return *this;
 }
 
+template <typename Block, typename Allocator>
+inline dynamic_bitset<Block, Allocator>&
+dynamic_bitset<Block, Allocator>::reset(size_type pos, size_type len)
+{
+    m_range_operation<detail::dynamic_bitset_impl::op_sub>(pos, len);
+    return *this;
+}
+
 template <typename Block, typename Allocator>
 dynamic_bitset<Block, Allocator>&
 dynamic_bitset<Block, Allocator>::flip(size_type pos)
 {
-    assert(pos < m_num_bits);
+    assert(pos < size());
     m_bits[block_index(pos)] ^= bit_mask(pos);
     return *this;
 }
@@ -953,12 +1417,20 @@ template <typename Block, typename Allocator>
 dynamic_bitset<Block, Allocator>&
 dynamic_bitset<Block, Allocator>::flip()
 {
-    for (size_type i = 0; i < num_blocks(); ++i)
-        m_bits[i] = ~m_bits[i];
+    using namespace detail::dynamic_bitset_impl;
+    bitwise_blocks<op_not>(m_block_data(), m_block_data(), num_blocks());
     m_zero_unused_bits();
     return *this;
 }
 
+template <typename Block, typename Allocator>
+inline dynamic_bitset<Block, Allocator>&
+dynamic_bitset<Block, Allocator>::flip(size_type pos, size_type len)
+{
+    m_range_operation<detail::dynamic_bitset_impl::op_xor>(pos, len);
+    return *this;
+}
+
 template <typename Block, typename Allocator>
 bool dynamic_bitset<Block, Allocator>::m_unchecked_test(size_type pos) const
 {
@@ -968,17 +1440,14 @@ bool dynamic_bitset<Block, Allocator>::m_unchecked_test(size_type pos) const
 template <typename Block, typename Allocator>
 bool dynamic_bitset<Block, Allocator>::test(size_type pos) const
 {
-    assert(pos < m_num_bits);
+    assert(pos < size());
     return m_unchecked_test(pos);
 }
 
 template <typename Block, typename Allocator>
 bool dynamic_bitset<Block, Allocator>::any() const
 {
-    for (size_type i = 0; i < num_blocks(); ++i)
-        if (m_bits[i])
-            return true;
-    return false;
+    return m_do_find_from(0) != npos;
 }
 
 template <typename Block, typename Allocator>
@@ -987,15 +1456,36 @@ inline bool dynamic_bitset<Block, Allocator>::none() const
     return !any();
 }
 
+#if defined(BOOST_NO_CXX11_RVALUE_REFERENCES) || defined(BOOST_NO_CXX11_REF_QUALIFIERS)
 template <typename Block, typename Allocator>
 dynamic_bitset<Block, Allocator>
 dynamic_bitset<Block, Allocator>::operator~() const
 {
-    dynamic_bitset b(*this);
-    b.flip();
+    using namespace detail::dynamic_bitset_impl;
+    dynamic_bitset b(get_allocator());
+    b.m_assign(bitset_not_expr<bitset_leaf<Block> >(bitset_leaf<Block>(*this)));
+    return b;
+}
+#else
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+dynamic_bitset<Block, Allocator>::operator~() const &
+{
+    using namespace detail::dynamic_bitset_impl;
+    dynamic_bitset b(get_allocator());
+    b.m_assign(bitset_not_expr<bitset_leaf<Block> >(bitset_leaf<Block>(*this)));
     return b;
 }
 
+template <typename Block, typename Allocator>
+inline dynamic_bitset<Block, Allocator>
+dynamic_bitset<Block, Allocator>::operator~() &&
+{
+    flip();
+    return boost::move(*this);
+}
+#endif
+
 template <typename Block, typename Allocator>
 typename dynamic_bitset<Block, Allocator>::size_type
 dynamic_bitset<Block, Allocator>::count() const
@@ -1023,8 +1513,27 @@ dynamic_bitset<Block, Allocator>::count() const
                           ? access_by_bytes
                           : access_by_blocks };
 
-    return do_count(m_bits.begin(), num_blocks(), Block(0),
-                    static_cast<value_to_type<(bool)mode> *>(0));
+    return detail::dynamic_bitset_impl::
+        count_blocks(m_bits.begin(), num_blocks(), Block(0),
+                     static_cast<value_to_type<(bool)mode> *>(0));
+}
+
+template <typename Block, typename Allocator>
+inline bool
+dynamic_bitset<Block, Allocator>::count_at_least(size_type k) const
+{
+    return detail::dynamic_bitset_impl::bitset_leaf<Block>(*this).count_at_least(k);
+}
+
+template <typename Block, typename Allocator>
+inline bool
+dynamic_bitset<Block, Allocator>::
+intersection_count_at_least(const dynamic_bitset& b, size_type k) const
+{
+    assert(size() == b.size());
+    using namespace detail::dynamic_bitset_impl;
+    return bitset_binary_expr<op_and, bitset_leaf<Block>, bitset_leaf<Block> >(
+        bitset_leaf<Block>(*this), bitset_leaf<Block>(b)).count_at_least(k);
 }
 
 
@@ -1036,7 +1545,6 @@ template <typename B, typename A, typename stringT>
 void to_string_helper(const dynamic_bitset<B, A> & b, stringT & s,
                       bool dump_all)
 {
-    typedef typename stringT::traits_type Tr;
     typedef typename stringT::value_type  Ch;
 
     BOOST_DYNAMIC_BITSET_CTYPE_FACET(Ch, fac, std::locale());
@@ -1053,10 +1561,18 @@ void to_string_helper(const dynamic_bitset<B, A> & b, stringT & s,
          b.size();
     s.assign (len, zero);
 
-    for (size_type i = 0; i < len; ++i) {
-        if (b.m_unchecked_test(i))
-            Tr::assign(s[len - 1 - i], one);
-
+    // a chunk at a time, from the most significant one
+    using detail::dynamic_bitset_impl::bit_chars_chunk;
+    char digits[bit_chars_chunk];
+    Ch chars[bit_chars_chunk];
+    for (size_type hi = len; hi != 0; ) {
+        const size_type lo = (hi - 1) / bit_chars_chunk * bit_chars_chunk;
+        detail::dynamic_bitset_impl::format_bit_chars(b.m_block_data(), b.num_blocks(),
+                                                      lo / 64, hi - lo, digits);
+        const Ch * const out = detail::dynamic_bitset_impl::
+            widen_bit_chars(digits, hi - lo, chars, zero, one);
+        std::copy(out, out + (hi - lo), s.begin() + (len - hi));
+        hi = lo;
     }
 
 }
@@ -1101,7 +1617,7 @@ unsigned long dynamic_bitset<Block, Allocator>::
 to_ulong() const
 {
 
-  if (m_num_bits == 0)
+  if (size() == 0)
       return 0; // convention
 
   // Check for overflows. This may be a performance burden on very
@@ -1115,7 +1631,7 @@ to_ulong() const
   typedef unsigned long result_type;
 
   const size_type maximum_size =
-            (std::min)(m_num_bits, static_cast<size_type>(ulong_width));
+            (std::min)(size(), static_cast<size_type>(ulong_width));
 
   const size_type last_block = block_index( maximum_size - 1 );
 
@@ -1134,7 +1650,7 @@ template <typename Block, typename Allocator>
 inline typename dynamic_bitset<Block, Allocator>::size_type
 dynamic_bitset<Block, Allocator>::size() const
 {
-    return m_num_bits;
+    return m_bits.num_bits();
 }
 
 template <typename Block, typename Allocator>
@@ -1177,10 +1693,8 @@ bool dynamic_bitset<Block, Allocator>::
 is_subset_of(const dynamic_bitset<Block, Allocator>& a) const
 {
     assert(size() == a.size());
-    for (size_type i = 0; i < num_blocks(); ++i)
-        if (m_bits[i] & ~a.m_bits[i])
-            return false;
-    return true;
+    return detail::dynamic_bitset_impl::
+        is_subset_blocks(m_block_data(), a.m_block_data(), num_blocks());
 }
 
 template <typename Block, typename Allocator>
@@ -1188,32 +1702,20 @@ bool dynamic_bitset<Block, Allocator>::
 is_proper_subset_of(const dynamic_bitset<Block, Allocator>& a) const
 {
     assert(size() == a.size());
-    assert(num_blocks() == a.num_blocks());
-
-    bool proper = false;
-    for (size_type i = 0; i < num_blocks(); ++i) {
-        const Block & bt =   m_bits[i];
-        const Block & ba = a.m_bits[i];
-
-        if (bt & ~ba)
-            return false; // not a subset at all
-        if (ba & ~bt)
-            proper = true;
-    }
-    return proper;
+    return detail::dynamic_bitset_impl::
+        is_proper_subset_blocks(m_block_data(), a.m_block_data(), num_blocks());
 }
 
 template <typename Block, typename Allocator>
 bool dynamic_bitset<Block, Allocator>::intersects(const dynamic_bitset & b) const
 {
+    using namespace detail::dynamic_bitset_impl;
+
     size_type common_blocks = num_blocks() < b.num_blocks()
                               ? num_blocks() : b.num_blocks();
 
-    for(size_type i = 0; i < common_blocks; ++i) {
-        if(m_bits[i] & b.m_bits[i])
-            return true;
-    }
-    return false;
+    return find_nonzero_block<op_and>(m_block_data(), b.m_block_data(),
+                                      common_blocks) != common_blocks;
 }
 
 // --------------------------------
@@ -1227,53 +1729,108 @@ template <typename Block, typename Allocator>
 typename dynamic_bitset<Block, Allocator>::size_type
 dynamic_bitset<Block, Allocator>::m_do_find_from(size_type first_block) const
 {
-    size_type i = first_block;
+    return detail::dynamic_bitset_impl::
+        find_from_block(m_block_data(), num_blocks(), first_block);
+}
 
-    // skip null blocks
-    while (i < num_blocks() && m_bits[i] == 0)
-        ++i;
 
-    if (i >= num_blocks())
-        return npos; // not found
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+dynamic_bitset<Block, Allocator>::find_first() const
+{
+    return m_do_find_from(0);
+}
 
-    return i * bits_per_block + boost::lowest_bit(m_bits[i]);
 
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+dynamic_bitset<Block, Allocator>::find_next(size_type pos) const
+{
+    return detail::dynamic_bitset_impl::find_next_bit(m_block_data(), size(), pos);
 }
 
 
+// look for the last bit "on", in the
+// blocks with index less than last_block
+//
 template <typename Block, typename Allocator>
 typename dynamic_bitset<Block, Allocator>::size_type
-dynamic_bitset<Block, Allocator>::find_first() const
+dynamic_bitset<Block, Allocator>::m_do_find_before(size_type last_block) const
 {
-    return m_do_find_from(0);
+    return detail::dynamic_bitset_impl::find_before_block(m_block_data(), last_block);
 }
 
 
 template <typename Block, typename Allocator>
 typename dynamic_bitset<Block, Allocator>::size_type
-dynamic_bitset<Block, Allocator>::find_next(size_type pos) const
+dynamic_bitset<Block, Allocator>::find_last() const
 {
+    return m_do_find_before(num_blocks());
+}
 
-    const size_type sz = size();
-    if (pos >= (sz-1) || sz == 0)
-        return npos;
 
-    ++pos;
+// look for the last bit "on" before pos;
+// if pos >= size() the whole bitset is searched
+//
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+dynamic_bitset<Block, Allocator>::find_prev(size_type pos) const
+{
+    return detail::dynamic_bitset_impl::find_prev_bit(m_block_data(), size(), pos);
+}
 
-    const size_type blk = block_index(pos);
-    const block_width_type ind = bit_index(pos);
 
-    // shift bits upto one immediately after current
-    const Block fore = m_bits[blk] >> ind;
+// look for the first bit "off", starting
+// from the block with index first_block
+//
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+dynamic_bitset<Block, Allocator>::m_do_find_zero_from(size_type first_block) const
+{
+    return detail::dynamic_bitset_impl::
+        find_zero_from_block(m_block_data(), size(), first_block);
+}
 
-    return fore?
-        pos + lowest_bit(fore)
-        :
-        m_do_find_from(blk + 1);
 
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+dynamic_bitset<Block, Allocator>::find_first_zero() const
+{
+    return m_do_find_zero_from(0);
 }
 
 
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+dynamic_bitset<Block, Allocator>::find_next_zero(size_type pos) const
+{
+    return detail::dynamic_bitset_impl::find_next_zero_bit(m_block_data(), size(), pos);
+}
+
+
+template <typename Block, typename Allocator>
+inline typename dynamic_bitset<Block, Allocator>::set_bit_range
+dynamic_bitset<Block, Allocator>::set_bits() const
+{
+    return set_bit_range(m_block_data(), num_blocks());
+}
+
+
+// the count is needed first: the vector kernels store whole vectors
+// of positions, and must know where the output ends
+//
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+dynamic_bitset<Block, Allocator>::decode_set_bits(boost::uint32_t* out) const
+{
+    assert(size() == 0 || size() - 1 <= 0xffffffffu);
+
+    const size_type n = count();
+    detail::dynamic_bitset_impl::decode_blocks(m_block_data(), num_blocks(),
+                                               out, out + n);
+    return n;
+}
+
 
 //-----------------------------------------------------------------------------
 // comparison
@@ -1282,8 +1839,9 @@ template <typename Block, typename Allocator>
 bool operator==(const dynamic_bitset<Block, Allocator>& a,
                 const dynamic_bitset<Block, Allocator>& b)
 {
-    return (a.m_num_bits == b.m_num_bits)
-           && (a.m_bits == b.m_bits);
+    return (a.size() == b.size())
+           && detail::dynamic_bitset_impl::
+                  equal_blocks(a.m_block_data(), b.m_block_data(), a.num_blocks());
 }
 
 template <typename Block, typename Allocator>
@@ -1298,22 +1856,32 @@ bool operator<(const dynamic_bitset<Block, Allocator>& a,
                const dynamic_bitset<Block, Allocator>& b)
 {
     assert(a.size() == b.size());
-    typedef typename dynamic_bitset<Block, Allocator>::size_type size_type;
-
-    //if (a.size() == 0)
-    //  return false;
 
     // Since we are storing the most significant bit
     // at pos == size() - 1, we need to do the comparisons in reverse.
     //
-    for (size_type ii = a.num_blocks(); ii > 0; --ii) {
-      size_type i = ii-1;
-      if (a.m_bits[i] < b.m_bits[i])
-        return true;
-      else if (a.m_bits[i] > b.m_bits[i])
-        return false;
-    }
-    return false;
+    return detail::dynamic_bitset_impl::
+        less_blocks(a.m_block_data(), b.m_block_data(), a.num_blocks());
+}
+
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+find_first_difference(const dynamic_bitset<Block, Allocator>& a,
+                      const dynamic_bitset<Block, Allocator>& b)
+{
+    assert(a.size() == b.size());
+    return detail::dynamic_bitset_impl::
+        find_first_difference_blocks(a.m_block_data(), b.m_block_data(), a.num_blocks());
+}
+
+template <typename Block, typename Allocator>
+typename dynamic_bitset<Block, Allocator>::size_type
+find_last_difference(const dynamic_bitset<Block, Allocator>& a,
+                     const dynamic_bitset<Block, Allocator>& b)
+{
+    assert(a.size() == b.size());
+    return detail::dynamic_bitset_impl::
+        find_last_difference_blocks(a.m_block_data(), b.m_block_data(), a.num_blocks());
 }
 
 template <typename Block, typename Allocator>
@@ -1450,14 +2018,24 @@ operator<<(std::basic_ostream<Ch, Tr>& os,
             }
 
             if (err == ok) {
-                // output the bitset
-                for (bitsetsize_type i = b.size(); 0 < i; --i) {
-                    typename buffer_type::int_type
-                        ret = buf->sputc(b.test(i-1)? one : zero);
-                    if (Tr::eq_int_type(Tr::eof(), ret)) {
+                // output the bitset, a chunk at a time from the most
+                // significant one
+                using detail::dynamic_bitset_impl::bit_chars_chunk;
+                char digits[bit_chars_chunk];
+                Ch chars[bit_chars_chunk];
+                for (bitsetsize_type hi = b.size(); hi != 0; ) {
+                    const bitsetsize_type lo = (hi - 1) / bit_chars_chunk * bit_chars_chunk;
+                    const std::size_t n = hi - lo;
+                    detail::dynamic_bitset_impl::format_bit_chars(
+                        b.m_block_data(), b.num_blocks(), lo / 64, n, digits);
+                    const Ch * const out = detail::dynamic_bitset_impl::
+                        widen_bit_chars(digits, n, chars, zero, one);
+                    if (buf->sputn(out, static_cast<streamsize>(n))
+                            != static_cast<streamsize>(n)) {
                         err |= ios_base::failbit;
                         break;
                     }
+                    hi = lo;
                 }
             }
 
@@ -1527,7 +2105,7 @@ operator>>(std::istream& is, dynamic_bitset<Block, Alloc>& b)
         const std::streamsize w = is.width();
         const size_type limit = w > 0 && static_cast<size_type>(w) < b.max_size()
                                                          ? w : b.max_size();
-        typename bitset_type::bit_appender appender(b);
+        typename bitset_type::bit_appender appender;
         std::streambuf * buf = is.rdbuf();
         for(int c = buf->sgetc(); appender.get_count() < limit; c = buf->snextc() ) {
 
@@ -1549,6 +2127,14 @@ operator>>(std::istream& is, dynamic_bitset<Block, Alloc>& b)
             }
 
         } // for
+
+        try {
+            appender.finish(b);
+        }
+        catch(...) {
+            is.setstate(std::ios::failbit); // assume this can't throw
+            throw;
+        }
     }
 
     is.width(0);
@@ -1562,6 +2148,88 @@ operator>>(std::istream& is, dynamic_bitset<Block, Alloc>& b)
 
 #else // BOOST_OLD_IOSTREAMS
 
+namespace detail {
+namespace dynamic_bitset_impl {
+
+    // The get area of any stream buffer: gptr(), egptr() and gbump() are
+    // protected, but a pointer to them can be formed in a derived class
+    // and applied to another buffer.
+    template <typename Ch, typename Tr>
+    class get_area : public std::basic_streambuf<Ch, Tr> {
+        typedef std::basic_streambuf<Ch, Tr> buffer_type;
+    public:
+        static const Ch * begin(buffer_type * b) { return (b->*&get_area::gptr)(); }
+        static const Ch * end(buffer_type * b) { return (b->*&get_area::egptr)(); }
+        static void skip(buffer_type * b, std::size_t n) {
+            (b->*&get_area::gbump)(static_cast<int>(n));
+        }
+    };
+
+    // '0' and '1' straight from the get area, as many as it holds at
+    // each step; one character at a time through sbumpc() from a buffer
+    // without a get area. Returns false at the first other character,
+    // which is left in the buffer.
+    template <typename Tr, typename Appender>
+    bool read_bit_chars(std::basic_streambuf<char, Tr> * buf, std::size_t limit,
+                        Appender & appender, const std::locale &)
+    {
+        typedef get_area<char, Tr> area;
+        while (appender.get_count() < limit) {
+            const typename Tr::int_type c = buf->sgetc();
+            if (Tr::eq_int_type(Tr::eof(), c))
+                return true;
+
+            const char * const p = area::begin(buf);
+            const std::size_t avail = static_cast<std::size_t>(area::end(buf) - p);
+            if (avail == 0) {
+                const char ch = Tr::to_char_type(c);
+                if ((ch & ~1) != '0')
+                    return false;
+                appender.do_append(ch == '1');
+                buf->sbumpc();
+                continue;
+            }
+
+            // gbump() takes an int
+            const std::size_t n = (std::min)((std::min)(avail, limit - appender.get_count()),
+                                             std::size_t(INT_MAX));
+            const std::size_t used = appender.append_chars(p, n);
+            area::skip(buf, used);
+            if (used < n)
+                return false;
+        }
+        return true;
+    }
+
+    template <typename Ch, typename Tr, typename Appender>
+    bool read_bit_chars(std::basic_streambuf<Ch, Tr> * buf, std::size_t limit,
+                        Appender & appender, const std::locale & loc)
+    {
+        // in accordance with prop. resol. of lib DR 303 [last checked 4 Feb 2004]
+        BOOST_DYNAMIC_BITSET_CTYPE_FACET(Ch, fac, loc);
+        const Ch zero = BOOST_DYNAMIC_BITSET_WIDEN_CHAR(fac, '0');
+        const Ch one  = BOOST_DYNAMIC_BITSET_WIDEN_CHAR(fac, '1');
+
+        typename Tr::int_type c = buf->sgetc();
+        for( ; appender.get_count() < limit; c = buf->snextc() ) {
+
+            if (Tr::eq_int_type(Tr::eof(), c))
+                return true;
+
+            const Ch to_c = Tr::to_char_type(c);
+            const bool is_one = Tr::eq(to_c, one);
+
+            if (!is_one && !Tr::eq(to_c, zero))
+                return false; // non digit character
+
+            appender.do_append(is_one);
+        }
+        return true;
+    }
+
+} // namespace dynamic_bitset_impl
+} // namespace detail
+
 template <typename Ch, typename Tr, typename Block, typename Alloc>
 std::basic_istream<Ch, Tr>&
 operator>>(std::basic_istream<Ch, Tr>& is, dynamic_bitset<Block, Alloc>& b)
@@ -1580,41 +2248,20 @@ operator>>(std::basic_istream<Ch, Tr>& is, dynamic_bitset<Block, Alloc>& b)
     typename basic_istream<Ch, Tr>::sentry cerberos(is); // skips whitespaces
     if(cerberos) {
 
-        // in accordance with prop. resol. of lib DR 303 [last checked 4 Feb 2004]
-        BOOST_DYNAMIC_BITSET_CTYPE_FACET(Ch, fac, is.getloc());
-        const Ch zero = BOOST_DYNAMIC_BITSET_WIDEN_CHAR(fac, '0');
-        const Ch one  = BOOST_DYNAMIC_BITSET_WIDEN_CHAR(fac, '1');
-
         b.clear();
         try {
-            typename bitset_type::bit_appender appender(b);
-            basic_streambuf <Ch, Tr> * buf = is.rdbuf();
-            typename Tr::int_type c = buf->sgetc();
-            for( ; appender.get_count() < limit; c = buf->snextc() ) {
-
-                if (Tr::eq_int_type(Tr::eof(), c)) {
-                    err |= ios_base::eofbit;
-                    break;
-                }
-                else {
-                    const Ch to_c = Tr::to_char_type(c);
-                    const bool is_one = Tr::eq(to_c, one);
-
-                    if (!is_one && !Tr::eq(to_c, zero))
-                        break; // non digit character
-
-                    appender.do_append(is_one);
-
-                }
-
-            } // for
+            typename bitset_type::bit_appender appender;
+            if (detail::dynamic_bitset_impl::read_bit_chars(is.rdbuf(), limit,
+                                                            appender, is.getloc())
+                && appender.get_count() < limit)
+                err |= ios_base::eofbit;
+            appender.finish(b);
         }
         catch (...) {
             // catches from stream buf, or from vector:
             //
-            // bits_stored bits have been extracted and stored, and
             // either no further character is extractable or we can't
-            // append to the underlying vector (out of memory)
+            // store the bits (out of memory); b is left empty
 
             bool rethrow = false;   // see std 27.6.1.1/4
             try { is.setstate(ios_base::badbit); }
@@ -1642,14 +2289,21 @@ operator>>(std::basic_istream<Ch, Tr>& is, dynamic_bitset<Block, Alloc>& b)
 
 //-----------------------------------------------------------------------------
 // bitset operations
+//
+// The result is written in a single pass over both operands, a chunk
+// of blocks at a time (see detail/dynamic_bitset_expr.hpp), rather
+// than copied from x and then combined with y.
 
 template <typename Block, typename Allocator>
 dynamic_bitset<Block, Allocator>
 operator&(const dynamic_bitset<Block, Allocator>& x,
           const dynamic_bitset<Block, Allocator>& y)
 {
-    dynamic_bitset<Block, Allocator> b(x);
-    return b &= y;
+    using namespace detail::dynamic_bitset_impl;
+    dynamic_bitset<Block, Allocator> b(x.get_allocator());
+    b.m_assign(bitset_binary_expr<op_and, bitset_leaf<Block>, bitset_leaf<Block> >(
+        bitset_leaf<Block>(x), bitset_leaf<Block>(y)));
+    return b;
 }
 
 template <typename Block, typename Allocator>
@@ -1657,8 +2311,11 @@ dynamic_bitset<Block, Allocator>
 operator|(const dynamic_bitset<Block, Allocator>& x,
           const dynamic_bitset<Block, Allocator>& y)
 {
-    dynamic_bitset<Block, Allocator> b(x);
-    return b |= y;
+    using namespace detail::dynamic_bitset_impl;
+    dynamic_bitset<Block, Allocator> b(x.get_allocator());
+    b.m_assign(bitset_binary_expr<op_or, bitset_leaf<Block>, bitset_leaf<Block> >(
+        bitset_leaf<Block>(x), bitset_leaf<Block>(y)));
+    return b;
 }
 
 template <typename Block, typename Allocator>
@@ -1666,8 +2323,11 @@ dynamic_bitset<Block, Allocator>
 operator^(const dynamic_bitset<Block, Allocator>& x,
           const dynamic_bitset<Block, Allocator>& y)
 {
-    dynamic_bitset<Block, Allocator> b(x);
-    return b ^= y;
+    using namespace detail::dynamic_bitset_impl;
+    dynamic_bitset<Block, Allocator> b(x.get_allocator());
+    b.m_assign(bitset_binary_expr<op_xor, bitset_leaf<Block>, bitset_leaf<Block> >(
+        bitset_leaf<Block>(x), bitset_leaf<Block>(y)));
+    return b;
 }
 
 template <typename Block, typename Allocator>
@@ -1675,8 +2335,179 @@ dynamic_bitset<Block, Allocator>
 operator-(const dynamic_bitset<Block, Allocator>& x,
           const dynamic_bitset<Block, Allocator>& y)
 {
-    dynamic_bitset<Block, Allocator> b(x);
-    return b -= y;
+    using namespace detail::dynamic_bitset_impl;
+    dynamic_bitset<Block, Allocator> b(x.get_allocator());
+    b.m_assign(bitset_binary_expr<op_sub, bitset_leaf<Block>, bitset_leaf<Block> >(
+        bitset_leaf<Block>(x), bitset_leaf<Block>(y)));
+    return b;
+}
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+
+// NOTE:
+//  The result is computed in place, in the buffer of an rvalue
+//  operand, and then moved out: so an expression like f() & a
+//  doesn't allocate at all. &, | and ^ are commutative, so the
+//  second operand can be reused as well; for - the swapped
+//  subtraction (y = x & ~y) is used.
+//
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator&(dynamic_bitset<Block, Allocator>&& x,
+          const dynamic_bitset<Block, Allocator>& y)
+{
+    x &= y;
+    return boost::move(x);
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator&(const dynamic_bitset<Block, Allocator>& x,
+          dynamic_bitset<Block, Allocator>&& y)
+{
+    y &= x;
+    return boost::move(y);
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator&(dynamic_bitset<Block, Allocator>&& x,
+          dynamic_bitset<Block, Allocator>&& y)
+{
+    x &= y;
+    return boost::move(x);
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator|(dynamic_bitset<Block, Allocator>&& x,
+          const dynamic_bitset<Block, Allocator>& y)
+{
+    x |= y;
+    return boost::move(x);
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator|(const dynamic_bitset<Block, Allocator>& x,
+          dynamic_bitset<Block, Allocator>&& y)
+{
+    y |= x;
+    return boost::move(y);
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator|(dynamic_bitset<Block, Allocator>&& x,
+          dynamic_bitset<Block, Allocator>&& y)
+{
+    x |= y;
+    return boost::move(x);
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator^(dynamic_bitset<Block, Allocator>&& x,
+          const dynamic_bitset<Block, Allocator>& y)
+{
+    x ^= y;
+    return boost::move(x);
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator^(const dynamic_bitset<Block, Allocator>& x,
+          dynamic_bitset<Block, Allocator>&& y)
+{
+    y ^= x;
+    return boost::move(y);
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator^(dynamic_bitset<Block, Allocator>&& x,
+          dynamic_bitset<Block, Allocator>&& y)
+{
+    x ^= y;
+    return boost::move(x);
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator-(dynamic_bitset<Block, Allocator>&& x,
+          const dynamic_bitset<Block, Allocator>& y)
+{
+    x -= y;
+    return boost::move(x);
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator-(const dynamic_bitset<Block, Allocator>& x,
+          dynamic_bitset<Block, Allocator>&& y)
+{
+    assert(x.size() == y.size());
+    using namespace detail::dynamic_bitset_impl;
+    bitwise_blocks<op_rsub>(y.m_block_data(), x.m_block_data(), y.num_blocks());
+    return boost::move(y);
+}
+
+template <typename Block, typename Allocator>
+dynamic_bitset<Block, Allocator>
+operator-(dynamic_bitset<Block, Allocator>&& x,
+          dynamic_bitset<Block, Allocator>&& y)
+{
+    x -= y;
+    return boost::move(x);
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+// population counts of bitset operations
+//
+// These go through the count() of the internal expressions, which uses
+// the binary count kernels: a and b are read once, and a op b is never
+// stored.
+
+template <typename Block, typename Allocator>
+inline typename dynamic_bitset<Block, Allocator>::size_type
+intersection_count(const dynamic_bitset<Block, Allocator>& a,
+                   const dynamic_bitset<Block, Allocator>& b)
+{
+    using namespace detail::dynamic_bitset_impl;
+    return bitset_binary_expr<op_and, bitset_leaf<Block>, bitset_leaf<Block> >(
+        bitset_leaf<Block>(a), bitset_leaf<Block>(b)).count();
+}
+
+template <typename Block, typename Allocator>
+inline typename dynamic_bitset<Block, Allocator>::size_type
+union_count(const dynamic_bitset<Block, Allocator>& a,
+            const dynamic_bitset<Block, Allocator>& b)
+{
+    using namespace detail::dynamic_bitset_impl;
+    return bitset_binary_expr<op_or, bitset_leaf<Block>, bitset_leaf<Block> >(
+        bitset_leaf<Block>(a), bitset_leaf<Block>(b)).count();
+}
+
+template <typename Block, typename Allocator>
+inline typename dynamic_bitset<Block, Allocator>::size_type
+difference_count(const dynamic_bitset<Block, Allocator>& a,
+                 const dynamic_bitset<Block, Allocator>& b)
+{
+    using namespace detail::dynamic_bitset_impl;
+    return bitset_binary_expr<op_sub, bitset_leaf<Block>, bitset_leaf<Block> >(
+        bitset_leaf<Block>(a), bitset_leaf<Block>(b)).count();
+}
+
+template <typename Block, typename Allocator>
+inline typename dynamic_bitset<Block, Allocator>::size_type
+hamming_distance(const dynamic_bitset<Block, Allocator>& a,
+                 const dynamic_bitset<Block, Allocator>& b)
+{
+    using namespace detail::dynamic_bitset_impl;
+    return bitset_binary_expr<op_xor, bitset_leaf<Block>, bitset_leaf<Block> >(
+        bitset_leaf<Block>(a), bitset_leaf<Block>(b)).count();
 }
 
 //-----------------------------------------------------------------------------
@@ -1730,7 +2561,7 @@ inline const Block& dynamic_bitset<Block, Allocator>::m_highest_block() const
 template <typename Block, typename Allocator>
 inline void dynamic_bitset<Block, Allocator>::m_zero_unused_bits()
 {
-    assert (num_blocks() == calc_num_blocks(m_num_bits));
+    assert (num_blocks() == calc_num_blocks(size()));
 
     // if != 0 this is the number of bits used in the last block
     const block_width_type extra_bits = count_extra_bits();
@@ -1761,6 +2592,24 @@ bool dynamic_bitset<Block, Allocator>::m_check_invariants() const
 } // namespace boost
 
 
+#if !defined(BOOST_NO_CXX11_HDR_FUNCTIONAL)
+
+namespace std {
+
+template <typename Block, typename Allocator>
+struct hash< boost::dynamic_bitset<Block, Allocator> >
+{
+    std::size_t operator()(const boost::dynamic_bitset<Block, Allocator>& b) const
+    {
+        return hash_value(b);
+    }
+};
+
+} // namespace std
+
+#endif
+
+
 #undef BOOST_BITSET_CHAR
 
 #endif // include guard
@@ -0,0 +1,130 @@
+// -----------------------------------------------------------
+// dynamic_bitset_hasher.hpp
+//
+//       The hash of a dynamic_bitset, kept up to date as bits
+//       are appended
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DYNAMIC_BITSET_DYNAMIC_BITSET_HASHER_HPP
+#define BOOST_DYNAMIC_BITSET_DYNAMIC_BITSET_HASHER_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include "boost/limits.hpp"
+#include "boost/cstdint.hpp"
+#include "boost/static_assert.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset_view.hpp"
+#include "boost/detail/dynamic_bitset_kernels.hpp"
+
+
+namespace boost {
+
+// The hash of a sequence of bits which only grows, as a bitset built
+// with push_back() and append(): value() is the hash_value() of a
+// dynamic_bitset holding the bits appended so far, and takes constant
+// time. Appending costs the same per bit as hash_value(), whatever the
+// block type.
+//
+template <typename Block = unsigned long>
+class dynamic_bitset_hasher
+{
+    BOOST_STATIC_ASSERT(std::numeric_limits<Block>::digits <= 64);
+
+public:
+    typedef Block block_type;
+    typedef std::size_t size_type;
+
+    BOOST_STATIC_CONSTANT(int, bits_per_block = (std::numeric_limits<Block>::digits));
+
+    dynamic_bitset_hasher()
+        : m_pending(0), m_current(0), m_num_bits(0)
+    {}
+
+    // starts from the bits of b
+    template <typename Allocator>
+    explicit dynamic_bitset_hasher(const dynamic_bitset<Block, Allocator>& b)
+        : m_pending(0), m_current(0), m_num_bits(0)
+    {
+        const Block * const p = dynamic_bitset_view<const Block>(b).data();
+        const size_type num_words = b.size() / 64;
+        for (size_type t = 0; t < num_words; ++t)
+            m_push_word(detail::dynamic_bitset_impl::load_bits64(p, b.num_blocks(), t));
+        m_num_bits = b.size();
+        if (m_num_bits % 64 != 0)
+            m_current = detail::dynamic_bitset_impl::load_bits64(p, b.num_blocks(), num_words);
+    }
+
+    void push_back(bool bit)
+    {
+        m_current |= static_cast<boost::uint64_t>(bit) << (m_num_bits % 64);
+        ++m_num_bits;
+        if (m_num_bits % 64 == 0)
+            m_push_word(m_current);
+    }
+
+    // the bits of block, as dynamic_bitset::append(Block)
+    void append(Block block)
+    {
+        const size_type offset = m_num_bits % 64;
+        m_current |= static_cast<boost::uint64_t>(block) << offset;
+        m_num_bits += bits_per_block;
+        if (offset + bits_per_block >= 64) {
+            m_push_word(m_current);
+            if (offset + bits_per_block > 64)
+                m_current = static_cast<boost::uint64_t>(block) >> (64 - offset);
+        }
+    }
+
+    template <typename BlockInputIterator>
+    void append(BlockInputIterator first, BlockInputIterator last)
+    {
+        for ( ; first != last; ++first)
+            append(static_cast<Block>(*first));
+    }
+
+    size_type size() const { return m_num_bits; }
+
+    std::size_t value() const
+    {
+        using namespace detail::dynamic_bitset_impl;
+
+        hash_state h = m_state;
+        boost::uint64_t w[hash_stripe_words];
+        std::copy(m_words, m_words + m_pending, w);
+        std::size_t n = m_pending;
+        if (m_num_bits % 64 != 0)
+            w[n++] = m_current;
+        if (n == hash_stripe_words) {
+            h.stripe(w);
+            n = 0;
+        }
+        return static_cast<std::size_t>(h.finish(w, n, m_num_bits));
+    }
+
+private:
+    void m_push_word(boost::uint64_t w)
+    {
+        m_words[m_pending++] = w;
+        m_current = 0;
+        if (m_pending == detail::dynamic_bitset_impl::hash_stripe_words) {
+            m_state.stripe(m_words);
+            m_pending = 0;
+        }
+    }
+
+    detail::dynamic_bitset_impl::hash_state m_state;
+    boost::uint64_t m_words[detail::dynamic_bitset_impl::hash_stripe_words];
+    std::size_t m_pending;      // full words in m_words
+    boost::uint64_t m_current;  // the bits beyond them
+    size_type m_num_bits;
+};
+
+} // namespace boost
+
+#endif // include guard
@@ -0,0 +1,435 @@
+// -----------------------------------------------------------
+// dynamic_bitset_view.hpp
+//
+//       A non-owning view of blocks as a bitset, with the
+//       algorithms of dynamic_bitset
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DYNAMIC_BITSET_DYNAMIC_BITSET_VIEW_HPP
+#define BOOST_DYNAMIC_BITSET_DYNAMIC_BITSET_VIEW_HPP
+
+#include <assert.h>
+#include <cstddef>
+#include <algorithm>
+#include "boost/limits.hpp"
+#include "boost/static_assert.hpp"
+#include "boost/core/enable_if.hpp"
+#include "boost/type_traits/is_const.hpp"
+#include "boost/type_traits/is_same.hpp"
+#include "boost/type_traits/remove_const.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset.hpp"
+#include "boost/detail/dynamic_bitset_kernels.hpp"
+#include "boost/detail/dynamic_bitset_iterator.hpp"
+
+
+namespace boost {
+
+// num_bits bits in blocks owned by someone else: a network buffer, a
+// memory-mapped file, another container, a dynamic_bitset. The bits are
+// laid out as in dynamic_bitset, bit i in bit i % bits_per_block of
+// block i / bits_per_block, and the bits of the last block beyond
+// num_bits must be off (the queries count them).
+//
+// dynamic_bitset_view<const Block> only reads the blocks, and is
+// constructed from a dynamic_bitset_view<Block> as well;
+// dynamic_bitset_view<Block> also has the modifiers. The lookups,
+// count(), the comparisons and the bitwise operators are the kernels
+// of dynamic_bitset. Nothing is allocated or copied: a view is a
+// pointer and a size, and is invalidated with the blocks.
+//
+template <typename Block>
+class dynamic_bitset_view
+{
+public:
+    typedef typename boost::remove_const<Block>::type block_type;
+    typedef std::size_t size_type;
+    typedef dynamic_bitset_view<const block_type> const_view;
+    typedef detail::dynamic_bitset_impl::set_bit_range<block_type> set_bit_range;
+
+    BOOST_STATIC_CONSTANT(int, bits_per_block = (std::numeric_limits<block_type>::digits));
+    BOOST_STATIC_CONSTANT(size_type, npos = static_cast<size_type>(-1));
+
+    dynamic_bitset_view() : m_data(0), m_num_bits(0) {}
+
+    // PRE: data points to (at least) num_bits bits
+    dynamic_bitset_view(Block* data, size_type num_bits)
+        : m_data(data), m_num_bits(num_bits)
+    {}
+
+    // a view of a const bitset is a dynamic_bitset_view<const Block>
+    template <typename Allocator>
+    dynamic_bitset_view(dynamic_bitset<block_type, Allocator>& b)
+        : m_data(b.m_block_data()), m_num_bits(b.size())
+    {}
+
+    template <typename Allocator>
+    dynamic_bitset_view(const dynamic_bitset<block_type, Allocator>& b,
+                        typename boost::enable_if<boost::is_const<Block>,
+                                                  Allocator>::type* = 0)
+        : m_data(b.m_block_data()), m_num_bits(b.size())
+    {}
+
+    dynamic_bitset_view(const dynamic_bitset_view<block_type>& v)
+        : m_data(v.data()), m_num_bits(v.size())
+    {}
+
+    Block* data() const { return m_data; }
+    size_type size() const { return m_num_bits; }
+    size_type num_blocks() const;
+    bool empty() const { return m_num_bits == 0; }
+
+    // basic bit operations, for views of non-const blocks
+    dynamic_bitset_view& set(size_type pos, bool val = true);
+    dynamic_bitset_view& set();
+    dynamic_bitset_view& reset(size_type pos);
+    dynamic_bitset_view& reset();
+    dynamic_bitset_view& flip(size_type pos);
+    dynamic_bitset_view& flip();
+
+    // PRE: x.size() == size()
+    dynamic_bitset_view& operator&=(const const_view& x);
+    dynamic_bitset_view& operator|=(const const_view& x);
+    dynamic_bitset_view& operator^=(const const_view& x);
+    dynamic_bitset_view& operator-=(const const_view& x);
+
+    bool test(size_type pos) const;
+    bool operator[](size_type pos) const { return test(pos); }
+    size_type count() const;
+    bool any() const { return find_first() != npos; }
+    bool none() const { return !any(); }
+
+    // PRE: a.size() == size()
+    bool is_subset_of(const const_view& a) const;
+    bool is_proper_subset_of(const const_view& a) const;
+    bool intersects(const const_view& a) const;
+
+    // lookup, as in dynamic_bitset
+    size_type find_first() const;
+    size_type find_next(size_type pos) const;
+    size_type find_last() const;
+    size_type find_prev(size_type pos) const;
+    size_type find_first_zero() const;
+    size_type find_next_zero(size_type pos) const;
+    set_bit_range set_bits() const;
+
+private:
+    void m_zero_unused_bits();
+
+    Block* m_data;
+    size_type m_num_bits;
+};
+
+template <typename Block>
+const int dynamic_bitset_view<Block>::bits_per_block;
+
+template <typename Block>
+const typename dynamic_bitset_view<Block>::size_type
+dynamic_bitset_view<Block>::npos;
+
+
+template <typename Block>
+inline typename dynamic_bitset_view<Block>::size_type
+dynamic_bitset_view<Block>::num_blocks() const
+{
+    return detail::dynamic_bitset_impl::blocks_for_bits<block_type>(m_num_bits);
+}
+
+// --------------------------------
+// modifiers
+
+template <typename Block>
+dynamic_bitset_view<Block>&
+dynamic_bitset_view<Block>::set(size_type pos, bool val)
+{
+    assert(pos < m_num_bits);
+    const block_type mask = static_cast<block_type>(block_type(1) << (pos % bits_per_block));
+    if (val)
+        m_data[pos / bits_per_block] |= mask;
+    else
+        m_data[pos / bits_per_block] &= static_cast<block_type>(~mask);
+    return *this;
+}
+
+template <typename Block>
+dynamic_bitset_view<Block>& dynamic_bitset_view<Block>::set()
+{
+    std::fill(m_data, m_data + num_blocks(), static_cast<block_type>(~block_type(0)));
+    m_zero_unused_bits();
+    return *this;
+}
+
+template <typename Block>
+inline dynamic_bitset_view<Block>&
+dynamic_bitset_view<Block>::reset(size_type pos)
+{
+    return set(pos, false);
+}
+
+template <typename Block>
+dynamic_bitset_view<Block>& dynamic_bitset_view<Block>::reset()
+{
+    std::fill(m_data, m_data + num_blocks(), block_type(0));
+    return *this;
+}
+
+template <typename Block>
+dynamic_bitset_view<Block>&
+dynamic_bitset_view<Block>::flip(size_type pos)
+{
+    assert(pos < m_num_bits);
+    m_data[pos / bits_per_block] ^= static_cast<block_type>(block_type(1) << (pos % bits_per_block));
+    return *this;
+}
+
+template <typename Block>
+dynamic_bitset_view<Block>& dynamic_bitset_view<Block>::flip()
+{
+    using namespace detail::dynamic_bitset_impl;
+    bitwise_blocks<op_not>(m_data, m_data, num_blocks());
+    m_zero_unused_bits();
+    return *this;
+}
+
+template <typename Block>
+dynamic_bitset_view<Block>&
+dynamic_bitset_view<Block>::operator&=(const const_view& x)
+{
+    assert(size() == x.size());
+    using namespace detail::dynamic_bitset_impl;
+    bitwise_blocks<op_and>(m_data, x.data(), num_blocks());
+    return *this;
+}
+
+template <typename Block>
+dynamic_bitset_view<Block>&
+dynamic_bitset_view<Block>::operator|=(const const_view& x)
+{
+    assert(size() == x.size());
+    using namespace detail::dynamic_bitset_impl;
+    bitwise_blocks<op_or>(m_data, x.data(), num_blocks());
+    return *this;
+}
+
+template <typename Block>
+dynamic_bitset_view<Block>&
+dynamic_bitset_view<Block>::operator^=(const const_view& x)
+{
+    assert(size() == x.size());
+    using namespace detail::dynamic_bitset_impl;
+    bitwise_blocks<op_xor>(m_data, x.data(), num_blocks());
+    return *this;
+}
+
+template <typename Block>
+dynamic_bitset_view<Block>&
+dynamic_bitset_view<Block>::operator-=(const const_view& x)
+{
+    assert(size() == x.size());
+    using namespace detail::dynamic_bitset_impl;
+    bitwise_blocks<op_sub>(m_data, x.data(), num_blocks());
+    return *this;
+}
+
+template <typename Block>
+void dynamic_bitset_view<Block>::m_zero_unused_bits()
+{
+    const size_type extra_bits = m_num_bits % bits_per_block;
+    const block_type all = static_cast<block_type>(~block_type(0));
+    if (extra_bits != 0)
+        m_data[num_blocks() - 1] &= static_cast<block_type>(~(all << extra_bits));
+}
+
+// --------------------------------
+// queries
+
+template <typename Block>
+inline bool dynamic_bitset_view<Block>::test(size_type pos) const
+{
+    assert(pos < m_num_bits);
+    return ((m_data[pos / bits_per_block] >> (pos % bits_per_block)) & 1) != 0;
+}
+
+template <typename Block>
+inline typename dynamic_bitset_view<Block>::size_type
+dynamic_bitset_view<Block>::count() const
+{
+    return detail::dynamic_bitset_impl::count_block_range(
+        static_cast<const block_type*>(m_data), num_blocks());
+}
+
+template <typename Block>
+inline bool dynamic_bitset_view<Block>::is_subset_of(const const_view& a) const
+{
+    assert(size() == a.size());
+    return detail::dynamic_bitset_impl::
+        is_subset_blocks(static_cast<const block_type*>(m_data), a.data(), num_blocks());
+}
+
+template <typename Block>
+inline bool dynamic_bitset_view<Block>::is_proper_subset_of(const const_view& a) const
+{
+    assert(size() == a.size());
+    return detail::dynamic_bitset_impl::
+        is_proper_subset_blocks(static_cast<const block_type*>(m_data), a.data(), num_blocks());
+}
+
+template <typename Block>
+inline bool dynamic_bitset_view<Block>::intersects(const const_view& a) const
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    assert(size() == a.size());
+    const block_type* const p = m_data;
+    return find_nonzero_block<op_and>(p, a.data(), num_blocks()) != num_blocks();
+}
+
+// --------------------------------
+// lookup
+
+template <typename Block>
+inline typename dynamic_bitset_view<Block>::size_type
+dynamic_bitset_view<Block>::find_first() const
+{
+    return detail::dynamic_bitset_impl::
+        find_from_block(static_cast<const block_type*>(m_data), num_blocks(), 0);
+}
+
+template <typename Block>
+inline typename dynamic_bitset_view<Block>::size_type
+dynamic_bitset_view<Block>::find_next(size_type pos) const
+{
+    return detail::dynamic_bitset_impl::
+        find_next_bit(static_cast<const block_type*>(m_data), m_num_bits, pos);
+}
+
+template <typename Block>
+inline typename dynamic_bitset_view<Block>::size_type
+dynamic_bitset_view<Block>::find_last() const
+{
+    return detail::dynamic_bitset_impl::
+        find_before_block(static_cast<const block_type*>(m_data), num_blocks());
+}
+
+template <typename Block>
+inline typename dynamic_bitset_view<Block>::size_type
+dynamic_bitset_view<Block>::find_prev(size_type pos) const
+{
+    return detail::dynamic_bitset_impl::
+        find_prev_bit(static_cast<const block_type*>(m_data), m_num_bits, pos);
+}
+
+template <typename Block>
+inline typename dynamic_bitset_view<Block>::size_type
+dynamic_bitset_view<Block>::find_first_zero() const
+{
+    return detail::dynamic_bitset_impl::
+        find_zero_from_block(static_cast<const block_type*>(m_data), m_num_bits, 0);
+}
+
+template <typename Block>
+inline typename dynamic_bitset_view<Block>::size_type
+dynamic_bitset_view<Block>::find_next_zero(size_type pos) const
+{
+    return detail::dynamic_bitset_impl::
+        find_next_zero_bit(static_cast<const block_type*>(m_data), m_num_bits, pos);
+}
+
+template <typename Block>
+inline typename dynamic_bitset_view<Block>::set_bit_range
+dynamic_bitset_view<Block>::set_bits() const
+{
+    return set_bit_range(m_data, num_blocks());
+}
+
+//-----------------------------------------------------------------------------
+// comparison, between views of const and non-const blocks alike
+
+template <typename B1, typename B2>
+bool operator==(const dynamic_bitset_view<B1>& a, const dynamic_bitset_view<B2>& b)
+{
+    using namespace detail::dynamic_bitset_impl;
+    typedef typename dynamic_bitset_view<B1>::block_type block_type;
+    BOOST_STATIC_ASSERT((boost::is_same<block_type,
+                         typename dynamic_bitset_view<B2>::block_type>::value));
+
+    const block_type* const p = a.data();
+    const block_type* const q = b.data();
+    return a.size() == b.size() && equal_blocks(p, q, a.num_blocks());
+}
+
+template <typename B1, typename B2>
+inline bool operator!=(const dynamic_bitset_view<B1>& a, const dynamic_bitset_view<B2>& b)
+{
+    return !(a == b);
+}
+
+// PRE: a.size() == b.size()
+template <typename B1, typename B2>
+bool operator<(const dynamic_bitset_view<B1>& a, const dynamic_bitset_view<B2>& b)
+{
+    typedef typename dynamic_bitset_view<B1>::block_type block_type;
+    BOOST_STATIC_ASSERT((boost::is_same<block_type,
+                         typename dynamic_bitset_view<B2>::block_type>::value));
+
+    assert(a.size() == b.size());
+    const block_type* const p = a.data();
+    const block_type* const q = b.data();
+    return detail::dynamic_bitset_impl::less_blocks(p, q, a.num_blocks());
+}
+
+// the lowest and the highest positions at which a and b differ, or npos
+// PRE: a.size() == b.size()
+template <typename B1, typename B2>
+typename dynamic_bitset_view<B1>::size_type
+find_first_difference(const dynamic_bitset_view<B1>& a, const dynamic_bitset_view<B2>& b)
+{
+    typedef typename dynamic_bitset_view<B1>::block_type block_type;
+    BOOST_STATIC_ASSERT((boost::is_same<block_type,
+                         typename dynamic_bitset_view<B2>::block_type>::value));
+
+    assert(a.size() == b.size());
+    const block_type* const p = a.data();
+    const block_type* const q = b.data();
+    return detail::dynamic_bitset_impl::find_first_difference_blocks(p, q, a.num_blocks());
+}
+
+template <typename B1, typename B2>
+typename dynamic_bitset_view<B1>::size_type
+find_last_difference(const dynamic_bitset_view<B1>& a, const dynamic_bitset_view<B2>& b)
+{
+    typedef typename dynamic_bitset_view<B1>::block_type block_type;
+    BOOST_STATIC_ASSERT((boost::is_same<block_type,
+                         typename dynamic_bitset_view<B2>::block_type>::value));
+
+    assert(a.size() == b.size());
+    const block_type* const p = a.data();
+    const block_type* const q = b.data();
+    return detail::dynamic_bitset_impl::find_last_difference_blocks(p, q, a.num_blocks());
+}
+
+template <typename B1, typename B2>
+inline bool operator<=(const dynamic_bitset_view<B1>& a, const dynamic_bitset_view<B2>& b)
+{
+    return !(b < a);
+}
+
+template <typename B1, typename B2>
+inline bool operator>(const dynamic_bitset_view<B1>& a, const dynamic_bitset_view<B2>& b)
+{
+    return b < a;
+}
+
+template <typename B1, typename B2>
+inline bool operator>=(const dynamic_bitset_view<B1>& a, const dynamic_bitset_view<B2>& b)
+{
+    return !(a < b);
+}
+
+} // namespace boost
+
+#endif // include guard
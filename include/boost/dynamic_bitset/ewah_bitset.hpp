@@ -0,0 +1,642 @@
+// -----------------------------------------------------------
+// ewah_bitset.hpp
+//
+//       A run-length compressed bitset (EWAH), with the bitwise
+//       operations done on the compressed words
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DYNAMIC_BITSET_EWAH_BITSET_HPP
+#define BOOST_DYNAMIC_BITSET_EWAH_BITSET_HPP
+
+#include <assert.h>
+#include <cstddef>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include "boost/limits.hpp"
+#include "boost/cstdint.hpp"
+#include "boost/pending/lowest_bit.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset.hpp"
+
+
+namespace boost {
+
+  namespace detail {
+  namespace dynamic_bitset_impl {
+
+    // An EWAH marker word: bit 0 is the bit of a run of clean (all 0 or
+    // all 1) words, the next half of the word its length, and the rest
+    // the number of literal words which follow the marker.
+    //
+    template <typename Block>
+    struct ewah_marker
+    {
+        typedef std::size_t size_type;
+
+        // computed in 64 bits: run_bits is 32 for 64-bit blocks, which
+        // a 32-bit size_t cannot be shifted by
+        BOOST_STATIC_CONSTANT(int, run_bits = std::numeric_limits<Block>::digits / 2);
+        BOOST_STATIC_CONSTANT(size_type, max_run = static_cast<size_type>(
+            (boost::uint64_t(1) << run_bits) - 1));
+        BOOST_STATIC_CONSTANT(size_type, max_literals = static_cast<size_type>(
+            (boost::uint64_t(1) << (std::numeric_limits<Block>::digits - 1 - run_bits)) - 1));
+
+        static bool run_bit(Block m) { return (m & 1) != 0; }
+        static size_type run_length(Block m) { return (m >> 1) & max_run; }
+        static size_type literals(Block m) { return m >> (1 + run_bits); }
+
+        static Block make(bool bit, size_type run, size_type lits)
+        {
+            return static_cast<Block>(Block(bit) | (Block(run) << 1)
+                                      | (Block(lits) << (1 + run_bits)));
+        }
+    };
+
+    // Reads an EWAH stream a marker at a time: a run of rl clean words
+    // of bit rb, then lits literal words at lit.
+    //
+    template <typename Block>
+    struct ewah_cursor
+    {
+        typedef std::size_t size_type;
+        typedef ewah_marker<Block> marker;
+
+        ewah_cursor(const Block * first, const Block * last)
+            : p(first), end(last), rl(0), rb(false), lits(0), lit(first)
+        {}
+
+        // reads markers until there are words left; false at the end
+        bool next()
+        {
+            while (rl == 0 && lits == 0) {
+                if (p == end)
+                    return false;
+                const Block m = *p++;
+                rb = marker::run_bit(m);
+                rl = marker::run_length(m);
+                lits = marker::literals(m);
+                lit = p;
+                p += lits;
+            }
+            return true;
+        }
+
+        const Block * p;
+        const Block * end;
+        size_type rl;
+        bool rb;
+        size_type lits;
+        const Block * lit;
+    };
+
+    // A forward iterator over the positions of the set bits of an EWAH
+    // stream: runs of zeros are skipped in constant time
+    //
+    template <typename Block>
+    class ewah_set_bit_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::size_t value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::size_t * pointer;
+        typedef std::size_t reference;
+
+        BOOST_STATIC_CONSTANT(std::size_t, npos = static_cast<std::size_t>(-1));
+
+        ewah_set_bit_iterator()
+            : m_cursor(0, 0), m_word(npos), m_current(0)
+        {}
+
+        // the first set bit of the stream [first, last), or the end
+        ewah_set_bit_iterator(const Block * first, const Block * last)
+            : m_cursor(first, last), m_word(npos), m_current(0)
+        {
+            m_next_word();
+        }
+
+        reference operator*() const
+        {
+            return m_word * std::numeric_limits<Block>::digits
+                 + boost::lowest_bit(m_current);
+        }
+
+        ewah_set_bit_iterator & operator++()
+        {
+            m_current = static_cast<Block>(m_current & (m_current - 1));
+            if (m_current == 0)
+                m_next_word();
+            return *this;
+        }
+
+        ewah_set_bit_iterator operator++(int)
+        {
+            ewah_set_bit_iterator r(*this);
+            ++*this;
+            return r;
+        }
+
+        friend bool operator==(const ewah_set_bit_iterator & a,
+                               const ewah_set_bit_iterator & b)
+        {
+            return a.m_word == b.m_word && a.m_current == b.m_current;
+        }
+
+        friend bool operator!=(const ewah_set_bit_iterator & a,
+                               const ewah_set_bit_iterator & b)
+        {
+            return !(a == b);
+        }
+
+    private:
+        // the next word with bits on; m_word wraps from npos to 0
+        void m_next_word()
+        {
+            while (m_cursor.next()) {
+                if (m_cursor.rl != 0) {
+                    if (m_cursor.rb) {
+                        --m_cursor.rl;
+                        ++m_word;
+                        m_current = static_cast<Block>(~Block(0));
+                        return;
+                    }
+                    m_word += m_cursor.rl;
+                    m_cursor.rl = 0;
+                }
+                else {
+                    // literal words are never null
+                    --m_cursor.lits;
+                    ++m_word;
+                    m_current = *m_cursor.lit++;
+                    return;
+                }
+            }
+            m_word = npos;
+            m_current = 0;
+        }
+
+        ewah_cursor<Block> m_cursor;
+        std::size_t m_word;     // index of the current word
+        Block m_current;        // its bits not visited yet
+    };
+
+    template <typename Block>
+    class ewah_set_bit_range
+    {
+    public:
+        typedef ewah_set_bit_iterator<Block> iterator;
+        typedef iterator const_iterator;
+
+        ewah_set_bit_range(const Block * first, const Block * last)
+            : m_first(first, last)
+        {}
+
+        iterator begin() const { return m_first; }
+        iterator end() const { return iterator(); }
+        bool empty() const { return m_first == iterator(); }
+
+    private:
+        iterator m_first;
+    };
+
+  } // dynamic_bitset_impl
+  } // namespace detail
+
+
+// A bitset compressed with the Enhanced Word-Aligned Hybrid scheme
+// (Lemire, Kaser and Aouiche, "Sorting improves word-aligned bitmap
+// indexes", 2010). The blocks are a sequence of markers, each one
+// followed by literal blocks:
+//
+//   - a marker holds a run of up to 2^(bits_per_block / 2) - 1 clean
+//     blocks, all 0 or all 1, and the number of literal blocks after
+//     it (up to 2^(bits_per_block / 2 - 1) - 1);
+//   - a literal block is any other block, stored as is.
+//
+// The bitwise operators, count() and set_bits() walk the markers of
+// their operands, and go through the clean runs in constant time: they
+// cost time proportional to the compressed sizes. Random access does
+// too, as test() has to walk the markers up to the position.
+//
+// The encoding of a sequence of blocks is unique, hence == compares the
+// compressed words.
+//
+template <typename Block, typename Allocator>
+class ewah_bitset
+{
+public:
+    typedef dynamic_bitset<Block, Allocator> bitset_type;
+    typedef Block block_type;
+    typedef std::size_t size_type;
+
+    typedef detail::dynamic_bitset_impl::ewah_set_bit_iterator<Block> set_bit_iterator;
+    typedef detail::dynamic_bitset_impl::ewah_set_bit_range<Block> set_bit_range;
+
+    BOOST_STATIC_CONSTANT(int, bits_per_block = bitset_type::bits_per_block);
+    BOOST_STATIC_CONSTANT(size_type, npos = static_cast<size_type>(-1));
+
+    ewah_bitset();
+    explicit ewah_bitset(const bitset_type& b);
+
+    // b gets the size and the bits of *this
+    void to_bitset(bitset_type& b) const;
+
+    // bits_per_block bits at the end, as dynamic_bitset::append(), and
+    // num_blocks blocks of all 0 or all 1
+    // PRE: size() % bits_per_block == 0
+    void append(Block value);
+    void append(size_type num_blocks, bool value);
+
+    size_type size() const { return m_num_bits; }
+    size_type num_blocks() const;
+    bool empty() const { return m_num_bits == 0; }
+
+    bool test(size_type pos) const;
+    bool operator[](size_type pos) const { return test(pos); }
+    size_type count() const;
+    bool any() const;
+    bool none() const { return !any(); }
+
+    // the positions of the set bits, in increasing order
+    set_bit_range set_bits() const;
+
+    // PRE: x.size() == size()
+    ewah_bitset& operator&=(const ewah_bitset& x);
+    ewah_bitset& operator|=(const ewah_bitset& x);
+    ewah_bitset& operator^=(const ewah_bitset& x);
+    ewah_bitset& operator-=(const ewah_bitset& x);
+
+    // the compressed size, in blocks
+    size_type num_words() const { return m_words.size(); }
+
+    template <typename B, typename A>
+    friend bool operator==(const ewah_bitset<B, A>& a, const ewah_bitset<B, A>& b);
+
+private:
+    typedef detail::dynamic_bitset_impl::ewah_marker<Block> marker;
+    typedef detail::dynamic_bitset_impl::ewah_cursor<Block> cursor;
+    typedef std::vector<Block, typename bitset_type::allocator_type> buffer_type;
+
+    cursor m_cursor() const;
+    void m_add_clean(bool bit, size_type n);
+    void m_add_literal(Block w);
+    void m_add_word(Block w);
+
+    template <int Op>
+    void m_combine(const ewah_bitset& x);
+
+    buffer_type m_words;
+    size_type m_last_marker; // index in m_words
+    size_type m_num_bits;
+};
+
+template <typename Block, typename Allocator>
+const int ewah_bitset<Block, Allocator>::bits_per_block;
+
+template <typename Block, typename Allocator>
+const typename ewah_bitset<Block, Allocator>::size_type
+ewah_bitset<Block, Allocator>::npos;
+
+
+template <typename Block, typename Allocator>
+ewah_bitset<Block, Allocator>::ewah_bitset()
+  : m_words(1, Block(0)), m_last_marker(0), m_num_bits(0)
+{}
+
+// the runs of clean blocks are found with the scan kernels
+//
+template <typename Block, typename Allocator>
+ewah_bitset<Block, Allocator>::ewah_bitset(const bitset_type& b)
+  : m_words(1, Block(0)), m_last_marker(0), m_num_bits(0)
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    const Block* const p = bitset_leaf<Block>(b).data();
+    const size_type n = b.num_blocks();
+    const Block all = static_cast<Block>(~Block(0));
+    for (size_type i = 0; i < n; ) {
+        size_type run = 0;
+        if (p[i] == 0)
+            run = find_nonzero_block<op_id>(p + i, p + i, n - i);
+        else if (p[i] == all)
+            run = find_nonzero_block<op_not>(p + i, p + i, n - i);
+
+        if (run != 0) {
+            m_add_clean(p[i] != 0, run);
+            i += run;
+        }
+        else
+            m_add_literal(p[i++]);
+    }
+    m_num_bits = b.size();
+}
+
+template <typename Block, typename Allocator>
+void ewah_bitset<Block, Allocator>::to_bitset(bitset_type& b) const
+{
+    const Block all = static_cast<Block>(~Block(0));
+
+    std::vector<Block> blocks;
+    blocks.reserve(num_blocks());
+    cursor c = m_cursor();
+    while (c.next()) {
+        blocks.insert(blocks.end(), c.rl, c.rb ? all : Block(0));
+        blocks.insert(blocks.end(), c.lit, c.lit + c.lits);
+        c.rl = c.lits = 0;
+    }
+
+    b.resize(m_num_bits);
+    from_block_range(blocks.begin(), blocks.end(), b);
+}
+
+template <typename Block, typename Allocator>
+inline typename ewah_bitset<Block, Allocator>::cursor
+ewah_bitset<Block, Allocator>::m_cursor() const
+{
+    return cursor(&m_words[0], &m_words[0] + m_words.size());
+}
+
+// extends the run of the last marker while it has no literals and the
+// same bit (or no run yet), then starts new markers
+//
+template <typename Block, typename Allocator>
+void ewah_bitset<Block, Allocator>::m_add_clean(bool bit, size_type n)
+{
+    while (n != 0) {
+        const Block m = m_words[m_last_marker];
+        const size_type run = marker::run_length(m);
+        if (marker::literals(m) != 0 || (run != 0 && marker::run_bit(m) != bit)
+            || run == marker::max_run) {
+            m_last_marker = m_words.size();
+            m_words.push_back(Block(0));
+            continue;
+        }
+        const size_type k = (std::min)(n, size_type(marker::max_run) - run);
+        m_words[m_last_marker] = marker::make(bit, run + k, 0);
+        n -= k;
+    }
+}
+
+// PRE: w is neither 0 nor all 1
+//
+template <typename Block, typename Allocator>
+void ewah_bitset<Block, Allocator>::m_add_literal(Block w)
+{
+    Block m = m_words[m_last_marker];
+    if (marker::literals(m) == marker::max_literals) {
+        m_last_marker = m_words.size();
+        m_words.push_back(Block(0));
+        m = 0;
+    }
+    m_words[m_last_marker] = marker::make(marker::run_bit(m), marker::run_length(m),
+                                          marker::literals(m) + 1);
+    m_words.push_back(w);
+}
+
+template <typename Block, typename Allocator>
+inline void ewah_bitset<Block, Allocator>::m_add_word(Block w)
+{
+    if (w == 0)
+        m_add_clean(false, 1);
+    else if (w == static_cast<Block>(~Block(0)))
+        m_add_clean(true, 1);
+    else
+        m_add_literal(w);
+}
+
+template <typename Block, typename Allocator>
+void ewah_bitset<Block, Allocator>::append(Block value)
+{
+    assert(m_num_bits % bits_per_block == 0);
+    m_add_word(value);
+    m_num_bits += bits_per_block;
+}
+
+template <typename Block, typename Allocator>
+void ewah_bitset<Block, Allocator>::append(size_type num_blocks, bool value)
+{
+    assert(m_num_bits % bits_per_block == 0);
+    m_add_clean(value, num_blocks);
+    m_num_bits += num_blocks * bits_per_block;
+}
+
+template <typename Block, typename Allocator>
+inline typename ewah_bitset<Block, Allocator>::size_type
+ewah_bitset<Block, Allocator>::num_blocks() const
+{
+    return (m_num_bits + bits_per_block - 1) / bits_per_block;
+}
+
+template <typename Block, typename Allocator>
+bool ewah_bitset<Block, Allocator>::test(size_type pos) const
+{
+    assert(pos < size());
+
+    size_type i = pos / bits_per_block; // blocks to skip
+    cursor c = m_cursor();
+    while (c.next()) {
+        if (i < c.rl)
+            return c.rb;
+        i -= c.rl;
+        if (i < c.lits)
+            return (c.lit[i] >> (pos % bits_per_block)) & 1;
+        i -= c.lits;
+        c.rl = c.lits = 0;
+    }
+    return false; // not reached
+}
+
+template <typename Block, typename Allocator>
+typename ewah_bitset<Block, Allocator>::size_type
+ewah_bitset<Block, Allocator>::count() const
+{
+    using detail::dynamic_bitset_impl::count_block_range;
+
+    size_type n = 0;
+    cursor c = m_cursor();
+    while (c.next()) {
+        if (c.rb)
+            n += c.rl * bits_per_block;
+        n += count_block_range(c.lit, c.lits);
+        c.rl = c.lits = 0;
+    }
+    return n;
+}
+
+template <typename Block, typename Allocator>
+bool ewah_bitset<Block, Allocator>::any() const
+{
+    cursor c = m_cursor();
+    while (c.next()) {
+        if (c.lits != 0 || c.rb)
+            return true;
+        c.rl = 0;
+    }
+    return false;
+}
+
+template <typename Block, typename Allocator>
+inline typename ewah_bitset<Block, Allocator>::set_bit_range
+ewah_bitset<Block, Allocator>::set_bits() const
+{
+    return set_bit_range(&m_words[0], &m_words[0] + m_words.size());
+}
+
+// A merge of the two streams, a run or a sequence of literals at a
+// time. Against a run, the result of a bitwise operation is a run of
+// the same length, or the literals of the other operand, possibly
+// complemented: they need not be looked at.
+//
+template <typename Block, typename Allocator>
+template <int Op>
+void ewah_bitset<Block, Allocator>::m_combine(const ewah_bitset& x)
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    assert(size() == x.size());
+
+    const Block all = static_cast<Block>(~Block(0));
+    ewah_bitset r;
+    cursor a = m_cursor();
+    cursor b = x.m_cursor();
+    while (a.next() && b.next()) {
+        if (a.rl != 0 && b.rl != 0) {
+            const size_type n = (std::min)(a.rl, b.rl);
+            r.m_add_clean(apply_bitwise<Op>(a.rb ? all : Block(0),
+                                            b.rb ? all : Block(0)) != 0, n);
+            a.rl -= n;
+            b.rl -= n;
+        }
+        else if (a.rl != 0 || b.rl != 0) {
+            const bool left_run = a.rl != 0;
+            cursor& run = left_run ? a : b;
+            cursor& lit = left_run ? b : a;
+            const size_type n = (std::min)(run.rl, lit.lits);
+            const Block rw = run.rb ? all : Block(0);
+
+            // the result for literals of all 0 and all 1
+            const Block r0 = left_run ? apply_bitwise<Op>(rw, Block(0))
+                                      : apply_bitwise<Op>(Block(0), rw);
+            const Block r1 = left_run ? apply_bitwise<Op>(rw, all)
+                                      : apply_bitwise<Op>(all, rw);
+            if (r0 == r1)
+                r.m_add_clean(r0 != 0, n);
+            else
+                for (size_type k = 0; k < n; ++k)
+                    r.m_add_literal(r0 == 0 ? lit.lit[k] : static_cast<Block>(~lit.lit[k]));
+            run.rl -= n;
+            lit.lit += n;
+            lit.lits -= n;
+        }
+        else {
+            const size_type n = (std::min)(a.lits, b.lits);
+            for (size_type k = 0; k < n; ++k)
+                r.m_add_word(apply_bitwise<Op>(a.lit[k], b.lit[k]));
+            a.lit += n;
+            a.lits -= n;
+            b.lit += n;
+            b.lits -= n;
+        }
+    }
+    r.m_num_bits = m_num_bits;
+
+    m_words.swap(r.m_words);
+    m_last_marker = r.m_last_marker;
+}
+
+template <typename Block, typename Allocator>
+ewah_bitset<Block, Allocator>&
+ewah_bitset<Block, Allocator>::operator&=(const ewah_bitset& x)
+{
+    m_combine<detail::dynamic_bitset_impl::op_and>(x);
+    return *this;
+}
+
+template <typename Block, typename Allocator>
+ewah_bitset<Block, Allocator>&
+ewah_bitset<Block, Allocator>::operator|=(const ewah_bitset& x)
+{
+    m_combine<detail::dynamic_bitset_impl::op_or>(x);
+    return *this;
+}
+
+template <typename Block, typename Allocator>
+ewah_bitset<Block, Allocator>&
+ewah_bitset<Block, Allocator>::operator^=(const ewah_bitset& x)
+{
+    m_combine<detail::dynamic_bitset_impl::op_xor>(x);
+    return *this;
+}
+
+template <typename Block, typename Allocator>
+ewah_bitset<Block, Allocator>&
+ewah_bitset<Block, Allocator>::operator-=(const ewah_bitset& x)
+{
+    m_combine<detail::dynamic_bitset_impl::op_sub>(x);
+    return *this;
+}
+
+//-----------------------------------------------------------------------------
+// comparison
+
+template <typename Block, typename Allocator>
+bool operator==(const ewah_bitset<Block, Allocator>& a,
+                const ewah_bitset<Block, Allocator>& b)
+{
+    return a.m_num_bits == b.m_num_bits && a.m_words == b.m_words;
+}
+
+template <typename Block, typename Allocator>
+inline bool operator!=(const ewah_bitset<Block, Allocator>& a,
+                       const ewah_bitset<Block, Allocator>& b)
+{
+    return !(a == b);
+}
+
+//-----------------------------------------------------------------------------
+// bitset operations
+
+template <typename Block, typename Allocator>
+ewah_bitset<Block, Allocator>
+operator&(const ewah_bitset<Block, Allocator>& x,
+          const ewah_bitset<Block, Allocator>& y)
+{
+    ewah_bitset<Block, Allocator> b(x);
+    return b &= y;
+}
+
+template <typename Block, typename Allocator>
+ewah_bitset<Block, Allocator>
+operator|(const ewah_bitset<Block, Allocator>& x,
+          const ewah_bitset<Block, Allocator>& y)
+{
+    ewah_bitset<Block, Allocator> b(x);
+    return b |= y;
+}
+
+template <typename Block, typename Allocator>
+ewah_bitset<Block, Allocator>
+operator^(const ewah_bitset<Block, Allocator>& x,
+          const ewah_bitset<Block, Allocator>& y)
+{
+    ewah_bitset<Block, Allocator> b(x);
+    return b ^= y;
+}
+
+template <typename Block, typename Allocator>
+ewah_bitset<Block, Allocator>
+operator-(const ewah_bitset<Block, Allocator>& x,
+          const ewah_bitset<Block, Allocator>& y)
+{
+    ewah_bitset<Block, Allocator> b(x);
+    return b -= y;
+}
+
+} // namespace boost
+
+#endif // include guard
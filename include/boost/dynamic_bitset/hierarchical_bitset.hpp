@@ -0,0 +1,541 @@
+// -----------------------------------------------------------
+// hierarchical_bitset.hpp
+//
+//       A dynamic_bitset with summaries of its non-empty blocks,
+//       for lookups in huge sparse sets
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DYNAMIC_BITSET_HIERARCHICAL_BITSET_HPP
+#define BOOST_DYNAMIC_BITSET_HIERARCHICAL_BITSET_HPP
+
+#include <assert.h>
+#include <cstddef>
+#include <vector>
+#include "boost/dynamic_bitset/dynamic_bitset.hpp"
+#include "boost/pending/lowest_bit.hpp"
+#include "boost/pending/highest_bit.hpp"
+
+
+namespace boost {
+
+// A dynamic_bitset (level 0) and summaries of it: bit i of level 1 is
+// on iff block i of the bitset is not null, bit i of level 2 iff block
+// i of level 1 is not null, and so on up to a level of one block.
+//
+// With 64-bit blocks, a level is 1/64 of the one below: 10^9 bits have
+// four levels, about 2MB in all. find_next() and find_prev() then read
+// at most two blocks per level, whatever the distance to the next set
+// bit; count(), == and the bitwise operators visit only the non-empty
+// blocks of their operands.
+//
+// set(), reset() and flip() keep the summaries current, climbing only
+// while a block becomes empty or stops being so; resize() and the
+// constructors rebuild them, in linear time.
+//
+template <typename Block, typename Allocator>
+class hierarchical_bitset
+{
+public:
+    typedef dynamic_bitset<Block, Allocator> bitset_type;
+    typedef Block block_type;
+    typedef std::size_t size_type;
+
+    BOOST_STATIC_CONSTANT(int, bits_per_block = bitset_type::bits_per_block);
+    BOOST_STATIC_CONSTANT(size_type, npos = static_cast<size_type>(-1));
+
+    explicit hierarchical_bitset(size_type num_bits = 0);
+    explicit hierarchical_bitset(const bitset_type& b);
+
+    // the new bits, if any, are off
+    void resize(size_type num_bits);
+
+    // basic bit operations
+    hierarchical_bitset& set(size_type pos, bool val = true);
+    hierarchical_bitset& reset(size_type pos);
+    hierarchical_bitset& reset();
+    hierarchical_bitset& flip(size_type pos);
+    bool test(size_type pos) const { return m_bits.test(pos); }
+    bool operator[](size_type pos) const { return test(pos); }
+
+    size_type size() const { return m_bits.size(); }
+    bool empty() const { return m_bits.empty(); }
+    bool any() const { return m_top() != 0; }
+    bool none() const { return m_top() == 0; }
+    size_type count() const;
+
+    // lookup
+    size_type find_first() const;
+    size_type find_next(size_type pos) const;
+    size_type find_last() const;
+    size_type find_prev(size_type pos) const;
+
+    // PRE: x.size() == size()
+    hierarchical_bitset& operator&=(const hierarchical_bitset& x);
+    hierarchical_bitset& operator|=(const hierarchical_bitset& x);
+    hierarchical_bitset& operator^=(const hierarchical_bitset& x);
+    hierarchical_bitset& operator-=(const hierarchical_bitset& x);
+
+    const bitset_type& bits() const { return m_bits; }
+
+    // number of summary levels, and the memory they use, in bytes
+    size_type num_levels() const { return m_summary.size(); }
+    size_type memory_usage() const;
+
+    template <typename B, typename A>
+    friend bool operator==(const hierarchical_bitset<B, A>& a,
+                           const hierarchical_bitset<B, A>& b);
+
+private:
+    typedef std::vector<Block, typename bitset_type::allocator_type> level_type;
+
+    Block* m_blocks() { return m_bits.m_block_data(); }
+    const Block* m_blocks() const { return m_bits.m_block_data(); }
+    Block m_top() const { return m_summary.back()[0]; }
+
+    void m_build();
+    void m_update(size_type i, bool not_null);
+    size_type m_find_from(size_type i) const;
+    size_type m_find_before(size_type i) const;
+
+    // the word i of level l, and what it summarizes
+    template <int Op>
+    Block m_combine(const hierarchical_bitset& x, size_type l, size_type i);
+    void m_clear(size_type l, size_type i);
+    size_type m_count(size_type l, size_type i) const;
+    bool m_equal(const hierarchical_bitset& x, size_type l, size_type i) const;
+
+    bitset_type m_bits;
+    std::vector<level_type> m_summary; // m_summary[l - 1] is level l
+};
+
+template <typename Block, typename Allocator>
+const int hierarchical_bitset<Block, Allocator>::bits_per_block;
+
+template <typename Block, typename Allocator>
+const typename hierarchical_bitset<Block, Allocator>::size_type
+hierarchical_bitset<Block, Allocator>::npos;
+
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>::hierarchical_bitset(size_type num_bits)
+  : m_bits(num_bits)
+{
+    m_build();
+}
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>::hierarchical_bitset(const bitset_type& b)
+  : m_bits(b)
+{
+    m_build();
+}
+
+template <typename Block, typename Allocator>
+void hierarchical_bitset<Block, Allocator>::resize(size_type num_bits)
+{
+    m_bits.resize(num_bits);
+    m_build();
+}
+
+// the levels above the bitset, up to (and including) the first one of
+// a single block; there is always one, even for an empty bitset
+//
+template <typename Block, typename Allocator>
+void hierarchical_bitset<Block, Allocator>::m_build()
+{
+    m_summary.clear();
+
+    const Block* below = m_blocks();
+    size_type n = m_bits.num_blocks();
+    do {
+        level_type level(n == 0 ? 1 : (n + bits_per_block - 1) / bits_per_block);
+        for (size_type i = 0; i < n; ++i)
+            if (below[i] != 0)
+                level[i / bits_per_block] |= Block(1) << (i % bits_per_block);
+        m_summary.push_back(level);
+        below = &m_summary.back()[0];
+        n = m_summary.back().size();
+    } while (n > 1);
+}
+
+// block i of the bitset has become null, or not null
+//
+template <typename Block, typename Allocator>
+void hierarchical_bitset<Block, Allocator>::m_update(size_type i, bool not_null)
+{
+    for (size_type l = 0; l < m_summary.size(); ++l, i /= bits_per_block) {
+        Block& w = m_summary[l][i / bits_per_block];
+        const bool was_null = w == 0;
+        const Block mask = Block(1) << (i % bits_per_block);
+        w = static_cast<Block>(not_null ? w | mask : w & ~mask);
+        if (was_null == (w == 0))
+            break;
+    }
+}
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>&
+hierarchical_bitset<Block, Allocator>::set(size_type pos, bool val)
+{
+    assert(pos < size());
+
+    Block& b = m_blocks()[pos / bits_per_block];
+    const bool was_null = b == 0;
+    const Block mask = Block(1) << (pos % bits_per_block);
+    b = static_cast<Block>(val ? b | mask : b & ~mask);
+    if (was_null != (b == 0))
+        m_update(pos / bits_per_block, b != 0);
+    return *this;
+}
+
+template <typename Block, typename Allocator>
+inline hierarchical_bitset<Block, Allocator>&
+hierarchical_bitset<Block, Allocator>::reset(size_type pos)
+{
+    return set(pos, false);
+}
+
+template <typename Block, typename Allocator>
+inline hierarchical_bitset<Block, Allocator>&
+hierarchical_bitset<Block, Allocator>::flip(size_type pos)
+{
+    return set(pos, !test(pos));
+}
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>&
+hierarchical_bitset<Block, Allocator>::reset()
+{
+    m_clear(m_summary.size(), 0);
+    return *this;
+}
+
+// -------- operations on the blocks below a summary word -------------
+//
+// They visit the on bits of the word i of level l, recursively: the
+// cost is proportional to the number of non-empty blocks, times the
+// number of levels. Level 0 is the bitset.
+
+template <typename Block, typename Allocator>
+void hierarchical_bitset<Block, Allocator>::m_clear(size_type l, size_type i)
+{
+    if (l == 0) {
+        m_blocks()[i] = 0;
+        return;
+    }
+
+    Block& w = m_summary[l - 1][i];
+    for (Block v = w; v != 0; v = static_cast<Block>(v & (v - 1)))
+        m_clear(l - 1, i * bits_per_block + boost::lowest_bit(v));
+    w = 0;
+}
+
+template <typename Block, typename Allocator>
+typename hierarchical_bitset<Block, Allocator>::size_type
+hierarchical_bitset<Block, Allocator>::m_count(size_type l, size_type i) const
+{
+    size_type n = 0;
+    if (l == 1) {
+        // each run of non-null blocks in one go, with the dispatched kernel
+        const Block* const p = m_blocks() + i * bits_per_block;
+        for (Block v = m_summary[0][i]; v != 0; ) {
+            const size_type first = boost::lowest_bit(v);
+            const Block rest = static_cast<Block>(~(v >> first));
+            const size_type len = rest == 0 ? size_type(bits_per_block)
+                                            : size_type(boost::lowest_bit(rest));
+            n += detail::dynamic_bitset_impl::count_block_range(p + first, len);
+            v = len == size_type(bits_per_block)
+                    ? Block(0)
+                    : static_cast<Block>(v & ~(((Block(1) << len) - 1) << first));
+        }
+        return n;
+    }
+
+    for (Block v = m_summary[l - 1][i]; v != 0; v = static_cast<Block>(v & (v - 1)))
+        n += m_count(l - 1, i * bits_per_block + boost::lowest_bit(v));
+    return n;
+}
+
+template <typename Block, typename Allocator>
+bool hierarchical_bitset<Block, Allocator>::m_equal(const hierarchical_bitset& x,
+                                                    size_type l, size_type i) const
+{
+    if (l == 0)
+        return m_blocks()[i] == x.m_blocks()[i];
+
+    const Block w = m_summary[l - 1][i];
+    if (w != x.m_summary[l - 1][i])
+        return false;
+    for (Block v = w; v != 0; v = static_cast<Block>(v & (v - 1)))
+        if (!m_equal(x, l - 1, i * bits_per_block + boost::lowest_bit(v)))
+            return false;
+    return true;
+}
+
+// *this = *this Op x below the word i of level l (l > 0): and and sub
+// visit the blocks not null in both operands (and clear the ones of
+// *this only, for and), or and xor those not null in x
+//
+template <typename Block, typename Allocator>
+template <int Op>
+Block hierarchical_bitset<Block, Allocator>::m_combine(const hierarchical_bitset& x,
+                                                       size_type l, size_type i)
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    Block& w = m_summary[l - 1][i];
+    const Block xw = x.m_summary[l - 1][i];
+
+    if (Op == op_and) {
+        for (Block v = static_cast<Block>(w & ~xw); v != 0; v = static_cast<Block>(v & (v - 1)))
+            m_clear(l - 1, i * bits_per_block + boost::lowest_bit(v));
+        w = static_cast<Block>(w & xw);
+    }
+
+    const Block visit = (Op == op_and || Op == op_sub) ? static_cast<Block>(w & xw) : xw;
+    for (Block v = visit; v != 0; v = static_cast<Block>(v & (v - 1))) {
+        const int k = boost::lowest_bit(v);
+        const size_type j = i * bits_per_block + k;
+        Block r;
+        if (l == 1) {
+            Block& b = m_blocks()[j];
+            r = b = apply_bitwise<Op>(b, x.m_blocks()[j]);
+        }
+        else
+            r = m_combine<Op>(x, l - 1, j);
+
+        const Block mask = Block(1) << k;
+        w = static_cast<Block>(r != 0 ? w | mask : w & ~mask);
+    }
+    return w;
+}
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>&
+hierarchical_bitset<Block, Allocator>::operator&=(const hierarchical_bitset& x)
+{
+    assert(size() == x.size());
+    m_combine<detail::dynamic_bitset_impl::op_and>(x, m_summary.size(), 0);
+    return *this;
+}
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>&
+hierarchical_bitset<Block, Allocator>::operator|=(const hierarchical_bitset& x)
+{
+    assert(size() == x.size());
+    m_combine<detail::dynamic_bitset_impl::op_or>(x, m_summary.size(), 0);
+    return *this;
+}
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>&
+hierarchical_bitset<Block, Allocator>::operator^=(const hierarchical_bitset& x)
+{
+    assert(size() == x.size());
+    m_combine<detail::dynamic_bitset_impl::op_xor>(x, m_summary.size(), 0);
+    return *this;
+}
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>&
+hierarchical_bitset<Block, Allocator>::operator-=(const hierarchical_bitset& x)
+{
+    assert(size() == x.size());
+    m_combine<detail::dynamic_bitset_impl::op_sub>(x, m_summary.size(), 0);
+    return *this;
+}
+
+template <typename Block, typename Allocator>
+inline typename hierarchical_bitset<Block, Allocator>::size_type
+hierarchical_bitset<Block, Allocator>::count() const
+{
+    return m_count(m_summary.size(), 0);
+}
+
+// --------------------------------
+// lookup
+
+// the first bit on in the blocks from i: climb while the rest of the
+// summary word is null, then descend along the lowest bits on
+//
+template <typename Block, typename Allocator>
+typename hierarchical_bitset<Block, Allocator>::size_type
+hierarchical_bitset<Block, Allocator>::m_find_from(size_type i) const
+{
+    size_type l = 0; // i is a block index of level l
+    size_type n = m_bits.num_blocks();
+    for ( ; ; ++l, i = i / bits_per_block + 1) {
+        if (i >= n || l == m_summary.size())
+            return npos;
+        const Block fore = static_cast<Block>(
+            m_summary[l][i / bits_per_block] >> (i % bits_per_block));
+        if (fore) {
+            i += boost::lowest_bit(fore);
+            break;
+        }
+        n = m_summary[l].size();
+    }
+
+    for ( ; l > 0; --l)
+        i = i * bits_per_block + boost::lowest_bit(m_summary[l - 1][i]);
+    return i * bits_per_block + boost::lowest_bit(m_blocks()[i]);
+}
+
+// the last bit on in the blocks before i
+//
+template <typename Block, typename Allocator>
+typename hierarchical_bitset<Block, Allocator>::size_type
+hierarchical_bitset<Block, Allocator>::m_find_before(size_type i) const
+{
+    const Block all = static_cast<Block>(~Block(0));
+
+    size_type l = 0; // i is a block index of level l
+    for ( ; ; ++l, i /= bits_per_block) {
+        if (i == 0 || l == m_summary.size())
+            return npos;
+        --i;
+        const Block back = static_cast<Block>(
+            m_summary[l][i / bits_per_block]
+            & (all >> (bits_per_block - 1 - i % bits_per_block)));
+        if (back) {
+            i = i / bits_per_block * bits_per_block + boost::highest_bit(back);
+            break;
+        }
+    }
+
+    for ( ; l > 0; --l)
+        i = i * bits_per_block + boost::highest_bit(m_summary[l - 1][i]);
+    return i * bits_per_block + boost::highest_bit(m_blocks()[i]);
+}
+
+template <typename Block, typename Allocator>
+inline typename hierarchical_bitset<Block, Allocator>::size_type
+hierarchical_bitset<Block, Allocator>::find_first() const
+{
+    return m_find_from(0);
+}
+
+template <typename Block, typename Allocator>
+typename hierarchical_bitset<Block, Allocator>::size_type
+hierarchical_bitset<Block, Allocator>::find_next(size_type pos) const
+{
+    const size_type sz = size();
+    if (pos >= (sz-1) || sz == 0)
+        return npos;
+
+    ++pos;
+
+    const size_type blk = pos / bits_per_block;
+    const Block fore = static_cast<Block>(m_blocks()[blk] >> (pos % bits_per_block));
+
+    return fore?
+        pos + boost::lowest_bit(fore)
+        :
+        m_find_from(blk + 1);
+}
+
+template <typename Block, typename Allocator>
+inline typename hierarchical_bitset<Block, Allocator>::size_type
+hierarchical_bitset<Block, Allocator>::find_last() const
+{
+    return m_find_before(m_bits.num_blocks());
+}
+
+// if pos >= size() the whole bitset is searched
+//
+template <typename Block, typename Allocator>
+typename hierarchical_bitset<Block, Allocator>::size_type
+hierarchical_bitset<Block, Allocator>::find_prev(size_type pos) const
+{
+    pos = (std::min)(pos, size());
+    if (pos == 0)
+        return npos;
+
+    --pos;
+
+    const size_type blk = pos / bits_per_block;
+    const Block all = static_cast<Block>(~Block(0));
+    const Block back = static_cast<Block>(
+        m_blocks()[blk] & (all >> (bits_per_block - 1 - pos % bits_per_block)));
+
+    return back?
+        blk * bits_per_block + boost::highest_bit(back)
+        :
+        m_find_before(blk);
+}
+
+template <typename Block, typename Allocator>
+typename hierarchical_bitset<Block, Allocator>::size_type
+hierarchical_bitset<Block, Allocator>::memory_usage() const
+{
+    size_type n = 0;
+    for (size_type l = 0; l < m_summary.size(); ++l)
+        n += m_summary[l].capacity() * sizeof(Block);
+    return n;
+}
+
+//-----------------------------------------------------------------------------
+// comparison
+
+template <typename Block, typename Allocator>
+bool operator==(const hierarchical_bitset<Block, Allocator>& a,
+                const hierarchical_bitset<Block, Allocator>& b)
+{
+    return a.size() == b.size() && a.m_equal(b, a.m_summary.size(), 0);
+}
+
+template <typename Block, typename Allocator>
+inline bool operator!=(const hierarchical_bitset<Block, Allocator>& a,
+                       const hierarchical_bitset<Block, Allocator>& b)
+{
+    return !(a == b);
+}
+
+//-----------------------------------------------------------------------------
+// bitset operations
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>
+operator&(const hierarchical_bitset<Block, Allocator>& x,
+          const hierarchical_bitset<Block, Allocator>& y)
+{
+    hierarchical_bitset<Block, Allocator> b(x);
+    return b &= y;
+}
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>
+operator|(const hierarchical_bitset<Block, Allocator>& x,
+          const hierarchical_bitset<Block, Allocator>& y)
+{
+    hierarchical_bitset<Block, Allocator> b(x);
+    return b |= y;
+}
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>
+operator^(const hierarchical_bitset<Block, Allocator>& x,
+          const hierarchical_bitset<Block, Allocator>& y)
+{
+    hierarchical_bitset<Block, Allocator> b(x);
+    return b ^= y;
+}
+
+template <typename Block, typename Allocator>
+hierarchical_bitset<Block, Allocator>
+operator-(const hierarchical_bitset<Block, Allocator>& x,
+          const hierarchical_bitset<Block, Allocator>& y)
+{
+    hierarchical_bitset<Block, Allocator> b(x);
+    return b -= y;
+}
+
+} // namespace boost
+
+#endif // include guard
@@ -0,0 +1,274 @@
+// -----------------------------------------------------------
+// rank_select_index.hpp
+//
+//       A rank/select index over the blocks of a dynamic_bitset
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DYNAMIC_BITSET_RANK_SELECT_INDEX_HPP
+#define BOOST_DYNAMIC_BITSET_RANK_SELECT_INDEX_HPP
+
+#include <assert.h>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include "boost/cstdint.hpp"
+#include "boost/static_assert.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset.hpp"
+
+
+namespace boost {
+
+// rank(pos) is the number of set bits in [0, pos), select(k) the
+// position of the k-th (from 0) set bit, for the dynamic_bitset given
+// to the constructor. That bitset is referred to, not copied; it must
+// outlive the index, and update() must be called after it changes.
+//
+// The layout is that of Poppy (Zhou, Andersen, Kaminsky, "Space-
+// efficient, high-performance rank & select structures on uncompressed
+// bit sequences", 2013):
+//
+//   - for every 2^32 bits, the number of set bits before them
+//     (64 bits each);
+//   - for every 2048 bits, a 64-bit entry holding the number of set
+//     bits before them, since the last 2^32 boundary (32 bits), and
+//     the counts of its first three 512-bit basic blocks (10 bits each);
+//   - for every 8192 set bits, the 2048-bit group which contains it
+//     (32 bits), which narrows the binary search of select().
+//
+// That is about 3.5% of the size of the bitset. rank() reads an entry
+// and at most one basic block; select() binary searches the entries
+// between two samples, then scans one basic block.
+//
+template <typename Block = unsigned long,
+          typename Allocator = std::allocator<Block> >
+class rank_select_index
+{
+public:
+    typedef dynamic_bitset<Block, Allocator> bitset_type;
+    typedef std::size_t size_type;
+
+    BOOST_STATIC_CONSTANT(size_type, npos = static_cast<size_type>(-1));
+
+    explicit rank_select_index(const bitset_type& b);
+
+    // rebuilds the index, from the group containing pos onwards
+    // PRE: no bit before pos has changed since the last (re)build, and
+    // pos <= the size of the bitset at that time
+    void update(size_type pos = 0);
+
+    size_type rank(size_type pos) const;
+    size_type select(size_type k) const;
+    size_type count() const { return m_count; }
+
+    // memory used by the index, in bytes
+    size_type memory_usage() const;
+
+private:
+    BOOST_STATIC_CONSTANT(int, bits_per_block = bitset_type::bits_per_block);
+    BOOST_STATIC_ASSERT(512 % bits_per_block == 0);
+
+    BOOST_STATIC_CONSTANT(size_type, basic_bits = 512);
+    BOOST_STATIC_CONSTANT(size_type, group_bits = 4 * basic_bits);
+    BOOST_STATIC_CONSTANT(size_type, groups_per_upper = size_type(1) << 21); // 2^32 bits
+    BOOST_STATIC_CONSTANT(size_type, blocks_per_basic = basic_bits / bits_per_block);
+    BOOST_STATIC_CONSTANT(size_type, select_sample_rate = 8192);
+
+    const Block* m_blocks() const;
+    size_type m_num_blocks() const;
+    size_type m_count_blocks(size_type first, size_type last) const;
+    size_type m_group_rank(size_type g) const; // set bits before group g
+
+    const bitset_type& m_bitset;
+    std::vector<boost::uint64_t> m_upper;   // one per 2^32 bits
+    std::vector<boost::uint64_t> m_groups;  // one per 2048 bits
+    std::vector<boost::uint32_t> m_samples; // one per 8192 set bits
+    size_type m_count;
+    size_type m_num_bits;
+};
+
+template <typename Block, typename Allocator>
+const typename rank_select_index<Block, Allocator>::size_type
+rank_select_index<Block, Allocator>::npos;
+
+
+template <typename Block, typename Allocator>
+rank_select_index<Block, Allocator>::rank_select_index(const bitset_type& b)
+  : m_bitset(b), m_count(0), m_num_bits(0)
+{
+    update(0);
+}
+
+template <typename Block, typename Allocator>
+inline const Block* rank_select_index<Block, Allocator>::m_blocks() const
+{
+    return detail::dynamic_bitset_impl::bitset_leaf<Block>(m_bitset).data();
+}
+
+template <typename Block, typename Allocator>
+inline typename rank_select_index<Block, Allocator>::size_type
+rank_select_index<Block, Allocator>::m_num_blocks() const
+{
+    return m_bitset.num_blocks();
+}
+
+// set bits in the blocks [first, last), clamped to the bitset
+template <typename Block, typename Allocator>
+inline typename rank_select_index<Block, Allocator>::size_type
+rank_select_index<Block, Allocator>::m_count_blocks(size_type first, size_type last) const
+{
+    last = (std::min)(last, m_num_blocks());
+    if (first >= last)
+        return 0;
+    return detail::dynamic_bitset_impl::count_block_range(m_blocks() + first,
+                                                          last - first);
+}
+
+template <typename Block, typename Allocator>
+inline typename rank_select_index<Block, Allocator>::size_type
+rank_select_index<Block, Allocator>::m_group_rank(size_type g) const
+{
+    return static_cast<size_type>(m_upper[g / groups_per_upper]
+                                  + (m_groups[g] & 0xffffffffu));
+}
+
+template <typename Block, typename Allocator>
+void rank_select_index<Block, Allocator>::update(size_type pos)
+{
+    assert(pos <= m_num_bits);
+
+    const size_type num_bits = m_bitset.size();
+    const size_type num_groups = (num_bits + group_bits - 1) / group_bits;
+    const size_type old_groups = m_groups.size();
+
+    // the groups before first, and their counts, are still valid
+    const size_type first = (std::min)(pos, num_bits) / group_bits;
+    const size_type first_rank = first < old_groups ? m_group_rank(first) : m_count;
+    size_type total = first_rank;
+
+    m_groups.resize(num_groups);
+    m_upper.resize(num_groups / groups_per_upper + 1);
+
+    for (size_type g = first; g < num_groups; ++g) {
+        if (g % groups_per_upper == 0)
+            m_upper[g / groups_per_upper] = total;
+        const size_type b = g * (group_bits / bits_per_block);
+        boost::uint64_t entry = total - m_upper[g / groups_per_upper];
+        for (size_type k = 0; k < 4; ++k) {
+            const size_type c = m_count_blocks(b + k * blocks_per_basic,
+                                               b + (k + 1) * blocks_per_basic);
+            if (k < 3)
+                entry |= static_cast<boost::uint64_t>(c) << (32 + 10 * k);
+            total += c;
+        }
+        m_groups[g] = entry;
+    }
+    if (num_groups % groups_per_upper == 0)
+        m_upper[num_groups / groups_per_upper] = total;
+
+    // select samples: the group of every select_sample_rate-th set bit
+    const size_type first_sample =
+        (first_rank + select_sample_rate - 1) / select_sample_rate;
+    m_samples.resize((total + select_sample_rate - 1) / select_sample_rate);
+    size_type g = first;
+    for (size_type s = first_sample; s < m_samples.size(); ++s) {
+        const size_type k = s * select_sample_rate;
+        while (g + 1 < num_groups && m_group_rank(g + 1) <= k)
+            ++g;
+        m_samples[s] = static_cast<boost::uint32_t>(g);
+    }
+
+    m_count = total;
+    m_num_bits = num_bits;
+}
+
+template <typename Block, typename Allocator>
+typename rank_select_index<Block, Allocator>::size_type
+rank_select_index<Block, Allocator>::rank(size_type pos) const
+{
+    using detail::dynamic_bitset_impl::popcount_word64;
+
+    assert(pos <= m_num_bits);
+    if (pos == m_num_bits)
+        return m_count;
+
+    const size_type g = pos / group_bits;
+    const boost::uint64_t entry = m_groups[g];
+    size_type r = m_group_rank(g);
+    const size_type basic = (pos % group_bits) / basic_bits;
+    for (size_type k = 0; k < basic; ++k)
+        r += static_cast<size_type>((entry >> (32 + 10 * k)) & 0x3ff);
+
+    const size_type first = pos / basic_bits * blocks_per_basic;
+    const size_type last = pos / bits_per_block;
+    r += m_count_blocks(first, last);
+    const size_type bit = pos % bits_per_block;
+    if (bit != 0) {
+        const Block all = static_cast<Block>(~Block(0));
+        const Block mask = static_cast<Block>(all >> (bits_per_block - bit));
+        r += popcount_word64(m_blocks()[last] & mask);
+    }
+    return r;
+}
+
+template <typename Block, typename Allocator>
+typename rank_select_index<Block, Allocator>::size_type
+rank_select_index<Block, Allocator>::select(size_type k) const
+{
+    using detail::dynamic_bitset_impl::popcount_word64;
+    using detail::dynamic_bitset_impl::select_word64;
+
+    if (k >= m_count)
+        return npos;
+
+    // the last group whose rank is <= k, between two samples
+    const size_type s = k / select_sample_rate;
+    size_type lo = m_samples[s];
+    size_type hi = s + 1 < m_samples.size() ? m_samples[s + 1] + 1 : m_groups.size();
+    while (hi - lo > 1) {
+        const size_type mid = lo + (hi - lo) / 2;
+        if (m_group_rank(mid) <= k)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    // the basic block, then the block
+    const boost::uint64_t entry = m_groups[lo];
+    size_type r = k - m_group_rank(lo);
+    size_type basic = 0;
+    for ( ; basic < 3; ++basic) {
+        const size_type c = static_cast<size_type>((entry >> (32 + 10 * basic)) & 0x3ff);
+        if (r < c)
+            break;
+        r -= c;
+    }
+
+    const Block* const p = m_blocks();
+    size_type i = (lo * 4 + basic) * blocks_per_basic;
+    for ( ; ; ++i) {
+        const size_type c = popcount_word64(p[i]);
+        if (r < c)
+            break;
+        r -= c;
+    }
+    return i * bits_per_block + select_word64(p[i], r);
+}
+
+template <typename Block, typename Allocator>
+typename rank_select_index<Block, Allocator>::size_type
+rank_select_index<Block, Allocator>::memory_usage() const
+{
+    return m_upper.capacity() * sizeof(boost::uint64_t)
+         + m_groups.capacity() * sizeof(boost::uint64_t)
+         + m_samples.capacity() * sizeof(boost::uint32_t);
+}
+
+} // namespace boost
+
+#endif // include guard
@@ -0,0 +1,1123 @@
+// -----------------------------------------------------------
+// roaring_bitset.hpp
+//
+//       A compressed set of 32-bit unsigned integers, in the
+//       manner of Roaring bitmaps
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DYNAMIC_BITSET_ROARING_BITSET_HPP
+#define BOOST_DYNAMIC_BITSET_ROARING_BITSET_HPP
+
+#include <assert.h>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include "boost/cstdint.hpp"
+#include "boost/limits.hpp"
+#include "boost/static_assert.hpp"
+#include "boost/pending/lowest_bit.hpp"
+#include "boost/pending/highest_bit.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset.hpp"
+
+
+namespace boost {
+
+// The positions of the set bits of a bitset of 2^32 bits, split in
+// chunks of 2^16 by their upper 16 bits (Chambi, Lemire, Kaser and
+// Godin, "Better bitmap performance with Roaring bitmaps", 2016; Lemire
+// et al., "Consistently faster and smaller compressed bitmaps with
+// Roaring", 2016). Each non-empty chunk is a container of its lower 16
+// bits, of one of three kinds:
+//
+//   - array: the sorted values, for at most 4096 of them (2 bytes
+//     each);
+//   - bitmap: 2^16 bits (8KB), for more than 4096 values;
+//   - run: the sorted [start, start + length] intervals of the values
+//     (4 bytes each).
+//
+// The kind is the smallest of the three after the conversion from a
+// dynamic_bitset, the bitwise operators and optimize(). deserialize()
+// keeps the kinds of the serialization, whichever they are. set() and
+// reset() only switch between array and bitmap at 4096 values, and
+// leave a run container when it stops being the smallest.
+//
+// Two arrays are combined by merging them (unless | or ^ may give more
+// than 4096 values), an array and anything else by lookups in the
+// latter (for & and -); the other combinations go through 8KB bitmaps
+// and the vector kernels of dynamic_bitset.
+//
+class roaring_bitset
+{
+public:
+    typedef std::size_t size_type;
+
+    BOOST_STATIC_CONSTANT(size_type, npos = static_cast<size_type>(-1));
+
+    roaring_bitset() {}
+
+    // PRE: b.size() <= 2^32
+    template <typename Block, typename Allocator>
+    explicit roaring_bitset(const dynamic_bitset<Block, Allocator>& b);
+
+    // b gets the bits of *this, and keeps its size
+    // PRE: none() || find_last() < b.size()
+    template <typename Block, typename Allocator>
+    void to_bitset(dynamic_bitset<Block, Allocator>& b) const;
+
+    // basic bit operations; PRE: pos < 2^32
+    roaring_bitset& set(size_type pos, bool val = true);
+    roaring_bitset& reset(size_type pos);
+    roaring_bitset& reset();
+    bool test(size_type pos) const;
+    bool operator[](size_type pos) const { return test(pos); }
+
+    size_type count() const;
+    bool any() const { return !m_chunks.empty(); }
+    bool none() const { return m_chunks.empty(); }
+
+    // lookup
+    size_type find_first() const;
+    size_type find_next(size_type pos) const;
+    size_type find_last() const;
+
+    roaring_bitset& operator&=(const roaring_bitset& x);
+    roaring_bitset& operator|=(const roaring_bitset& x);
+    roaring_bitset& operator^=(const roaring_bitset& x);
+    roaring_bitset& operator-=(const roaring_bitset& x);
+
+    // makes every container of the smallest kind
+    void optimize();
+
+    // memory used, in bytes, besides sizeof(roaring_bitset)
+    size_type memory_usage() const;
+
+    // the portable Roaring format (github.com/RoaringBitmap/RoaringFormatSpec),
+    // little endian; deserialize() throws std::invalid_argument if data
+    // is not a valid serialization, of at most n bytes
+    size_type serialized_size() const;
+    size_type serialize(char* out) const;
+    static roaring_bitset deserialize(const char* data, size_type n);
+
+    friend bool operator==(const roaring_bitset& a, const roaring_bitset& b);
+
+private:
+    BOOST_STATIC_CONSTANT(size_type, chunk_bits = 65536);
+    BOOST_STATIC_CONSTANT(size_type, bitmap_words = 1024);
+    BOOST_STATIC_CONSTANT(size_type, array_max = 4096);
+    BOOST_STATIC_CONSTANT(size_type, bitmap_bytes = 8192);
+
+    enum kind_type { array_kind, bitmap_kind, run_kind };
+
+    struct container
+    {
+        boost::uint16_t key;                 // upper 16 bits of the values
+        kind_type kind;
+        boost::uint32_t card;                // number of values, > 0
+        std::vector<boost::uint16_t> values; // array: the values; run: start,
+                                             // length - 1 pairs
+        std::vector<boost::uint64_t> words;  // bitmap
+
+        explicit container(boost::uint16_t k = 0)
+            : key(k), kind(array_kind), card(0) {}
+
+        void swap(container& c)
+        {
+            std::swap(key, c.key);
+            std::swap(kind, c.kind);
+            std::swap(card, c.card);
+            values.swap(c.values);
+            words.swap(c.words);
+        }
+
+        bool operator<(boost::uint16_t k) const { return key < k; }
+    };
+
+    typedef std::vector<container>::iterator chunk_iterator;
+    typedef std::vector<container>::const_iterator const_chunk_iterator;
+
+    chunk_iterator m_find(size_type key);
+    const_chunk_iterator m_find(size_type key) const;
+    bool m_has_runs() const;
+
+    template <int Op>
+    void m_combine(const roaring_bitset& x);
+
+    // on a single container; values are its lower 16 bits, and
+    // chunk_bits stands for "none"
+    static bool c_test(const container& c, size_type v);
+    static size_type c_next(const container& c, size_type v);
+    static size_type c_last(const container& c);
+    static void c_set(container& c, size_type v);
+    static void c_reset(container& c, size_type v);
+    static size_type c_num_runs(const container& c, size_type limit);
+    static size_type c_serialized_size(const container& c);
+    static void c_to_bitmap(const container& c, boost::uint64_t* w);
+    static void c_convert(container& c, kind_type k);
+    static void c_optimize(container& c);
+    static bool c_equal(const container& a, const container& b);
+    template <int Op>
+    static void c_combine(container& a, const container& b);
+
+    // the run of a run container which starts at or before v, or
+    // values.size() / 2 if none does
+    static size_type c_run_before(const container& c, size_type v);
+
+    // on 2^16-bit bitmaps: the first position at or after v whose bit
+    // is val, or chunk_bits
+    static size_type bm_next(const boost::uint64_t* w, size_type v, bool val);
+    static void bm_set_range(boost::uint64_t* w, size_type first, size_type last);
+
+    std::vector<container> m_chunks; // by increasing key
+};
+
+
+// -------- conversions ---------------------------------------------
+
+template <typename Block, typename Allocator>
+roaring_bitset::roaring_bitset(const dynamic_bitset<Block, Allocator>& b)
+{
+    BOOST_STATIC_ASSERT(64 % std::numeric_limits<Block>::digits == 0);
+    assert(b.size() == 0 || b.size() - 1 <= 0xffffffffu);
+
+    const size_type digits = std::numeric_limits<Block>::digits;
+    const size_type per_word = 64 / digits;
+    const size_type per_chunk = chunk_bits / digits;
+
+    const Block* const p = detail::dynamic_bitset_impl::bitset_leaf<Block>(b).data();
+    const size_type n = b.num_blocks();
+    boost::uint64_t w[bitmap_words];
+    for (size_type first = 0; first < n; first += per_chunk) {
+        const size_type last = (std::min)(first + per_chunk, n);
+        std::fill(w, w + bitmap_words, boost::uint64_t(0));
+        for (size_type i = first; i < last; ++i)
+            w[(i - first) / per_word] |=
+                static_cast<boost::uint64_t>(p[i]) << ((i - first) % per_word * digits);
+
+        const size_type card =
+            detail::dynamic_bitset_impl::count_block_range(w, bitmap_words);
+        if (card == 0)
+            continue;
+
+        m_chunks.push_back(container(static_cast<boost::uint16_t>(first / per_chunk)));
+        container& c = m_chunks.back();
+        c.kind = bitmap_kind;
+        c.card = static_cast<boost::uint32_t>(card);
+        c.words.assign(w, w + bitmap_words);
+        c_optimize(c);
+    }
+}
+
+template <typename Block, typename Allocator>
+void roaring_bitset::to_bitset(dynamic_bitset<Block, Allocator>& b) const
+{
+    BOOST_STATIC_ASSERT(64 % std::numeric_limits<Block>::digits == 0);
+    assert(none() || find_last() < b.size());
+
+    const size_type digits = std::numeric_limits<Block>::digits;
+    const size_type per_word = 64 / digits;
+    const size_type per_chunk = chunk_bits / digits;
+
+    std::vector<Block> blocks(b.num_blocks());
+    boost::uint64_t w[bitmap_words];
+    for (const_chunk_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it) {
+        c_to_bitmap(*it, w);
+        const size_type first = it->key * per_chunk;
+        const size_type n = (std::min)(per_chunk, blocks.size() - first);
+        for (size_type i = 0; i < n; ++i)
+            blocks[first + i] = static_cast<Block>(w[i / per_word] >> (i % per_word * digits));
+    }
+    from_block_range(blocks.begin(), blocks.end(), b);
+}
+
+
+// -------- 2^16-bit bitmaps ----------------------------------------
+
+inline roaring_bitset::size_type
+roaring_bitset::bm_next(const boost::uint64_t* w, size_type v, bool val)
+{
+    const boost::uint64_t flip = val ? 0 : ~boost::uint64_t(0);
+    if (v >= chunk_bits)
+        return chunk_bits;
+
+    size_type i = v / 64;
+    boost::uint64_t x = (w[i] ^ flip) >> (v % 64);
+    if (x)
+        return v + boost::lowest_bit(x);
+    for (++i; i < bitmap_words; ++i)
+        if ((x = w[i] ^ flip) != 0)
+            return i * 64 + boost::lowest_bit(x);
+    return chunk_bits;
+}
+
+// PRE: first <= last < chunk_bits
+inline void roaring_bitset::bm_set_range(boost::uint64_t* w, size_type first, size_type last)
+{
+    const boost::uint64_t all = ~boost::uint64_t(0);
+    const size_type i = first / 64;
+    const size_type j = last / 64;
+    const boost::uint64_t head = all << (first % 64);
+    const boost::uint64_t tail = all >> (63 - last % 64);
+    if (i == j) {
+        w[i] |= head & tail;
+        return;
+    }
+    w[i] |= head;
+    std::fill(w + i + 1, w + j, all);
+    w[j] |= tail;
+}
+
+
+// -------- containers ----------------------------------------------
+
+inline roaring_bitset::size_type
+roaring_bitset::c_run_before(const container& c, size_type v)
+{
+    // the first run starting after v, then the one before it
+    size_type lo = 0;
+    size_type hi = c.values.size() / 2;
+    while (lo < hi) {
+        const size_type mid = lo + (hi - lo) / 2;
+        if (c.values[2 * mid] <= v)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo == 0 ? c.values.size() / 2 : lo - 1;
+}
+
+inline bool roaring_bitset::c_test(const container& c, size_type v)
+{
+    switch (c.kind) {
+    case array_kind:
+        return std::binary_search(c.values.begin(), c.values.end(),
+                                  static_cast<boost::uint16_t>(v));
+    case bitmap_kind:
+        return (c.words[v / 64] >> (v % 64)) & 1;
+    default: {
+        const size_type r = c_run_before(c, v);
+        return r < c.values.size() / 2
+            && v <= size_type(c.values[2 * r]) + c.values[2 * r + 1];
+    }
+    }
+}
+
+inline roaring_bitset::size_type
+roaring_bitset::c_next(const container& c, size_type v)
+{
+    if (v >= chunk_bits)
+        return chunk_bits;
+
+    switch (c.kind) {
+    case array_kind: {
+        const std::vector<boost::uint16_t>::const_iterator it =
+            std::lower_bound(c.values.begin(), c.values.end(),
+                             static_cast<boost::uint16_t>(v));
+        return it == c.values.end() ? size_type(chunk_bits) : *it;
+    }
+    case bitmap_kind:
+        return bm_next(&c.words[0], v, true);
+    default: {
+        const size_type runs = c.values.size() / 2;
+        size_type r = c_run_before(c, v);
+        if (r < runs && v <= size_type(c.values[2 * r]) + c.values[2 * r + 1])
+            return v;
+        r = r < runs ? r + 1 : 0; // the first run after v
+        return r < runs ? size_type(c.values[2 * r]) : size_type(chunk_bits);
+    }
+    }
+}
+
+inline roaring_bitset::size_type roaring_bitset::c_last(const container& c)
+{
+    switch (c.kind) {
+    case array_kind:
+        return c.values.back();
+    case bitmap_kind: {
+        size_type i = bitmap_words;
+        while (c.words[i - 1] == 0)
+            --i;
+        return (i - 1) * 64 + boost::highest_bit(c.words[i - 1]);
+    }
+    default:
+        return size_type(c.values[c.values.size() - 2]) + c.values.back();
+    }
+}
+
+// the number of runs, or a number >= limit if there are more
+//
+inline roaring_bitset::size_type roaring_bitset::c_num_runs(const container& c,
+                                                            size_type limit)
+{
+    size_type n = 0;
+    switch (c.kind) {
+    case array_kind:
+        for (size_type i = 0; i < c.values.size() && n < limit; ++i)
+            n += i == 0 || c.values[i] != c.values[i - 1] + 1;
+        return n;
+    case bitmap_kind: {
+        // the bits on whose predecessor is off
+        boost::uint64_t carry = 0;
+        for (size_type i = 0; i < bitmap_words && n < limit; ++i) {
+            const boost::uint64_t w = c.words[i];
+            n += detail::dynamic_bitset_impl::popcount_word64(w & ~((w << 1) | carry));
+            carry = w >> 63;
+        }
+        return n;
+    }
+    default:
+        return c.values.size() / 2;
+    }
+}
+
+inline roaring_bitset::size_type roaring_bitset::c_serialized_size(const container& c)
+{
+    switch (c.kind) {
+    case array_kind:  return 2 * c.card;
+    case bitmap_kind: return bitmap_bytes;
+    default:          return 2 + 2 * c.values.size();
+    }
+}
+
+// PRE: w has bitmap_words words
+inline void roaring_bitset::c_to_bitmap(const container& c, boost::uint64_t* w)
+{
+    if (c.kind == bitmap_kind) {
+        std::copy(c.words.begin(), c.words.end(), w);
+        return;
+    }
+
+    std::fill(w, w + bitmap_words, boost::uint64_t(0));
+    if (c.kind == array_kind)
+        for (size_type i = 0; i < c.values.size(); ++i)
+            w[c.values[i] / 64] |= boost::uint64_t(1) << (c.values[i] % 64);
+    else
+        for (size_type i = 0; i < c.values.size(); i += 2)
+            bm_set_range(w, c.values[i], size_type(c.values[i]) + c.values[i + 1]);
+}
+
+// through a bitmap: conversions are rare, and each one visits at most
+// 8KB
+//
+inline void roaring_bitset::c_convert(container& c, kind_type k)
+{
+    if (c.kind == k)
+        return;
+
+    boost::uint64_t w[bitmap_words];
+    c_to_bitmap(c, w);
+    std::vector<boost::uint16_t>().swap(c.values);
+    std::vector<boost::uint64_t>().swap(c.words);
+    c.kind = k;
+
+    switch (k) {
+    case array_kind:
+        c.values.reserve(c.card);
+        for (size_type i = 0; i < bitmap_words; ++i)
+            for (boost::uint64_t x = w[i]; x != 0; x &= x - 1)
+                c.values.push_back(static_cast<boost::uint16_t>(i * 64 + boost::lowest_bit(x)));
+        break;
+    case bitmap_kind:
+        c.words.assign(w, w + bitmap_words);
+        break;
+    default:
+        for (size_type v = bm_next(w, 0, true); v < chunk_bits; ) {
+            const size_type end = bm_next(w, v, false);
+            c.values.push_back(static_cast<boost::uint16_t>(v));
+            c.values.push_back(static_cast<boost::uint16_t>(end - 1 - v));
+            v = bm_next(w, end, true);
+        }
+        break;
+    }
+}
+
+// array up to array_max values, bitmap beyond, unless runs are smaller
+//
+inline void roaring_bitset::c_optimize(container& c)
+{
+    const size_type bytes = c.card <= array_max ? 2 * c.card : bitmap_bytes;
+    const size_type run_bytes = 2 + 4 * c_num_runs(c, bytes / 4);
+    if (run_bytes < bytes)
+        c_convert(c, run_kind);
+    else
+        c_convert(c, c.card <= array_max ? array_kind : bitmap_kind);
+}
+
+inline void roaring_bitset::c_set(container& c, size_type v)
+{
+    switch (c.kind) {
+    case array_kind: {
+        const boost::uint16_t x = static_cast<boost::uint16_t>(v);
+        const std::vector<boost::uint16_t>::iterator it =
+            std::lower_bound(c.values.begin(), c.values.end(), x);
+        if (it != c.values.end() && *it == x)
+            return;
+        c.values.insert(it, x);
+        if (++c.card > array_max)
+            c_convert(c, bitmap_kind);
+        return;
+    }
+    case bitmap_kind: {
+        boost::uint64_t& w = c.words[v / 64];
+        const boost::uint64_t mask = boost::uint64_t(1) << (v % 64);
+        c.card += (w & mask) == 0;
+        w |= mask;
+        return;
+    }
+    default:
+        break;
+    }
+
+    // extend the run before v, or the one after, or both (merging
+    // them), or insert a run of one value
+    std::vector<boost::uint16_t>& r = c.values;
+    const size_type runs = r.size() / 2;
+    const size_type p = c_run_before(c, v);
+    const size_type i = p < runs ? p + 1 : 0;    // the first run after v
+    const size_type prev_end = p < runs ? size_type(r[2 * p]) + r[2 * p + 1] : 0;
+    if (p < runs && v <= prev_end)
+        return;
+
+    const bool join_prev = p < runs && prev_end + 1 == v;
+    const bool join_next = i < runs && size_type(r[2 * i]) == v + 1;
+    if (join_prev && join_next) {
+        r[2 * p + 1] = static_cast<boost::uint16_t>(r[2 * p + 1] + r[2 * i + 1] + 2);
+        r.erase(r.begin() + 2 * i, r.begin() + 2 * i + 2);
+    }
+    else if (join_prev)
+        ++r[2 * p + 1];
+    else if (join_next) {
+        --r[2 * i];
+        ++r[2 * i + 1];
+    }
+    else {
+        const boost::uint16_t run[2] = { static_cast<boost::uint16_t>(v), 0 };
+        r.insert(r.begin() + 2 * i, run, run + 2);
+    }
+    ++c.card;
+
+    const size_type bytes = c.card <= array_max ? 2 * c.card : bitmap_bytes;
+    if (2 + 2 * r.size() > bytes)
+        c_optimize(c);
+}
+
+inline void roaring_bitset::c_reset(container& c, size_type v)
+{
+    switch (c.kind) {
+    case array_kind: {
+        const boost::uint16_t x = static_cast<boost::uint16_t>(v);
+        const std::vector<boost::uint16_t>::iterator it =
+            std::lower_bound(c.values.begin(), c.values.end(), x);
+        if (it != c.values.end() && *it == x) {
+            c.values.erase(it);
+            --c.card;
+        }
+        return;
+    }
+    case bitmap_kind: {
+        boost::uint64_t& w = c.words[v / 64];
+        const boost::uint64_t mask = boost::uint64_t(1) << (v % 64);
+        if ((w & mask) == 0)
+            return;
+        w &= ~mask;
+        if (--c.card <= array_max)
+            c_convert(c, array_kind);
+        return;
+    }
+    default:
+        break;
+    }
+
+    // shorten the run containing v, or split it in two
+    std::vector<boost::uint16_t>& r = c.values;
+    const size_type p = c_run_before(c, v);
+    if (p == r.size() / 2)
+        return;
+    const size_type start = r[2 * p];
+    const size_type end = start + r[2 * p + 1];
+    if (v > end)
+        return;
+
+    if (start == end)
+        r.erase(r.begin() + 2 * p, r.begin() + 2 * p + 2);
+    else if (v == start) {
+        ++r[2 * p];
+        --r[2 * p + 1];
+    }
+    else if (v == end)
+        --r[2 * p + 1];
+    else {
+        r[2 * p + 1] = static_cast<boost::uint16_t>(v - 1 - start);
+        const boost::uint16_t run[2] = { static_cast<boost::uint16_t>(v + 1),
+                                         static_cast<boost::uint16_t>(end - v - 1) };
+        r.insert(r.begin() + 2 * p + 2, run, run + 2);
+    }
+    --c.card;
+
+    const size_type bytes = c.card <= array_max ? 2 * c.card : bitmap_bytes;
+    if (c.card != 0 && 2 + 2 * r.size() > bytes)
+        c_optimize(c);
+}
+
+inline bool roaring_bitset::c_equal(const container& a, const container& b)
+{
+    if (a.key != b.key || a.card != b.card)
+        return false;
+    // runs are compared as bitmaps, as a run may end where the next
+    // one starts in deserialized data
+    if (a.kind == b.kind && a.kind != run_kind)
+        return a.values == b.values && a.words == b.words;
+
+    boost::uint64_t wa[bitmap_words], wb[bitmap_words];
+    c_to_bitmap(a, wa);
+    c_to_bitmap(b, wb);
+    return std::equal(wa, wa + bitmap_words, wb);
+}
+
+// a = a Op b, for containers of the same key; a may become empty
+//
+template <int Op>
+void roaring_bitset::c_combine(container& a, const container& b)
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    std::vector<boost::uint16_t> out;
+
+    // & and - of two larger arrays look the values of a up in a bitmap
+    // of b, | and ^ are likely to give a bitmap
+    const size_type merge_max = 256;
+    const bool arrays = a.kind == array_kind && b.kind == array_kind;
+    if (arrays && (Op == op_and || Op == op_sub) && b.card > merge_max) {
+        boost::uint64_t w[bitmap_words];
+        c_to_bitmap(b, w);
+        out.resize(a.values.size());
+        size_type n = 0;
+        for (size_type i = 0; i < a.values.size(); ++i) {
+            const size_type v = a.values[i];
+            out[n] = a.values[i];
+            n += ((w[v / 64] >> (v % 64)) & 1) == (Op == op_and);
+        }
+        out.resize(n);
+    }
+    else if (arrays && (Op == op_and || Op == op_sub || a.card + b.card <= array_max)) {
+        const std::vector<boost::uint16_t>& x = a.values;
+        const std::vector<boost::uint16_t>& y = b.values;
+        std::back_insert_iterator<std::vector<boost::uint16_t> > it(out);
+        switch (Op) {
+        case op_and:
+            out.reserve((std::min)(x.size(), y.size()));
+            std::set_intersection(x.begin(), x.end(), y.begin(), y.end(), it);
+            break;
+        case op_or:
+            out.reserve(x.size() + y.size());
+            std::set_union(x.begin(), x.end(), y.begin(), y.end(), it);
+            break;
+        case op_xor:
+            out.reserve(x.size() + y.size());
+            std::set_symmetric_difference(x.begin(), x.end(), y.begin(), y.end(), it);
+            break;
+        default:
+            out.reserve(x.size());
+            std::set_difference(x.begin(), x.end(), y.begin(), y.end(), it);
+            break;
+        }
+    }
+    else if ((Op == op_and || Op == op_sub) && a.kind == array_kind) {
+        out.reserve(a.values.size());
+        for (size_type i = 0; i < a.values.size(); ++i)
+            if (c_test(b, a.values[i]) == (Op == op_and))
+                out.push_back(a.values[i]);
+    }
+    else if (Op == op_and && b.kind == array_kind) {
+        out.reserve(b.values.size());
+        for (size_type i = 0; i < b.values.size(); ++i)
+            if (c_test(a, b.values[i]))
+                out.push_back(b.values[i]);
+    }
+    else {
+        boost::uint64_t w[bitmap_words];
+        c_convert(a, bitmap_kind);
+        const boost::uint64_t* s = &w[0];
+        if (b.kind == bitmap_kind)
+            s = &b.words[0];
+        else
+            c_to_bitmap(b, w);
+        bitwise_blocks<Op>(&a.words[0], s, bitmap_words);
+        a.card = static_cast<boost::uint32_t>(count_block_range(&a.words[0], bitmap_words));
+        if (a.card != 0)
+            c_optimize(a);
+        return;
+    }
+
+    // the result of the merges and lookups is an array, of any size
+    a.kind = array_kind;
+    a.card = static_cast<boost::uint32_t>(out.size());
+    a.values.swap(out);
+    std::vector<boost::uint64_t>().swap(a.words);
+    if (a.card != 0)
+        c_optimize(a);
+}
+
+
+// -------- roaring_bitset ------------------------------------------
+
+inline roaring_bitset::chunk_iterator roaring_bitset::m_find(size_type key)
+{
+    return std::lower_bound(m_chunks.begin(), m_chunks.end(),
+                            static_cast<boost::uint16_t>(key));
+}
+
+inline roaring_bitset::const_chunk_iterator roaring_bitset::m_find(size_type key) const
+{
+    return std::lower_bound(m_chunks.begin(), m_chunks.end(),
+                            static_cast<boost::uint16_t>(key));
+}
+
+inline bool roaring_bitset::m_has_runs() const
+{
+    for (const_chunk_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+        if (it->kind == run_kind)
+            return true;
+    return false;
+}
+
+inline roaring_bitset& roaring_bitset::set(size_type pos, bool val)
+{
+    assert(pos <= 0xffffffffu);
+
+    if (!val)
+        return reset(pos);
+
+    const size_type key = pos >> 16;
+    chunk_iterator it = m_find(key);
+    if (it == m_chunks.end() || it->key != key)
+        it = m_chunks.insert(it, container(static_cast<boost::uint16_t>(key)));
+    c_set(*it, pos & 0xffff);
+    return *this;
+}
+
+inline roaring_bitset& roaring_bitset::reset(size_type pos)
+{
+    assert(pos <= 0xffffffffu);
+
+    const size_type key = pos >> 16;
+    const chunk_iterator it = m_find(key);
+    if (it != m_chunks.end() && it->key == key) {
+        c_reset(*it, pos & 0xffff);
+        if (it->card == 0)
+            m_chunks.erase(it);
+    }
+    return *this;
+}
+
+inline roaring_bitset& roaring_bitset::reset()
+{
+    m_chunks.clear();
+    return *this;
+}
+
+inline bool roaring_bitset::test(size_type pos) const
+{
+    assert(pos <= 0xffffffffu);
+
+    const size_type key = pos >> 16;
+    const const_chunk_iterator it = m_find(key);
+    return it != m_chunks.end() && it->key == key && c_test(*it, pos & 0xffff);
+}
+
+inline roaring_bitset::size_type roaring_bitset::count() const
+{
+    size_type n = 0;
+    for (const_chunk_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+        n += it->card;
+    return n;
+}
+
+inline roaring_bitset::size_type roaring_bitset::find_first() const
+{
+    return m_chunks.empty() ? npos
+        : (size_type(m_chunks[0].key) << 16) + c_next(m_chunks[0], 0);
+}
+
+inline roaring_bitset::size_type roaring_bitset::find_next(size_type pos) const
+{
+    if (pos >= 0xffffffffu)
+        return npos;
+
+    ++pos;
+
+    const size_type key = pos >> 16;
+    const_chunk_iterator it = m_find(key);
+    if (it == m_chunks.end())
+        return npos;
+    if (it->key == key) {
+        const size_type v = c_next(*it, pos & 0xffff);
+        if (v < chunk_bits)
+            return (key << 16) + v;
+        if (++it == m_chunks.end())
+            return npos;
+    }
+    return (size_type(it->key) << 16) + c_next(*it, 0);
+}
+
+inline roaring_bitset::size_type roaring_bitset::find_last() const
+{
+    return m_chunks.empty() ? npos
+        : (size_type(m_chunks.back().key) << 16) + c_last(m_chunks.back());
+}
+
+// a merge of the keys: & keeps the common ones, - those of *this, |
+// and ^ all of them
+//
+template <int Op>
+void roaring_bitset::m_combine(const roaring_bitset& x)
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    const bool keep_left = Op != op_and;
+    const bool keep_right = Op == op_or || Op == op_xor;
+
+    std::vector<container> r;
+    r.reserve(m_chunks.size() + (keep_right ? x.m_chunks.size() : 0));
+
+    chunk_iterator i = m_chunks.begin();
+    const_chunk_iterator j = x.m_chunks.begin();
+    while (i != m_chunks.end() || j != x.m_chunks.end()) {
+        if (j == x.m_chunks.end() || (i != m_chunks.end() && i->key < j->key)) {
+            if (keep_left) {
+                r.push_back(container());
+                r.back().swap(*i);
+            }
+            ++i;
+        }
+        else if (i == m_chunks.end() || j->key < i->key) {
+            if (keep_right)
+                r.push_back(*j);
+            ++j;
+        }
+        else {
+            c_combine<Op>(*i, *j);
+            if (i->card != 0) {
+                r.push_back(container());
+                r.back().swap(*i);
+            }
+            ++i;
+            ++j;
+        }
+    }
+    m_chunks.swap(r);
+}
+
+inline roaring_bitset& roaring_bitset::operator&=(const roaring_bitset& x)
+{
+    m_combine<detail::dynamic_bitset_impl::op_and>(x);
+    return *this;
+}
+
+inline roaring_bitset& roaring_bitset::operator|=(const roaring_bitset& x)
+{
+    m_combine<detail::dynamic_bitset_impl::op_or>(x);
+    return *this;
+}
+
+inline roaring_bitset& roaring_bitset::operator^=(const roaring_bitset& x)
+{
+    m_combine<detail::dynamic_bitset_impl::op_xor>(x);
+    return *this;
+}
+
+inline roaring_bitset& roaring_bitset::operator-=(const roaring_bitset& x)
+{
+    m_combine<detail::dynamic_bitset_impl::op_sub>(x);
+    return *this;
+}
+
+inline void roaring_bitset::optimize()
+{
+    for (chunk_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+        c_optimize(*it);
+}
+
+inline roaring_bitset::size_type roaring_bitset::memory_usage() const
+{
+    size_type n = m_chunks.capacity() * sizeof(container);
+    for (const_chunk_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+        n += it->values.capacity() * sizeof(boost::uint16_t)
+           + it->words.capacity() * sizeof(boost::uint64_t);
+    return n;
+}
+
+
+// -------- serialization -------------------------------------------
+//
+// A cookie, then the key and the cardinality - 1 of each container
+// (16 bits each), the offsets of the containers from the start (32 bits
+// each), and the containers. With run containers, the cookie includes
+// the number of containers and is followed by a bitset of the run
+// ones, and the offsets are only there for 4 containers or more.
+
+  namespace detail {
+  namespace dynamic_bitset_impl {
+
+    const boost::uint32_t roaring_cookie = 12346;
+    const boost::uint32_t roaring_run_cookie = 12347;
+    const std::size_t roaring_no_offset_threshold = 4;
+
+    inline char * put_le(char * out, boost::uint64_t x, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i, x >>= 8)
+            *out++ = static_cast<char>(x & 0xff);
+        return out;
+    }
+
+    // reads little endian values, and throws on reading past the end
+    class roaring_reader
+    {
+    public:
+        roaring_reader(const char * p, std::size_t n)
+            : m_first(reinterpret_cast<const unsigned char *>(p)),
+              m_p(m_first), m_last(m_first + n)
+        {}
+
+        boost::uint64_t get(int bytes)
+        {
+            need(bytes);
+            boost::uint64_t x = 0;
+            for (int i = 0; i < bytes; ++i)
+                x |= static_cast<boost::uint64_t>(*m_p++) << (8 * i);
+            return x;
+        }
+
+        const unsigned char * skip(std::size_t n)
+        {
+            need(n);
+            const unsigned char * const p = m_p;
+            m_p += n;
+            return p;
+        }
+
+        std::size_t offset() const { return m_p - m_first; }
+
+        // throws unless n more bytes can be read
+        void need(std::size_t n) const
+        {
+            if (static_cast<std::size_t>(m_last - m_p) < n)
+                invalid();
+        }
+
+        static void invalid()
+        {
+            throw std::invalid_argument("boost::roaring_bitset::deserialize: invalid data");
+        }
+
+    private:
+        const unsigned char * m_first;
+        const unsigned char * m_p;
+        const unsigned char * m_last;
+    };
+
+  } // dynamic_bitset_impl
+  } // namespace detail
+
+inline roaring_bitset::size_type roaring_bitset::serialized_size() const
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    const size_type n = m_chunks.size();
+    const bool runs = m_has_runs();
+    size_type bytes = runs ? 4 + (n + 7) / 8 : 8;
+    bytes += 4 * n;
+    if (!runs || n >= roaring_no_offset_threshold)
+        bytes += 4 * n;
+    for (const_chunk_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+        bytes += c_serialized_size(*it);
+    return bytes;
+}
+
+// PRE: out has room for serialized_size() bytes
+//
+inline roaring_bitset::size_type roaring_bitset::serialize(char* out) const
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    char* const first = out;
+    const size_type n = m_chunks.size();
+    const bool runs = m_has_runs();
+
+    if (runs) {
+        out = put_le(out, roaring_run_cookie | ((n - 1) << 16), 4);
+        for (size_type i = 0; i < n; i += 8) {
+            unsigned flags = 0;
+            for (size_type k = i; k < n && k < i + 8; ++k)
+                flags |= unsigned(m_chunks[k].kind == run_kind) << (k - i);
+            out = put_le(out, flags, 1);
+        }
+    }
+    else {
+        out = put_le(out, roaring_cookie, 4);
+        out = put_le(out, n, 4);
+    }
+
+    for (size_type i = 0; i < n; ++i) {
+        out = put_le(out, m_chunks[i].key, 2);
+        out = put_le(out, m_chunks[i].card - 1, 2);
+    }
+
+    if (!runs || n >= roaring_no_offset_threshold) {
+        size_type offset = (out - first) + 4 * n;
+        for (size_type i = 0; i < n; ++i) {
+            out = put_le(out, offset, 4);
+            offset += c_serialized_size(m_chunks[i]);
+        }
+    }
+
+    for (size_type i = 0; i < n; ++i) {
+        const container& c = m_chunks[i];
+        if (c.kind == run_kind)
+            out = put_le(out, c.values.size() / 2, 2);
+        for (size_type k = 0; k < c.values.size(); ++k)
+            out = put_le(out, c.values[k], 2);
+        for (size_type k = 0; k < c.words.size(); ++k)
+            out = put_le(out, c.words[k], 8);
+    }
+    return out - first;
+}
+
+// the containers keep the kinds they are stored with, which makes
+// serialize() the inverse of deserialize()
+//
+inline roaring_bitset roaring_bitset::deserialize(const char* data, size_type n)
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    roaring_reader in(data, n);
+    const boost::uint32_t cookie = static_cast<boost::uint32_t>(in.get(4));
+
+    size_type num = 0;
+    const unsigned char* run_flags = 0;
+    if ((cookie & 0xffff) == roaring_run_cookie) {
+        num = (cookie >> 16) + 1;
+        run_flags = in.skip((num + 7) / 8);
+    }
+    else if (cookie == roaring_cookie) {
+        num = static_cast<size_type>(in.get(4));
+        if (num > chunk_bits)
+            roaring_reader::invalid();
+    }
+    else
+        roaring_reader::invalid();
+
+    // num comes from the data: its keys and cardinalities must be there
+    // before anything is allocated for it
+    in.need(4 * num);
+    roaring_bitset r;
+    r.m_chunks.resize(num);
+    for (size_type i = 0; i < num; ++i) {
+        container& c = r.m_chunks[i];
+        c.key = static_cast<boost::uint16_t>(in.get(2));
+        c.card = static_cast<boost::uint32_t>(in.get(2)) + 1;
+        if (i > 0 && c.key <= r.m_chunks[i - 1].key)
+            roaring_reader::invalid();
+    }
+
+    // the containers follow each other: the offsets are not needed
+    if (run_flags == 0 || num >= roaring_no_offset_threshold)
+        in.skip(4 * num);
+
+    for (size_type i = 0; i < num; ++i) {
+        container& c = r.m_chunks[i];
+        if (run_flags && (run_flags[i / 8] >> (i % 8)) & 1) {
+            c.kind = run_kind;
+            const size_type runs = static_cast<size_type>(in.get(2));
+            c.values.resize(2 * runs);
+            size_type card = 0;
+            size_type next = 0; // the first value a run may start at
+            for (size_type k = 0; k < runs; ++k) {
+                const size_type start = static_cast<size_type>(in.get(2));
+                const size_type length = static_cast<size_type>(in.get(2));
+                if (start < next || start + length >= chunk_bits)
+                    roaring_reader::invalid();
+                c.values[2 * k] = static_cast<boost::uint16_t>(start);
+                c.values[2 * k + 1] = static_cast<boost::uint16_t>(length);
+                card += length + 1;
+                next = start + length + 1;
+            }
+            if (card != c.card)
+                roaring_reader::invalid();
+        }
+        else if (c.card <= array_max) {
+            c.kind = array_kind;
+            c.values.resize(c.card);
+            for (size_type k = 0; k < c.card; ++k) {
+                c.values[k] = static_cast<boost::uint16_t>(in.get(2));
+                if (k > 0 && c.values[k] <= c.values[k - 1])
+                    roaring_reader::invalid();
+            }
+        }
+        else {
+            c.kind = bitmap_kind;
+            c.words.resize(bitmap_words);
+            for (size_type k = 0; k < bitmap_words; ++k)
+                c.words[k] = in.get(8);
+            if (count_block_range(&c.words[0], bitmap_words) != c.card)
+                roaring_reader::invalid();
+        }
+    }
+    return r;
+}
+
+
+//-----------------------------------------------------------------------------
+// comparison
+
+inline bool operator==(const roaring_bitset& a, const roaring_bitset& b)
+{
+    if (a.m_chunks.size() != b.m_chunks.size())
+        return false;
+    for (std::size_t i = 0; i < a.m_chunks.size(); ++i)
+        if (!roaring_bitset::c_equal(a.m_chunks[i], b.m_chunks[i]))
+            return false;
+    return true;
+}
+
+inline bool operator!=(const roaring_bitset& a, const roaring_bitset& b)
+{
+    return !(a == b);
+}
+
+//-----------------------------------------------------------------------------
+// bitset operations
+
+inline roaring_bitset operator&(const roaring_bitset& x, const roaring_bitset& y)
+{
+    roaring_bitset b(x);
+    return b &= y;
+}
+
+inline roaring_bitset operator|(const roaring_bitset& x, const roaring_bitset& y)
+{
+    roaring_bitset b(x);
+    return b |= y;
+}
+
+inline roaring_bitset operator^(const roaring_bitset& x, const roaring_bitset& y)
+{
+    roaring_bitset b(x);
+    return b ^= y;
+}
+
+inline roaring_bitset operator-(const roaring_bitset& x, const roaring_bitset& y)
+{
+    roaring_bitset b(x);
+    return b -= y;
+}
+
+} // namespace boost
+
+#endif // include guard
@@ -0,0 +1,669 @@
+// -----------------------------------------------------------
+// text_codecs.hpp
+//
+//       Hexadecimal and base64 text for dynamic_bitset, and a
+//       formatter for std::format and {fmt}
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_DYNAMIC_BITSET_TEXT_CODECS_HPP
+#define BOOST_DYNAMIC_BITSET_TEXT_CODECS_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <string>
+#include "boost/config.hpp"
+#include "boost/cstdint.hpp"
+#include "boost/limits.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset.hpp"
+#include "boost/dynamic_bitset/dynamic_bitset_view.hpp"
+#include "boost/detail/dynamic_bitset_kernels.hpp"
+
+#if !defined(BOOST_NO_CXX17_HDR_STRING_VIEW)
+# include <string_view>
+#endif
+
+#if defined(__has_include)
+# if __has_include(<format>) && __cplusplus >= 202002L
+#  include <format>
+# endif
+#endif
+
+
+// Hexadecimal text is the bits as a number, the most significant digit
+// first as with to_string(): digit i from the right holds the bits
+// [4 i, 4 i + 4). Base64 (RFC 4648, with padding) is the bytes of the
+// bitset, byte k holding the bits [8 k, 8 k + 8), as in the binary
+// format. Neither records the size: the readers give the bitset the
+// size of the text (4 bits per digit, 8 per byte), or num_bits.
+
+namespace boost {
+
+  namespace detail {
+  namespace dynamic_bitset_impl {
+
+    // ------- hexadecimal kernels ----------------------------
+
+    // As the format and parse kernels, 16 digits per 64-bit word:
+    // w[k] goes to the 16 characters which end 16 * k characters before
+    // last, the most significant digit first. The digits are lowercase;
+    // decoding also takes uppercase, and returns false if a character
+    // is not a digit (out is then unspecified).
+    //
+    typedef void (*hex_encode_function)(const boost::uint64_t *, std::size_t, char *);
+    typedef bool (*hex_decode_function)(const char *, std::size_t, boost::uint64_t *);
+
+    inline boost::uint64_t reverse_bytes64(boost::uint64_t x)
+    {
+        x = ((x >> 8) & UINT64_C(0x00ff00ff00ff00ff)) | ((x & UINT64_C(0x00ff00ff00ff00ff)) << 8);
+        x = ((x >> 16) & UINT64_C(0x0000ffff0000ffff)) | ((x & UINT64_C(0x0000ffff0000ffff)) << 16);
+        return (x >> 32) | (x << 32);
+    }
+
+    // the eight nibbles of v in the bytes of the result, the most
+    // significant one in the low byte
+    inline boost::uint64_t spread_nibbles(boost::uint64_t v)
+    {
+        v = ((v << 16) | v) & UINT64_C(0x0000ffff0000ffff);
+        v = ((v << 8) | v) & UINT64_C(0x00ff00ff00ff00ff);
+        v = ((v << 4) | v) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+        return reverse_bytes64(v);
+    }
+
+    // the inverse of spread_nibbles()
+    inline boost::uint64_t gather_nibbles(boost::uint64_t v)
+    {
+        v = reverse_bytes64(v);
+        v = (v | (v >> 4)) & UINT64_C(0x00ff00ff00ff00ff);
+        v = (v | (v >> 8)) & UINT64_C(0x0000ffff0000ffff);
+        return (v | (v >> 16)) & UINT64_C(0x00000000ffffffff);
+    }
+
+    // a byte of x + 0x76 has its high bit set iff the byte is above 9
+    inline void hex_encode_word_kernel(const boost::uint64_t * w, std::size_t n,
+                                       char * last)
+    {
+        const boost::uint64_t lows = UINT64_C(0x0101010101010101);
+        for (std::size_t k = 0; k < n; ++k) {
+            char * const p = last - 16 * (k + 1);
+            for (int h = 0; h < 2; ++h) {
+                const boost::uint64_t x =
+                    spread_nibbles((w[k] >> (32 * (1 - h))) & UINT64_C(0xffffffff));
+                const boost::uint64_t letters = ((x + 0x76 * lows) >> 7) & lows;
+                store_chars64(p + 8 * h, x + 0x30 * lows + 39 * letters);
+            }
+        }
+    }
+
+    // the bytes of x in [lo, hi] get their high bit set
+    // PRE: the bytes of x are below 0x80
+    inline boost::uint64_t bytes_in_range(boost::uint64_t x, unsigned lo, unsigned hi)
+    {
+        const boost::uint64_t lows = UINT64_C(0x0101010101010101);
+        return (x + (0x80 - lo) * lows) & ~(x + (0x7f - hi) * lows) & (0x80 * lows);
+    }
+
+    inline bool hex_decode_word_kernel(const char * last, std::size_t n,
+                                       boost::uint64_t * out)
+    {
+        const boost::uint64_t lows = UINT64_C(0x0101010101010101);
+        const boost::uint64_t highs = 0x80 * lows;
+        boost::uint64_t bad = 0;
+        for (std::size_t k = 0; k < n; ++k) {
+            const char * const p = last - 16 * (k + 1);
+            boost::uint64_t w = 0;
+            for (int h = 0; h < 2; ++h) {
+                const boost::uint64_t x = load_chars64(p + 8 * h);
+                const boost::uint64_t valid = bytes_in_range(x, '0', '9')
+                                            | bytes_in_range(x | 0x20 * lows, 'a', 'f');
+                bad |= (x & highs) | (~valid & highs);
+                // 'A' and 'a' have bit 6 set, the decimal digits don't
+                const boost::uint64_t v = (x & 0x0f * lows) + ((x >> 6) & lows) * 9;
+                w |= gather_nibbles(v) << (32 * (1 - h));
+            }
+            out[k] = w;
+        }
+        return bad == 0;
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+
+    // a table lookup per digit through pshufb
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline void hex_encode_avx2_kernel(const boost::uint64_t * w, std::size_t n,
+                                       char * last)
+    {
+        const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                             '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+        const __m128i reverse = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0,
+                                              15, 14, 13, 12, 11, 10, 9, 8);
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        for (std::size_t k = 0; k < n; ++k) {
+            const __m128i v = _mm_shuffle_epi8(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i *>(w + k)), reverse);
+            const __m128i lo = _mm_and_si128(v, nibble);
+            const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(last - 16 * (k + 1)),
+                             _mm_shuffle_epi8(digits, _mm_unpacklo_epi8(hi, lo)));
+        }
+    }
+
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline bool hex_decode_avx2_kernel(const char * last, std::size_t n,
+                                       boost::uint64_t * out)
+    {
+        const __m128i reverse = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0,
+                                              15, 14, 13, 12, 11, 10, 9, 8);
+        const __m128i weights = _mm_set1_epi16(0x0110);
+        __m128i valid = _mm_set1_epi8(-1);
+        for (std::size_t k = 0; k < n; ++k) {
+            const __m128i c = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(last - 16 * (k + 1)));
+            const __m128i l = _mm_or_si128(c, _mm_set1_epi8(0x20));
+            // signed compares: characters above 0x7f are negative
+            const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                                _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), c));
+            const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)),
+                                                 _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), l));
+            valid = _mm_and_si128(valid, _mm_or_si128(digit, letter));
+            const __m128i v = _mm_add_epi8(_mm_and_si128(c, _mm_set1_epi8(0x0f)),
+                                           _mm_and_si128(letter, _mm_set1_epi8(9)));
+            // pairs of digits to bytes, the most significant first
+            const __m128i bytes = _mm_packus_epi16(_mm_maddubs_epi16(v, weights),
+                                                   _mm_setzero_si128());
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out + k),
+                             _mm_shuffle_epi8(bytes, reverse));
+        }
+        return _mm_movemask_epi8(valid) == 0xffff;
+    }
+
+#endif // BOOST_DYNAMIC_BITSET_X86_SIMD
+
+    // PRE: simd_level_available(l); there is no SSE2 flavor
+    inline hex_encode_function hex_encode_kernel_function(simd_level l)
+    {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        if (l >= simd_avx2)
+            return &hex_encode_avx2_kernel;
+#endif
+        (void)l;
+        return &hex_encode_word_kernel;
+    }
+
+    // PRE: simd_level_available(l); there is no SSE2 flavor
+    inline hex_decode_function hex_decode_kernel_function(simd_level l)
+    {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        if (l >= simd_avx2)
+            return &hex_decode_avx2_kernel;
+#endif
+        (void)l;
+        return &hex_decode_word_kernel;
+    }
+
+    // the value of a hexadecimal digit, or -1
+    inline int hex_digit_value(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    // ------- base64 kernels ---------------------------------
+
+    // Encoding takes n bytes, a multiple of 3, and writes 4 n / 3
+    // characters to out. Decoding takes n characters, a multiple of 4,
+    // without padding, writes 3 n / 4 bytes to out and returns false if
+    // a character is not in the alphabet; out must have room for
+    // base64_slack more bytes.
+    //
+    typedef void (*base64_encode_function)(const byte_type *, std::size_t, char *);
+    typedef bool (*base64_decode_function)(const char *, std::size_t, byte_type *);
+
+    const std::size_t base64_slack = 16;
+
+    inline const char * base64_alphabet()
+    {
+        return "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    }
+
+    // for each character, its value in the alphabet or 0xff
+    struct base64_table
+    {
+        unsigned char values[256];
+
+        base64_table()
+        {
+            std::fill(values, values + 256, static_cast<unsigned char>(0xff));
+            for (unsigned i = 0; i < 64; ++i)
+                values[static_cast<unsigned char>(base64_alphabet()[i])] =
+                    static_cast<unsigned char>(i);
+        }
+
+        static const base64_table & get()
+        {
+            static const base64_table table;
+            return table;
+        }
+    };
+
+    inline void base64_encode_word_kernel(const byte_type * p, std::size_t n, char * out)
+    {
+        const char * const alphabet = base64_alphabet();
+        for (std::size_t i = 0; i < n; i += 3, out += 4) {
+            const unsigned v = (unsigned(p[i]) << 16) | (unsigned(p[i + 1]) << 8) | p[i + 2];
+            out[0] = alphabet[v >> 18];
+            out[1] = alphabet[(v >> 12) & 63];
+            out[2] = alphabet[(v >> 6) & 63];
+            out[3] = alphabet[v & 63];
+        }
+    }
+
+    inline bool base64_decode_word_kernel(const char * p, std::size_t n, byte_type * out)
+    {
+        const unsigned char * const values = base64_table::get().values;
+        unsigned bad = 0;
+        for (std::size_t i = 0; i < n; i += 4, out += 3) {
+            const unsigned a = values[static_cast<unsigned char>(p[i])];
+            const unsigned b = values[static_cast<unsigned char>(p[i + 1])];
+            const unsigned c = values[static_cast<unsigned char>(p[i + 2])];
+            const unsigned d = values[static_cast<unsigned char>(p[i + 3])];
+            bad |= a | b | c | d;
+            const unsigned v = (a << 18) | (b << 12) | (c << 6) | d;
+            out[0] = static_cast<byte_type>(v >> 16);
+            out[1] = static_cast<byte_type>(v >> 8);
+            out[2] = static_cast<byte_type>(v);
+        }
+        return (bad & 0x80) == 0;
+    }
+
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+
+    // 12 bytes to 16 characters per step (W. Mula and D. Lemire): the
+    // sextets are moved to their bytes with two multiplications, and
+    // turned into characters by adding an offset looked up by range
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline void base64_encode_avx2_kernel(const byte_type * p, std::size_t n, char * out)
+    {
+        const __m128i split = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                           4, 5, 3, 4, 1, 2, 0, 1);
+        const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0);
+        std::size_t i = 0;
+        for ( ; i + 16 <= n; i += 12, out += 16) {
+            const __m128i in = _mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)), split);
+            const __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+                                               _mm_set1_epi32(0x04000040));
+            const __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+                                               _mm_set1_epi32(0x01000010));
+            const __m128i sextets = _mm_or_si128(t0, t1);
+
+            // 0: 26..51, 1..10: 52..61, 11: 62, 12: 63, 13: 0..25
+            __m128i range = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+            range = _mm_or_si128(range, _mm_and_si128(
+                _mm_cmpgt_epi8(_mm_set1_epi8(26), sextets), _mm_set1_epi8(13)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                             _mm_add_epi8(sextets, _mm_shuffle_epi8(offsets, range)));
+        }
+        base64_encode_word_kernel(p + i, n - i, out);
+    }
+
+    // 16 characters to 12 bytes per step (W. Mula and D. Lemire): the
+    // characters are validated with two table lookups, by high and low
+    // nibble, and turned into sextets by adding an offset looked up by
+    // high nibble
+    BOOST_DYNAMIC_BITSET_TARGET("avx2")
+    inline bool base64_decode_avx2_kernel(const char * p, std::size_t n, byte_type * out)
+    {
+        const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                             0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                             0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                               0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                           -1, -1, -1, -1);
+        __m128i bad = _mm_setzero_si128();
+        std::size_t i = 0;
+        for ( ; i + 16 <= n; i += 16, out += 12) {
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+            const __m128i hi = _mm_and_si128(_mm_srli_epi32(c, 4), nibble);
+            const __m128i lo = _mm_and_si128(c, nibble);
+            bad = _mm_or_si128(bad, _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo),
+                                                  _mm_shuffle_epi8(lut_hi, hi)));
+            // '/' shares its high nibble with '+'
+            const __m128i slash = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+            const __m128i sextets = _mm_add_epi8(
+                c, _mm_shuffle_epi8(lut_roll, _mm_add_epi8(slash, hi)));
+            const __m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+            const __m128i words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(words, pack));
+        }
+        return base64_decode_word_kernel(p + i, n - i, out) && _mm_testz_si128(bad, bad);
+    }
+
+#endif // BOOST_DYNAMIC_BITSET_X86_SIMD
+
+    // PRE: simd_level_available(l); there is no SSE2 flavor
+    inline base64_encode_function base64_encode_kernel_function(simd_level l)
+    {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        if (l >= simd_avx2)
+            return &base64_encode_avx2_kernel;
+#endif
+        (void)l;
+        return &base64_encode_word_kernel;
+    }
+
+    // PRE: simd_level_available(l); there is no SSE2 flavor
+    inline base64_decode_function base64_decode_kernel_function(simd_level l)
+    {
+#if defined(BOOST_DYNAMIC_BITSET_X86_SIMD)
+        if (l >= simd_avx2)
+            return &base64_decode_avx2_kernel;
+#endif
+        (void)l;
+        return &base64_decode_word_kernel;
+    }
+
+    // in bytes, the size of the buffers of to_base64() and
+    // from_base64(); a multiple of 3 and of 8
+    const std::size_t base64_chunk = 3072;
+
+    // Gives b the size num_bits, unless it is npos, if none of the bits
+    // beyond it are set; otherwise clears b.
+    template <typename Block, typename Allocator>
+    bitset_parse_result fit_parsed_bits(dynamic_bitset<Block, Allocator>& b,
+                                        std::size_t num_bits)
+    {
+        typedef dynamic_bitset<Block, Allocator> bitset_type;
+        if (num_bits == bitset_type::npos)
+            return bitset_parse_ok;
+        if (num_bits < b.size()
+            && (num_bits == 0 ? b.find_first() : b.find_next(num_bits - 1)) != bitset_type::npos) {
+            b.clear();
+            return bitset_parse_out_of_range;
+        }
+        b.resize(num_bits);
+        return bitset_parse_ok;
+    }
+
+  } // dynamic_bitset_impl
+  } // namespace detail
+
+
+// The hexadecimal digits of b, lowercase, the most significant first:
+// (b.size() + 3) / 4 of them.
+//
+template <typename Block, typename Allocator>
+void to_hex_string(const dynamic_bitset<Block, Allocator>& b, std::string& s)
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    const std::size_t num_digits = (b.size() + 3) / 4;
+    s.resize(num_digits);
+    if (num_digits == 0)
+        return;
+
+    const Block * const p = dynamic_bitset_view<const Block>(b).data();
+    const std::size_t num_blocks = b.num_blocks();
+    char * const last = &s[0] + num_digits;
+
+    static const hex_encode_function f = hex_encode_kernel_function(best_simd_level());
+    const std::size_t num_words = num_digits / 16;
+    boost::uint64_t buf[64];
+    for (std::size_t k = 0; k < num_words; ) {
+        const std::size_t m = (std::min)(num_words - k, std::size_t(64));
+        for (std::size_t j = 0; j < m; ++j)
+            buf[j] = load_bits64(p, num_blocks, k + j);
+        f(buf, m, last - 16 * k);
+        k += m;
+    }
+
+    const std::size_t rest = num_digits % 16;
+    const boost::uint64_t w = load_bits64(p, num_blocks, num_words);
+    for (std::size_t i = 0; i < rest; ++i)
+        s[i] = "0123456789abcdef"[(w >> (4 * (rest - 1 - i))) & 0xf];
+}
+
+// Assigns to b the value of the hexadecimal digits of [first, last),
+// upper or lower case, the most significant first. The size of b is
+// num_bits, or 4 bits per digit if num_bits is npos. On failure b is
+// empty.
+//
+template <typename Block, typename Allocator>
+bitset_parse_result from_hex(const char* first, const char* last,
+                             dynamic_bitset<Block, Allocator>& b,
+                             std::size_t num_bits = dynamic_bitset<Block, Allocator>::npos)
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    const std::size_t num_digits = static_cast<std::size_t>(last - first);
+    b.clear();
+    b.resize(4 * num_digits);
+
+    Block * const p = dynamic_bitset_view<Block>(b).data();
+    const std::size_t num_blocks = b.num_blocks();
+
+    static const hex_decode_function f = hex_decode_kernel_function(best_simd_level());
+    const std::size_t num_words = num_digits / 16;
+    boost::uint64_t buf[64];
+    for (std::size_t k = 0; k < num_words; ) {
+        const std::size_t m = (std::min)(num_words - k, std::size_t(64));
+        if (!f(last - 16 * k, m, buf)) {
+            b.clear();
+            return bitset_parse_invalid_char;
+        }
+        for (std::size_t j = 0; j < m; ++j)
+            store_bits64(p, num_blocks, k + j, buf[j]);
+        k += m;
+    }
+
+    const std::size_t rest = num_digits % 16;
+    boost::uint64_t w = 0;
+    for (std::size_t i = 0; i < rest; ++i) {
+        const int v = hex_digit_value(first[i]);
+        if (v < 0) {
+            b.clear();
+            return bitset_parse_invalid_char;
+        }
+        w = (w << 4) | static_cast<boost::uint64_t>(v);
+    }
+    if (rest != 0)
+        store_bits64(p, num_blocks, num_words, w);
+
+    return fit_parsed_bits(b, num_bits);
+}
+
+// The base64 text of the (b.size() + 7) / 8 bytes of b, with padding.
+//
+template <typename Block, typename Allocator>
+void to_base64(const dynamic_bitset<Block, Allocator>& b, std::string& s)
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    const std::size_t num_bytes = (b.size() + 7) / 8;
+    s.resize(4 * ((num_bytes + 2) / 3));
+    if (num_bytes == 0)
+        return;
+
+    const Block * const p = dynamic_bitset_view<const Block>(b).data();
+    const std::size_t num_blocks = b.num_blocks();
+    char * out = &s[0];
+
+    static const base64_encode_function f = base64_encode_kernel_function(best_simd_level());
+    byte_type buf[base64_chunk];
+    for (std::size_t first = 0; first < num_bytes; first += base64_chunk) {
+        const std::size_t n = (std::min)(num_bytes - first, base64_chunk);
+        for (std::size_t i = 0; i < n; i += 8)
+            store_chars64(reinterpret_cast<char *>(buf + i),
+                          load_bits64(p, num_blocks, (first + i) / 8));
+
+        const std::size_t whole = n - n % 3;
+        f(buf, whole, out);
+        out += 4 * whole / 3;
+
+        if (whole != n) {
+            // the last one or two bytes
+            const char * const alphabet = base64_alphabet();
+            const unsigned v = (unsigned(buf[whole]) << 16)
+                             | (whole + 1 < n ? unsigned(buf[whole + 1]) << 8 : 0u);
+            out[0] = alphabet[v >> 18];
+            out[1] = alphabet[(v >> 12) & 63];
+            out[2] = whole + 1 < n ? alphabet[(v >> 6) & 63] : '=';
+            out[3] = '=';
+        }
+    }
+}
+
+// Assigns to b the bytes of the base64 text [first, last), which must
+// be padded. The size of b is num_bits, or 8 bits per byte if num_bits
+// is npos. On failure b is empty.
+//
+template <typename Block, typename Allocator>
+bitset_parse_result from_base64(const char* first, const char* last,
+                                dynamic_bitset<Block, Allocator>& b,
+                                std::size_t num_bits = dynamic_bitset<Block, Allocator>::npos)
+{
+    using namespace detail::dynamic_bitset_impl;
+
+    b.clear();
+    const std::size_t len = static_cast<std::size_t>(last - first);
+    if (len % 4 != 0)
+        return bitset_parse_invalid_char;
+    if (len == 0)
+        return fit_parsed_bits(b, num_bits);
+
+    // up to two '=' end the last group; they are decoded as 'A'
+    char tail[4];
+    std::copy(last - 4, last, tail);
+    std::size_t padding = 0;
+    for ( ; padding < 2 && tail[3 - padding] == '='; ++padding)
+        tail[3 - padding] = 'A';
+
+    const std::size_t num_bytes = 3 * (len / 4) - padding;
+    b.resize(8 * num_bytes);
+    Block * const p = dynamic_bitset_view<Block>(b).data();
+    const std::size_t num_blocks = b.num_blocks();
+
+    static const base64_decode_function f = base64_decode_kernel_function(best_simd_level());
+    const std::size_t chunk_chars = 4 * base64_chunk / 3;
+    byte_type buf[base64_chunk + base64_slack];
+    for (std::size_t c = 0; c < len; c += chunk_chars) {
+        const std::size_t m = (std::min)(len - c, chunk_chars);
+        const bool valid = c + m == len
+            ? f(first + c, m - 4, buf) && base64_decode_word_kernel(tail, 4, buf + 3 * (m - 4) / 4)
+            : f(first + c, m, buf);
+        if (!valid) {
+            b.clear();
+            return bitset_parse_invalid_char;
+        }
+
+        // the bytes past num_bytes, from the padding, are dropped
+        const std::size_t start = 3 * (c / 4);
+        const std::size_t n = (std::min)(3 * m / 4, num_bytes - start);
+        std::fill(buf + n, buf + (n + 7) / 8 * 8, byte_type(0));
+        for (std::size_t i = 0; i < n; i += 8)
+            store_bits64(p, num_blocks, (start + i) / 8,
+                         load_chars64(reinterpret_cast<const char *>(buf + i)));
+    }
+
+    return fit_parsed_bits(b, num_bits);
+}
+
+#if !defined(BOOST_NO_CXX17_HDR_STRING_VIEW)
+
+template <typename Block, typename Allocator>
+inline bitset_parse_result from_hex(std::string_view s,
+                                    dynamic_bitset<Block, Allocator>& b,
+                                    std::size_t num_bits = dynamic_bitset<Block, Allocator>::npos)
+{
+    return from_hex(s.data(), s.data() + s.size(), b, num_bits);
+}
+
+template <typename Block, typename Allocator>
+inline bitset_parse_result from_base64(std::string_view s,
+                                       dynamic_bitset<Block, Allocator>& b,
+                                       std::size_t num_bits = dynamic_bitset<Block, Allocator>::npos)
+{
+    return from_base64(s.data(), s.data() + s.size(), b, num_bits);
+}
+
+#endif
+
+  namespace detail {
+  namespace dynamic_bitset_impl {
+
+    // the formatter of std::format and {fmt}: "{}" and "{:b}" give the
+    // text of to_string(), "{:x}" that of to_hex_string()
+    template <typename Error>
+    struct bitset_formatter
+    {
+        char type;
+
+        BOOST_CONSTEXPR bitset_formatter() : type('b') {}
+
+        template <typename ParseContext>
+        BOOST_CXX14_CONSTEXPR typename ParseContext::iterator parse(ParseContext& ctx)
+        {
+            typename ParseContext::iterator it = ctx.begin();
+            if (it != ctx.end() && (*it == 'b' || *it == 'x'))
+                type = *it++;
+            if (it != ctx.end() && *it != '}')
+                throw Error("invalid format specification for dynamic_bitset");
+            return it;
+        }
+
+        template <typename Block, typename Allocator, typename FormatContext>
+        typename FormatContext::iterator format(const dynamic_bitset<Block, Allocator>& b,
+                                                FormatContext& ctx) const
+        {
+            std::string s;
+            if (type == 'x')
+                to_hex_string(b, s);
+            else
+                to_string(b, s);
+            return std::copy(s.begin(), s.end(), ctx.out());
+        }
+    };
+
+  } // dynamic_bitset_impl
+  } // namespace detail
+
+} // namespace boost
+
+
+#if defined(__cpp_lib_format)
+
+template <typename Block, typename Allocator>
+struct std::formatter<boost::dynamic_bitset<Block, Allocator>, char>
+    : boost::detail::dynamic_bitset_impl::bitset_formatter<std::format_error>
+{
+};
+
+#endif
+
+// {fmt} is used if its header comes first
+#if defined(FMT_VERSION)
+
+template <typename Block, typename Allocator>
+struct fmt::formatter<boost::dynamic_bitset<Block, Allocator>, char>
+    : boost::detail::dynamic_bitset_impl::bitset_formatter<fmt::format_error>
+{
+};
+
+#endif
+
+#endif // include guard
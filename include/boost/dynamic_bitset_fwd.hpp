@@ -12,7 +12,9 @@
 #ifndef BOOST_DYNAMIC_BITSET_FWD_HPP
 #define BOOST_DYNAMIC_BITSET_FWD_HPP
 
+#include <cstddef>
 #include <memory>
+#include "boost/config.hpp"
 
 namespace boost {
 
@@ -20,6 +22,38 @@ template <typename Block = unsigned long,
           typename Allocator = std::allocator<Block> >
 class dynamic_bitset;
 
+template <typename Block = unsigned long,
+          typename Allocator = std::allocator<Block> >
+class hierarchical_bitset;
+
+template <typename Block = unsigned long,
+          typename Allocator = std::allocator<Block> >
+class ewah_bitset;
+
+template <typename Block = unsigned long>
+class dynamic_bitset_view;
+
+// Passed as the Allocator argument of dynamic_bitset, keeps up to N
+// blocks inside the bitset object and allocates with Allocator (or
+// std::allocator<Block> if void) beyond that.
+template <std::size_t N, typename Allocator = void>
+struct dynamic_bitset_small_buffer {};
+
+// Passed as the Allocator argument of dynamic_bitset, makes the bitset
+// a single pointer: its size and capacity are stored in the allocation,
+// before the blocks. Allocates with Allocator (or std::allocator<Block>
+// if void).
+template <typename Allocator = void>
+struct dynamic_bitset_compact_buffer {};
+
+#if !defined(BOOST_NO_CXX11_TEMPLATE_ALIASES)
+template <std::size_t N, typename Block = unsigned long>
+using small_dynamic_bitset = dynamic_bitset<Block, dynamic_bitset_small_buffer<N> >;
+
+template <typename Block = unsigned long>
+using compact_dynamic_bitset = dynamic_bitset<Block, dynamic_bitset_compact_buffer<> >;
+#endif
+
 }
 
 #endif // include guard
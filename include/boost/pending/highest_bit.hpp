@@ -0,0 +1,90 @@
+// -----------------------------------------------------------
+// highest_bit.hpp
+//
+//           Position of the highest bit 'on'
+//
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+// -----------------------------------------------------------
+
+#ifndef BOOST_HIGHEST_BIT_HPP
+#define BOOST_HIGHEST_BIT_HPP
+
+#include <assert.h>
+#include <climits>
+#include "boost/pending/integer_log2.hpp"
+
+
+namespace boost {
+
+    template <typename T>
+    int highest_bit(T x) {
+
+        assert(x >= 1); // PRE
+
+        // the position of the leftmost bit on is
+        // the logarithm base 2, rounded down
+        //
+        return boost::integer_log2<T>( x );
+
+    }
+
+#if defined(BOOST_MSVC) && (defined(_M_IX86) || defined(_M_X64))
+    template<>
+    BOOST_FORCEINLINE int highest_bit(unsigned int x) {
+        assert(x >= 1); // PRE
+
+        unsigned long result;
+        _BitScanReverse(&result, x);
+        return result;
+    }
+
+    template<>
+    BOOST_FORCEINLINE int highest_bit(unsigned long x) {
+        assert(x >= 1); // PRE
+
+        unsigned long result;
+        _BitScanReverse(&result, x);
+        return result;
+    }
+
+#ifdef _M_X64
+    template<>
+    BOOST_FORCEINLINE int highest_bit(unsigned long long x) {
+        assert(x >= 1); // PRE
+
+        unsigned long result;
+        _BitScanReverse64(&result, x);
+        return result;
+    }
+#endif
+
+#elif defined(BOOST_GCC) || defined(__clang__) || (defined(BOOST_INTEL) && defined(__GNUC__))
+    template<>
+    BOOST_FORCEINLINE int highest_bit(unsigned int x) {
+        assert(x >= 1); // PRE
+
+        return static_cast<int>(sizeof(x) * CHAR_BIT) - 1 - __builtin_clz( x );
+    }
+
+    template<>
+    BOOST_FORCEINLINE int highest_bit(unsigned long x) {
+        assert(x >= 1); // PRE
+
+        return static_cast<int>(sizeof(x) * CHAR_BIT) - 1 - __builtin_clzl( x );
+    }
+
+    template<>
+    BOOST_FORCEINLINE int highest_bit(unsigned long long x) {
+        assert(x >= 1); // PRE
+
+        return static_cast<int>(sizeof(x) * CHAR_BIT) - 1 - __builtin_clzll( x );
+    }
+#endif
+
+}
+
+
+#endif // include guard